@@ -106,21 +106,79 @@ def skeleton_checkpoint_lenet_distributed(cluster, executables, dir_name, compil
      os.system('rm -rf ckpt*')
      assert diff_test == 0
 
+def skeleton_checkpoint_lenet_aggregate(cluster, executables, dir_name, compiler_name):
+     # Each epoch writes an epoch checkpoint followed by a validation
+     # checkpoint into the same directory; restart must still find the
+     # aggregated matrices
+     if compiler_name not in executables:
+       pytest.skip('default_exes[%s] does not exist' % compiler_name)
+     exe = executables[compiler_name]
+     output_file_name = '%s/bamboo/unit_tests/output/checkpoint_lenet_aggregate_no_checkpoint_%s_output.txt' % (dir_name, compiler_name)
+     error_file_name  = '%s/bamboo/unit_tests/error/checkpoint_lenet_aggregate_no_checkpoint_%s_error.txt' % (dir_name, compiler_name)
+     command = tools.get_command(
+         cluster=cluster, executable=exe, num_nodes=1, num_processes=2,
+         dir_name=dir_name,
+         data_filedir_default='/p/lscratchh/brainusr/datasets/MNIST',
+         data_reader_name='mnist', model_folder='tests',
+         model_name='lenet_mnist_aggr_ckpt', num_epochs=2, optimizer_name='sgd',
+        output_file_name=output_file_name, error_file_name=error_file_name)
+     return_code_nockpt = os.system(command)
+     if return_code_nockpt != 0:
+         sys.stderr.write('LeNet (no checkpoint) execution failed, exiting with error')
+         sys.exit(1)
+     os.system('mv ckpt ckpt_baseline')
+
+     output_file_name = '%s/bamboo/unit_tests/output/checkpoint_lenet_aggregate_checkpoint_%s_output.txt' % (dir_name, compiler_name)
+     error_file_name  = '%s/bamboo/unit_tests/error/checkpoint_lenet_aggregate_checkpoint_%s_error.txt' % (dir_name, compiler_name)
+     command = tools.get_command(
+         cluster=cluster, executable=exe, num_nodes=1, num_processes=2,
+         dir_name=dir_name,
+         data_filedir_default='/p/lscratchh/brainusr/datasets/MNIST',
+         data_reader_name='mnist', model_folder='tests',
+         model_name='lenet_mnist_aggr_ckpt', num_epochs=1, optimizer_name='sgd',
+        output_file_name=output_file_name, error_file_name=error_file_name)
+     return_code_ckpt_1 = os.system(command)
+     if return_code_ckpt_1 != 0:
+         sys.stderr.write('LeNet (checkpoint) execution failed, exiting with error')
+         sys.exit(1)
+
+     output_file_name = '%s/bamboo/unit_tests/output/checkpoint_lenet_aggregate_restart_%s_output.txt' % (dir_name, compiler_name)
+     error_file_name  = '%s/bamboo/unit_tests/error/checkpoint_lenet_aggregate_restart_%s_error.txt' % (dir_name, compiler_name)
+     command = tools.get_command(
+         cluster=cluster, executable=exe, num_nodes=1, num_processes=2,
+         dir_name=dir_name,
+         data_filedir_default='/p/lscratchh/brainusr/datasets/MNIST',
+         data_reader_name='mnist', model_folder='tests',
+         model_name='lenet_mnist_aggr_ckpt', num_epochs=2, optimizer_name='sgd',
+        output_file_name=output_file_name, error_file_name=error_file_name)
+     return_code_ckpt_2 = os.system(command)
+     if return_code_ckpt_2 != 0:
+         sys.stderr.write('LeNet execution (restart from checkpoint) failed, exiting with error')
+         sys.exit(1)
+
+     diff_test = os.system('diff -rq ckpt ckpt_baseline')
+     os.system('rm -rf ckpt*')
+     assert diff_test == 0
+
 def test_unit_checkpoint_lenet_clang4(cluster, exes, dirname):
     skeleton_checkpoint_lenet_shared(cluster, exes, dirname, 'clang4')
     skeleton_checkpoint_lenet_distributed(cluster, exes, dirname, 'clang4')
+    skeleton_checkpoint_lenet_aggregate(cluster, exes, dirname, 'clang4')
 
 def test_unit_checkpoint_lenet_gcc4(cluster, exes, dirname):
     skeleton_checkpoint_lenet_shared(cluster, exes, dirname, 'gcc4')
     skeleton_checkpoint_lenet_distributed(cluster, exes, dirname, 'gcc4')
+    skeleton_checkpoint_lenet_aggregate(cluster, exes, dirname, 'gcc4')
 
 def test_unit_checkpoint_lenet_gcc7(cluster, exes, dirname):
     skeleton_checkpoint_lenet_shared(cluster, exes, dirname, 'gcc7')
     skeleton_checkpoint_lenet_distributed(cluster, exes, dirname, 'gcc7')
+    skeleton_checkpoint_lenet_aggregate(cluster, exes, dirname, 'gcc7')
 
 def test_unit_checkpoint_lenet_intel18(cluster, exes, dirname):
     skeleton_checkpoint_lenet_shared(cluster, exes, dirname, 'intel18')
     skeleton_checkpoint_lenet_distributed(cluster, exes, dirname, 'intel18')
+    skeleton_checkpoint_lenet_aggregate(cluster, exes, dirname, 'intel18')
 
 # Run with python -m pytest -s test_unit_checkpoint.py -k 'test_unit_checkpoint_lenet_exe' --exe=<executable>
 def test_unit_checkpoint_lenet_exe(cluster, dirname, exe):
@@ -129,3 +187,4 @@ def test_unit_checkpoint_lenet_exe(cluster, dirname, exe):
     exes = {'exe' : exe}
     skeleton_checkpoint_lenet_shared(cluster, exes, dirname, 'exe')
     skeleton_checkpoint_lenet_distributed(cluster, exes, dirname, 'exe')
+    skeleton_checkpoint_lenet_aggregate(cluster, exes, dirname, 'exe')
@@ -63,6 +63,7 @@ class lbann_callback_checkpoint : public lbann_callback {
   void on_epoch_end(model *m) override;
   void on_batch_end(model *m) override;
   void on_validation_end(model *m) override;
+  void on_train_end(model *m) override;
 
   inline void set_checkpoint_dir(std::string dir){
     m_checkpoint_dir= dir;
@@ -92,11 +93,36 @@ class lbann_callback_checkpoint : public lbann_callback {
     m_ckpt_dist_steps = ckpt_dist_steps;
   }
 
+  /** Write checkpoints to disk in the background.
+   *  Training resumes as soon as the model state has been copied
+   *  into host staging memory.
+   */
+  inline void set_checkpoint_async(bool async){
+    p.set_async(async);
+  }
+
+  /** Write the per-rank matrices of a distributed checkpoint into a
+   *  single indexed file instead of a file per matrix.
+   */
+  inline void set_checkpoint_aggregate(bool aggregate){
+    p.set_aggregate(aggregate);
+  }
+
   bool need_checkpoint(model *m);
   bool checkpoint(model *m);
   bool restart(model *m);
   std::string name() const override { return "checkpoint"; }
  protected:
+  /** Mark the last checkpoint as the latest one.
+   *  Must be called by all ranks in the model. Waits until this
+   *  rank's checkpoint files are on disk and checks that every rank
+   *  wrote its files successfully. Otherwise the "latest" files are
+   *  not updated, so restarts use the previous complete checkpoint.
+   *  Asynchronous checkpoints are finished when the next checkpoint
+   *  starts or when training ends.
+   */
+  void finish_checkpoint(model *m);
+
   std::string m_checkpoint_dir;
   int m_checkpoint_epochs;
   int m_checkpoint_steps;
@@ -108,6 +134,12 @@ class lbann_callback_checkpoint : public lbann_callback {
   persist p;
   bool m_checkpoint_dist;
   bool m_checkpoint_shared;
+  /** Whether the last checkpoint has not been finished. */
+  bool m_checkpoint_pending = false;
+  /** "Latest" files to write when the last checkpoint is finished. */
+  std::vector<std::string> m_pending_latest_files;
+  int m_pending_epoch = -1;
+  int m_pending_step = -1;
 
   template<size_t _max_dir_len>
   struct header_t {
@@ -157,14 +189,20 @@ static inline std::string get_distributed_checkpoint_dirname(model *m, std::stri
   return ss.str();
 }
 
+// Contents of the file recording the last checkpoint.
+static inline std::string format_latest(int epoch, int train) {
+  char field[256];
+  sprintf(field, "epoch=%d step=%d\n", epoch, train);
+  return std::string(field);
+}
+
 // Print last checkpoint to file, used to determine which checkpoint to load from.
 static inline bool write_latest(std::string filename, int epoch, int train) {
   // open the file for writing
   int fd = openwrite(filename.c_str());
   if (fd != -1) {
-    char field[256];
-    sprintf(field, "epoch=%d step=%d\n", epoch, train);
-    write_string(fd, filename.c_str(), field, strlen(field));
+    const auto field = format_latest(epoch, train);
+    write_string(fd, filename.c_str(), field.c_str(), field.size());
     // close our file
     closewrite(fd, filename.c_str());
   }
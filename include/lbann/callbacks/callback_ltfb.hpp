@@ -54,7 +54,16 @@ namespace lbann {
  *      or a subset of the weights? Hyperparameters?
  *    - Can this be used to explore model architectures?
  *
- *  @todo Exchange optimizer state.
+ *  Tournaments can be made cheaper in two ways:
+ *    - Models can be scored with a subset of the validation set,
+ *      namely the first few mini-batches of its current epoch. Both
+ *      models in a tournament are scored with the same mini-batches.
+ *    - With the sendrecv_weights algorithm, model data can be
+ *      exchanged asynchronously. A snapshot of the local model is
+ *      sent to the partner trainer while the next training step is
+ *      performed, and models are scored once it has arrived. The
+ *      local model is then one step ahead of the partner's.
+ *
  *  @todo Support heterogeneous models.
  */
 class lbann_callback_ltfb : public lbann_callback {
@@ -112,15 +121,23 @@ public:
    *  @param low_score_wins Whether low-scoring or high-scoring models
    *                        survive a tournament.
    *  @param comm_algo      Inter-trainer communication scheme.
+   *  @param eval_mini_batches  Number of validation mini-batches used
+   *                        to score models. If zero, then the whole
+   *                        validation set is used.
+   *  @param async_exchange Whether to overlap the exchange of model
+   *                        data with a training step.
    */
   lbann_callback_ltfb(El::Int batch_interval,
                       std::string metric_name,
                       std::set<std::string> weights_names = {},
                       bool low_score_wins = false,
                       communication_algorithm comm_algo = communication_algorithm::sendrecv_weights,
+                      El::Int eval_mini_batches = 0,
+                      bool async_exchange = false,
                       lbann_summary *summarizer = nullptr);
   lbann_callback_ltfb(const lbann_callback_ltfb& other);
   lbann_callback_ltfb& operator=(const lbann_callback_ltfb& other);
+  ~lbann_callback_ltfb() override;
   lbann_callback_ltfb* copy() const override { return new lbann_callback_ltfb(*this); }
   std::string name() const override { return "LTFB"; }
 
@@ -136,6 +153,18 @@ public:
 
 private:
 
+  /** Start a tournament by sending the local model to the partner
+   *  trainer without waiting for the partner's model.
+   */
+  void start_async_exchange(model& m, const std::string& message_prefix);
+  /** Score the local and partner models and keep the winner. */
+  void finish_tournament(model& m,
+                         El::Int partner_trainer,
+                         const std::string& message_prefix);
+
+  /** Number of training mini-batch steps between tournaments. */
+  El::Int m_tournament_interval;
+
   /** Metric for tournament evaluation. */
   std::string m_metric_name;
 
@@ -158,6 +187,29 @@ private:
    */
   std::vector<std::unique_ptr<weights>> m_workspace_weights;
 
+  /** Number of validation mini-batches used to score models.
+   *
+   *  If zero, then the whole validation set is used.
+   */
+  El::Int m_eval_mini_batches;
+
+  /** Whether to overlap the exchange of model data with a training
+   *  step. */
+  bool m_async_exchange;
+
+  /** Partner trainer of the tournament with an exchange in progress.
+   *
+   *  Negative if there is no exchange in progress.
+   */
+  El::Int m_pending_partner;
+
+  /** Packed snapshot of local model data sent to partner. */
+  std::vector<DataType> m_send_buffer;
+  /** Packed model data received from partner. */
+  std::vector<DataType> m_recv_buffer;
+  /** Requests for exchange in progress. */
+  std::vector<El::mpi::Request<DataType>> m_requests;
+
 };
 
 } // namespace lbann
@@ -89,6 +89,10 @@ class cv_cropper : public cv_transform {
 
   unsigned int get_crop_width() const { return m_width; }
   unsigned int get_crop_height() const { return m_height; }
+  /// Whether a region of interest is set instead of using the whole image
+  bool is_roi_set() const { return m_is_roi_set; }
+  /// The size of the initial region of interest to crop from
+  const std::pair<int, int>& get_roi_size() const { return m_roi_size; }
 
   /// Clear the states of the previous transform applied
   void reset() override;
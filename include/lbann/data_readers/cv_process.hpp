@@ -62,6 +62,8 @@ class cv_process {
   bool m_is_normalizer_set;
   /// The index of the normalizing transform in the array of transforms
   unsigned int m_normalizer_idx;
+  /// Whether images may be decoded at a reduced resolution
+  bool m_reduced_decoding;
 
   /// Array of transforms
   std::vector<std::unique_ptr<cv_transform> > m_transforms;
@@ -73,13 +75,15 @@ class cv_process {
 
  public:
   cv_process()
-    : m_flip(cv_transform::_no_flip_), m_split(true), m_is_normalizer_set(false), m_normalizer_idx(0u) {}
+    : m_flip(cv_transform::_no_flip_), m_split(true), m_is_normalizer_set(false), m_normalizer_idx(0u),
+      m_reduced_decoding(false) {}
 
   cv_process(const cv_process& rhs);
   cv_process& operator=(const cv_process& rhs);
 
   cv_process(const cv_transform::cv_flipping flip_code, const bool tosplit)
-    : m_flip(flip_code), m_split(tosplit), m_is_normalizer_set(false), m_normalizer_idx(0u) {}
+    : m_flip(flip_code), m_split(tosplit), m_is_normalizer_set(false), m_normalizer_idx(0u),
+      m_reduced_decoding(false) {}
 
   virtual ~cv_process() {}
 
@@ -111,6 +115,28 @@ class cv_process {
     return m_split;
   }
 
+  /**
+   *  Allow decoding images at a reduced resolution. JPEG decoders can
+   *  downscale an image by 1/2, 1/4, or 1/8 while decoding it, which is
+   *  much cheaper than decoding the full image and shrinking it
+   *  afterwards. This only takes effect if the first transform is a
+   *  cropper with a region of interest or a resizer, which shrink the
+   *  image anyway.
+   */
+  void set_reduced_decoding(const bool b) {
+    m_reduced_decoding = b;
+  }
+  /// Check whether images may be decoded at a reduced resolution
+  bool is_reduced_decoding() const {
+    return m_reduced_decoding;
+  }
+  /**
+   *  Return the largest factor (1, 2, 4, or 8) by which an image of the
+   *  given size can be downscaled while decoding such that the first
+   *  transform still shrinks or keeps the size of the result.
+   */
+  int get_decoding_reduction(const int width, const int height) const;
+
   /// Export transform operator of normalizer to allow lazy application
   std::vector<cv_normalizer::channel_trans_t> get_transform_normalize() const;
   /// Export transform operator of normalizer for a specific channel
@@ -112,6 +112,28 @@ class cv_utils {
    *  result in a better performance.
    */
   static cv::Mat lbann_imread(const std::string& img_file_path, int flags, std::vector<char>& buf, cv::Mat* image = nullptr);
+
+  /**
+   *  Same as above, but decode the image for the preprocessing pipeline pp.
+   *  If pp allows it, the image is decoded at a reduced resolution (see
+   *  cv_process::set_reduced_decoding()).
+   */
+  static cv::Mat lbann_imread(const std::string& img_file_path, const cv_process& pp, std::vector<char>& buf, cv::Mat* image = nullptr);
+
+  /**
+   *  Decode an image from a memory buffer for the preprocessing pipeline pp.
+   *  JPEG images are decoded at a reduced resolution if pp allows it and the
+   *  first transform in pp shrinks the image at least as much. Otherwise, this
+   *  is the same as cv::imdecode() with cv::IMREAD_ANYCOLOR | cv::IMREAD_ANYDEPTH.
+   */
+  static cv::Mat lbann_imdecode(cv::InputArray inbuf, const cv_process& pp, cv::Mat* image = nullptr);
+
+  /**
+   *  Read the width, the height, and the number of channels of a JPEG image
+   *  from its header without decoding it.
+   *  Returns false if the buffer does not contain a JPEG image.
+   */
+  static bool get_jpeg_info(const uint8_t* data, const size_t size, int& width, int& height, int& channels);
 };
 
 
@@ -326,29 +348,24 @@ inline bool cv_utils::copy_cvMat_to_buf_with_full_info(
     }
     _LBANN_MILD_EXCEPTION((trans.size() != NCh),
                           "Incorrect number of channels in transform", false);
-    std::vector<cv::Mat> channels(NCh);
 
-    if (std::is_same<DataType, T>::value) {
-      for(size_t ch=0; ch < NCh; ++ch, Pixels += sz) {
-        // create a separate image per channel aliasing the memory of buf
-        channels[ch] = cv::Mat(Height, Width, CV_MAKETYPE(image.depth(),1), Pixels);
-      }
-      Pixels = buf.Buffer();
-
-      cv::split(image, channels);
-
-      for(size_t ch=0; ch < NCh; ++ch, Pixels += sz) {
-        cv_normalizer::
-        scale(Pixels, Pixels + sz, Pixels, {trans[ch]});
-      }
-    } else {
-      cv::split(image, channels);
-
-      for(size_t ch=0; ch < NCh; ++ch, Pixels += sz) {
-        cv_normalizer::
-        scale(reinterpret_cast<const T *>(channels[ch].datastart),
-              reinterpret_cast<const T *>(channels[ch].dataend),
-              Pixels, {trans[ch]});
+    // Split channels, convert channel values, and normalize them in a
+    // single pass while writing each pixel into the buffer. This
+    // avoids temporary per-channel images and a separate pass over
+    // the buffer for normalization.
+    cv_normalizer::ComputeType alpha[NCh];
+    cv_normalizer::ComputeType beta[NCh];
+    for (int ch = 0; ch < NCh; ++ch) {
+      alpha[ch] = trans[ch].first;
+      beta[ch] = trans[ch].second;
+    }
+    for (int y = 0; y < Height; ++y) {
+      const T *src = image.ptr<T>(y);
+      DataType *dst = Pixels + y*Width;
+      for (int x = 0; x < Width; ++x) {
+        for (int ch = 0; ch < NCh; ++ch) {
+          dst[ch*sz + x] = static_cast<DataType>(alpha[ch]*src[x*NCh + ch] + beta[ch]);
+        }
       }
     }
   } else {
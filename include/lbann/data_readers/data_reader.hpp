@@ -40,6 +40,7 @@
 #include "lbann/utils/threads/thread_pool.hpp"
 #include <cassert>
 #include <algorithm>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <unistd.h>
@@ -73,13 +74,14 @@ class generic_data_reader : public lbann_image_preprocessor {
   generic_data_reader(bool shuffle = true) :
     m_data_store(nullptr),
     m_comm(nullptr),
-    m_mini_batch_size(0), m_current_pos(0),
+    m_mini_batch_size(0), m_current_pos(0), m_fetch_pos(0),
     m_stride_to_next_mini_batch(0), m_base_offset(0), m_model_offset(0),
     m_sample_stride(1), m_iteration_stride(1),
     m_last_mini_batch_size(0),
     m_stride_to_last_mini_batch(0),
     m_reset_mini_batch_index(0),
     m_loaded_mini_batch_idx(0),
+    m_consumed_mini_batch_idx(0),
     m_current_mini_batch_idx(0),
     m_num_iterations_per_epoch(0), m_global_mini_batch_size(0),
     m_global_last_mini_batch_size(0),
@@ -100,6 +102,8 @@ class generic_data_reader : public lbann_image_preprocessor {
     m_procs_per_partition(1),
     m_io_thread_pool(nullptr),
     m_jag_partitioned(false),
+    m_zero_fill_tail_only(false),
+    m_dynamic_fetch_chunk_size(0),
     m_model(nullptr)
   {}
   generic_data_reader(const generic_data_reader&) = default;
@@ -342,13 +346,20 @@ class generic_data_reader : public lbann_image_preprocessor {
   virtual const std::vector<int> get_data_dims() const {
     return std::vector<int>(0);
   }
-  /// True if the data reader's current position is valid.
+  /// True if the data reader's fetch position is valid.
   virtual bool position_valid() const {
-    return (m_current_pos < (int)m_shuffled_indices.size());
+    return (m_fetch_pos < (int)m_shuffled_indices.size());
   }
-  /// True if the data reader's current position is not valid but within # ranks per model
+  /// True if the data reader's fetch position is not valid but within # ranks per model
   /// of the end of the data set (e.g. it is a rank with no valid data on the last iteration)
   virtual bool position_is_overrun() const {
+    int end_pos = (int)m_shuffled_indices.size();
+    return (m_fetch_pos >= end_pos && (m_fetch_pos - end_pos) < m_comm->get_procs_per_model());
+  }
+  /// True if the data reader's current position is overrun, as in
+  /// position_is_overrun(); for use while processing the current
+  /// mini-batch, since the fetch position may be ahead
+  bool current_position_is_overrun() const {
     int end_pos = (int)m_shuffled_indices.size();
     return (m_current_pos >= end_pos && (m_current_pos - end_pos) < m_comm->get_procs_per_model());
   }
@@ -356,7 +367,7 @@ class generic_data_reader : public lbann_image_preprocessor {
   bool at_new_epoch() const {
     /// Note that data readers can start at a non-zero index if there
     /// are parallel data readers in a model
-    return ((m_loaded_mini_batch_idx == m_reset_mini_batch_index)
+    return ((m_consumed_mini_batch_idx == m_reset_mini_batch_index)
             && (m_current_mini_batch_idx == 0));
   }
   /// Set the mini batch size
@@ -369,6 +380,8 @@ class generic_data_reader : public lbann_image_preprocessor {
   }
   /// Get the loaded mini-batch size
   int get_loaded_mini_batch_size() const;
+  /// Get the model's mini-batch size for the mini-batch that is fetched next.
+  int get_fetch_mini_batch_size() const;
   /// Get the current mini-batch size.
   int get_current_mini_batch_size() const;
   /// Get the current global mini-batch size.
@@ -495,15 +508,27 @@ class generic_data_reader : public lbann_image_preprocessor {
   /// Set the current position based on the base and model offsets
   void set_initial_position() {
     m_current_pos = m_base_offset + m_model_offset;
+    m_fetch_pos = m_current_pos;
     m_loaded_mini_batch_idx = m_reset_mini_batch_index;
+    m_consumed_mini_batch_idx = m_reset_mini_batch_index;
     m_current_mini_batch_idx = 0;
   }
   /// Get the current position in the data reader.
   int get_position() const {
     return m_current_pos;
   }
+  /// Get the position of the next mini-batch to be fetched.
+  int get_fetch_position() const {
+    return m_fetch_pos;
+  }
   /// Get the next position in the data reader.
   int get_next_position() const;
+  /**
+   * Move the fetch position to the next mini-batch. This is called
+   * once a mini-batch has been fetched, so that the following
+   * mini-batch can be fetched before the current one is consumed.
+   */
+  void advance_fetch_position();
   /// Get a pointer to the start of the shuffled indices.
   int *get_indices() {
     return &m_shuffled_indices[0];
@@ -643,6 +668,9 @@ class generic_data_reader : public lbann_image_preprocessor {
     snprintf(fieldname, sizeof(fieldname), "%s_data_position", name);
     p.read_uint64(persist_value, fieldname, &val);
     m_current_pos = (int) val;
+    m_fetch_pos = m_current_pos;
+    m_loaded_mini_batch_idx = m_reset_mini_batch_index + m_current_mini_batch_idx * m_iteration_stride;
+    m_consumed_mini_batch_idx = m_loaded_mini_batch_idx;
     //resize shuffled index array to hold values
     m_shuffled_indices.resize(size);
 
@@ -663,7 +691,10 @@ class generic_data_reader : public lbann_image_preprocessor {
 
   void unpack_header(struct packing_header& header){
     m_current_pos = (int) header.current_pos;
+    m_fetch_pos = m_current_pos;
     m_current_mini_batch_idx = (int) header.current_mini_batch_idx;
+    m_loaded_mini_batch_idx = m_reset_mini_batch_index + m_current_mini_batch_idx * m_iteration_stride;
+    m_consumed_mini_batch_idx = m_loaded_mini_batch_idx;
   }
 
   /// returns the data store
@@ -708,6 +739,28 @@ class generic_data_reader : public lbann_image_preprocessor {
   }
   void set_gan_label_value(int gan_label_value) { m_gan_label_value = gan_label_value; }
 
+  /** If true, only the mini-batch columns that are not filled by
+   *  fetch_datum/fetch_response (i.e. the tail of a short last
+   *  mini-batch) are zeroed before fetching. This is only valid for
+   *  data readers that write every entry of the columns they fill.
+   */
+  void set_zero_fill_tail_only(bool flag) { m_zero_fill_tail_only = flag; }
+  bool get_zero_fill_tail_only() const { return m_zero_fill_tail_only; }
+  /// Number of bytes zeroed while fetching the most recent mini-batch
+  size_t get_zero_filled_bytes() const { return m_zero_filled_bytes.m_value; }
+
+  /** If positive, I/O threads fetch the samples of a mini-batch
+   *  dynamically: each thread repeatedly claims the next chunk of
+   *  this many samples until the mini-batch is exhausted. This
+   *  balances the load when samples vary in cost (e.g. images of
+   *  different sizes). If zero, samples are statically assigned to
+   *  threads in round-robin order.
+   */
+  void set_dynamic_fetch_chunk_size(int chunk_size) {
+    m_dynamic_fetch_chunk_size = std::max(chunk_size, 0);
+  }
+  int get_dynamic_fetch_chunk_size() const { return m_dynamic_fetch_chunk_size; }
+
   /// support of data store functionality
   void set_data_store(generic_data_store *g);
 
@@ -744,6 +797,11 @@ class generic_data_reader : public lbann_image_preprocessor {
   lbann_comm *m_comm;
 
   bool fetch_data_block(CPUMat& X, El::Int thread_index, El::Int mb_size, El::Matrix<El::Int>& indices_fetched);
+  /** Fetch chunks of samples until the mini-batch is exhausted.
+   *  @param next_sample  Mini-batch index of the next unclaimed
+   *                      sample; shared by all I/O threads.
+   */
+  bool fetch_data_dynamic(CPUMat& X, El::Int mb_size, El::Matrix<El::Int>& indices_fetched, std::atomic<El::Int>& next_sample);
 
   /**
    * Fetch a single sample into a matrix.
@@ -794,6 +852,9 @@ class generic_data_reader : public lbann_image_preprocessor {
 
   int m_mini_batch_size;
   int m_current_pos;
+  /// Position of the next mini-batch to be fetched; runs ahead of
+  /// m_current_pos while mini-batches are prefetched
+  int m_fetch_pos;
   /// Batch Stride is typically batch_size, but may be a multiple of batch size if there are multiple readers
   int m_stride_to_next_mini_batch;
   /// If there are multiple instances of the reader,
@@ -817,8 +878,13 @@ class generic_data_reader : public lbann_image_preprocessor {
   int m_stride_to_last_mini_batch;
   /// The index at which this data reader starts its epoch
   int m_reset_mini_batch_index;
-  /// The index of the current mini-batch that has been loaded
+  /// The index of the next mini-batch to be loaded; only used by the
+  /// thread that fetches mini-batches
   int m_loaded_mini_batch_idx;
+  /// The loaded mini-batch index of the mini-batch that is being
+  /// processed; lags m_loaded_mini_batch_idx while mini-batches are
+  /// prefetched
+  int m_consumed_mini_batch_idx;
   /// The index of the current mini-batch that is being processed (train/test/validate)
   int m_current_mini_batch_idx;
   int m_num_iterations_per_epoch; /// How many iterations all readers will execute
@@ -895,6 +961,31 @@ class generic_data_reader : public lbann_image_preprocessor {
   /// owns a unique subset of the data
   bool m_jag_partitioned;
 
+  /// if true, only zero the unfilled columns of a mini-batch
+  bool m_zero_fill_tail_only;
+  /// Byte count that is updated by the fetching thread while other
+  /// threads may read it
+  struct byte_counter {
+    std::atomic<size_t> m_value;
+    byte_counter() : m_value(0) {}
+    byte_counter(const byte_counter& other) : m_value(other.m_value.load()) {}
+    byte_counter& operator=(const byte_counter& other) {
+      m_value.store(other.m_value.load());
+      return *this;
+    }
+  };
+  /// bytes zeroed while fetching the most recent mini-batch
+  byte_counter m_zero_filled_bytes;
+
+  /// samples claimed at a time by dynamic fetching; 0 for static
+  int m_dynamic_fetch_chunk_size;
+
+  /** Zero the mini-batch matrix before fetching mb_size samples into it.
+   *  If all_columns is false and m_zero_fill_tail_only is set, only
+   *  the columns past mb_size are zeroed.
+   */
+  void zero_fill_mini_batch(CPUMat& X, El::Int mb_size, bool all_columns = false);
+
   /// called by fetch_data a single time if m_jag_partitioned = true;
   /// this sets various member variables (num_iterations, m_reset_mini_batch_index,
   /// etc.
@@ -31,6 +31,7 @@
 
 #include "data_reader.hpp"
 #include "image_preprocessor.hpp"
+#include <memory>
 #include <unordered_map>
 
 namespace lbann {
@@ -40,6 +41,10 @@ namespace lbann {
  * This will parse a header to determine how many columns of data there are, and
  * will return each row split based on a separator. This does not handle quotes
  * or escape sequences. The label column is by default converted to an integer.
+ * The file is memory-mapped and its row index is built in parallel.
+ * Optionally, the parsed file can be written to a binary cache next to
+ * the CSV file (<filename>.lbann_cache). Later runs with the same
+ * reader settings map the cache instead of parsing the CSV file.
  * @note This does not currently support comments or blank lines.
  */
 class csv_reader : public generic_data_reader {
@@ -74,6 +79,12 @@ class csv_reader : public generic_data_reader {
   void set_skip_rows(int rows) { m_skip_rows = rows; }
   /// Set whether the CSV file has a header; default true.
   void set_has_header(bool b) { m_has_header = b; }
+  /**
+   * Set whether to use a binary cache of the parsed CSV file; default
+   * false. The cache is ignored if custom transforms are set, since
+   * they cannot be checked against the cache.
+   */
+  void set_use_binary_cache(bool b) { m_use_binary_cache = b; }
 
   /**
    * Supply a custom transform to convert an input string to a numerical value.
@@ -84,6 +95,7 @@ class csv_reader : public generic_data_reader {
   void set_column_transform(int col,
                             std::function<DataType(const std::string&)> f) {
     m_col_transforms[col] = f;
+    m_custom_transforms = true;
   }
 
   /**
@@ -92,12 +104,14 @@ class csv_reader : public generic_data_reader {
    */
   void set_label_transform(std::function<int(const std::string&)> f) {
     m_label_transform = f;
+    m_custom_transforms = true;
   }
   /**
    * Supply a custom transform to convert the response column to a DataType.
    */
   void set_response_transform(std::function<DataType(const std::string&)> f) {
     m_response_transform = f;
+    m_custom_transforms = true;
   }
 
   /**
@@ -148,17 +162,42 @@ class csv_reader : public generic_data_reader {
    */
   std::vector<DataType> fetch_line(int data_id);
 
-  /// Skip rows in an ifstream.
-  void skip_rows(std::ifstream& s, int rows);
+  /**
+   * Parse the header of the CSV file to determine column information.
+   * @return Offset of the first data row within the file.
+   */
+  size_t parse_header();
+  /// Build the row index of the data rows starting at data_start.
+  void build_index(size_t data_start);
+  /**
+   * Verify every row and extract labels and responses. If features is not
+   * null, the features are also parsed into it (row-major, one row per
+   * sample).
+   */
+  void parse_rows(DataType *features = nullptr);
+  /// Parse the features of a line, skipping the label/response columns.
+  void parse_features(int data_id, DataType *out) const;
+  /// Number of features in a parsed line.
+  int get_num_features() const;
 
-  /// Initialize the ifstreams vector.
-  void setup_ifstreams();
+  /// Name of the binary cache file.
+  std::string get_cache_filename() const;
+  /// Map the binary cache file; return false if it is missing or stale.
+  bool open_cache();
+  /**
+   * Parse the CSV file rows into a new binary cache file. The row index
+   * must already be built. Return false if the file cannot be created.
+   */
+  bool write_cache();
 
   /** Return a raw line from the CSV file.
    *  (Made public to support data store functionality)
    */
   std::string fetch_raw_line(int data_id);
 
+  /// Map the CSV file into memory.
+  void map_file();
+
   /// String value that separates data.
   char m_separator = ',';
   /// Number of columns (from the left) to skip.
@@ -185,14 +224,25 @@ class csv_reader : public generic_data_reader {
   int m_num_samples = 0;
   /// Number of label classes.
   int m_num_labels = 0;
-  /// Input file streams (per-thread).
-  std::vector<std::ifstream*> m_ifstreams;
+  /// Whether to use a binary cache of the parsed CSV file.
+  bool m_use_binary_cache = false;
+  /// Whether custom column, label, or response transforms are set.
+  bool m_custom_transforms = false;
+  /// CSV file mapped into memory (shared by copies of the reader).
+  std::shared_ptr<const char> m_file;
+  /// Size of the CSV file.
+  size_t m_file_size = 0;
+  /// Binary cache file mapped into memory, if one is used.
+  std::shared_ptr<const char> m_cache;
+  /// Parsed features in the binary cache (row-major).
+  const DataType *m_cache_data = nullptr;
   /**
    * Index mapping lines (samples) to their start offset within the file.
-   * This excludes the header, but includes a final entry indicating the length
-   * of the file.
+   * This excludes the header, but includes a final entry one past the
+   * end of the last line (i.e. past its newline). Stored as long long so
+   * that it can be broadcast.
    */
-  std::vector<std::streampos> m_index;
+  std::vector<long long> m_index;
   /// Store labels.
   std::vector<int> m_labels;
   /// Store responses.
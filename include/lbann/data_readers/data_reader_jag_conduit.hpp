@@ -35,6 +35,7 @@
 #include "conduit/conduit.hpp"
 #include "hdf5.h"
 #include "lbann/data_readers/cv_process.hpp"
+#include "lbann/utils/lru_cache.hpp"
 #include <string>
 #include <set>
 #include <unordered_map>
@@ -285,7 +286,66 @@ class data_reader_jag_conduit : public generic_data_reader {
   void add_scalar_normalization_param(const linear_transform_t& t);
   void add_input_normalization_param(const linear_transform_t& t);
 
+  /**
+   * Set the number of samples of which the selected fields are kept in memory
+   * once read. The cache holds at least two mini-batches regardless.
+   */
+  void set_sample_cache_size(const size_t n);
+
  protected:
+  /**
+   * The selected fields of a sample as stored in the file, i.e., before
+   * normalization. Only the fields of the variable types in use are loaded.
+   */
+  struct sample_record {
+    /// One image per selected view
+    std::vector< std::vector<ch_t> > m_images;
+    /// Selected scalar outputs in the order of m_scalar_keys
+    std::vector<scalar_t> m_scalars;
+    /// Selected input parameters in the order of m_input_keys
+    std::vector<input_t> m_inputs;
+    /// Number of values in m_inputs up to and including each input key
+    std::vector<size_t> m_input_ends;
+    bool m_has_images = false;
+    bool m_has_scalars = false;
+    bool m_has_inputs = false;
+  };
+  using sample_record_ptr = std::shared_ptr<const sample_record>;
+
+  /// Hash of a sample locator to use it as a cache key
+  struct sample_locator_hash {
+    size_t operator()(const sample_locator_t& s) const {
+      return std::hash<std::string>()(s.first) ^ (std::hash<hid_t>()(s.second) << 1);
+    }
+  };
+  using sample_cache_t = lru_cache<sample_locator_t, sample_record_ptr, sample_locator_hash>;
+
+  /**
+   * Read the selected fields of the sample i with one read per field group:
+   * all the inputs, all the scalars, and each selected image view.
+   */
+  sample_record_ptr load_sample_record(const size_t i) const;
+  /// Return the record of the sample i, loading and caching it on a miss
+  sample_record_ptr get_sample_record(const size_t i) const;
+  /**
+   * Load the records of the samples in the upcoming mini-batch that are not
+   * cached, in the order they are stored in files, before the I/O threads
+   * start decoding them.
+   */
+  void load_mini_batch_records();
+  /// Check if a variable type is used as either independent or dependent one
+  bool uses_variable_type(const variable_t t) const;
+
+  /// Read the raw images of the sample i from its file
+  std::vector< std::vector<ch_t> > read_image_data(const size_t i) const;
+  /// Read the raw scalar outputs of the sample i from its file
+  std::vector<scalar_t> read_scalars(const size_t i) const;
+  /**
+   * Read the raw input parameters of the sample i from its file, and record
+   * the number of values read up to and including each key in 'ends'
+   */
+  std::vector<input_t> read_inputs(const size_t i, std::vector<size_t>& ends) const;
+
   virtual void set_defaults();
   virtual bool replicate_processor(const cv_process& pp, const int nthreads);
   virtual void copy_members(const data_reader_jag_conduit& rhs);
@@ -485,6 +545,14 @@ class data_reader_jag_conduit : public generic_data_reader {
   /// Shared set of the handles of open HDF5 files
   std::shared_ptr<hdf5_file_handles> m_open_hdf5_files;
 
+  /**
+   * Records of recently read samples, keyed by sample locator as sample
+   * indices change with shuffling. Shared by the I/O threads.
+   */
+  std::shared_ptr<sample_cache_t> m_sample_cache;
+  /// Requested capacity of m_sample_cache
+  size_t m_sample_cache_size;
+
   /**
    * The leading data reader among the local readers, which actually does the
    * file IO and data shuffling.
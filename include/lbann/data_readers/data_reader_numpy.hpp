@@ -31,6 +31,7 @@
 
 #include "data_reader.hpp"
 #include <cnpy.h>
+#include <memory>
 
 namespace lbann {
 
@@ -40,6 +41,9 @@ namespace lbann {
  * axes can be flattened to form a sample.
  * This supports fetching labels, but only from the last column. (This can be
  * relaxed if necessary.) Ditto responses.
+ * For .npz archives, the array with the first name (e.g. arr_0) is used.
+ * The file can be memory-mapped instead of read into memory, in which case
+ * samples are copied directly from the page cache when they are fetched.
  */
 class numpy_reader : public generic_data_reader {
  public:
@@ -60,6 +64,12 @@ class numpy_reader : public generic_data_reader {
   void set_has_labels(bool b) { m_has_labels = b; }
   /// Set whether to fetch responses.
   void set_has_responses(bool b) { m_has_responses = b; }
+  /**
+   * Set whether to memory-map the file (default false). This is supported
+   * for .npy files and for uncompressed (stored) arrays in .npz files;
+   * compressed arrays are read into memory.
+   */
+  void set_use_mmap(bool b) { m_use_mmap = b; }
 
   void load() override;
 
@@ -67,8 +77,8 @@ class numpy_reader : public generic_data_reader {
   int get_linearized_data_size() const override { return m_num_features; }
   int get_linearized_label_size() const override { return m_num_labels; }
   const std::vector<int> get_data_dims() const override {
-    std::vector<int> dims(m_data.shape.begin() + 1,
-                          m_data.shape.end());
+    std::vector<int> dims(m_shape.begin() + 1,
+                          m_shape.end());
     if (m_has_labels || m_has_responses) {
       dims.back() -= 1;
     }
@@ -80,6 +90,20 @@ class numpy_reader : public generic_data_reader {
   bool fetch_label(CPUMat& Y, int data_id, int mb_idx) override;
   bool fetch_response(CPUMat& Y, int data_id, int mb_idx) override;
 
+  /**
+   * Memory-map the array in a .npy file, or the first array in a .npz
+   * file. Return false if the array is compressed.
+   */
+  bool map_file(const std::string& filename);
+
+  /// Return a pointer to the data of a sample.
+  template <typename T>
+  const T* get_row(int data_id) const {
+    const size_t row_size = (m_num_features
+                             + (m_has_labels || m_has_responses ? 1 : 0));
+    return reinterpret_cast<const T*>(m_raw_data) + data_id * row_size;
+  }
+
   /// Number of samples.
   int m_num_samples = 0;
   /// Number of features in each sample.
@@ -90,12 +114,22 @@ class numpy_reader : public generic_data_reader {
   bool m_has_labels = true;
   /// Whether to fetch a response from the last column.
   bool m_has_responses = false;
+  /// Whether to memory-map the file.
+  bool m_use_mmap = false;
+  /// Shape of the numpy array.
+  std::vector<size_t> m_shape;
+  /// Size in bytes of an array entry.
+  size_t m_word_size = 0;
   /**
    * Underlying numpy data.
    * Note raw data is managed with shared smart pointer semantics (relevant
    * for copying).
    */
   cnpy::NpyArray m_data;
+  /// Memory-mapped file (shared by copies of the reader).
+  std::shared_ptr<const char> m_mapping;
+  /// Start of the array data, either in m_data or in m_mapping.
+  const char *m_raw_data = nullptr;
 };
 
 }  // namespace lbann
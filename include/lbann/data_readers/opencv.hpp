@@ -48,6 +48,10 @@
 #define _LBANN_CV_COLOR_     cv::IMREAD_COLOR
 #define _LBANN_CV_ANYDEPTH_  cv::IMREAD_ANYDEPTH
 #define _LBANN_CV_ANYCOLOR_  cv::IMREAD_ANYCOLOR
+#if (CV_VERSION_MAJOR > 3) || (CV_VERSION_MINOR >= 2)
+// decoders can downscale JPEG images by 1/2, 1/4, and 1/8 while decoding
+#define _LBANN_CV_REDUCED_DECODING_
+#endif
 #else
 #include <opencv2/core/core.hpp>
 #include <opencv2/core/core_c.h>
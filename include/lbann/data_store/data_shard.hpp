@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __DATA_SHARD_HPP__
+#define __DATA_SHARD_HPP__
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lbann {
+
+/**
+ * Packed shard of data store files.
+ *
+ * A shard is a single file holding the contents of many data files
+ * back to back, followed by an index of (global index, offset, size)
+ * entries and a fixed-size footer. The footer records the number of
+ * index entries, the offset of the index, and an FNV-1a checksum of
+ * the file contents, so a shard can be staged with one copy and
+ * served from one memory mapping instead of one open per file.
+ */
+
+/// writes a shard; files are appended in the order they are added
+class data_shard_writer {
+ public:
+
+  data_shard_writer(const std::string &filename);
+  data_shard_writer(const data_shard_writer&) = delete;
+  data_shard_writer& operator=(const data_shard_writer&) = delete;
+
+  /// closes the shard if close() has not been called
+  ~data_shard_writer();
+
+  /// appends the contents of a file with the given global index
+  void add(int index, const unsigned char *data, size_t sz);
+
+  /// writes the index and footer, then closes the shard
+  void close();
+
+ private :
+
+  std::string m_filename;
+  std::ofstream m_out;
+
+  /// index entries for the files added so far
+  std::vector<uint64_t> m_index;
+
+  /// number of bytes of file contents written so far
+  uint64_t m_offset;
+
+  /// running checksum of file contents
+  uint64_t m_checksum;
+};
+
+/// read-only view of a shard; the shard is mapped into memory, and
+/// file contents are returned as pointers into the mapping
+class data_shard {
+ public:
+
+  /// maps the shard and parses its index
+  data_shard(const std::string &filename);
+  data_shard(const data_shard&) = delete;
+  data_shard& operator=(const data_shard&) = delete;
+
+  ~data_shard();
+
+  /// returns true if the file with the given global index is in the shard
+  bool has(int index) const {
+    return m_entries.find(index) != m_entries.end();
+  }
+
+  /// returns a pointer to the contents of a file; throws an
+  /// exception if the file is not in the shard
+  const unsigned char * get_data(int index) const;
+
+  /// returns the number of bytes in a file; throws an exception if
+  /// the file is not in the shard
+  size_t get_size(int index) const;
+
+  /// returns the global indices of all files in the shard
+  std::vector<int> get_indices() const;
+
+  /// recomputes the checksum of the file contents, and throws an
+  /// exception if it does not match the checksum in the footer
+  void verify() const;
+
+  /// magic number at the start of the footer
+  static const uint64_t magic = 0x4452414853534450ULL;
+
+  /// footer: magic, num entries, index offset, checksum
+  static const size_t footer_size = 4*sizeof(uint64_t);
+
+ private :
+
+  std::string m_filename;
+
+  /// the mapped shard
+  const unsigned char *m_map;
+  size_t m_map_size;
+
+  /// number of bytes of file contents at the start of the shard
+  uint64_t m_data_size;
+
+  /// checksum recorded when the shard was written
+  uint64_t m_checksum;
+
+  /// maps a global index to the offset and size of a file
+  std::unordered_map<int, std::pair<uint64_t, uint64_t>> m_entries;
+};
+
+/// returns the FNV-1a checksum of data, starting from checksum h; pass
+/// the result of a previous call as h to checksum data in pieces
+uint64_t data_shard_checksum(const unsigned char *data, size_t sz,
+                             uint64_t h = 0xcbf29ce484222325ULL);
+
+}  // namespace lbann
+
+#endif  // __DATA_SHARD_HPP__
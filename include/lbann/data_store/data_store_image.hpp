@@ -29,6 +29,8 @@
 #define __DATA_STORE_IMAGE_HPP__
 
 #include "lbann/data_store/generic_data_store.hpp"
+#include "lbann/data_store/data_shard.hpp"
+#include <memory>
 #include <unordered_map>
 
 namespace lbann {
@@ -72,10 +74,6 @@ class data_store_image : public generic_data_store {
   /// fills in m_file_sizes
   virtual void get_file_sizes() = 0;
 
-  /// fills in m_file_sizes; this is called when we're using files
-  /// from a tarball
-  virtual void read_file_sizes();
-
   /// called by get_file_sizes
   void exchange_file_sizes(
     std::vector<int> &global_indices,
@@ -117,35 +115,50 @@ class data_store_image : public generic_data_store {
   /// to local store, e.g, /l/ssd
   void stage_files();
 
-  /// for out-of-memory mode: unpack files from a previously created tarball
-  void stage_tarball();
+  /// for out-of-memory mode: copy a previously created shard to local
+  /// store, e.g, /l/ssd, and map it into memory. Activated by the cmd
+  /// line options: --use_tarball=<dir>/<prefix> --num_tarballs=<int>;
+  /// the shard's checksum is verified if --verify_shards is given
+  void stage_shard();
 
   /// called by data_reader::fetch_data; supports out-of-memory mode
   void fetch_data() override;
 
-  /// creates a tarball of files written to local disk, then
-  /// copies the tarball to, e.g, lscratchX. Activated by the cmd line
-  /// options: --create_tarball <name> where <name> is the directory
-  /// to which to copy the tarball. 
-  void create_tarball();
-
-  /// returns the string that will be passed to a system call to
-  /// create the tarball on local store (/l/ssd), and string for copying
-  /// to remote store (lscratchX)
-  std::pair<std::string, std::string> get_tarball_exe();
-
-  /// called by create_tarball
-  void write_file_sizes();
-  
-  /// called by create_tarball
-  void write_datastore_indices();
-
-  void read_datastore_indices();
-
-  /// called by create_tarball
-  void write_data_filepaths();
-
-  void read_data_filepaths();
+  /// packs the files assigned to this processor into a shard, and
+  /// writes it to, e.g, lscratchX. Activated by the cmd line
+  /// option: --create_tarball=<dir>/<prefix>
+  void create_shard();
+
+  /// returns the shard filename for the given rank, for an option
+  /// of the form: <dir>/<prefix>
+  std::string get_shard_filename(const std::string &name, int rank, int np);
+
+  /// fills in m_my_datastore_indices and m_file_sizes from the index
+  /// of the staged shard
+  void read_shard_index();
+
+  /// shard staged on this node, if any; shared by copies of the data store
+  std::shared_ptr<data_shard> m_shard;
+
+  /// for in-memory mode: moves the files owned by all processors on
+  /// this node into one POSIX shared memory segment, so each file is
+  /// held once per node, and processors on the same node read each
+  /// other's files without messages. Activated by the cmd line
+  /// option: --node_shm_cache
+  void setup_node_cache();
+
+  /// node-local shared memory segment, if any; shared by copies of
+  /// the data store, and unmapped when the last copy is destroyed
+  std::shared_ptr<unsigned char> m_node_cache;
+
+  /// maps a global index to the offset of a file in m_node_cache
+  std::unordered_map<int, size_t> m_node_cache_offsets;
+
+  /// returns true if m_node_cache holds the files owned by processor p
+  bool in_node_cache(int p) const {
+    return m_node_cache != nullptr
+           && m_comm->is_rank_node_local(p, m_comm->get_model_comm());
+  }
 
   /// returns true if option: --create_tarball is in use;
   /// print info to screen, and performs error checking
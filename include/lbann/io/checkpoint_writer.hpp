@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LBANN_IO_CHECKPOINT_WRITER_HPP
+#define LBANN_IO_CHECKPOINT_WRITER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lbann {
+
+/** Background writer for asynchronous checkpoints.
+ *
+ *  Checkpoint files are staged in host memory and written to disk by
+ *  a background thread, so training only stalls for the time needed
+ *  to copy its state. Each staged file is written with a few large
+ *  writes rather than one write per matrix or scalar.
+ *
+ *  The writer owns a fixed number of staging areas (two by default,
+ *  i.e. double buffering). A new checkpoint can be staged while the
+ *  previous one drains, and only blocks if every staging area is
+ *  still being written. Staging areas keep their memory between
+ *  checkpoints.
+ */
+class checkpoint_writer {
+public:
+
+  /** Host staging area for the files of one checkpoint. */
+  class stage {
+  public:
+    /** Add a file to the stage.
+     *  @return Index of the file within the stage.
+     */
+    int add_file(const std::string& filename);
+    /** Append data to a staged file. */
+    void append(int file, const void *buf, size_t size);
+    /** Add a file that is written once all other files in the stage
+     *  are on disk, e.g. a marker for the latest checkpoint.
+     */
+    void add_completion_file(const std::string& filename,
+                             const std::string& contents);
+    /** Number of bytes staged. */
+    size_t get_size() const;
+
+  private:
+    friend class checkpoint_writer;
+
+    /** File contents staged in memory. */
+    struct staged_file {
+      std::string m_filename;
+      std::vector<char> m_data;
+    };
+
+    /** Remove all files while keeping their memory. */
+    void clear();
+
+    /** Pool of staged files.
+     *  Only the first m_num_files entries are in use.
+     */
+    std::vector<staged_file> m_files;
+    /** Number of staged files in use. */
+    size_t m_num_files = 0;
+    /** Files written after all other files. */
+    std::vector<std::pair<std::string, std::string>> m_completion_files;
+  };
+
+  /** Constructor.
+   *  @param num_stages  Number of staging areas.
+   */
+  checkpoint_writer(int num_stages = 2);
+  checkpoint_writer(const checkpoint_writer&) = delete;
+  checkpoint_writer& operator=(const checkpoint_writer&) = delete;
+  /** Destructor. Blocks until all staged checkpoints are written. */
+  ~checkpoint_writer();
+
+  /** Get an empty staging area.
+   *  Blocks until a staging area is available. Throws an exception
+   *  if a previous checkpoint failed to write.
+   */
+  stage& acquire();
+  /** Write a staging area to disk in the background.
+   *  The staging area must have been obtained with acquire.
+   */
+  void submit(stage& s);
+  /** Block until all submitted staging areas have been written.
+   *  Throws an exception if a checkpoint failed to write.
+   */
+  void wait();
+
+private:
+
+  /** Main loop for background thread. */
+  void drain_loop();
+  /** Write the files in a staging area to disk.
+   *  Returns an empty string on success and an error message
+   *  otherwise.
+   */
+  static std::string write_stage(const stage& s);
+  /** Throw an exception if a background write failed. */
+  void check_error_locked();
+
+  /** Staging areas. */
+  std::vector<std::unique_ptr<stage>> m_stages;
+  /** Staging areas available for new checkpoints. */
+  std::deque<stage*> m_free_stages;
+  /** Staging areas waiting to be written, in submission order. */
+  std::deque<stage*> m_pending_stages;
+  /** Number of staging areas being written. */
+  int m_num_writing;
+  /** Error message from a failed background write. */
+  std::string m_error;
+  /** Whether the background thread should exit. */
+  bool m_stop;
+
+  /** Mutex protecting writer state. */
+  std::mutex m_mutex;
+  /** Signaled when a staging area is submitted or the writer stops. */
+  std::condition_variable m_submitted;
+  /** Signaled when a staging area has been written. */
+  std::condition_variable m_written;
+  /** Background thread. Declared last so that it is started after
+   *  the rest of the writer is initialized.
+   */
+  std::thread m_thread;
+
+};
+
+} // namespace lbann
+
+#endif // LBANN_IO_CHECKPOINT_WRITER_HPP
@@ -108,7 +108,7 @@ public:
 
   /** Return this buffer's type, e.g: "partitioned_io_buffer," etc. */
   virtual std::string get_type() const = 0;
-  virtual void fp_setup_data(El::Int cur_mini_batch_size, int idx) = 0;
+  virtual void fp_setup_data(El::Int cur_mini_batch_size, int idx, execution_mode mode) = 0;
   virtual void setup_data(El::Int num_neurons, El::Int num_targets, El::Int max_minibatch_size) = 0;
 
   virtual int fetch_to_local_matrix(generic_data_reader *data_reader, execution_mode mode) = 0;
@@ -119,6 +119,8 @@ public:
   virtual bool is_data_fetched_in_background(execution_mode mode) = 0;
   virtual El::Matrix<El::Int>* get_sample_indices_fetched_per_mb(execution_mode mode) = 0;
   virtual int num_samples_ready(execution_mode mode) = 0;
+  /// Drop fetched samples that have not been distributed yet
+  virtual void discard_samples(execution_mode mode) = 0;
   virtual void set_data_fetch_future(std::future<void> future, execution_mode mode) = 0;
   virtual std::future<void> get_data_fetch_future(execution_mode mode) = 0;
 
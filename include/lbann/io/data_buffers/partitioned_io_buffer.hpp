@@ -90,7 +90,7 @@ class partitioned_io_buffer : public generic_io_buffer {
 
   std::string get_type() const override { return "partitioned"; }
 
-  void fp_setup_data(El::Int cur_mini_batch_size, int idx) override;
+  void fp_setup_data(El::Int cur_mini_batch_size, int idx, execution_mode mode) override;
   void setup_data(El::Int num_neurons, El::Int num_targets, El::Int max_mini_batch_size) override;
 
   int fetch_to_local_matrix(generic_data_reader *data_reader, execution_mode mode) override;
@@ -101,6 +101,7 @@ class partitioned_io_buffer : public generic_io_buffer {
   bool is_data_fetched_in_background(execution_mode mode) override;
   El::Matrix<El::Int>* get_sample_indices_fetched_per_mb(execution_mode mode) override;
   int num_samples_ready(execution_mode mode) override;
+  void discard_samples(execution_mode mode) override;
   void set_data_fetch_future(std::future<void> future, execution_mode mode) override;
   std::future<void> get_data_fetch_future(execution_mode mode) override;
 
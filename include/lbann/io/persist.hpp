@@ -30,7 +30,13 @@
 #define LBANN_PERSIST_H
 
 #include "lbann/base.hpp"
+#include "lbann/io/checkpoint_writer.hpp"
 #include "El.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace lbann {
 
@@ -58,11 +64,58 @@ class persist {
   char m_train_filename[1024];
   char m_validate_filename[1024];
   callback_type ckpt_type;
+
+  /** Whether checkpoints are written asynchronously. */
+  bool m_async;
+  /** Background writer for asynchronous checkpoints.
+   *  Created when the first asynchronous checkpoint is opened.
+   */
+  std::unique_ptr<checkpoint_writer> m_writer;
+  /** Staging area for the open asynchronous checkpoint. */
+  checkpoint_writer::stage *m_stage;
+  /** Staged files for model, train, and validate data.
+   *  Negative if the file is not being written.
+   */
+  int m_model_file;
+  int m_train_file;
+  int m_validate_file;
+  /** Files to write once the open checkpoint is closed. */
+  std::vector<std::pair<std::string, std::string>> m_completion_files;
+
+  /** Whether per-rank matrices are aggregated into one file.
+   *  Otherwise each matrix is written to its own file.
+   */
+  bool m_aggregate;
+  /** Container file for aggregated per-rank matrices. */
+  char m_container_filename[1024];
+  int m_container_fd;
+  /** Staged container file for asynchronous checkpoints. */
+  int m_container_file;
+  /** Number of bytes written to container file. */
+  uint64_t m_container_size;
+  /** Serialized index of matrices written to container file. */
+  std::vector<char> m_container_index;
+  /** Number of entries in container index. */
+  uint64_t m_container_num_entries;
+  /** Offsets of matrices in the container file being restarted
+   *  from, keyed by matrix file name.
+   */
+  std::unordered_map<std::string, uint64_t> m_container_offsets;
+  /** Container file being restarted from, mapped into memory. */
+  const char *m_container_map;
+  size_t m_container_map_size;
+  /** Size of the matrix records in the mapped container file, i.e.
+   *  the offset of its index.
+   */
+  uint64_t m_container_data_size;
+
  public:
   char m_checkpoint_dir[1024];
 
  public:
   persist();
+  persist(const persist& other);
+  persist& operator=(const persist& other);
   ~persist() {};
 
   callback_type get_cb_type() const {
@@ -73,8 +126,35 @@ class persist {
     ckpt_type = type;
   }
 
+  /** Set whether checkpoints are written asynchronously.
+   *  In asynchronous mode, checkpoint data is copied into host
+   *  staging memory and written to disk by a background thread once
+   *  the checkpoint is closed. Matrices written with write_distmat
+   *  are still written synchronously.
+   */
+  void set_async(bool async) { m_async = async; }
+  bool is_async() const { return m_async; }
+
+  /** Set whether per-rank matrices are aggregated into one file.
+   *  Matrices written with write_rank_distmat are appended to a
+   *  single container file per checkpoint directory, followed by an
+   *  index of matrix names, offsets, and dimensions. This avoids
+   *  creating a file per matrix. Restarts detect container files
+   *  automatically.
+   */
+  void set_aggregate(bool aggregate) { m_aggregate = aggregate; }
+  bool is_aggregate() const { return m_aggregate; }
+
   void open_checkpoint(const char *dir);
   void close_checkpoint();
+  /** Write a small file after the open checkpoint is complete on
+   *  disk, e.g. a marker for the latest checkpoint. Must be called
+   *  between open_checkpoint and close_checkpoint.
+   */
+  void add_completion_file(const std::string& filename,
+                           const std::string& contents);
+  /** Block until all asynchronous checkpoints are on disk. */
+  void wait_for_checkpoints();
 
   void open_restart(const char *dir);
   void close_restart();
@@ -119,6 +199,17 @@ class persist {
 
  private:
   int get_fd(persist_type type) const;
+  /** Staged file for a persist type, or -1 if there is none. */
+  int get_staged_file(persist_type type) const;
+  /** Write data to a file descriptor or staged file. */
+  void write_data(int fd, int staged_file, const char *name,
+                  const void *buf, size_t size);
+  /** Map container file and read its index, if it exists. */
+  void open_container_restart();
+  /** Unmap container file being restarted from, if any. */
+  void close_container_restart();
+  /** Write container index and close container file. */
+  void close_container_checkpoint();
 };
 
 bool write_distmat(int fd, const char *name, DistMat *M, uint64_t *bytes);
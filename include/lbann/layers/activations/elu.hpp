@@ -62,6 +62,9 @@ public:
     return desc;
   }
 
+  /** Scale parameter for negative region. */
+  DataType get_alpha() const { return m_alpha; }
+
 protected:
   void setup_dims() override {
     Layer::setup_dims();
@@ -62,6 +62,9 @@ public:
     return desc;
   }
 
+  /** Function slope in negative region. */
+  DataType get_negative_slope() const { return m_negative_slope; }
+
 protected:
   void setup_dims() override {
     Layer::setup_dims();
@@ -35,6 +35,7 @@
 #include "lbann/callbacks/callback_imcomm.hpp"
 #include "lbann/utils/omp_diagnostics.hpp"
 
+#include <deque>
 #include <future>
 
 namespace lbann {
@@ -50,14 +51,17 @@ class generic_input_layer : public io_layer {
               int num_parallel_readers,
               std::map<execution_mode, generic_data_reader *> data_readers,
               bool data_set_spans_models = true,
-              data_reader_target_mode dr_mode = data_reader_target_mode::CLASSIFICATION)
+              data_reader_target_mode dr_mode = data_reader_target_mode::CLASSIFICATION,
+              int prefetch_depth = 1)
     : io_layer(comm, data_set_spans_models, dr_mode),
       m_io_buffers(),
       m_training_dataset(),
       m_testing_dataset(),
       m_validation_dataset(),
       m_data_readers(data_readers),
-      m_data_set_processed(false) {
+      m_data_set_processed(false),
+      m_prefetch_depth(std::max(prefetch_depth, 1)),
+      m_fetch_worker_active(false) {
       //m_data_sets_span_models(data_sets_span_models) {
     // Input layers have no parents
     m_expected_num_parent_layers = 0;
@@ -103,7 +107,9 @@ class generic_input_layer : public io_layer {
       m_training_dataset(other.m_training_dataset),
       m_testing_dataset(other.m_testing_dataset),
       m_validation_dataset(other.m_validation_dataset),
-      m_data_readers(other.m_data_readers) {
+      m_data_readers(other.m_data_readers),
+      m_prefetch_depth(other.m_prefetch_depth),
+      m_fetch_worker_active(false) {
     for (auto& io_buffer : m_io_buffers) {
       io_buffer = io_buffer->copy();
     }
@@ -114,6 +120,7 @@ class generic_input_layer : public io_layer {
 
   generic_input_layer& operator=(const generic_input_layer& other) {
     io_layer::operator=(other);
+    m_prefetch_depth = other.m_prefetch_depth;
     for (auto& io_buffer : m_io_buffers) {
       io_buffer = io_buffer->copy();
     }
@@ -132,6 +139,7 @@ class generic_input_layer : public io_layer {
     auto&& desc = io_layer::get_description();
     desc.add("Buffer", m_io_buffers[0]->get_type());
     desc.add("Background I/O", this->m_model->background_io_activity_allowed());
+    desc.add("Prefetch depth", m_prefetch_depth);
     return desc;
   }
 
@@ -219,34 +227,110 @@ class generic_input_layer : public io_layer {
     this->m_model->set_effective_mini_batch_size(effective_mini_batch_size);
 
     // Initialize matrices
+    // Note: I/O buffers are sized when their mini-batch is fetched,
+    // since they may be filled several mini-batches ahead.
     io_layer::fp_setup_outputs(mini_batch_size);
-
-    for (auto& io_buffer : m_io_buffers) {
-      for (int i = 0; i < get_num_children(); ++i) {
-        io_buffer->fp_setup_data(mini_batch_size, i);
-      }
-    }
   }
 
   void fetch_data_in_background(int future_active_buffer, execution_mode mode) {
     int active_buffer = future_active_buffer % m_io_buffers.size();
     generic_io_buffer* io_buffer = m_io_buffers[active_buffer];
+    generic_data_reader* data_reader = get_data_reader(mode);
     std::lock_guard<std::mutex> guard(dr_mutex);
-    setup_next_io_buffer(io_buffer);
-    io_buffer->fetch_to_local_matrix(get_data_reader(mode), mode);
+    setup_next_io_buffer(io_buffer, mode);
+    io_buffer->fetch_to_local_matrix(data_reader, mode);
+    data_reader->advance_fetch_position();
     return;
   }
 
-  /// Check for each buffer if there is an outstanding fetch request
+  /** Queue up a background fetch of the next mini-batch into an I/O buffer.
+   *  Requests are serviced in order by a single job in the I/O thread
+   *  pool, since the data reader uses the rest of the pool to fetch
+   *  each mini-batch.
+   */
+  void queue_background_data_fetch(int future_active_buffer, execution_mode mode) {
+    generic_io_buffer* io_buffer = m_io_buffers[future_active_buffer % m_io_buffers.size()];
+    std::promise<void> fetch_done;
+    io_buffer->set_data_fetch_future(fetch_done.get_future(), mode);
+    io_buffer->set_fetch_data_in_background(true, mode);
+
+    std::lock_guard<std::mutex> guard(m_fetch_queue_mutex);
+    m_fetch_queue.emplace_back(future_active_buffer, mode, std::move(fetch_done));
+    if(!m_fetch_worker_active) {
+      m_fetch_worker_active = true;
+      this->m_model->get_io_thread_pool()->submit_job(
+        std::bind(&generic_input_layer::process_data_fetch_queue, this));
+    }
+  }
+
+  /// Fetch queued mini-batches until the queue is empty
+  void process_data_fetch_queue() {
+    while(true) {
+      data_fetch_request request;
+      {
+        std::lock_guard<std::mutex> guard(m_fetch_queue_mutex);
+        if(m_fetch_queue.empty()) {
+          m_fetch_worker_active = false;
+          return;
+        }
+        request = std::move(m_fetch_queue.front());
+        m_fetch_queue.pop_front();
+      }
+      try {
+        fetch_data_in_background(request.m_buffer_idx, request.m_mode);
+        request.m_fetch_done.set_value();
+      } catch(...) {
+        request.m_fetch_done.set_exception(std::current_exception());
+      }
+    }
+  }
+
+  /** Queue up background fetches for the mini-batches that follow the
+   *  active one, up to the prefetch depth and the end of the epoch.
+   */
+  void prefetch_data_in_background(execution_mode mode) {
+    const int active_buffer = get_active_buffer_idx(mode);
+    const int steps_left_in_epoch = get_num_iterations_per_epoch(mode) - get_current_step_in_epoch(mode);
+    const int depth = std::min(m_prefetch_depth, steps_left_in_epoch);
+    for(int i = 1; i <= depth; ++i) {
+      generic_io_buffer* next_io_buffer = m_io_buffers[(active_buffer + i) % m_io_buffers.size()];
+      if(next_io_buffer->num_samples_ready(mode) == 0 && !next_io_buffer->is_data_fetched_in_background(mode)) {
+        queue_background_data_fetch(active_buffer + i, mode);
+      }
+    }
+  }
+
+  /** Wait for each buffer's outstanding fetch request.
+   *  The fetched data stays in the buffers until it is consumed.
+   */
   void collect_background_data_fetch(execution_mode mode) {
     for(auto& io_buffer : m_io_buffers) {
       if(io_buffer->is_data_fetched_in_background(mode)) {
-        io_buffer->get_data_fetch_future(mode).get();
-        io_buffer->set_fetch_data_in_background(false, mode);
+        auto fetch_done = io_buffer->get_data_fetch_future(mode);
+        if(fetch_done.valid()) {
+          fetch_done.get();
+        }
       }
     }
   }
 
+  /** Restart the data set of an execution mode at the beginning of
+   *  its current epoch, without reshuffling it. Mini-batches already
+   *  fetched for the mode are discarded.
+   */
+  void reset_data_set(execution_mode mode) {
+    collect_background_data_fetch(mode);
+    for(auto& io_buffer : m_io_buffers) {
+      io_buffer->set_fetch_data_in_background(false, mode);
+      io_buffer->discard_samples(mode);
+    }
+    m_active_buffer[mode].store(-1);
+    generic_data_reader *data_reader = get_data_reader(mode);
+    if(data_reader != nullptr) {
+      data_reader->set_initial_position();
+    }
+  }
+
   void fp_compute() override {
     execution_mode mode = this->m_model->get_execution_mode();
 
@@ -261,15 +345,15 @@ class generic_input_layer : public io_layer {
     // If there is no valid data and there is not already a background
     // thread to fetch the data, queue up the background thread
     if(io_buffer->num_samples_ready(mode) == 0 && !io_buffer->is_data_fetched_in_background(mode)) {
-      std::future<void> background_fetch_done = this->m_model->get_io_thread_pool()->submit_job(
-        std::bind(&generic_input_layer::fetch_data_in_background, this, get_active_buffer_idx(mode), mode));
-      io_buffer->set_data_fetch_future(std::move(background_fetch_done), mode);
-      io_buffer->set_fetch_data_in_background(true, mode);
+      queue_background_data_fetch(get_active_buffer_idx(mode), mode);
     }
 
     // Wait for the background thread to complete fetching the data
     if(io_buffer->is_data_fetched_in_background(mode)) {
-      io_buffer->get_data_fetch_future(mode).get();
+      auto fetch_done = io_buffer->get_data_fetch_future(mode);
+      if(fetch_done.valid()) {
+        fetch_done.get();
+      }
       io_buffer->set_fetch_data_in_background(false, mode);
     }
 
@@ -277,7 +361,7 @@ class generic_input_layer : public io_layer {
     if(io_buffer->num_samples_ready(mode) > 0) {
       num_samples_in_batch = io_buffer->num_samples_ready(mode);
     }else {
-        if(!get_data_reader()->position_is_overrun()) {
+        if(!get_data_reader()->current_position_is_overrun()) {
           std::stringstream err;
           err << "I/O buffer does not contain valid samples ("<< num_samples_in_batch << ")";
           LBANN_ERROR(err.str());
@@ -305,22 +389,20 @@ class generic_input_layer : public io_layer {
     m_data_set_processed = io_buffer->update_data_set(get_data_reader(mode), mode);
 
     if(!m_data_set_processed && this->m_model->background_io_activity_allowed()) {
-      int next_active_buffer = get_active_buffer_idx(mode) + 1;
-      std::future<void> background_fetch_done = this->m_model->get_io_thread_pool()->submit_job(
-        std::bind(&generic_input_layer::fetch_data_in_background, this, next_active_buffer, mode));
-      generic_io_buffer* next_io_buffer = m_io_buffers[next_active_buffer % m_io_buffers.size()];
-      next_io_buffer->set_data_fetch_future(std::move(background_fetch_done), mode);
-      next_io_buffer->set_fetch_data_in_background(true, mode);
+      prefetch_data_in_background(mode);
     }
   }
 
-  void setup_next_io_buffer(generic_io_buffer* io_buffer) {
-    int mini_batch_size = get_current_mini_batch_size();
+  void setup_next_io_buffer(generic_io_buffer* io_buffer, execution_mode mode) {
+    int mini_batch_size = get_data_reader(mode)->get_fetch_mini_batch_size();
     for (int i = 0; i < get_num_children(); ++i) {
-      io_buffer->fp_setup_data(mini_batch_size, i);
+      io_buffer->fp_setup_data(mini_batch_size, i, mode);
     }
   }
 
+  /// Number of mini-batches that are fetched ahead of the current one
+  int get_prefetch_depth() const { return m_prefetch_depth; }
+
   /**
    * Once a mini-batch is processed, resuffle the data for the next batch if necessary
    */
@@ -902,6 +984,26 @@ class generic_input_layer : public io_layer {
  //  std::map<execution_mode, dataset_stats> m_dataset_stats;
   bool m_data_set_processed;
   std::mutex dr_mutex;
+
+  /** Number of mini-batches that may be fetched ahead of the current
+   *  one. One more I/O buffer than this is allocated.
+   */
+  int m_prefetch_depth;
+
+  /// Request to fetch a mini-batch into an I/O buffer
+  struct data_fetch_request {
+    data_fetch_request() = default;
+    data_fetch_request(int buffer_idx, execution_mode mode, std::promise<void> fetch_done)
+      : m_buffer_idx(buffer_idx), m_mode(mode), m_fetch_done(std::move(fetch_done)) {}
+    int m_buffer_idx;
+    execution_mode m_mode;
+    std::promise<void> m_fetch_done;
+  };
+  /// Background fetches waiting to be serviced, in mini-batch order
+  std::deque<data_fetch_request> m_fetch_queue;
+  std::mutex m_fetch_queue_mutex;
+  /// Whether a job is servicing the fetch queue
+  bool m_fetch_worker_active;
 };
 
 template<typename T> inline void generic_input_layer::initialize_io_buffer(lbann_comm *comm, int num_parallel_readers, std::map<execution_mode, generic_data_reader *> data_readers) {
@@ -46,12 +46,15 @@ class input_layer : public generic_input_layer {
   /// @todo make the map and vector references
   input_layer(lbann_comm *comm, int num_parallel_readers, std::map<execution_mode,
     generic_data_reader *> data_readers, bool data_set_spans_models = true,
-    data_reader_target_mode target_mode = data_reader_target_mode::CLASSIFICATION)
-    : generic_input_layer(comm, num_parallel_readers, data_readers, data_set_spans_models, target_mode) {
+    data_reader_target_mode target_mode = data_reader_target_mode::CLASSIFICATION,
+    int prefetch_depth = 1)
+    : generic_input_layer(comm, num_parallel_readers, data_readers, data_set_spans_models, target_mode, prefetch_depth) {
     validate_data_layout();
-    // Initialize two buffers
-    initialize_io_buffer(comm, std::min(num_parallel_readers, Layer::m_comm->get_procs_per_model()), data_readers);
-    initialize_io_buffer(comm, std::min(num_parallel_readers, Layer::m_comm->get_procs_per_model()), data_readers);
+    // Initialize a buffer for the current mini-batch and one for each
+    // prefetched mini-batch
+    for (int i = 0; i <= get_prefetch_depth(); ++i) {
+      initialize_io_buffer(comm, std::min(num_parallel_readers, Layer::m_comm->get_procs_per_model()), data_readers);
+    }
     for (auto io_buffer : m_io_buffers) {
       io_buffer->fetch_data_fn = new fetch_data_functor(target_mode);
       io_buffer->update_data_reader_fn = new update_data_reader_functor();
@@ -66,6 +66,7 @@ class lbann_callback_sync_layers;
 class Layer {
   friend class lbann_callback_sync_layers;
   friend class lbann_callback_sync_selected;
+  friend class model;
 
 public:
 
@@ -298,6 +299,29 @@ public:
   /** Get reference to LBANN communicator. */
   lbann_comm* get_comm() const { return m_comm; }
 
+  // ===========================================================
+  // Memory planning functions
+  // ===========================================================
+
+  /** Attach activation tensor to externally managed memory.
+   *  The tensor uses the buffer instead of allocating its own memory
+   *  from the next forward prop step on. 'ldim' is the leading
+   *  dimension of the local data. The buffer must be large enough for
+   *  the largest mini-batch.
+   */
+  void set_activations_buffer(int child_index, DataType* buffer, El::Int ldim);
+  /** Attach error signal tensor to externally managed memory.
+   *  The tensor uses the buffer instead of allocating its own memory
+   *  from the next backward prop step on.
+   */
+  void set_error_signals_buffer(int parent_index, DataType* buffer, El::Int ldim);
+  /** Whether an activation tensor is attached to external memory. */
+  bool has_activations_buffer(int child_index) const;
+  /** Whether an error signal tensor is attached to external memory. */
+  bool has_error_signals_buffer(int parent_index) const;
+  /** Go back to allocating memory for all tensors. */
+  void clear_tensor_buffers();
+
   // ===========================================================
   // Hint layer access functions
   // ===========================================================
@@ -399,6 +423,18 @@ protected:
    *  tensor is resized to match the mini-batch size.
    */
   virtual void bp_setup_gradient_wrt_inputs(El::Int mini_batch_size);
+  /** Allocate memory for an output tensor.
+   *  The tensor must already be empty and aligned. If external memory
+   *  has been assigned to the tensor (see set_activations_buffer), it
+   *  is attached to it and otherwise it is resized.
+   */
+  void allocate_activations(int child_index, El::Int mini_batch_size);
+  /** Allocate memory for a gradient w.r.t. input tensor.
+   *  The tensor must already be empty and aligned. If external memory
+   *  has been assigned to the tensor (see set_error_signals_buffer),
+   *  it is attached to it and otherwise it is resized.
+   */
+  void allocate_error_signals(int parent_index, El::Int mini_batch_size);
   /** Compute objective funciton gradients.
    *  Called by the 'back_prop' function. Given the input, output, and
    *  gradient w.r.t. output tensors, the gradient w.r.t. input
@@ -498,6 +534,21 @@ private:
    */
   std::vector<std::unique_ptr<AbsDistMat>> m_gradient_wrt_inputs;
 
+  /** External memory assigned to a tensor, e.g. by a memory planner
+   *  or by a child layer that aliases its input tensors. */
+  struct tensor_buffer {
+    DataType* m_data = nullptr;
+    El::Int m_ldim = 0;
+  };
+  /** Memory assigned to output tensors.
+   *  Empty or null entries allocate their own memory.
+   */
+  std::vector<tensor_buffer> m_activations_buffers;
+  /** Memory assigned to gradient w.r.t. input tensors.
+   *  Empty or null entries allocate their own memory.
+   */
+  std::vector<tensor_buffer> m_error_signals_buffers;
+
   /** Hint layer.
    *  During setup, the output tensor dimensions are set to match the
    *  first output tensor of the hint layer. Derived classes may do
@@ -38,6 +38,7 @@
 #include "lbann/utils/random.hpp"
 #include "lbann/utils/timer.hpp"
 #include "lbann/utils/im2col.hpp"
+#include "lbann/utils/direct_convolution.hpp"
 
 namespace lbann {
 
@@ -70,6 +71,18 @@ protected:
    */
   DataType m_bias_scaling_factor;
 
+  /** Number of samples lowered together in im2col GEMM algorithms.
+   *  Lowering several samples at once produces fewer, larger GEMMs
+   *  at the cost of a proportionally larger im2col workspace.
+   */
+  int m_im2col_batch_size;
+  /** Whether to use direct convolution kernels on CPU.
+   *  Direct convolution avoids the im2col workspace and is typically
+   *  faster for small kernels. Otherwise im2col GEMM algorithms are
+   *  used.
+   */
+  bool m_direct_convolution;
+
   /** Convolutional kernel gradient.
    *  This is this layer's contribution to the objective function
    *  gradient w.r.t. the convolutional kernel weights.
@@ -113,6 +126,8 @@ public:
       m_dilations(dilations),
       m_num_groups(groups),
       m_bias_scaling_factor(has_bias ? DataType(1) : DataType(0)),
+      m_im2col_batch_size(1),
+      m_direct_convolution(false),
       m_kernel_gradient(this->m_comm->get_model_grid()),
       m_bias_gradient(this->m_comm->get_model_grid())
 #ifdef LBANN_HAS_CUDNN
@@ -174,6 +189,8 @@ public:
       m_dilations(other.m_dilations),
       m_num_groups(other.m_num_groups),
       m_bias_scaling_factor(other.m_bias_scaling_factor),
+      m_im2col_batch_size(other.m_im2col_batch_size),
+      m_direct_convolution(other.m_direct_convolution),
       m_kernel_gradient(other.m_kernel_gradient),
       m_bias_gradient(other.m_bias_gradient)
 #ifdef LBANN_HAS_CUDNN
@@ -203,6 +220,8 @@ public:
     m_dilations = other.m_dilations;
     m_num_groups = other.m_num_groups;
     m_bias_scaling_factor = other.m_bias_scaling_factor;
+    m_im2col_batch_size = other.m_im2col_batch_size;
+    m_direct_convolution = other.m_direct_convolution;
     m_kernel_gradient = other.m_kernel_gradient;
     m_bias_gradient = other.m_bias_gradient;
 
@@ -235,6 +254,23 @@ public:
 #endif // LBANN_HAS_CUDNN
   }
 
+  /** Set number of samples lowered together in im2col GEMM
+   *  algorithms. Only used on CPU.
+   */
+  void set_im2col_batch_size(int batch_size) {
+    m_im2col_batch_size = std::max(batch_size, 1);
+  }
+  /** Get number of samples lowered together in im2col GEMM
+   *  algorithms.
+   */
+  int get_im2col_batch_size() const { return m_im2col_batch_size; }
+  /** Set whether to use direct convolution kernels instead of
+   *  im2col GEMM algorithms. Only used on CPU.
+   */
+  void set_direct_convolution(bool direct) { m_direct_convolution = direct; }
+  /** Whether direct convolution kernels are used on CPU. */
+  bool get_direct_convolution() const { return m_direct_convolution; }
+
   description get_description() const override {
     auto&& desc = learning_layer::get_description();
     std::stringstream ss;
@@ -755,29 +791,52 @@ protected:
     const int m = output_size / output_dims[0];
     const int n = output_dims[0];
     const int k = m_kernel_size / output_dims[0];
-    DMat<Dev> input_col, output_col;
-    DMat<Dev> im2col_matrix(k, m);
+    const El::Int batch_size = std::min(El::Int{m_im2col_batch_size},
+                                        std::max(local_width, El::Int{1}));
+    DMat<Dev> input_col, output_col, im2col_block, output_block;
+    DMat<Dev> im2col_matrix(k, m * batch_size);
+    DMat<Dev> output_batch(batch_size > 1 ? m * batch_size : 0, n);
     const DMat<Dev> kernel_matrix(k, n, local_kernel.LockedBuffer(), k);
 
-    // Iterate through input columns
-    for (El::Int col = 0; col < local_width; ++col) {
+    // Iterate through batches of input columns
+    for (El::Int first_col = 0; first_col < local_width; first_col += batch_size) {
+      const El::Int current_batch_size = std::min(batch_size,
+                                                  local_width - first_col);
 
-      // Construct im2col matrix from current input column
-      El::LockedView(input_col, local_input, El::ALL, El::IR(col));
-      im2col(input_col,
-             im2col_matrix,
-             input_dims[0],
-             input_dims.size() - 1,
-             &input_dims[1],
-             m_pads.data(),
-             &m_kernel_dims[2],
-             m_strides.data());
+      // Construct im2col matrix from current input columns
+      for (El::Int b = 0; b < current_batch_size; ++b) {
+        El::LockedView(input_col, local_input, El::ALL, El::IR(first_col + b));
+        El::View(im2col_block, im2col_matrix, El::ALL, El::IR(b * m, (b+1) * m));
+        im2col(input_col,
+               im2col_block,
+               input_dims[0],
+               input_dims.size() - 1,
+               &input_dims[1],
+               m_pads.data(),
+               &m_kernel_dims[2],
+               m_strides.data());
+      }
 
-      // Apply convolution to current input column
-      output_col.Attach(m, n, local_output.Buffer(0, col), m);
-      El::Gemm(El::TRANSPOSE, El::NORMAL,
-               DataType(1), im2col_matrix, kernel_matrix,
-               DataType(0), output_col);
+      // Apply convolution to current input columns
+      if (current_batch_size == 1) {
+        output_col.Attach(m, n, local_output.Buffer(0, first_col), m);
+        El::Gemm(El::TRANSPOSE, El::NORMAL,
+                 DataType(1), im2col_block, kernel_matrix,
+                 DataType(0), output_col);
+      } else {
+        El::View(im2col_block, im2col_matrix,
+                 El::ALL, El::IR(0, current_batch_size * m));
+        El::View(output_block, output_batch,
+                 El::IR(0, current_batch_size * m), El::ALL);
+        El::Gemm(El::TRANSPOSE, El::NORMAL,
+                 DataType(1), im2col_block, kernel_matrix,
+                 DataType(0), output_block);
+        for (El::Int b = 0; b < current_batch_size; ++b) {
+          output_col.Attach(m, n, local_output.Buffer(0, first_col + b), m);
+          El::Copy(El::LockedView(output_batch, El::IR(b * m, (b+1) * m), El::ALL),
+                   output_col);
+        }
+      }
 
     }
 
@@ -877,7 +936,6 @@ protected:
     const DMat<Dev>& local_input = get_local_prev_activations();
     const DMat<Dev>& local_gradient_wrt_output = get_local_prev_error_signals();
     auto& local_kernel_gradient = m_kernel_gradient.Matrix();
-    auto& local_bias_gradient = m_bias_gradient.Matrix();
 
     // Get convolution parameters
     const El::Int local_width = local_input.Width();
@@ -885,34 +943,10 @@ protected:
     const auto& output_dims = get_output_dims();
     const int num_input_channels = input_dims[0];
     const int num_output_channels = output_dims[0];
-    const int num_per_output_channel = get_output_size() / num_output_channels;
     const int effective_mini_batch_size = this->m_model->get_effective_mini_batch_size();
 
     // Compute bias gradient
-    // Note: Sum is computed with Kahan summation
-    optimizer* bias_optimizer = this->m_weights[1]->get_optimizer();
-    if (m_bias_scaling_factor != DataType(0) && bias_optimizer != nullptr) {
-      LBANN_OMP_PARALLEL_FOR
-      for (int channel = 0; channel < num_output_channels; ++channel) {
-        const El::Int row_start = channel * num_per_output_channel;
-        const El::Int row_end = (channel+1) * num_per_output_channel;
-        DataType sum = 0;
-        DataType correction = 0;
-        for (El::Int col = 0; col < local_width; ++col) {
-          for (El::Int row = row_start; row < row_end; ++row) {
-            DataType term = local_gradient_wrt_output(row, col);
-            term += correction;
-            const DataType next_sum = sum + term;
-            correction = term - (next_sum - sum);
-            sum = next_sum;
-          }
-        }
-        local_bias_gradient(channel, 0) = m_bias_scaling_factor * sum;
-      }
-      const DataType bias_scale = m_bias_scaling_factor / effective_mini_batch_size;
-      bias_optimizer->add_to_gradient_staging(m_bias_gradient,
-                                              bias_scale);
-    }
+    compute_bias_gradient_cpu();
 
     // Stop early if kernel is not being optimized
     optimizer* kernel_optimizer = this->m_weights[0]->get_optimizer();
@@ -928,42 +962,61 @@ protected:
     const int k = (using_transposed_convolution ?
                    get_input_size() / num_input_channels :
                    get_output_size() / num_output_channels);
-    DMat<Dev> im2col_matrix(m, k);
+    const El::Int batch_size = std::min(El::Int{m_im2col_batch_size},
+                                        std::max(local_width, El::Int{1}));
+    DMat<Dev> im2col_block, stacked_block;
+    DMat<Dev> im2col_matrix(m, k * batch_size);
+    DMat<Dev> stacked_matrix(batch_size > 1 ? k * batch_size : 0, n);
     DMat<Dev> kernel_gradient_matrix(m, n, local_kernel_gradient.Buffer(), m);
     El::Zero(kernel_gradient_matrix);
 
-    // Compute kernel gradient contributions from each data sample
-    for (El::Int col = 0; col < local_width; ++col) {
-      if (using_transposed_convolution) {
-        const DMat<Dev> input_col(k, n, local_input.LockedBuffer(0,col), k);
-        const DMat<Dev> gradient_wrt_output_col =
-          El::LockedView(local_gradient_wrt_output, El::ALL, El::IR(col));
-        im2col(gradient_wrt_output_col,
-               im2col_matrix,
-               num_output_channels,
-               output_dims.size() - 1,
-               &output_dims[1],
+    // The im2col matrix is constructed from one tensor and multiplied
+    // with the other
+    const auto& im2col_source = (using_transposed_convolution ?
+                                 local_gradient_wrt_output :
+                                 local_input);
+    const auto& gemm_source = (using_transposed_convolution ?
+                               local_input :
+                               local_gradient_wrt_output);
+    const auto& im2col_dims = (using_transposed_convolution ?
+                               output_dims :
+                               input_dims);
+
+    // Compute kernel gradient contributions from batches of data
+    // samples
+    for (El::Int first_col = 0; first_col < local_width; first_col += batch_size) {
+      const El::Int current_batch_size = std::min(batch_size,
+                                                  local_width - first_col);
+      for (El::Int b = 0; b < current_batch_size; ++b) {
+        const El::Int col = first_col + b;
+        const DMat<Dev> im2col_source_col
+          = El::LockedView(im2col_source, El::ALL, El::IR(col));
+        const DMat<Dev> gemm_source_col(k, n, gemm_source.LockedBuffer(0,col), k);
+        El::View(im2col_block, im2col_matrix, El::ALL, El::IR(b * k, (b+1) * k));
+        im2col(im2col_source_col,
+               im2col_block,
+               im2col_dims[0],
+               im2col_dims.size() - 1,
+               &im2col_dims[1],
                m_pads.data(),
                &m_kernel_dims[2],
                m_strides.data());
-        El::Gemm(El::NORMAL, El::NORMAL,
-                 DataType(1), im2col_matrix, input_col,
-                 DataType(1), kernel_gradient_matrix);
+        if (current_batch_size == 1) {
+          El::Gemm(El::NORMAL, El::NORMAL,
+                   DataType(1), im2col_block, gemm_source_col,
+                   DataType(1), kernel_gradient_matrix);
+        } else {
+          El::View(stacked_block, stacked_matrix, El::IR(b * k, (b+1) * k), El::ALL);
+          El::Copy(gemm_source_col, stacked_block);
+        }
       }
-      else {
-        const DMat<Dev> input_col
-          = El::LockedView(local_input, El::ALL, El::IR(col));
-        const DMat<Dev> gradient_wrt_output_col(k, n, local_gradient_wrt_output.LockedBuffer(0,col), k);
-        im2col(input_col,
-               im2col_matrix,
-               num_input_channels,
-               input_dims.size() - 1,
-               &input_dims[1],
-               m_pads.data(),
-               &m_kernel_dims[2],
-               m_strides.data());
+      if (current_batch_size > 1) {
+        El::View(im2col_block, im2col_matrix,
+                 El::ALL, El::IR(0, current_batch_size * k));
+        El::View(stacked_block, stacked_matrix,
+                 El::IR(0, current_batch_size * k), El::ALL);
         El::Gemm(El::NORMAL, El::NORMAL,
-                 DataType(1), im2col_matrix, gradient_wrt_output_col,
+                 DataType(1), im2col_block, stacked_block,
                  DataType(1), kernel_gradient_matrix);
       }
     }
@@ -975,6 +1028,185 @@ protected:
 
   }
 
+  /** Compute bias gradient on CPU. */
+  void compute_bias_gradient_cpu() {
+
+    // Return immediately if bias is not being optimized
+    optimizer* bias_optimizer = this->m_weights[1]->get_optimizer();
+    if (m_bias_scaling_factor == DataType(0) || bias_optimizer == nullptr) {
+      return;
+    }
+
+    // Local matrices
+    const DMat<Dev>& local_gradient_wrt_output = get_local_prev_error_signals();
+    auto& local_bias_gradient = m_bias_gradient.Matrix();
+
+    // Matrix parameters
+    const El::Int local_width = local_gradient_wrt_output.Width();
+    const int num_output_channels = get_output_dims()[0];
+    const int num_per_output_channel = get_output_size() / num_output_channels;
+    const int effective_mini_batch_size = this->m_model->get_effective_mini_batch_size();
+
+    // Compute bias gradient
+    // Note: Sum is computed with Kahan summation
+    LBANN_OMP_PARALLEL_FOR
+    for (int channel = 0; channel < num_output_channels; ++channel) {
+      const El::Int row_start = channel * num_per_output_channel;
+      const El::Int row_end = (channel+1) * num_per_output_channel;
+      DataType sum = 0;
+      DataType correction = 0;
+      for (El::Int col = 0; col < local_width; ++col) {
+        for (El::Int row = row_start; row < row_end; ++row) {
+          DataType term = local_gradient_wrt_output(row, col);
+          term += correction;
+          const DataType next_sum = sum + term;
+          correction = term - (next_sum - sum);
+          sum = next_sum;
+        }
+      }
+      local_bias_gradient(channel, 0) = m_bias_scaling_factor * sum;
+    }
+    const DataType bias_scale = m_bias_scaling_factor / effective_mini_batch_size;
+    bias_optimizer->add_to_gradient_staging(m_bias_gradient,
+                                            bias_scale);
+
+  }
+
+  /** Convolution with direct algorithm. */
+  void apply_convolution_direct(bool during_forward_prop) {
+
+    // Local matrices
+    const auto& local_kernel = this->m_weights[0]->get_values().LockedMatrix();
+    const auto& local_input = (during_forward_prop ?
+                               get_local_prev_activations() :
+                               get_local_prev_error_signals());
+    auto& local_output = (during_forward_prop ?
+                          get_local_activations() :
+                          get_local_error_signals());
+
+    // Tensor dimensions
+    std::vector<int> input_dims, output_dims;
+    if (during_forward_prop) {
+      input_dims = get_input_dims();
+      output_dims = get_output_dims();
+    }
+    else {
+      input_dims = get_output_dims();
+      output_dims = get_input_dims();
+    }
+
+    // Apply convolution
+    direct_convolution_forward(local_input.LockedBuffer(),
+                               local_input.LDim(),
+                               local_kernel.LockedBuffer(),
+                               local_output.Buffer(),
+                               local_output.LDim(),
+                               local_input.Width(),
+                               input_dims[0],
+                               output_dims[0],
+                               input_dims.size() - 1,
+                               &input_dims[1],
+                               &output_dims[1],
+                               &m_kernel_dims[2],
+                               m_pads.data(),
+                               m_strides.data());
+
+  }
+
+  /** Transposed convolution with direct algorithm. */
+  void apply_transposed_convolution_direct(bool during_forward_prop) {
+
+    // Local matrices
+    const auto& local_kernel = this->m_weights[0]->get_values().LockedMatrix();
+    const auto& local_input = (during_forward_prop ?
+                               get_local_prev_activations() :
+                               get_local_prev_error_signals());
+    auto& local_output = (during_forward_prop ?
+                          get_local_activations() :
+                          get_local_error_signals());
+
+    // Tensor dimensions
+    std::vector<int> input_dims, output_dims;
+    if (during_forward_prop) {
+      input_dims = get_input_dims();
+      output_dims = get_output_dims();
+    }
+    else {
+      input_dims = get_output_dims();
+      output_dims = get_input_dims();
+    }
+
+    // Apply transposed convolution, i.e. the input gradient of a
+    // convolution from the output tensor to the input tensor
+    direct_convolution_backward_data(local_input.LockedBuffer(),
+                                     local_input.LDim(),
+                                     local_kernel.LockedBuffer(),
+                                     local_output.Buffer(),
+                                     local_output.LDim(),
+                                     local_input.Width(),
+                                     output_dims[0],
+                                     input_dims[0],
+                                     output_dims.size() - 1,
+                                     &output_dims[1],
+                                     &input_dims[1],
+                                     &m_kernel_dims[2],
+                                     m_pads.data(),
+                                     m_strides.data());
+
+  }
+
+  void compute_gradients_direct(bool using_transposed_convolution) {
+
+    // Compute bias gradient
+    compute_bias_gradient_cpu();
+
+    // Stop early if kernel is not being optimized
+    optimizer* kernel_optimizer = this->m_weights[0]->get_optimizer();
+    if (kernel_optimizer == nullptr) { return; }
+
+    // Local matrices
+    const DMat<Dev>& local_input = get_local_prev_activations();
+    const DMat<Dev>& local_gradient_wrt_output = get_local_prev_error_signals();
+    auto& local_kernel_gradient = m_kernel_gradient.Matrix();
+
+    // The kernel gradient is the correlation of the tensor with the
+    // convolution's input dimensions and the tensor with the
+    // convolution's output dimensions
+    const auto& conv_input = (using_transposed_convolution ?
+                              local_gradient_wrt_output :
+                              local_input);
+    const auto& conv_output = (using_transposed_convolution ?
+                               local_input :
+                               local_gradient_wrt_output);
+    const auto& conv_input_dims = (using_transposed_convolution ?
+                                   get_output_dims() :
+                                   get_input_dims());
+    const auto& conv_output_dims = (using_transposed_convolution ?
+                                    get_input_dims() :
+                                    get_output_dims());
+    direct_convolution_backward_filter(conv_input.LockedBuffer(),
+                                       conv_input.LDim(),
+                                       conv_output.LockedBuffer(),
+                                       conv_output.LDim(),
+                                       local_kernel_gradient.Buffer(),
+                                       local_input.Width(),
+                                       conv_input_dims[0],
+                                       conv_output_dims[0],
+                                       conv_input_dims.size() - 1,
+                                       &conv_input_dims[1],
+                                       &conv_output_dims[1],
+                                       &m_kernel_dims[2],
+                                       m_pads.data(),
+                                       m_strides.data());
+
+    // Scale and accumulate gradients
+    const int effective_mini_batch_size = this->m_model->get_effective_mini_batch_size();
+    const DataType kernel_scale = DataType(1) / effective_mini_batch_size;
+    kernel_optimizer->add_to_gradient_staging(m_kernel_gradient,
+                                              kernel_scale);
+
+  }
+
 private:
 
 #ifdef LBANN_HAS_CUDNN
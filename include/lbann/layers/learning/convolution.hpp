@@ -170,7 +170,11 @@ protected:
       base_convolution_layer<Dev>::apply_convolution_cudnn(true);
       base_convolution_layer<Dev>::apply_bias_cudnn();
     } else {
-      base_convolution_layer<Dev>::apply_convolution_im2col(true);
+      if (this->m_direct_convolution) {
+        base_convolution_layer<Dev>::apply_convolution_direct(true);
+      } else {
+        base_convolution_layer<Dev>::apply_convolution_im2col(true);
+      }
       base_convolution_layer<Dev>::apply_bias_cpu();
     }
   }
@@ -180,8 +184,13 @@ protected:
       base_convolution_layer<Dev>::compute_gradients_cudnn(false);
       base_convolution_layer<Dev>::apply_transposed_convolution_cudnn(false);
     } else {
-      base_convolution_layer<Dev>::compute_gradients_im2col(false);
-      base_convolution_layer<Dev>::apply_transposed_convolution_im2col(false);
+      if (this->m_direct_convolution) {
+        base_convolution_layer<Dev>::compute_gradients_direct(false);
+        base_convolution_layer<Dev>::apply_transposed_convolution_direct(false);
+      } else {
+        base_convolution_layer<Dev>::compute_gradients_im2col(false);
+        base_convolution_layer<Dev>::apply_transposed_convolution_im2col(false);
+      }
     }
   }
 
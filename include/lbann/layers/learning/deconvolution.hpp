@@ -192,7 +192,11 @@ protected:
       base_convolution_layer<Dev>::apply_transposed_convolution_cudnn(true);
       base_convolution_layer<Dev>::apply_bias_cudnn();
     } else {
-      base_convolution_layer<Dev>::apply_transposed_convolution_im2col(true);
+      if (this->m_direct_convolution) {
+        base_convolution_layer<Dev>::apply_transposed_convolution_direct(true);
+      } else {
+        base_convolution_layer<Dev>::apply_transposed_convolution_im2col(true);
+      }
       base_convolution_layer<Dev>::apply_bias_cpu();
     }
   }
@@ -202,8 +206,13 @@ protected:
       base_convolution_layer<Dev>::compute_gradients_cudnn(true);
       base_convolution_layer<Dev>::apply_convolution_cudnn(false);
     } else {
-      base_convolution_layer<Dev>::compute_gradients_im2col(true);
-      base_convolution_layer<Dev>::apply_convolution_im2col(false);
+      if (this->m_direct_convolution) {
+        base_convolution_layer<Dev>::compute_gradients_direct(true);
+        base_convolution_layer<Dev>::apply_convolution_direct(false);
+      } else {
+        base_convolution_layer<Dev>::compute_gradients_im2col(true);
+        base_convolution_layer<Dev>::apply_convolution_im2col(false);
+      }
     }
   }
 
@@ -66,6 +66,11 @@ public:
     return desc;
   }
 
+  /** Minimum output. */
+  DataType get_min() const { return m_min; }
+  /** Maximum output. */
+  DataType get_max() const { return m_max; }
+
 protected:
   void setup_dims() override {
     Layer::setup_dims();
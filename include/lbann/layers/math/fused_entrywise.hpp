@@ -0,0 +1,281 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LBANN_LAYERS_MATH_FUSED_ENTRYWISE_HPP_INCLUDED
+#define LBANN_LAYERS_MATH_FUSED_ENTRYWISE_HPP_INCLUDED
+
+#include "lbann/layers/layer.hpp"
+#include <array>
+
+namespace lbann {
+
+/** @brief Entry-wise operation of a layer that can be fused.
+ *
+ *  A stage applies a unary operation to the output of the previous
+ *  stage or a binary operation to the output of the previous stage
+ *  and an additional input tensor. Kernels operate on contiguous
+ *  arrays and unused arguments are ignored, e.g. the second operand
+ *  of a unary stage.
+ */
+struct entrywise_stage {
+
+  /** Forward prop kernel.
+   *  Computes @f$ y = f(x_1,x_2) @f$. @f$ y @f$ may alias an
+   *  operand.
+   */
+  using fp_kernel = void (*)(const DataType* params,
+                             const DataType* x1,
+                             const DataType* x2,
+                             DataType* y,
+                             El::Int size);
+  /** Backprop kernel.
+   *  Computes @f$ dL/dx_1 @f$ and @f$ dL/dx_2 @f$ from
+   *  @f$ dL/dy @f$. Gradients must not alias the inputs.
+   */
+  using bp_kernel = void (*)(const DataType* params,
+                             const DataType* x1,
+                             const DataType* x2,
+                             const DataType* dy,
+                             DataType* dx1,
+                             DataType* dx2,
+                             El::Int size);
+
+  /** Name of the original layer. */
+  std::string m_name;
+  /** Type of the original layer. */
+  std::string m_type;
+  /** Number of operands (1 or 2). */
+  int m_num_operands = 1;
+  /** Layer parameters, e.g. clamp bounds. */
+  std::array<DataType,2> m_params = {{DataType(0), DataType(0)}};
+  fp_kernel m_fp = nullptr;
+  bp_kernel m_bp = nullptr;
+
+  /** Operand that receives the output of the previous stage. */
+  int m_chain_operand = 0;
+  /** Fused layer input that provides the other operand of a binary
+   *  stage.
+   */
+  int m_external_input = -1;
+
+};
+
+/** @brief Chain of entry-wise layers evaluated in one sweep.
+ *
+ *  Sequences of entry-wise layers (e.g. clamp, then exp, then
+ *  multiply by a mask) each read and write a full tensor and keep
+ *  their outputs around for backprop, so they are limited by memory
+ *  bandwidth. This layer replaces such a chain (see
+ *  model::set_fuse_entrywise_layers). Its local data is processed in
+ *  tiles that fit in cache and all stages are applied to a tile
+ *  before moving to the next one. Only the input tensors of the chain
+ *  are kept for backprop. Intermediate values are recomputed tile by
+ *  tile during backprop, which is cheap compared to the memory
+ *  traffic it avoids.
+ *
+ *  The first input is the input of the first stage. Additional
+ *  inputs are the second operands of binary stages.
+ */
+template <data_layout Layout, El::Device Device>
+class fused_entrywise_layer : public Layer {
+public:
+
+  fused_entrywise_layer(lbann_comm *comm,
+                        std::vector<entrywise_stage> stages)
+    : Layer(comm), m_stages(std::move(stages)) {
+    if (m_stages.empty()) {
+      LBANN_ERROR("attempted to construct fused entry-wise layer "
+                  "with no stages");
+    }
+    this->m_expected_num_parent_layers = -1; // No limit on parents
+  }
+  fused_entrywise_layer* copy() const override {
+    return new fused_entrywise_layer(*this);
+  }
+  std::string get_type() const override { return "fused entry-wise"; }
+  data_layout get_data_layout() const override { return Layout; }
+  El::Device get_device_allocation() const override { return Device; }
+
+  description get_description() const override {
+    auto&& desc = Layer::get_description();
+    std::stringstream ss;
+    for (size_t i = 0; i < m_stages.size(); ++i) {
+      ss << (i > 0 ? ", " : "")
+         << m_stages[i].m_name << " (" << m_stages[i].m_type << ")";
+    }
+    desc.add("Fused layers", ss.str());
+    return desc;
+  }
+
+  /** Fused stages in execution order. */
+  const std::vector<entrywise_stage>& get_stages() const { return m_stages; }
+
+protected:
+
+  void setup_dims() override {
+    Layer::setup_dims();
+    set_output_dims(get_input_dims());
+
+    // Check that input dimensions match
+    for (int i = 1; i < get_num_parents(); ++i) {
+      if (get_input_dims(i) != get_input_dims(0)) {
+        const auto& parents = get_parent_layers();
+        std::stringstream err;
+        err << get_type() << " layer \"" << get_name() << "\" "
+            << "has input tensors with different dimensions "
+            << "(layer \"" << parents[0]->get_name() << "\" outputs "
+            << get_input_size(0) << " entries, "
+            << "layer \"" << parents[i]->get_name() << "\" outputs "
+            << get_input_size(i) << " entries)";
+        LBANN_ERROR(err.str());
+      }
+    }
+
+  }
+
+  void fp_compute() override;
+  void bp_compute() override;
+
+private:
+
+  /** Fused stages in execution order. */
+  std::vector<entrywise_stage> m_stages;
+  /** Per-thread workspace for recomputed values during backprop. */
+  std::vector<DataType> m_workspace;
+
+};
+
+/** Construct the fused stage for a CPU entry-wise layer.
+ *  Returns false if the layer cannot be fused.
+ */
+bool get_entrywise_stage(const Layer& l, entrywise_stage& stage);
+
+// Stage lookup for each family of entry-wise layers. These are
+// defined alongside the layers' operators.
+bool get_unary_entrywise_stage(const Layer& l, entrywise_stage& stage);
+bool get_binary_entrywise_stage(const Layer& l, entrywise_stage& stage);
+bool get_activation_entrywise_stage(const Layer& l, entrywise_stage& stage);
+bool get_clamp_entrywise_stage(const Layer& l, entrywise_stage& stage);
+bool get_elu_entrywise_stage(const Layer& l, entrywise_stage& stage);
+bool get_leaky_relu_entrywise_stage(const Layer& l, entrywise_stage& stage);
+
+/** Whether a layer is a CPU instance of a layer class template. */
+template <template <data_layout, El::Device> class LayerType>
+bool is_cpu_instance(const Layer& l) {
+  using dp_layer = LayerType<data_layout::DATA_PARALLEL, El::Device::CPU>;
+  using mp_layer = LayerType<data_layout::MODEL_PARALLEL, El::Device::CPU>;
+  return (dynamic_cast<const dp_layer*>(&l) != nullptr
+          || dynamic_cast<const mp_layer*>(&l) != nullptr);
+}
+
+/** Forward prop kernel for an entry-wise unary operator. */
+template <typename UnaryOperator>
+void entrywise_unary_fp_kernel(const DataType*,
+                               const DataType* x,
+                               const DataType*,
+                               DataType* y,
+                               El::Int size) {
+  UnaryOperator op;
+  for (El::Int i = 0; i < size; ++i) {
+    y[i] = op(x[i]);
+  }
+}
+
+/** Backprop kernel for an entry-wise unary operator.
+ *  The operator's binary form computes @f$ dL/dx @f$.
+ */
+template <typename UnaryOperator>
+void entrywise_unary_bp_kernel(const DataType*,
+                               const DataType* x,
+                               const DataType*,
+                               const DataType* dy,
+                               DataType* dx,
+                               DataType*,
+                               El::Int size) {
+  UnaryOperator op;
+  for (El::Int i = 0; i < size; ++i) {
+    dx[i] = op(x[i], dy[i]);
+  }
+}
+
+/** Forward prop kernel for an entry-wise binary operator. */
+template <typename BinaryOperator>
+void entrywise_binary_fp_kernel(const DataType*,
+                                const DataType* x1,
+                                const DataType* x2,
+                                DataType* y,
+                                El::Int size) {
+  BinaryOperator op;
+  for (El::Int i = 0; i < size; ++i) {
+    y[i] = op(x1[i], x2[i]);
+  }
+}
+
+/** Backprop kernel for an entry-wise binary operator.
+ *  The operator's 5-ary form computes @f$ dL/dx_1 @f$ and
+ *  @f$ dL/dx_2 @f$.
+ */
+template <typename BinaryOperator>
+void entrywise_binary_bp_kernel(const DataType*,
+                                const DataType* x1,
+                                const DataType* x2,
+                                const DataType* dy,
+                                DataType* dx1,
+                                DataType* dx2,
+                                El::Int size) {
+  BinaryOperator op;
+  for (El::Int i = 0; i < size; ++i) {
+    op(x1[i], x2[i], dy[i], dx1[i], dx2[i]);
+  }
+}
+
+/** Construct the stage for an entry-wise unary operator. */
+template <typename UnaryOperator>
+entrywise_stage make_unary_entrywise_stage(const Layer& l) {
+  entrywise_stage stage;
+  stage.m_name = l.get_name();
+  stage.m_type = l.get_type();
+  stage.m_num_operands = 1;
+  stage.m_fp = &entrywise_unary_fp_kernel<UnaryOperator>;
+  stage.m_bp = &entrywise_unary_bp_kernel<UnaryOperator>;
+  return stage;
+}
+
+/** Construct the stage for an entry-wise binary operator. */
+template <typename BinaryOperator>
+entrywise_stage make_binary_entrywise_stage(const Layer& l) {
+  entrywise_stage stage;
+  stage.m_name = l.get_name();
+  stage.m_type = l.get_type();
+  stage.m_num_operands = 2;
+  stage.m_fp = &entrywise_binary_fp_kernel<BinaryOperator>;
+  stage.m_bp = &entrywise_binary_bp_kernel<BinaryOperator>;
+  return stage;
+}
+
+} // namespace lbann
+
+#endif // LBANN_LAYERS_MATH_FUSED_ENTRYWISE_HPP_INCLUDED
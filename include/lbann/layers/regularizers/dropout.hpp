@@ -29,6 +29,8 @@
 
 #include "lbann/layers/regularizers/regularizer.hpp"
 #include "lbann/utils/cudnn.hpp"
+#include "lbann/utils/random.hpp"
+#include <limits>
 
 namespace lbann {
 
@@ -42,6 +44,12 @@ namespace lbann {
  *  Sutskever, and Ruslan Salakhutdinov. "Dropout: a simple way to
  *  prevent neural networks from overfitting." The Journal of Machine
  *  Learning Research 15, no. 1 (2014): 1929-1958.
+ *
+ *  On CPU, the dropout mask is generated with a counter-based random
+ *  number generator from the random seed, the training step, the
+ *  layer name, and the global index of each entry. It is applied as
+ *  it is generated and regenerated in backprop, so it is never
+ *  stored and does not depend on the data distribution.
  */
 template <data_layout T_layout, El::Device Dev>
 class dropout : public regularizer_layer {
@@ -67,8 +75,7 @@ public:
 
   dropout(const dropout& other)
     : regularizer_layer(other),
-      m_keep_prob(other.m_keep_prob),
-      m_mask(other.m_mask ? other.m_mask->Copy() : nullptr)
+      m_keep_prob(other.m_keep_prob)
 #ifdef LBANN_HAS_CUDNN
     , m_dropout_cudnn_desc(nullptr),
       m_tensors_cudnn_desc(other.m_tensors_cudnn_desc)
@@ -87,7 +94,6 @@ public:
   dropout& operator=(const dropout& other) {
     regularizer_layer::operator=(other);
     m_keep_prob = other.m_keep_prob;
-    m_mask = other.m_mask ? other.m_mask->Copy() : nullptr;
 #ifdef LBANN_HAS_CUDNN
     m_tensors_cudnn_desc = other.m_tensors_cudnn_desc;
     m_tensors_cudnn_desc.set_layer(this);
@@ -129,11 +135,6 @@ protected:
     set_output_dims(get_input_dims());
   }
 
-  void setup_matrices(const El::Grid& grid) override {
-    regularizer_layer::setup_matrices(grid);
-    m_mask = std::unique_ptr<AbsDistMat>(get_activations().Copy());
-  }
-
   void setup_gpu() override {
     regularizer_layer::setup_gpu();
 #ifndef LBANN_HAS_CUDNN
@@ -177,26 +178,8 @@ protected:
       return;
     }
 
-    // Construct mask matrix
-    const DataType scale = 1 / m_keep_prob;
-    const auto& height = input.Height();
-    const auto& width = input.Width();
-    m_mask->Resize(height, width);
-#ifdef LBANN_DETERMINISTIC
-    bernoulli_fill_procdet(*m_mask, height, width, DataType(m_keep_prob));
-    *m_mask *= scale;
-#else
-    El::EntrywiseMap(*m_mask,
-                     (std::function<DataType(const DataType&)>)
-                     ([this,scale](const DataType& z)->DataType {
-                       auto& gen = get_fast_generator();
-                       std::bernoulli_distribution dist(m_keep_prob);
-                       return dist(gen) ? scale : DataType(0);
-                     }));
-#endif // LBANN_DETERMINISTIC
-
-    // Apply mask matrix to get activations
-    El::Hadamard(input, *m_mask, output);
+    // Apply dropout mask
+    apply_mask_cpu(input, output);
 
   }
 
@@ -208,8 +191,55 @@ protected:
     if (mode != execution_mode::training || m_keep_prob < EvalType(0)) {
       El::Copy(gradient_wrt_output, gradient_wrt_input);
     } else {
-      El::Hadamard(gradient_wrt_output, *m_mask, gradient_wrt_input);
+      apply_mask_cpu(gradient_wrt_output, gradient_wrt_input);
+    }
+  }
+
+  /** Multiply a matrix by the dropout mask.
+   *  The mask is generated on the fly, so forward prop and backprop
+   *  in the same training step apply the same mask.
+   */
+  void apply_mask_cpu(const AbsDistMat& input, AbsDistMat& output) {
+
+    // Random number generator for current step
+    const counter_rng rng(get_counter_rng_seed(),
+                          get_counter_rng_stream(get_name()));
+    const uint64_t step = this->m_model->get_cur_step();
+    const uint64_t threshold = counter_rng::bernoulli_threshold(m_keep_prob);
+    const DataType scale = 1 / m_keep_prob;
+
+    // Local matrices
+    const DataType* __restrict__ input_buffer = input.LockedBuffer();
+    const El::Int input_ldim = input.LDim();
+    DataType* __restrict__ output_buffer = output.Buffer();
+    const El::Int output_ldim = output.LDim();
+    const El::Int height = input.Height();
+    const El::Int local_height = input.LocalHeight();
+    const El::Int local_width = input.LocalWidth();
+    const El::Int col_shift = input.ColShift();
+    const El::Int col_stride = input.ColStride();
+    const El::Int row_shift = input.RowShift();
+    const El::Int row_stride = input.RowStride();
+
+    // Each block of random numbers covers four consecutive entries
+    LBANN_OMP_PARALLEL_FOR
+    for (El::Int col = 0; col < local_width; ++col) {
+      const uint64_t global_col = row_shift + col * row_stride;
+      uint64_t block = std::numeric_limits<uint64_t>::max();
+      counter_rng::result_type r;
+      for (El::Int row = 0; row < local_height; ++row) {
+        const uint64_t global_row = col_shift + row * col_stride;
+        const uint64_t index = global_row + global_col * height;
+        if (index / 4 != block) {
+          block = index / 4;
+          r = rng(step, block);
+        }
+        const DataType x = input_buffer[row + col * input_ldim];
+        output_buffer[row + col * output_ldim] = (r[index % 4] < threshold ?
+                                                  x * scale : DataType(0));
+      }
     }
+
   }
 
   void fp_compute_gpu() {
@@ -312,8 +342,6 @@ protected:
 
   /** Probability of keeping each unit. */
   EvalType m_keep_prob;
-  /** Current dropout mask (a scaled Bernoulli random matrix). */
-  std::unique_ptr<AbsDistMat> m_mask;
 
 #ifdef LBANN_HAS_CUDNN
   /** Dropout cuDNN descriptor. */
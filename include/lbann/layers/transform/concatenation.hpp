@@ -45,9 +45,12 @@ public:
   concatenation_layer(const concatenation_layer& other)
     : transform_layer(other),
       m_concat_dim(other.m_concat_dim),
-      m_concat_points(other.m_concat_points) {
+      m_concat_points(other.m_concat_points),
+      m_alias_inputs(false) {
     m_input_v.reset(other.m_input_v ? other.m_input_v->Copy() : nullptr);
     m_output_v.reset(other.m_output_v ? other.m_output_v->Copy() : nullptr);
+    m_output_storage.reset(other.m_output_storage ?
+                           other.m_output_storage->Copy() : nullptr);
   }
 
   concatenation_layer& operator=(const concatenation_layer& other) {
@@ -56,6 +59,9 @@ public:
     m_concat_points = other.m_concat_points;
     m_input_v.reset(other.m_input_v ? other.m_input_v->Copy() : nullptr);
     m_output_v.reset(other.m_output_v ? other.m_output_v->Copy() : nullptr);
+    m_output_storage.reset(other.m_output_storage ?
+                           other.m_output_storage->Copy() : nullptr);
+    m_alias_inputs = false;
   }
 
   concatenation_layer* copy() const override { return new concatenation_layer(*this); }
@@ -86,6 +92,13 @@ protected:
     const auto& input = get_prev_activations();
     m_input_v.reset(input.Construct(input.Grid(), input.Root()));
     m_output_v.reset(input.Construct(input.Grid(), input.Root()));
+    m_output_storage.reset(input.Construct(input.Grid(), input.Root()));
+    m_alias_inputs = false;
+  }
+
+  void setup_data() override {
+    transform_layer::setup_data();
+    setup_input_aliasing();
   }
 
   void setup_dims() override {
@@ -151,9 +164,12 @@ protected:
     // Initialize output tensor
     auto& output = get_activations();
     output.Empty(false);
-    if (num_inputs > 1) {
+    if (num_inputs > 1 && m_alias_inputs) {
+      El::View(output, *m_output_storage,
+               El::ALL, El::IR(0, mini_batch_size));
+    } else if (num_inputs > 1) {
       output.AlignWith(get_prev_activations());
-      output.Resize(get_output_size(), mini_batch_size);
+      allocate_activations(0, mini_batch_size);
     } else {
       El::LockedView(output, get_prev_activations());
       return;
@@ -186,6 +202,11 @@ protected:
       const auto& block_size = input_num_unit_slices * unit_block_size;
       const auto& output_block_offset = m_concat_points[i] * unit_block_size;
 
+      // Skip input if parent layer wrote it directly into the output
+      if (m_alias_inputs && is_input_aliased(input, output_block_offset)) {
+        continue;
+      }
+
       // Populate output tensor one block at a time
       for (int block = 0; block < blocks_per_slice; ++block) {
         const auto& input_offset = block * block_size;
@@ -227,7 +248,6 @@ protected:
     const auto& gradient_wrt_output = get_prev_error_signals();
     for (int i = 0; i < num_inputs; ++i) {
       const auto& input_dims = get_input_dims(i);
-      const auto& input_size = get_input_size(i);
       auto& gradient_wrt_input = get_error_signals(i);
 
       // Divide input tensor into unit slices
@@ -245,7 +265,7 @@ protected:
       // Note: If there is only one block, the tensor can be a view
       if (blocks_per_slice > 1) {
         gradient_wrt_input.AlignWith(*m_output_v);
-        gradient_wrt_input.Resize(input_size, mini_batch_size);
+        allocate_error_signals(i, mini_batch_size);
         for (int block = 0; block < blocks_per_slice; ++block) {
           const auto& input_offset = block * block_size;
           const auto& output_offset = (output_block_offset
@@ -271,6 +291,81 @@ protected:
 
 private:
 
+  /** Let parent layers write their outputs into the output tensor.
+   *  If the input tensors are contiguous blocks of the output tensor,
+   *  i.e. all dimensions before the concatenation dimension are 1,
+   *  the output tensor is a view into persistent memory and each
+   *  parent's output tensor is attached to its block. The concatenation
+   *  then needs no copies. Inputs that are not written in place,
+   *  e.g. because a parent outputs a view or has a different data
+   *  layout, are still copied.
+   */
+  void setup_input_aliasing() {
+    m_alias_inputs = false;
+    const auto& num_inputs = get_num_parents();
+    const auto& output_dims = get_output_dims();
+    const auto& blocks_per_slice
+      = std::accumulate(output_dims.begin(),
+                        output_dims.begin() + m_concat_dim,
+                        1, std::multiplies<int>());
+    if (num_inputs < 2 || blocks_per_slice > 1
+        || Dev != El::Device::CPU) {
+      return;
+    }
+
+    // Allocate output memory for largest mini-batch
+    // Note: Blocks of local rows are only contiguous if the rows are
+    // not distributed.
+    auto& storage = *m_output_storage;
+    storage.Empty();
+    storage.AlignWith(get_prev_activations());
+    const auto& max_mini_batch_size = this->m_model->get_max_mini_batch_size();
+    storage.Resize(get_output_size(), max_mini_batch_size);
+    if (storage.ColStride() != 1 || storage.Buffer() == nullptr) {
+      storage.Empty();
+      return;
+    }
+    m_alias_inputs = true;
+    auto& output = get_activations();
+    output.Empty();
+    El::View(output, storage,
+             El::ALL, El::IR(0, max_mini_batch_size));
+
+    // Attach parent output tensors to blocks of output memory
+    const auto& unit_block_size
+      = std::accumulate(output_dims.begin() + m_concat_dim + 1,
+                        output_dims.end(),
+                        1, std::multiplies<int>());
+    const Layer* self = this;
+    for (int i = 0; i < num_inputs; ++i) {
+      auto* parent = const_cast<Layer*>(m_parent_layers[i]);
+      const auto& children = parent->get_child_layers();
+      if (parent->get_data_layout() != T_layout
+          || parent->get_device_allocation() != Dev
+          || std::count(children.begin(), children.end(), self) != 1) {
+        continue;
+      }
+      const int child_index = (std::find(children.begin(),
+                                         children.end(),
+                                         self)
+                               - children.begin());
+      const auto& offset = m_concat_points[i] * unit_block_size;
+      parent->set_activations_buffer(child_index,
+                                     storage.Buffer(offset, 0),
+                                     storage.LDim());
+    }
+
+  }
+
+  /** Whether an input tensor is stored in place in the output tensor. */
+  bool is_input_aliased(const AbsDistMat& input, El::Int offset) const {
+    const auto& output = get_activations();
+    return (input.LockedBuffer() == output.LockedBuffer(offset, 0)
+            && input.LDim() == output.LDim()
+            && input.RowAlign() == output.RowAlign()
+            && input.LocalWidth() == output.LocalWidth());
+  }
+
   /** Tensor dimension to concatenation. */
   El::Int m_concat_dim;
   /** Concatenation points for each child layer. */
@@ -281,6 +376,14 @@ private:
   /** View into output tensor. */
   std::unique_ptr<AbsDistMat> m_output_v;
 
+  /** Persistent memory for output tensor.
+   *  Only used if parent layers write directly into the output
+   *  tensor.
+   */
+  std::unique_ptr<AbsDistMat> m_output_storage;
+  /** Whether parent layers write directly into the output tensor. */
+  bool m_alias_inputs = false;
+
 };
 
 } // namespace lbann
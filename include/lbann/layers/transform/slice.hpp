@@ -60,9 +60,13 @@ public:
   slice_layer(const slice_layer& other)
     : transform_layer(other),
       m_slice_dim(other.m_slice_dim),
-      m_slice_points(other.m_slice_points) {
+      m_slice_points(other.m_slice_points),
+      m_alias_gradients(false) {
     m_input_v.reset(other.m_input_v ? other.m_input_v->Copy() : nullptr);
     m_output_v.reset(other.m_output_v ? other.m_output_v->Copy() : nullptr);
+    m_gradient_wrt_input_storage.reset(other.m_gradient_wrt_input_storage ?
+                                       other.m_gradient_wrt_input_storage->Copy() :
+                                       nullptr);
   }
 
   slice_layer& operator=(const slice_layer& other) {
@@ -71,6 +75,10 @@ public:
     m_slice_points = other.m_slice_points;
     m_input_v.reset(other.m_input_v ? other.m_input_v->Copy() : nullptr);
     m_output_v.reset(other.m_output_v ? other.m_output_v->Copy() : nullptr);
+    m_gradient_wrt_input_storage.reset(other.m_gradient_wrt_input_storage ?
+                                       other.m_gradient_wrt_input_storage->Copy() :
+                                       nullptr);
+    m_alias_gradients = false;
   }
 
   slice_layer* copy() const override { return new slice_layer(*this); }
@@ -101,6 +109,14 @@ protected:
     const auto& input = get_prev_activations();
     m_input_v.reset(input.Construct(input.Grid(), input.Root()));
     m_output_v.reset(input.Construct(input.Grid(), input.Root()));
+    m_gradient_wrt_input_storage.reset(input.Construct(input.Grid(),
+                                                       input.Root()));
+    m_alias_gradients = false;
+  }
+
+  void setup_data() override {
+    transform_layer::setup_data();
+    setup_gradient_aliasing();
   }
 
   void setup_dims() override {
@@ -172,7 +188,6 @@ protected:
     const auto& input = get_prev_activations();
     for (int i = 0; i < num_outputs; ++i) {
       const auto& output_dims = get_output_dims(i);
-      const auto& output_size = get_output_size(i);
       auto& output = get_activations(i);
       output.Empty(false);
 
@@ -191,7 +206,7 @@ protected:
       // Note: If there is only one block, output can be a view
       if (blocks_per_slice > 1) {
         output.AlignWith(*m_input_v);
-        output.Resize(output_size, mini_batch_size);
+        allocate_activations(i, mini_batch_size);
         for (int block = 0; block < blocks_per_slice; ++block) {
           const auto& input_offset = (input_block_offset
                                       + block * input_block_stride);
@@ -216,16 +231,6 @@ protected:
     const auto& num_outputs = get_num_children();
     const auto& input_dims = get_input_dims();
 
-    // Initialize gradient w.r.t. input tensor
-    auto& gradient_wrt_input = get_error_signals();
-    gradient_wrt_input.Empty(false);
-    gradient_wrt_input.AlignWith(get_prev_activations());
-    gradient_wrt_input.Resize(get_input_size(), mini_batch_size);
-    if (m_slice_points[0] != 0
-        || m_slice_points[num_outputs] != input_dims[m_slice_dim]) {
-      El::Zero(gradient_wrt_input);
-    }
-
     // Divide input tensor into unit slices along slice dimension
     // Note: Each unit slice is divided into contiguous "unit blocks"
     const auto& input_num_unit_slices = input_dims[m_slice_dim];
@@ -239,6 +244,32 @@ protected:
     const auto& input_block_stride = (input_num_unit_slices
                                       * unit_block_size);
 
+    // Initialize gradient w.r.t. input tensor
+    auto& gradient_wrt_input = get_error_signals();
+    gradient_wrt_input.Empty(false);
+    if (m_alias_gradients) {
+      El::View(gradient_wrt_input, *m_gradient_wrt_input_storage,
+               El::ALL, El::IR(0, mini_batch_size));
+    } else {
+      gradient_wrt_input.AlignWith(get_prev_activations());
+      allocate_error_signals(0, mini_batch_size);
+    }
+    if (m_slice_points[0] != 0
+        || m_slice_points[num_outputs] != input_dims[m_slice_dim]) {
+      if (m_alias_gradients) {
+        // Only zero the rows that are not written by child layers
+        const auto& begin = m_slice_points[0] * unit_block_size;
+        const auto& end = m_slice_points[num_outputs] * unit_block_size;
+        El::View(*m_input_v, gradient_wrt_input, El::IR(0, begin), El::ALL);
+        El::Zero(*m_input_v);
+        El::View(*m_input_v, gradient_wrt_input,
+                 El::IR(end, get_input_size()), El::ALL);
+        El::Zero(*m_input_v);
+      } else {
+        El::Zero(gradient_wrt_input);
+      }
+    }
+
     // Populate slices of gradient w.r.t. input tensor
     for (int i = 0; i < num_outputs; ++i) {
       const auto& output_dims = get_output_dims(i);
@@ -251,6 +282,13 @@ protected:
       const auto& block_size = output_num_unit_slices * unit_block_size;
       const auto& input_block_offset = m_slice_points[i] * unit_block_size;
 
+      // Skip gradient if child layer wrote it directly into the
+      // gradient w.r.t. input
+      if (m_alias_gradients
+          && is_gradient_aliased(gradient_wrt_output, input_block_offset)) {
+        continue;
+      }
+
       // Populate gradient w.r.t. input tensor one block at a time
       for (int block = 0; block < blocks_per_slice; ++block) {
         const auto& input_offset = (input_block_offset
@@ -274,6 +312,85 @@ protected:
 
 private:
 
+  /** Let child layers write their error signals into the gradient
+   *  w.r.t. the input tensor.
+   *  If the output tensors are contiguous blocks of the input tensor,
+   *  i.e. all dimensions before the slice dimension are 1, the output
+   *  tensors are already views into the input tensor. Similarly, the
+   *  gradient w.r.t. the input tensor is then a view into persistent
+   *  memory and each child's gradient w.r.t. its input tensor is
+   *  attached to its block, so backprop needs no copies. Gradients
+   *  that are not written in place are still copied.
+   */
+  void setup_gradient_aliasing() {
+    m_alias_gradients = false;
+    const auto& num_outputs = get_num_children();
+    const auto& input_dims = get_input_dims();
+    const auto& blocks_per_slice
+      = std::accumulate(input_dims.begin(),
+                        input_dims.begin() + m_slice_dim,
+                        1, std::multiplies<int>());
+    if (num_outputs < 1 || blocks_per_slice > 1
+        || Dev != El::Device::CPU) {
+      return;
+    }
+
+    // Allocate gradient memory for largest mini-batch
+    // Note: Blocks of local rows are only contiguous if the rows are
+    // not distributed.
+    auto& storage = *m_gradient_wrt_input_storage;
+    storage.Empty();
+    storage.AlignWith(get_prev_activations());
+    const auto& max_mini_batch_size = this->m_model->get_max_mini_batch_size();
+    storage.Resize(get_input_size(), max_mini_batch_size);
+    if (storage.ColStride() != 1 || storage.Buffer() == nullptr) {
+      storage.Empty();
+      return;
+    }
+    m_alias_gradients = true;
+    auto& gradient_wrt_input = get_error_signals();
+    gradient_wrt_input.Empty();
+    El::View(gradient_wrt_input, storage,
+             El::ALL, El::IR(0, max_mini_batch_size));
+
+    // Attach child error signal tensors to blocks of gradient memory
+    const auto& unit_block_size
+      = std::accumulate(input_dims.begin() + m_slice_dim + 1,
+                        input_dims.end(),
+                        1, std::multiplies<int>());
+    const Layer* self = this;
+    for (int i = 0; i < num_outputs; ++i) {
+      auto* child = const_cast<Layer*>(m_child_layers[i]);
+      const auto& parents = child->get_parent_layers();
+      if (child->get_data_layout() != T_layout
+          || child->get_device_allocation() != Dev
+          || std::count(parents.begin(), parents.end(), self) != 1) {
+        continue;
+      }
+      const int parent_index = (std::find(parents.begin(),
+                                          parents.end(),
+                                          self)
+                                - parents.begin());
+      const auto& offset = m_slice_points[i] * unit_block_size;
+      child->set_error_signals_buffer(parent_index,
+                                      storage.Buffer(offset, 0),
+                                      storage.LDim());
+    }
+
+  }
+
+  /** Whether a gradient w.r.t. an output tensor is stored in place
+   *  in the gradient w.r.t. the input tensor. */
+  bool is_gradient_aliased(const AbsDistMat& gradient_wrt_output,
+                           El::Int offset) const {
+    const auto& gradient_wrt_input = get_error_signals();
+    return (gradient_wrt_output.LockedBuffer()
+            == gradient_wrt_input.LockedBuffer(offset, 0)
+            && gradient_wrt_output.LDim() == gradient_wrt_input.LDim()
+            && gradient_wrt_output.RowAlign() == gradient_wrt_input.RowAlign()
+            && gradient_wrt_output.LocalWidth() == gradient_wrt_input.LocalWidth());
+  }
+
   /** Tensor dimension to slice. */
   El::Int m_slice_dim;
   /** Slice points for each child layer. */
@@ -284,6 +401,16 @@ private:
   /** View into output tensor. */
   std::unique_ptr<AbsDistMat> m_output_v;
 
+  /** Persistent memory for gradient w.r.t. input tensor.
+   *  Only used if child layers write directly into the gradient
+   *  w.r.t. the input tensor.
+   */
+  std::unique_ptr<AbsDistMat> m_gradient_wrt_input_storage;
+  /** Whether child layers write directly into the gradient w.r.t.
+   *  the input tensor.
+   */
+  bool m_alias_gradients = false;
+
 };
 
 } // namespace lbann
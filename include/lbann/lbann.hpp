@@ -29,6 +29,7 @@
 
 /// Models
 #include "lbann/models/directed_acyclic_graph.hpp"
+#include "lbann/models/inference_server.hpp"
 
 /// Activation Layers
 #include "lbann/layers/activations/activations.hpp"
@@ -60,6 +61,7 @@
 #include "lbann/layers/math/unary.hpp"
 #include "lbann/layers/math/binary.hpp"
 #include "lbann/layers/math/clamp.hpp"
+#include "lbann/layers/math/fused_entrywise.hpp"
 
 /// Transform Layers
 #include "lbann/layers/transform/reshape.hpp"
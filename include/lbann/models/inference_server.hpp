@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LBANN_MODELS_INFERENCE_SERVER_HPP
+#define LBANN_MODELS_INFERENCE_SERVER_HPP
+
+#include "lbann/base.hpp"
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lbann {
+
+// Forward declarations
+class Layer;
+class model;
+
+/** Serve inference requests with a trained model.
+ *
+ *  Evaluating a model epoch by epoch over a data reader's test set
+ *  is not suitable when a trained model is used as an emulator
+ *  inside a simulation, since samples arrive one at a time and each
+ *  query should return quickly. The server instead queues individual
+ *  samples, groups them into mini-batches, and runs forward prop
+ *  with model::infer_mini_batch. A mini-batch is started as soon as
+ *  the maximum batch size is reached or the oldest queued request
+ *  has waited for the maximum delay, so throughput improves under
+ *  load without adding more than the delay to the latency of a
+ *  lone request. Background I/O is disabled for the model.
+ *
+ *  Requests are submitted on the model master process, either
+ *  in-process with submit or through a local socket (see listen).
+ *  All processes in the model must call serve.
+ */
+class inference_server {
+public:
+
+  /** Constructor.
+   *  @param m               Trained model. It must have exactly one
+   *                         input layer.
+   *  @param output_layer    Name of the layer whose output is
+   *                         returned for each request.
+   *  @param max_batch_size  Maximum number of requests per
+   *                         mini-batch. Clamped to the model's
+   *                         maximum mini-batch size.
+   *  @param max_delay       Maximum time (in seconds) that a request
+   *                         waits for other requests to join its
+   *                         mini-batch.
+   */
+  inference_server(model* m,
+                   const std::string& output_layer,
+                   int max_batch_size,
+                   double max_delay);
+  inference_server(const inference_server&) = delete;
+  inference_server& operator=(const inference_server&) = delete;
+  ~inference_server();
+
+  /** Queue a sample for inference.
+   *  Must be called on the model master process and may be called
+   *  from any thread. The sample must match the input layer's output
+   *  size. The future provides the output of the output layer for
+   *  the sample.
+   */
+  std::future<std::vector<DataType>> submit(std::vector<DataType> sample);
+
+  /** Stop accepting requests.
+   *  serve returns once all queued requests have been processed.
+   */
+  void shutdown();
+
+  /** Process requests until the server is shut down.
+   *  Must be called by all processes in the model.
+   */
+  void serve();
+
+  /** Accept requests on a local (Unix domain) socket.
+   *  Must be called on the model master process. Connections are
+   *  handled in background threads until the server is destroyed.
+   *  Each message on a connection is a 64-bit entry count followed by
+   *  the entries of a sample as DataType values, in native byte
+   *  order. The reply to a sample has the same format and contains
+   *  the output of the output layer, or no entries if the request
+   *  failed. A message with no entries shuts the server down.
+   */
+  void listen(const std::string& socket_path);
+
+  /** Number of requests that have been served. */
+  size_t get_num_requests() const { return m_latencies.size(); }
+  /** Number of mini-batches that have been processed. */
+  size_t get_num_batches() const { return m_num_batches; }
+
+  /** Print latency and throughput statistics.
+   *  Statistics are only available on the model master process.
+   */
+  void print_statistics(std::ostream& os) const;
+
+private:
+
+  /** Queued inference request. */
+  struct request {
+    std::vector<DataType> m_sample;
+    std::promise<std::vector<DataType>> m_result;
+    /** Time when the request was queued. */
+    double m_arrival_time;
+  };
+
+  /** Wait for the next mini-batch of requests.
+   *  Returns false if the server has been shut down and the queue is
+   *  empty.
+   */
+  bool get_next_batch(std::vector<request>& batch);
+  /** Run forward prop on a mini-batch and fulfill its requests.
+   *  Requests are only available on the model master process.
+   */
+  void process_batch(std::vector<request>& batch, int batch_size);
+
+  /** Accept connections on the listening socket. */
+  void accept_connections();
+  /** Serve requests received on a socket connection. */
+  void handle_connection(int fd);
+  /** Close the listening socket and wait for connection threads. */
+  void stop_listening();
+
+  model* m_model;
+  /** Input layer that receives samples. */
+  Layer* m_input_layer = nullptr;
+  /** Layer whose output is returned for each request. */
+  Layer* m_output_layer = nullptr;
+  int m_max_batch_size;
+  double m_max_delay;
+
+  /** Queued requests in order of arrival. */
+  std::deque<request> m_queue;
+  /** Whether new requests are rejected. */
+  bool m_shutdown = false;
+  std::mutex m_queue_mutex;
+  std::condition_variable m_queue_cv;
+
+  /** Listening socket (-1 if not listening). */
+  int m_listen_fd = -1;
+  std::string m_socket_path;
+  std::thread m_accept_thread;
+  std::vector<std::thread> m_connection_threads;
+  /** Open connections, which are closed when listening stops. */
+  std::vector<int> m_connection_fds;
+  std::mutex m_connection_mutex;
+
+  /** Time from arrival to completion (in seconds) of served requests. */
+  std::vector<double> m_latencies;
+  size_t m_num_batches = 0;
+  /** Arrival time of the first served request. */
+  double m_start_time = 0;
+  /** Time when the last request was served. */
+  double m_end_time = 0;
+
+};
+
+} // namespace lbann
+
+#endif // LBANN_MODELS_INFERENCE_SERVER_HPP
@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LBANN_MODELS_MEMORY_PLANNER_HPP
+#define LBANN_MODELS_MEMORY_PLANNER_HPP
+
+#include "lbann/base.hpp"
+#include <vector>
+
+namespace lbann {
+
+// Forward declarations
+class Layer;
+
+/** Liveness-based memory planner for layer tensors.
+ *
+ *  By default, every layer allocates its own activation and error
+ *  signal tensors for the largest mini-batch, so the memory for a
+ *  model grows with the sum of all tensor sizes. Most of these
+ *  tensors are only live for part of a mini-batch step though. The
+ *  activations of a layer are needed from its forward prop step
+ *  until its backward prop step, and the error signals that a layer
+ *  sends to a parent layer are only needed until the parent has
+ *  finished its backward prop step.
+ *
+ *  The planner walks the forward and backward prop schedule of a
+ *  model, computes the interval of steps during which each tensor is
+ *  live, and greedily assigns tensors with disjoint intervals to a
+ *  shared arena. Layers then attach their tensors to the arena memory
+ *  instead of allocating their own. For instance, the error signals
+ *  of early layers reuse the memory of activations of deep layers
+ *  that have already finished backprop.
+ *
+ *  Only tensors that own their memory and live on the CPU are
+ *  planned, and tensors of input layers are never planned since data
+ *  readers fill them in the background. Activations and error signals
+ *  are not preserved after the backward prop step of a mini-batch, so
+ *  callbacks that inspect tensors at the end of a training step may
+ *  see overwritten values.
+ */
+class memory_planner {
+public:
+
+  /** Plan memory for the tensors of a model's layers.
+   *  Layers must have just been set up and must be listed in
+   *  execution order. Any previous plan is discarded.
+   */
+  void plan(const std::vector<Layer*>& layers);
+
+  /** Number of planned tensors. */
+  size_t get_num_tensors() const { return m_tensors.size(); }
+  /** Number of arenas. */
+  size_t get_num_arenas() const { return m_arenas.size(); }
+  /** Bytes needed if every planned tensor allocated its own memory. */
+  size_t get_naive_size() const;
+  /** Bytes allocated for arenas. */
+  size_t get_planned_size() const;
+
+private:
+
+  /** Tensor that is assigned to an arena. */
+  struct tensor {
+    Layer* m_layer;
+    /** Whether tensor is an activation or an error signal tensor. */
+    bool m_is_activations;
+    /** Child index for activations, parent index for error signals. */
+    int m_index;
+    /** Leading dimension of local data. */
+    El::Int m_ldim;
+    /** Number of local entries for the largest mini-batch. */
+    size_t m_size;
+    /** First step of the execution schedule where tensor is live. */
+    int m_first_step;
+    /** Last step of the execution schedule where tensor is live. */
+    int m_last_step;
+    /** Index of the arena the tensor is assigned to. */
+    int m_arena;
+  };
+
+  /** Find tensors that own their memory and compute lifetimes. */
+  void find_tensors(const std::vector<Layer*>& layers);
+  /** Greedily assign tensors to arenas. */
+  void assign_arenas();
+
+  /** Planned tensors. */
+  std::vector<tensor> m_tensors;
+  /** Memory shared by tensors with disjoint lifetimes. */
+  std::vector<std::vector<DataType>> m_arenas;
+
+};
+
+} // namespace lbann
+
+#endif // LBANN_MODELS_MEMORY_PLANNER_HPP
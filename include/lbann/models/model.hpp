@@ -40,6 +40,9 @@
 #include "lbann/metrics/metric.hpp"
 #include "lbann/weights/weights.hpp"
 #include "lbann/optimizers/optimizer.hpp"
+#include "lbann/optimizers/gradient_bucket.hpp"
+#include "lbann/optimizers/multi_tensor_step.hpp"
+#include "lbann/models/memory_planner.hpp"
 #include "lbann/utils/threads/thread_pool.hpp"
 #include <lbann.pb.h>
 #include <vector>
@@ -225,8 +228,20 @@ public:
 
   /** Train model. */
   virtual void train(int num_epochs, int num_batches=0);
-  /** Evaluate model. */
+  /** Evaluate model.
+   *  If num_batches is positive, evaluation stops after that many
+   *  mini-batches or at the end of the epoch, whichever comes first.
+   */
   virtual void evaluate(execution_mode mode, int num_batches=0);
+  /** Forward prop on samples provided by the caller.
+   *  Each column of the matrix is a sample for the model's input
+   *  layer. The input layer does not fetch data and its other output
+   *  tensors (e.g. labels) are zero, so data readers are not
+   *  touched. Callbacks, metrics, and the objective function are
+   *  skipped to keep per-query latency low. Must be called by all
+   *  processes in the model.
+   */
+  virtual void infer_mini_batch(const AbsDistMat& samples);
 
   /** Run one epoch using only the input layer; this supports
    *  data_store functionality
@@ -237,12 +252,56 @@ public:
       mode requested */
   virtual void collect_background_data_fetch(execution_mode mode);
 
+  /** Restart the data set of the execution mode requested at the
+   *  beginning of its current epoch, without reshuffling it */
+  virtual void reset_data_set(execution_mode mode);
+
   /** Set a flag that can be used to enable / disable the background I/O activities */
   void allow_background_io_activity(bool enable) { m_background_io_allowed = enable; }
 
   /** Are background I/O activities enabled by the input layers */
   bool background_io_activity_allowed() { return m_background_io_allowed; }
 
+  /** Set the bucket size (in bytes) for fused gradient allreduces.
+   *  Gradients of different weights are packed into buckets of this
+   *  size and allreduced together. A size of zero disables
+   *  bucketing. This must be called before the model is set up.
+   */
+  void set_gradient_bucket_size(size_t size) { m_gradient_bucket_size = size; }
+  /** Get the bucket size (in bytes) for fused gradient allreduces. */
+  size_t get_gradient_bucket_size() const { return m_gradient_bucket_size; }
+
+  /** Set whether optimizers are stepped with a multi-tensor step.
+   *  If enabled, all optimizers that support it are applied together
+   *  in one parallel loop instead of one parallel loop per weights
+   *  object.
+   */
+  void set_multi_tensor_step(bool enable) { m_multi_tensor_step_enabled = enable; }
+  /** Whether optimizers are stepped with a multi-tensor step. */
+  bool get_multi_tensor_step() const { return m_multi_tensor_step_enabled; }
+
+  /** Set whether layer tensors share memory planned by liveness.
+   *  If enabled, activation and error signal tensors with disjoint
+   *  lifetimes share memory arenas (see memory_planner). Tensors are
+   *  then not preserved after backprop. This must be called before
+   *  the model is set up.
+   */
+  void set_memory_planner(bool enable) { m_memory_planner_enabled = enable; }
+  /** Whether layer tensors share memory planned by liveness. */
+  bool get_memory_planner() const { return m_memory_planner_enabled; }
+
+  /** Set whether chains of entry-wise layers are fused.
+   *  If enabled, chains of CPU entry-wise layers (e.g. unary math,
+   *  binary math, clamp, and activation layers) are replaced by
+   *  fused_entrywise_layer instances when the model is set up. Fused
+   *  layers are named after the last layer in the chain and the other
+   *  layers are removed from the model. This must be called before
+   *  the model is set up.
+   */
+  void set_fuse_entrywise_layers(bool enable) { m_fuse_entrywise_layers_enabled = enable; }
+  /** Whether chains of entry-wise layers are fused. */
+  bool get_fuse_entrywise_layers() const { return m_fuse_entrywise_layers_enabled; }
+
   /** Checkpoint model to given file descriptor, return number of bytes written */
   virtual bool save_to_checkpoint_shared(persist& p);
   /** Restore model by reading checkpoint from given file descriptor, return number of bytes read */
@@ -326,6 +385,28 @@ protected:
   /** Flag that allows input layers to fetch data in the background */
   bool m_background_io_allowed;
 
+  /** Bucket size (in bytes) for fused gradient allreduces. */
+  size_t m_gradient_bucket_size;
+  /** Manager for fused gradient allreduces.
+   *  Null if gradient bucketing is disabled.
+   */
+  std::unique_ptr<gradient_bucket_manager> m_gradient_buckets;
+
+  /** Whether optimizers are stepped with a multi-tensor step. */
+  bool m_multi_tensor_step_enabled;
+  /** Fused optimization step over optimizers of all weights. */
+  multi_tensor_step m_multi_tensor_step;
+
+  /** Whether layer tensors share memory planned by liveness. */
+  bool m_memory_planner_enabled;
+  /** Memory planner for layer tensors.
+   *  Null if memory planning is disabled.
+   */
+  std::unique_ptr<memory_planner> m_memory_planner;
+
+  /** Whether chains of entry-wise layers are fused. */
+  bool m_fuse_entrywise_layers_enabled;
+
   /** Check if the model execution mode is valid. */
   virtual bool is_execution_mode_valid(execution_mode mode) const;
 
@@ -361,12 +442,24 @@ protected:
    *  Called in setup function.
    */
   virtual void setup_layers();
+  /** Set up memory plan for layer tensors.
+   *  Called in setup function after layers are set up. If memory
+   *  planning is enabled, tensors are assigned to shared memory
+   *  arenas according to their lifetimes in the execution order.
+   */
+  virtual void setup_memory_plan();
   /** Set up weights.
    *  Called in setup function. All weights being used by layers or
    *  the objective function are added to the model and all unused
    *  weights are deleted.
    */
   virtual void setup_weights();
+  /** Set up fused gradient allreduces.
+   *  Called in setup function. If gradient bucketing is enabled, the
+   *  optimizers of all weights are pointed to the model's bucket
+   *  manager.
+   */
+  virtual void setup_gradient_buckets();
 
   /** Reset model pointer and execution mode. */
   virtual void reset_mode_and_model(execution_mode mode);
@@ -464,6 +557,13 @@ private:
    *  the split layer's children will be the original children.
    */
   void add_split_layers();
+  /** Replace chains of entry-wise layers with fused layers.
+   *  A chain is a sequence of CPU entry-wise layers with the same
+   *  data layout where each layer's only child is the next layer.
+   *  Binary layers continue a chain through one input and the other
+   *  input becomes an input of the fused layer.
+   */
+  void fuse_entrywise_layers();
 };
 
 }  // namespace lbann
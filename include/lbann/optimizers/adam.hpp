@@ -80,6 +80,15 @@ public:
 
 private:
 
+  bool supports_step_compute_local() const override { return true; }
+  bool step_compute_local_contiguous() const override;
+  void step_compute_local_setup() override;
+  void step_compute_local(AbsDistMat& values,
+                          const AbsDistMat& gradient,
+                          El::Int col,
+                          El::Int row_begin,
+                          El::Int row_end) override;
+
   /** Update factor for first moment estimate. */
   DataType m_beta1;
   /** Update factor for second moment estimate. */
@@ -90,6 +99,8 @@ private:
   DataType m_current_beta1 = 1;
   /** beta2 ^ iteration. */
   DataType m_current_beta2 = 1;
+  /** Bias-corrected learning rate for step_compute_local. */
+  DataType m_correction = 0;
   /** First moment estimates. */
   std::unique_ptr<AbsDistMat> m_moment1;
   /** Second moment estimates. */
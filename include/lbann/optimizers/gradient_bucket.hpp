@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LBANN_OPTIMIZERS_GRADIENT_BUCKET_HPP
+#define LBANN_OPTIMIZERS_GRADIENT_BUCKET_HPP
+
+#include "lbann/base.hpp"
+#include "lbann/comm.hpp"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace lbann {
+
+// Forward declarations
+class optimizer;
+
+/** Fused allreduce over the gradient staging matrices of many weights.
+ *
+ *  Models with many small weights (e.g. biases and batch
+ *  normalization parameters) pay one collective latency per weights
+ *  object if each optimizer allreduces its own staging matrix. The
+ *  bucket manager instead packs the local staging matrices into
+ *  contiguous buffers of a fixed byte size and launches a single
+ *  non-blocking allreduce per buffer. Gradients are packed in the
+ *  order that their optimizers become ready, i.e. the order in which
+ *  backprop finishes them, and are scattered back into the staging
+ *  matrices when an optimizer requests its gradient.
+ *
+ *  Gradients are only fused with gradients that share the same
+ *  process grid, distribution, and device, since these have the same
+ *  redundant communicator. Gradients that do not fit in a bucket are
+ *  not bucketed.
+ */
+class gradient_bucket_manager {
+public:
+
+  /** Constructor.
+   *  @param comm         LBANN communicator.
+   *  @param bucket_size  Capacity of a bucket in bytes.
+   */
+  gradient_bucket_manager(lbann_comm* comm, size_t bucket_size);
+  gradient_bucket_manager(const gradient_bucket_manager& other) = delete;
+  gradient_bucket_manager& operator=(const gradient_bucket_manager& other) = delete;
+  ~gradient_bucket_manager();
+
+  /** Capacity of a bucket in bytes. */
+  size_t get_bucket_size() const { return m_bucket_size; }
+
+  /** Pack an optimizer's gradient staging matrix into a bucket.
+   *  The bucket's allreduce is started once it is full. Returns false
+   *  if the gradient cannot be bucketed, in which case the caller is
+   *  responsible for allreducing it.
+   */
+  bool add(const optimizer& opt, AbsDistMat& gradient);
+  /** Start allreduces on all buckets that have not been started. */
+  void flush();
+  /** Wait for the allreduce on an optimizer's bucket.
+   *  The allreduce is started if needed. Once it completes, every
+   *  gradient in the bucket is unpacked into its staging matrix.
+   */
+  void wait(const optimizer& opt);
+  /** Poll the allreduces that have started.
+   *  Buckets whose allreduce has completed are unpacked into their
+   *  staging matrices. This drives the progress of non-blocking
+   *  allreduces while other work is performed.
+   */
+  void progress();
+  /** Complete outstanding allreduces and empty all buckets. */
+  void reset();
+
+  /** Number of allreduces launched since construction. */
+  size_t get_num_allreduces() const { return m_num_allreduces; }
+
+private:
+
+  /** Location of a gradient within a bucket. */
+  struct bucket_entry {
+    /** Gradient staging matrix. */
+    AbsDistMat* m_gradient;
+    /** Offset of local data within bucket buffer. */
+    El::Int m_offset;
+  };
+
+  /** Contiguous buffer of packed gradients. */
+  struct bucket {
+    /** Process grid of packed gradients. */
+    const El::Grid* m_grid = nullptr;
+    /** Column distribution of packed gradients. */
+    El::Dist m_col_dist = El::STAR;
+    /** Row distribution of packed gradients. */
+    El::Dist m_row_dist = El::STAR;
+    /** Device of packed gradients. */
+    El::Device m_device = El::Device::CPU;
+    /** Packed data.
+     *  Column vector with capacity for the bucket size.
+     */
+    std::unique_ptr<AbsMat> m_buffer;
+    /** Number of entries currently packed into buffer. */
+    El::Int m_size = 0;
+    /** Gradients packed into buffer. */
+    std::vector<bucket_entry> m_entries;
+    /** Request for non-blocking allreduce. */
+    Al::request m_req;
+    /** Whether the allreduce has started. */
+    bool m_started = false;
+    /** Whether the allreduce has finished and data is unpacked. */
+    bool m_finished = false;
+  };
+
+  /** Get an unstarted bucket compatible with a gradient.
+   *  Returns a null pointer if there is none.
+   */
+  bucket* find_open_bucket(const AbsDistMat& gradient);
+  /** Get an empty bucket compatible with a gradient. */
+  bucket& new_bucket(const AbsDistMat& gradient);
+  /** Start non-blocking allreduce on a bucket. */
+  void start_allreduce(bucket& b);
+  /** Wait for allreduce on a bucket and unpack its gradients. */
+  void finish_allreduce(bucket& b);
+
+  /** LBANN communicator. */
+  lbann_comm* m_comm;
+  /** Capacity of a bucket in bytes. */
+  size_t m_bucket_size;
+
+  /** Pool of buckets.
+   *  Buckets are reused between mini-batches to avoid reallocating
+   *  their buffers.
+   */
+  std::vector<std::unique_ptr<bucket>> m_buckets;
+  /** Number of buckets in pool that are in use. */
+  size_t m_num_buckets_used;
+  /** Bucket containing each optimizer's gradient. */
+  std::unordered_map<const optimizer*, bucket*> m_optimizer_buckets;
+
+  /** Number of allreduces launched since construction. */
+  size_t m_num_allreduces;
+
+};
+
+} // namespace lbann
+
+#endif // LBANN_OPTIMIZERS_GRADIENT_BUCKET_HPP
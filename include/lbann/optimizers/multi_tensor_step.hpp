@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LBANN_OPTIMIZERS_MULTI_TENSOR_STEP_HPP
+#define LBANN_OPTIMIZERS_MULTI_TENSOR_STEP_HPP
+
+#include "lbann/base.hpp"
+#include <vector>
+
+namespace lbann {
+
+// Forward declarations
+class optimizer;
+
+/** Fused optimization step over the weights of many optimizers.
+ *
+ *  Each optimizer normally applies its step in its own OpenMP
+ *  parallel region. Models with many small weights (e.g. biases and
+ *  batch normalization parameters) then spend most of the update in
+ *  thread fork/join overhead. A multi-tensor step instead splits the
+ *  local data of every optimizer added to it into chunks of similar
+ *  size and applies all of them in one parallel loop. Each chunk is
+ *  processed with the optimizer's own vectorizable kernel and
+ *  hyperparameters, so optimizers of different types and
+ *  hyperparameters can share a step.
+ *
+ *  Only optimizers with CPU weights that implement
+ *  optimizer::step_compute_local can be added.
+ */
+class multi_tensor_step {
+public:
+
+  /** Constructor.
+   *  @param chunk_size  Target number of local entries per chunk.
+   */
+  multi_tensor_step(El::Int chunk_size = 4096);
+
+  /** Add an optimizer to the step.
+   *  The optimizer's gradient is finalized and its per-step state
+   *  (e.g. Adam's bias correction) is updated, but its weights are
+   *  not changed until apply is called.
+   */
+  void add(optimizer& opt);
+  /** Apply the optimization step of all added optimizers.
+   *  The step is then emptied.
+   */
+  void apply();
+
+private:
+
+  /** Optimizer added to the step. */
+  struct entry {
+    optimizer* m_optimizer;
+    AbsDistMat* m_values;
+    const AbsDistMat* m_gradient;
+    /** Number of local entries. */
+    El::Int m_size;
+  };
+
+  /** Range of local entries within one column of an optimizer's
+   *  weights, or within its flattened local data if that is
+   *  contiguous (then m_col is 0).
+   */
+  struct chunk {
+    /** Index of entry in entry list. */
+    size_t m_entry;
+    El::Int m_col;
+    El::Int m_row_begin;
+    El::Int m_row_end;
+  };
+
+  /** Target number of local entries per chunk. */
+  El::Int m_chunk_size;
+  /** Optimizers added to the step. */
+  std::vector<entry> m_entries;
+  /** Work list for the step.
+   *  Kept between steps to avoid reallocating it.
+   */
+  std::vector<chunk> m_chunks;
+
+};
+
+} // namespace lbann
+
+#endif // LBANN_OPTIMIZERS_MULTI_TENSOR_STEP_HPP
@@ -45,6 +45,8 @@ namespace lbann {
 // Forward declarations
 class weights;
 class persist;
+class gradient_bucket_manager;
+class multi_tensor_step;
 
 /** Abstract optimizer. */
 class optimizer {
@@ -96,6 +98,23 @@ class optimizer {
    *  function does nothing. This may call a non-blocking allreduce.
    */
   void start_gradient_staging_allreduce();
+  /** Check whether the allreduce on the gradient staging matrix has
+   *  finished. Polling drives the progress of a non-blocking
+   *  allreduce while other work is performed. Returns true if no
+   *  allreduce is in progress. Allreduces on gradient buckets are
+   *  polled by the bucket manager instead.
+   */
+  bool test_gradient_staging_allreduce();
+
+  /** Set the manager for fused gradient allreduces.
+   *  If set, the gradient staging matrix is packed into a bucket
+   *  with other gradients instead of being allreduced on its own. The
+   *  optimizer does not take ownership of the manager. A null pointer
+   *  disables bucketing.
+   */
+  void set_gradient_buckets(gradient_bucket_manager* buckets) {
+    m_gradient_buckets = buckets;
+  }
 
   /** Get number of gradient sources.
    *  This is the number of objects that contribute to the gradient
@@ -136,6 +155,13 @@ class optimizer {
                                 const AbsDistMat& gradient);
 #endif // LBANN_HAS_GPU
 
+  /** Whether the optimization step can be applied by a
+   *  multi_tensor_step.
+   *  This requires the weights to be on CPU and the optimizer to
+   *  implement step_compute_local.
+   */
+  bool can_fuse_step() const;
+
   /** Get the time spent in step(). */
   double get_step_time() const { return m_step_time; }
   /** Reset stats counters. */
@@ -157,8 +183,36 @@ class optimizer {
   /** Gradient matrix. */
   AbsDistMat* m_gradient;
 
+  /** Whether step_compute_local is implemented. */
+  virtual bool supports_step_compute_local() const { return false; }
+  /** Prepare an optimization step applied with step_compute_local.
+   *  Called once per step, before any calls to step_compute_local.
+   */
+  virtual void step_compute_local_setup() {}
+  /** Whether the optimizer state used by step_compute_local is
+   *  stored contiguously, i.e. its local leading dimension equals its
+   *  local height.
+   */
+  virtual bool step_compute_local_contiguous() const { return true; }
+  /** Perform the computation in an optimization step on a range of
+   *  local entries.
+   *  The range is rows [row_begin, row_end) of local column col. If
+   *  the values, gradient, and optimizer state are all contiguous,
+   *  the range may instead cover the flattened local data with col
+   *  set to 0. The values, gradient, and optimizer state are
+   *  otherwise as in step_compute. Calls on disjoint ranges may run
+   *  concurrently.
+   */
+  virtual void step_compute_local(AbsDistMat& values,
+                                  const AbsDistMat& gradient,
+                                  El::Int col,
+                                  El::Int row_begin,
+                                  El::Int row_end);
+
  private:
 
+  friend class multi_tensor_step;
+
   /** Sources of gradient contributions.
    *  This set contains pointers to objects (i.e. layers and objective
    *  function terms) which depend on the weights being optimized and
@@ -183,6 +237,11 @@ class optimizer {
   bool m_gradient_allreduce_started;
   /** Whether an allreduce on the gradient staging matrix has been finished. */
   bool m_gradient_allreduce_finished;
+  /** Whether the gradient staging matrix was packed into a bucket. */
+  bool m_gradient_allreduce_bucketed;
+
+  /** Manager for fused gradient allreduces (not owned). */
+  gradient_bucket_manager* m_gradient_buckets;
 
   /** Running count of the time spent in step(). */
   double m_step_time = 0.0;
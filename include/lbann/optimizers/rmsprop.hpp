@@ -64,6 +64,14 @@ class rmsprop : public optimizer {
 
  private:
 
+  bool supports_step_compute_local() const override { return true; }
+  bool step_compute_local_contiguous() const override;
+  void step_compute_local(AbsDistMat& values,
+                          const AbsDistMat& gradient,
+                          El::Int col,
+                          El::Int row_begin,
+                          El::Int row_end) override;
+
   /** Decay rate. */
   DataType m_decay_rate;
   /** Small factor to avoid division by zero. */
@@ -70,6 +70,14 @@ class sgd : public optimizer {
 
 private:
 
+  bool supports_step_compute_local() const override { return true; }
+  bool step_compute_local_contiguous() const override;
+  void step_compute_local(AbsDistMat& values,
+                          const AbsDistMat& gradient,
+                          El::Int col,
+                          El::Int row_begin,
+                          El::Int row_end) override;
+
   /** Momentum. */
   DataType m_momentum;
   /** Nesterov acceleration. */
@@ -0,0 +1,126 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LBANN_UTILS_DIRECT_CONVOLUTION_HPP
+#define LBANN_UTILS_DIRECT_CONVOLUTION_HPP
+
+#include "lbann/base.hpp"
+
+namespace lbann {
+
+/** @file Direct convolution kernels for CPU.
+ *
+ *  These compute convolutions without materializing an im2col
+ *  matrix, which is more cache friendly for small kernels on large
+ *  images. Tensors use the same layout as LBANN activations: each
+ *  sample is a column, stored channel-major with the last spatial
+ *  dimension contiguous. The kernel is stored like the kernel
+ *  weights of a convolution layer, i.e. as an
+ *  (input channels x window) by (output channels) column-major
+ *  matrix.
+ *
+ *  Work is parallelized with OpenMP over samples and channels. The
+ *  inner loops run along the contiguous spatial dimension and keep a
+ *  block of output channels in a small accumulator tile so that each
+ *  input row is reused across the block.
+ */
+
+/// Direct convolution
+/** @param input                Input tensors.
+ *  @param input_ldim           Leading dimension of input matrix.
+ *  @param kernel               Convolution kernel.
+ *  @param output               Output tensors.
+ *  @param output_ldim          Leading dimension of output matrix.
+ *  @param num_samples          Number of samples.
+ *  @param num_input_channels   Number of input channels.
+ *  @param num_output_channels  Number of output channels.
+ *  @param num_dims             Number of spatial dimensions.
+ *  @param input_dims           Spatial dimensions of input.
+ *  @param output_dims          Spatial dimensions of output.
+ *  @param window_dims          Spatial dimensions of kernel.
+ *  @param pads                 Zero pads for input.
+ *  @param strides              Convolution strides.
+ */
+void direct_convolution_forward(const DataType * input,
+                                int input_ldim,
+                                const DataType * kernel,
+                                DataType * output,
+                                int output_ldim,
+                                int num_samples,
+                                int num_input_channels,
+                                int num_output_channels,
+                                int num_dims,
+                                const int * input_dims,
+                                const int * output_dims,
+                                const int * window_dims,
+                                const int * pads,
+                                const int * strides);
+
+/// Gradient of direct convolution w.r.t. input
+/** This is also the forward pass of a transposed convolution. The
+ *  input gradient is overwritten. Parameters are as in
+ *  direct_convolution_forward, where the output gradient has the
+ *  output dimensions and the input gradient has the input
+ *  dimensions.
+ */
+void direct_convolution_backward_data(const DataType * gradient_wrt_output,
+                                      int gradient_wrt_output_ldim,
+                                      const DataType * kernel,
+                                      DataType * gradient_wrt_input,
+                                      int gradient_wrt_input_ldim,
+                                      int num_samples,
+                                      int num_input_channels,
+                                      int num_output_channels,
+                                      int num_dims,
+                                      const int * input_dims,
+                                      const int * output_dims,
+                                      const int * window_dims,
+                                      const int * pads,
+                                      const int * strides);
+
+/// Gradient of direct convolution w.r.t. kernel
+/** The kernel gradient is overwritten with the sum of contributions
+ *  from all samples. Parameters are as in
+ *  direct_convolution_forward.
+ */
+void direct_convolution_backward_filter(const DataType * input,
+                                        int input_ldim,
+                                        const DataType * gradient_wrt_output,
+                                        int gradient_wrt_output_ldim,
+                                        DataType * kernel_gradient,
+                                        int num_samples,
+                                        int num_input_channels,
+                                        int num_output_channels,
+                                        int num_dims,
+                                        const int * input_dims,
+                                        const int * output_dims,
+                                        const int * window_dims,
+                                        const int * pads,
+                                        const int * strides);
+
+} // namespace lbann
+
+#endif // LBANN_UTILS_DIRECT_CONVOLUTION_HPP
@@ -135,6 +135,23 @@ void im2col_2d(const DataType *__restrict__ input_buffer,
                int offset_stride_x,
                int offset_stride_y);
 
+/// Rearrange N-D image blocks into matrix columns
+/** This is an optimized implementation of im2col for data of any
+ *  dimension. Output columns are split into tiles that are processed
+ *  in parallel with the channels, and window entries along the last
+ *  (contiguous) dimension are copied as vectorizable runs. im2col
+ *  will automatically call this routine if no more specialized
+ *  routine applies.
+ */
+void im2col_nd(const DataType *__restrict__ input_buffer,
+               DataType *__restrict__ output_buffer,
+               int num_channels,
+               int num_dims,
+               const int * input_dims,
+               const int * input_pads,
+               const int * window_dims,
+               const int * offset_strides);
+
 /// Rearrange matrix columns into 1x1 image blocks
 /** This is an optimized implementation of col2im when the window has
  *  a size of one, there is no padding, and the window stride is
@@ -163,5 +180,22 @@ void col2im_2d(const DataType *__restrict__ input_buffer,
                int offset_stride_x,
                int offset_stride_y);
 
+/// Rearrange matrix columns into N-D image blocks
+/** This is an optimized implementation of col2im for data of any
+ *  dimension. Channels are processed in parallel and window entries
+ *  along the last (contiguous) dimension are accumulated as
+ *  vectorizable runs. col2im will call this routine if no more
+ *  specialized routine applies and there are at least as many
+ *  channels as OpenMP threads.
+ */
+void col2im_nd(const DataType *__restrict__ input_buffer,
+               DataType *__restrict__ output_buffer,
+               int num_channels,
+               int num_dims,
+               const int * output_dims,
+               const int * output_pads,
+               const int * window_dims,
+               const int * offset_strides);
+
 } // end namespace
 #endif // LBANN_UTILS_IM2COL_HPP
@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+//
+// lru_cache .hpp - Thread-safe least-recently-used cache
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LBANN_LRU_CACHE_HPP_INCLUDED
+#define LBANN_LRU_CACHE_HPP_INCLUDED
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace lbann {
+
+/**
+ * A thread-safe cache of key-value pairs with a fixed capacity. When the
+ * cache is full, inserting a new key evicts the least recently used one.
+ * Values are copied in and out under a lock, so large values should be
+ * held by shared pointers.
+ */
+template < class KEY_T,
+           class VAL_T,
+           class HASH_T = std::hash<KEY_T>,
+           class KEYeq_T = std::equal_to<KEY_T>
+         >
+class lru_cache {
+ public:
+  lru_cache(size_t capacity = 0u) : m_capacity(capacity) {}
+
+  lru_cache(const lru_cache&) = delete;
+  lru_cache& operator=(const lru_cache&) = delete;
+
+  /// Set the maximum number of entries, evicting entries as needed
+  void set_capacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity;
+    evict();
+  }
+
+  size_t get_capacity() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_capacity;
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+  }
+
+  /**
+   * Look up a key. Returns true and sets 'val' if the key is found, in
+   * which case the entry becomes the most recently used one.
+   */
+  bool get(const KEY_T& key, VAL_T& val) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+      return false;
+    }
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    val = it->second->second;
+    return true;
+  }
+
+  /// Returns true if the key is in the cache, without marking it as used
+  bool has(const KEY_T& key) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (m_index.find(key) != m_index.end());
+  }
+
+  /// Insert or replace an entry, and make it the most recently used one
+  void put(const KEY_T& key, const VAL_T& val) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_capacity == 0u) {
+      return;
+    }
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+      it->second->second = val;
+      m_entries.splice(m_entries.begin(), m_entries, it->second);
+      return;
+    }
+    m_entries.emplace_front(key, val);
+    m_index[key] = m_entries.begin();
+    evict();
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_index.clear();
+  }
+
+ protected:
+  using entry_list_t = std::list< std::pair<KEY_T, VAL_T> >;
+
+  /// Remove least recently used entries beyond the capacity
+  void evict() {
+    while (m_entries.size() > m_capacity) {
+      m_index.erase(m_entries.back().first);
+      m_entries.pop_back();
+    }
+  }
+
+  size_t m_capacity;
+  /// Entries ordered from the most to the least recently used
+  entry_list_t m_entries;
+  std::unordered_map<KEY_T, typename entry_list_t::iterator, HASH_T, KEYeq_T> m_index;
+  mutable std::mutex m_mutex;
+};
+
+} // end of namespace
+
+#endif // LBANN_LRU_CACHE_HPP_INCLUDED
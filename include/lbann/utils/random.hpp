@@ -30,7 +30,10 @@
 #include "lbann/base.hpp"
 #include "lbann/comm.hpp"
 #include "lbann/io/persist.hpp"
+#include <array>
+#include <cstdint>
 #include <random>
+#include <string>
 
 namespace lbann {
 
@@ -140,8 +143,11 @@ void uniform_fill(AbsDistMat& mat, El::Int m, El::Int n, DataType center = 0.0f,
 /**
  * Make mat into an m x n matrix where each entry is independently drawn from
  * a Gaussian distribution with given mean and standard deviation.
- * This always ensures that the entries of the matrix do not change as the grid
- * it is distributed over changes.
+ * For a given random seed, this ensures that the entries of the matrix do not
+ * change as the grid it is distributed over changes. Entries are generated in
+ * parallel with a counter-based generator from their global indices, using the
+ * seed of the grid's root process, so every process in the grid must make the
+ * same sequence of calls.
  */
 void gaussian_fill_procdet(AbsDistMat& mat, El::Int m, El::Int n,
                            DataType mean = 0.0f, DataType stddev = 1.0f);
@@ -159,6 +165,73 @@ void bernoulli_fill_procdet(AbsDistMat& mat, El::Int m, El::Int n, double p = 0.
 void uniform_fill_procdet(AbsDistMat& mat, El::Int m, El::Int n,
                           DataType center = 0.0f, DataType radius = 1.0f);
 
+/**
+ * Counter-based random number generator.
+ * Implements Philox4x32-10 from Salmon et al., "Parallel random
+ * numbers: as easy as 1, 2, 3" (SC 2011). The output is a pure
+ * function of a key, which is made from a seed and a stream ID, and a
+ * counter, which is made from a step and an index. There is no state
+ * to advance, so random numbers can be generated in parallel and in
+ * any order, and can be regenerated later instead of being stored.
+ */
+class counter_rng {
+ public:
+  using result_type = std::array<uint32_t, 4>;
+
+  /**
+   * @param seed Random seed, e.g. from get_counter_rng_seed.
+   * @param stream Stream ID, e.g. from get_counter_rng_stream.
+   */
+  counter_rng(uint32_t seed, uint32_t stream) : m_key{{seed, stream}} {}
+
+  /** Four independent random 32-bit integers for a counter. */
+  inline result_type operator()(uint64_t step, uint64_t index) const {
+    result_type ctr = {{uint32_t(index), uint32_t(index >> 32),
+                        uint32_t(step), uint32_t(step >> 32)}};
+    uint32_t k0 = m_key[0], k1 = m_key[1];
+    for (int round = 0; round < 10; ++round) {
+      const uint64_t p0 = uint64_t(0xD2511F53) * ctr[0];
+      const uint64_t p1 = uint64_t(0xCD9E8D57) * ctr[2];
+      ctr = {{uint32_t(p1 >> 32) ^ ctr[1] ^ k0, uint32_t(p1),
+              uint32_t(p0 >> 32) ^ ctr[3] ^ k1, uint32_t(p0)}};
+      k0 += 0x9E3779B9;
+      k1 += 0xBB67AE85;
+    }
+    return ctr;
+  }
+
+  /** Map a random 32-bit integer to [0,1). */
+  static inline DataType to_uniform(uint32_t x) {
+    return DataType(x >> 8) * DataType(1.0 / 16777216.0);
+  }
+
+  /** Threshold for Bernoulli random variables.
+   *  A random 32-bit integer is less than the threshold with
+   *  probability p.
+   */
+  static inline uint64_t bernoulli_threshold(double p) {
+    if (p <= 0.0) { return 0; }
+    if (p >= 1.0) { return uint64_t(1) << 32; }
+    return uint64_t(p * 4294967296.0);
+  }
+
+ private:
+  /** Philox key. */
+  std::array<uint32_t, 2> m_key;
+};
+
+/**
+ * Seed for counter-based random number generators.
+ * Set by init_random.
+ */
+uint32_t get_counter_rng_seed();
+/**
+ * Stream ID for counter-based random number generators.
+ * Computed from a name (e.g. a layer name) so that it does not
+ * depend on construction order.
+ */
+uint32_t get_counter_rng_stream(const std::string& name);
+
 bool save_rng_to_checkpoint_shared(persist& p, const lbann_comm* comm);
 bool load_rng_from_checkpoint_shared(persist& p, const lbann_comm* comm);
 
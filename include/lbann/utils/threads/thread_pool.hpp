@@ -1,17 +1,33 @@
 #ifndef __LBANN_THREAD_POOL_HPP__
 #define __LBANN_THREAD_POOL_HPP__
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <future>
 #include <thread>
 #include <vector>
-#include <unordered_map>
 
-#include "thread_safe_queue.hpp"
+#include "work_stealing_queue.hpp"
 #include "type_erased_function.hpp"
 #include "lbann/utils/exception.hpp"
 
 namespace lbann {
 
+/** \class thread_pool
+ *  \brief A pool of worker threads with work stealing.
+ *
+ *  Each worker owns a work_stealing_queue. Jobs submitted from a
+ *  worker thread are pushed onto that worker's queue, and jobs
+ *  submitted from any other thread are spread round-robin across
+ *  the workers' queues. Idle workers steal from the other queues
+ *  before going to sleep, so fine-grained jobs can be submitted
+ *  without every thread contending on a single queue lock.
+ *
+ *  Jobs that are waited on together belong to a caller-owned
+ *  work_group. A thread waiting on a work group only helps with jobs
+ *  of that group, so unrelated jobs never run nested inside it.
+ */
 class thread_pool {
 public:
   using thread_container_type = std::vector<std::thread>;
@@ -32,6 +48,23 @@ private:
   };
 
 public:
+  /** \class work_group
+   *  \brief Jobs submitted together and waited on together
+   *
+   *  Owned by the caller, so concurrent or nested fan-outs on the
+   *  same pool never share a group.
+   */
+  class work_group {
+  public:
+    work_group() = default;
+    work_group(const work_group&) = delete;
+    work_group& operator=(const work_group&) = delete;
+  private:
+    friend class thread_pool;
+    /** \brief Futures of the jobs in the group */
+    std::vector<std::future<bool>> futures_;
+  };
+
   /** \brief Construct an empty threadpool. Size must be set with launch().
    */
   thread_pool();
@@ -46,7 +79,7 @@ public:
   /** \brief Destroy the threadpool */
   ~thread_pool() {
     all_work_done_ = true;
-    global_work_queue_.wake_all(true);
+    wake_all_threads_();
   }
 
   /** \brief Launch the threads */
@@ -67,34 +100,42 @@ public:
 
     std::packaged_task<return_type()> task(std::move(func));
     auto future = task.get_future();
-    global_work_queue_.push(std::move(task));
+    push_task_(std::move(task), nullptr);
     return future;
   }
 
   /** \brief Submit a job to the pool's queue and place the future
       into a work group */
   template <typename FunctionT>
-  void submit_job_to_work_group(FunctionT func)
+  void submit_job_to_work_group(work_group& group, FunctionT func)
   {
     using return_type = typename std::result_of<FunctionT()>::type;
 
     std::packaged_task<return_type()> task(std::move(func));
-    m_work_group.emplace_back(task.get_future());
-    global_work_queue_.push(std::move(task));
+    group.futures_.emplace_back(task.get_future());
+    push_task_(std::move(task), &group);
 
     return;
   }
 
-  /** \brief Wait for all of the jobs in a work group to finish */
-  bool finish_work_group() {
+  /** \brief Wait for all of the jobs in a work group to finish
+   *
+   *  While jobs of the group are still queued, the calling thread
+   *  runs them itself rather than blocking. Jobs of other groups are
+   *  left to the workers.
+   */
+  bool finish_work_group(work_group& group) {
     std::string error_message;
-    for (auto& f : m_work_group) {
+    for (auto& f : group.futures_) {
+      while (f.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        if (!run_group_task_(group)) { f.wait(); }
+      }
       bool valid = f.get();
       if (!valid) {
         error_message = "invalid future in work group";
       }
     }
-    m_work_group.clear();
+    group.futures_.clear();
     if (!error_message.empty()) { LBANN_ERROR(error_message); }
     return true;
   }
@@ -102,39 +143,78 @@ public:
   /** Query the number of worker threads actually present */
   size_type get_num_threads() const noexcept { return threads_.size(); }
 
-  /** Convert the C++ thread id into a local thread pool id */
+  /** Convert the C++ thread id into a local thread pool id
+   *
+   *  Threads that do not belong to the pool are reported as thread 0.
+   */
   int get_local_thread_id();
 
   /** Convert the C++ thread id into a local thread pool id */
   int get_threads_offset() { return m_threads_offset; }
 
 private:
+  /** \brief A queued job and the work group it belongs to */
+  struct task_ {
+    /** \brief The job */
+    type_erased_function func;
+    /** \brief Work group of the job; nullptr if it has none */
+    const work_group* group;
+  };
+
   /** \brief The task executed by each thread */
-  void do_thread_work_();
+  void do_thread_work_(int tid);
   void do_thread_work_pinned_thread_(int tid, cpu_set_t cpu_set);
 
+  /** \brief Create one task queue per worker thread */
+  void setup_task_queues_(size_type num_threads);
+  /** \brief Add a task to the calling worker's queue, or to a worker
+   *  queue chosen round-robin if not called from a worker */
+  void push_task_(type_erased_function func, const work_group* group);
+  /** \brief Take a task from a worker's own queue or steal one */
+  std::unique_ptr<task_> get_task_(int tid);
+  /** \brief Run a queued task of a work group, looking in the calling
+   *  worker's own queue first
+   *
+   *  \return false if no task of the group is queued
+   */
+  bool run_group_task_(const work_group& group);
+  /** \brief Wake up any sleeping worker threads */
+  void wake_all_threads_();
+  /** \brief Local id of the calling thread; -1 if it is not a worker */
+  int get_worker_id_() const;
+
 private:
 
   /** \brief Container holding the threads */
   thread_container_type threads_;
 
-  /** \brief The thread-safe work queue */
-  thread_safe_queue<type_erased_function> global_work_queue_;
+  /** \brief Per-worker task queues */
+  std::vector<std::unique_ptr<work_stealing_queue<task_>>> task_queues_;
 
-  /** \brief RAII "deleter" for the threads */
-  thread_joiner thread_joiner_;
+  /** \brief Number of tasks submitted but not yet started */
+  std::atomic<long> num_pending_tasks_;
+  /** \brief Number of workers waiting for tasks */
+  std::atomic<int> num_sleeping_threads_;
+  /** \brief Next queue for tasks submitted from outside the pool */
+  std::atomic<size_type> next_queue_;
+
+  /** \brief Mutex for idle workers */
+  std::mutex sleep_mtx_;
+  /** \brief Condition variable tripped when tasks are added */
+  std::condition_variable work_available_;
 
   /** \brief Flag to track if more work is to be done */
   std::atomic<bool> all_work_done_;
 
-  std::mutex m_thread_map_mutex;
-  std::unordered_map<std::thread::id, int> m_thread_id_to_local_id_map;
-
-  /** \brief Work Group */
-  std::vector<std::future<bool>> m_work_group;
-
   int m_threads_offset;
 
+  /** \brief RAII "deleter" for the threads
+   *
+   *  Declared last so that the threads are joined before the task
+   *  queues and synchronization objects are destroyed.
+   */
+  thread_joiner thread_joiner_;
+
 };// class thread_pool
 
 }// namespace lbann
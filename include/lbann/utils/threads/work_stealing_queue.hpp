@@ -0,0 +1,106 @@
+#ifndef __LBANN_WORK_STEALING_QUEUE_HPP__
+#define __LBANN_WORK_STEALING_QUEUE_HPP__
+
+#include <deque>
+#include <iterator>
+#include <mutex>
+
+#include "memory.hpp"
+
+namespace lbann {
+
+/** \class work_stealing_queue
+ *  \brief A double-ended task queue owned by a single worker thread.
+ *
+ *  The owning thread pushes and pops at the back of the queue (LIFO,
+ *  which keeps recently submitted work cache-hot) while other threads
+ *  steal from the front (FIFO, which tends to take the largest
+ *  remaining chunks of work). Each queue has its own lock, so threads
+ *  only contend when they touch the same worker's queue.
+ *
+ *  \tparam T A move-constructible type
+ */
+template <typename T>
+class work_stealing_queue {
+public:
+
+  /** \brief Default constructor; creates an empty queue */
+  work_stealing_queue() = default;
+
+  work_stealing_queue(const work_stealing_queue&) = delete;
+  work_stealing_queue& operator=(const work_stealing_queue&) = delete;
+
+  /** \brief Adds a value to the back of the queue */
+  void push_back(T value)
+  {
+    // Make the new data outside of the lock to minimize lock time
+    auto new_value = make_unique<T>(std::move(value));
+    std::lock_guard<std::mutex> lk(mtx_);
+    queue_.push_back(std::move(new_value));
+  }
+
+  /** \brief Try to remove the most recently added value
+   *
+   *  \return nullptr if empty(); otherwise return a value
+   */
+  std::unique_ptr<T> try_pop_back()
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (queue_.empty()) return nullptr;
+    auto value = std::move(queue_.back());
+    queue_.pop_back();
+    return value;
+  }
+
+  /** \brief Try to remove the least recently added value
+   *
+   *  \return nullptr if empty(); otherwise return a value
+   */
+  std::unique_ptr<T> try_steal()
+  {
+    std::unique_lock<std::mutex> lk(mtx_, std::try_to_lock);
+    if (!lk.owns_lock() || queue_.empty()) return nullptr;
+    auto value = std::move(queue_.front());
+    queue_.pop_front();
+    return value;
+  }
+
+  /** \brief Try to remove the most recently added value that
+   *  satisfies a predicate
+   *
+   *  \return nullptr if no value satisfies the predicate; otherwise
+   *  return a value
+   */
+  template <typename PredicateT>
+  std::unique_ptr<T> try_remove_if(PredicateT pred)
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    for (auto it = queue_.rbegin(); it != queue_.rend(); ++it) {
+      if (pred(**it)) {
+        auto value = std::move(*it);
+        queue_.erase(std::next(it).base());
+        return value;
+      }
+    }
+    return nullptr;
+  }
+
+  /** Check if queue is empty */
+  bool empty() const
+  {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return queue_.empty();
+  }
+
+private:
+
+  /** \brief The mutex protecting the queue */
+  mutable std::mutex mtx_;
+
+  /** \brief The queued values */
+  std::deque<std::unique_ptr<T>> queue_;
+
+};// class work_stealing_queue
+
+}// namespace lbann
+#endif /* __LBANN_WORK_STEALING_QUEUE_HPP__ */
@@ -70,12 +70,36 @@ int main(int argc, char *argv[]) {
       LBANN_ERROR("Unable to reload model");
     }
 
-    /// Interleave the inference between the models so that they can use a shared data reader
-    /// Enable shared testing data readers on the command line via --share_testing_data_readers=1
-    El::Int num_samples = models[0]->get_num_iterations_per_epoch(execution_mode::testing);
-    for(El::Int s = 0; s < num_samples; s++) {
-      for(auto m : models) {
-        m->evaluate(execution_mode::testing, 1);
+    if(opts->has_string("serve")) {
+      /// Serve inference requests on a local socket with the first model
+      /// until a client sends an empty request
+      if(!opts->has_string("serve_layer")) {
+        LBANN_ERROR("serving inference requires --serve_layer=<string>");
+      }
+      std::string socket_path = opts->get_string("serve");
+      if(comm->get_num_models() > 1) {
+        socket_path += "_" + std::to_string(comm->get_model_rank());
+      }
+      inference_server server(models[0],
+                              opts->get_string("serve_layer"),
+                              opts->get_int("serve_max_batch", 0),
+                              opts->get_double("serve_max_delay", 1.0) / 1000);
+      if(comm->am_model_master()) {
+        server.listen(socket_path);
+        std::cout << "serving inference requests on " << socket_path << std::endl;
+      }
+      server.serve();
+      if(comm->am_model_master()) {
+        server.print_statistics(std::cout);
+      }
+    } else {
+      /// Interleave the inference between the models so that they can use a shared data reader
+      /// Enable shared testing data readers on the command line via --share_testing_data_readers=1
+      El::Int num_samples = models[0]->get_num_iterations_per_epoch(execution_mode::testing);
+      for(El::Int s = 0; s < num_samples; s++) {
+        for(auto m : models) {
+          m->evaluate(execution_mode::testing, 1);
+        }
       }
     }
 
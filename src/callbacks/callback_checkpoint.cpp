@@ -50,6 +50,10 @@ void lbann_callback_checkpoint::on_validation_end(model *m) {
     checkpoint(m);
   }
   p.set_cb_type(callback_type::invalid);
+}
+// Make sure the last asynchronous checkpoint is marked as complete
+void lbann_callback_checkpoint::on_train_end(model *m) {
+  finish_checkpoint(m);
 }
  // Interval defined with checkpoint_steps or ckpt_dist_steps
 void lbann_callback_checkpoint::on_batch_end(model *m) {
@@ -144,6 +148,11 @@ bool lbann_callback_checkpoint::checkpoint(model *m) {
   comm->model_broadcast(0, epoch);
   comm->model_broadcast(0, step);
 
+  // Finish the previous checkpoint before staging a new one
+  finish_checkpoint(m);
+  m_pending_epoch = epoch;
+  m_pending_step = step;
+
   // Distributed ckpt
   if(m_checkpoint_dist){
     // prepend per rank directory with shared checkpoint dir name
@@ -159,12 +168,12 @@ bool lbann_callback_checkpoint::checkpoint(model *m) {
     p.open_checkpoint(epochdir.c_str());
     // Call top level save to checkpoint function in model, in turn calls save to checkpoint functions for other model classes (weights, layers)
     m->save_to_checkpoint_distributed(p);
-    p.close_checkpoint();
-    // Print latest checkpoint to file
+    // Print latest checkpoint to file once all ranks have written it
     if (comm->am_model_master()) {
       latest_file = get_last_distributed_checkpoint_filename(m, dir);
-      write_latest(latest_file, epoch, step);
+      m_pending_latest_files.push_back(latest_file);
     }
+    p.close_checkpoint();
   }
   // Shared checkpoint, logic identical to Distributed.i
   if(m_checkpoint_shared){
@@ -177,12 +186,16 @@ bool lbann_callback_checkpoint::checkpoint(model *m) {
     // Need to give other ranks knowledge of checkpoint dir for writing of rank specific rng state
     comm->model_broadcast(0, &(p.m_checkpoint_dir[0]), sizeof(p.m_checkpoint_dir));
     m->save_to_checkpoint_shared(p);
-    // close our checkpoint
-    p.close_checkpoint();
     if (comm->am_model_master()) {
       latest_file = get_last_shared_checkpoint_filename(m, dir);
-      write_latest(latest_file, epoch, step);
+      m_pending_latest_files.push_back(latest_file);
     }
+    // close our checkpoint
+    p.close_checkpoint();
+  }
+  m_checkpoint_pending = true;
+  if (!p.is_async()) {
+    finish_checkpoint(m);
   }
 
   uint64_t bytes_count = p.get_bytes();
@@ -193,8 +206,10 @@ bool lbann_callback_checkpoint::checkpoint(model *m) {
     if (secs > 0.0) {
       bw = EvalType(bytes_count) / (secs * 1024.0 * 1024.0);
     }
-    printf("[%s.%d] Checkpoint complete: Epoch=%d Step=%d (%f secs, %llu bytes, %f MB/sec)\n",
-           m->get_name().c_str(), comm->get_model_rank(), epoch, step, secs, (unsigned long long) bytes_count, bw);
+    printf("[%s.%d] Checkpoint %s: Epoch=%d Step=%d (%f secs, %llu bytes, %f MB/sec)\n",
+           m->get_name().c_str(), comm->get_model_rank(),
+           (p.is_async() ? "staged" : "complete"),
+           epoch, step, secs, (unsigned long long) bytes_count, bw);
     fflush(stdout);
   }
   // record last checkpoint time in case checkpoint_secs interval defined.
@@ -203,6 +218,40 @@ bool lbann_callback_checkpoint::checkpoint(model *m) {
   return true;
 }
 
+void lbann_callback_checkpoint::finish_checkpoint(model *m) {
+  if (!m_checkpoint_pending) {
+    return;
+  }
+  m_checkpoint_pending = false;
+  lbann_comm *comm = m->get_comm();
+
+  // Check that every rank has written its checkpoint files
+  int failed = 0;
+  try {
+    p.wait_for_checkpoints();
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    failed = 1;
+  }
+  failed = comm->model_allreduce(failed, El::mpi::MAX);
+
+  // Print latest checkpoint to file
+  if (comm->am_model_master()) {
+    if (failed) {
+      std::stringstream err;
+      err << "checkpoint at epoch " << m_pending_epoch
+          << " step " << m_pending_step << " failed on some ranks "
+          << "and is not marked as the latest checkpoint";
+      LBANN_WARNING(err.str());
+    } else {
+      for (const auto& latest_file : m_pending_latest_files) {
+        write_latest(latest_file, m_pending_epoch, m_pending_step);
+      }
+    }
+  }
+  m_pending_latest_files.clear();
+}
+
 // Restart Shared/Distributed
 bool lbann_callback_checkpoint::restart(model *m) {
   // if the checkpoint directory is not defined, bail
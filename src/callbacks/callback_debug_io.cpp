@@ -80,6 +80,8 @@ void lbann::lbann_callback_debug_io::print_fp_start(model *m, generic_input_laye
             << " @" << input->get_data_reader()->get_position()
     //              << " %" << input->get_data_reader()->get_batch_stride()
             << " ^" << input->get_data_reader()->get_sample_stride()
+            << " fetch @" << input->get_data_reader()->get_fetch_position()
+            << " zero-filled " << input->get_data_reader()->get_zero_filled_bytes() << "B"
             << std::endl;
 }
 
@@ -29,6 +29,7 @@
 #include "lbann/utils/random.hpp"
 #include "lbann/optimizers/sgd.hpp"
 #include "lbann/optimizers/adam.hpp"
+#include <limits>
 
 namespace lbann {
 
@@ -152,6 +153,86 @@ void exchange_models__sendrecv_weights(lbann_comm& comm,
 
 }
 
+/** Whether weights are exchanged with partner. */
+bool is_exchanged(const weights& w,
+                  const std::set<std::string>& weights_names) {
+  return (weights_names.empty()
+          || (std::find(weights_names.begin(), weights_names.end(),
+                        w.get_name())
+              != weights_names.end()));
+}
+
+/** Local matrices with model data of weights.
+ *
+ *  Includes the weights values and the state of SGD and Adam
+ *  optimizers.
+ */
+std::vector<AbsMat*> get_model_data(weights& w) {
+  std::vector<AbsMat*> data;
+  data.push_back(&w.get_values().Matrix());
+  auto* opt = w.get_optimizer();
+  auto* opt_sgd = dynamic_cast<sgd*>(opt);
+  if (opt_sgd != nullptr) {
+    data.push_back(&opt_sgd->get_velocity().Matrix());
+  }
+  auto* opt_adam = dynamic_cast<adam*>(opt);
+  if (opt_adam != nullptr) {
+    data.push_back(&opt_adam->get_moment1().Matrix());
+    data.push_back(&opt_adam->get_moment2().Matrix());
+  }
+  return data;
+}
+
+/** Copy between model data and a contiguous CPU buffer.
+ *
+ *  @param pack     Whether to copy model data into the buffer or
+ *                  buffer contents into model data. The buffer is
+ *                  resized when packing.
+ */
+void copy_model_data(const std::vector<weights*>& model_weights,
+                     const std::set<std::string>& weights_names,
+                     std::vector<DataType>& buffer,
+                     bool pack) {
+
+  // Get local matrices to copy
+  std::vector<AbsMat*> matrices;
+  for (auto* w : model_weights) {
+    if (is_exchanged(*w, weights_names)) {
+      for (auto* mat : get_model_data(*w)) {
+        matrices.push_back(mat);
+      }
+    }
+  }
+  El::Int size = 0;
+  for (const auto* mat : matrices) {
+    size += mat->Height() * mat->Width();
+  }
+  if (pack) {
+    buffer.resize(size);
+  } else if ((El::Int) buffer.size() != size) {
+    std::stringstream err;
+    err << "expected " << size << " entries of model data "
+        << "from partner trainer, but got " << buffer.size();
+    LBANN_ERROR(err.str());
+  }
+
+  // Copy between matrices and buffer
+  El::Int offset = 0;
+  for (auto* mat : matrices) {
+    const El::Int height = mat->Height();
+    const El::Int width = mat->Width();
+    El::Matrix<DataType, El::Device::CPU> segment;
+    segment.Attach(height, width, buffer.data() + offset, height);
+    if (pack) {
+      El::Copy(*mat, segment);
+    } else {
+      El::Copy(segment, *mat);
+    }
+    offset += height * width;
+  }
+
+}
+
 void exchange_models__checkpoint_file(lbann_comm& comm,
                                       El::Int partner_trainer,
                                       model& m,
@@ -239,15 +320,35 @@ void restore_local_model__checkpoint_file(lbann_comm& comm, model& m) {
 
 }
 
-/** Get mean metric value with validation set. */
-EvalType evaluate(model& m, const std::string& metric_name) {
+/** Get mean metric value with validation set.
+ *
+ *  @param num_mini_batches Number of validation mini-batches to
+ *                          evaluate, starting from the beginning of
+ *                          the current validation epoch. It is
+ *                          clamped to the number of mini-batches in
+ *                          an epoch. If zero, then the whole
+ *                          validation set is used.
+ */
+EvalType evaluate(model& m,
+                  const std::string& metric_name,
+                  El::Int num_mini_batches) {
 
   // Make sure data readers finish asynchronous work
   const auto original_mode = m.get_execution_mode();
   m.collect_background_data_fetch(original_mode);
 
   // Evaluate model on validation set
-  m.evaluate(execution_mode::validation);
+  // Note: When scoring with a subset of the validation set, the
+  // validation data set is rewound so that every model sees the
+  // same mini-batches.
+  if (num_mini_batches > 0) {
+    num_mini_batches = std::min(num_mini_batches,
+                                El::Int(m.get_num_iterations_per_epoch(execution_mode::validation)));
+    m.reset_data_set(execution_mode::validation);
+    m.evaluate(execution_mode::validation, num_mini_batches);
+  } else {
+    m.evaluate(execution_mode::validation);
+  }
 
   // Get metric value
   bool found_metric = false;
@@ -279,19 +380,38 @@ lbann_callback_ltfb::lbann_callback_ltfb(El::Int batch_interval,
                                          std::set<std::string> weights_names,
                                          bool low_score_wins,
                                          communication_algorithm comm_algo,
+                                         El::Int eval_mini_batches,
+                                         bool async_exchange,
                                          lbann_summary *summarizer)
-  : lbann_callback(batch_interval, summarizer),
+  // Note: With asynchronous exchanges, the tournament is completed
+  // at the step after it starts, so the callback is invoked every
+  // step.
+  : lbann_callback(async_exchange ? 1 : batch_interval, summarizer),
+    m_tournament_interval(std::max(batch_interval, El::Int(1))),
     m_metric_name(std::move(metric_name)),
     m_weights_names(std::move(weights_names)),
     m_low_score_wins(low_score_wins),
-    m_comm_algo(comm_algo) {}
+    m_comm_algo(comm_algo),
+    m_eval_mini_batches(std::max(eval_mini_batches, El::Int(0))),
+    m_async_exchange(async_exchange),
+    m_pending_partner(-1) {
+  if (m_async_exchange
+      && m_comm_algo != communication_algorithm::sendrecv_weights) {
+    LBANN_ERROR("asynchronous LTFB exchanges are only supported "
+                "with the sendrecv_weights communication algorithm");
+  }
+}
 
 lbann_callback_ltfb::lbann_callback_ltfb(const lbann_callback_ltfb& other) :
   lbann_callback(other),
+  m_tournament_interval(other.m_tournament_interval),
   m_metric_name(other.m_metric_name),
   m_weights_names(other.m_weights_names),
   m_low_score_wins(other.m_low_score_wins),
-  m_comm_algo(other.m_comm_algo) {
+  m_comm_algo(other.m_comm_algo),
+  m_eval_mini_batches(other.m_eval_mini_batches),
+  m_async_exchange(other.m_async_exchange),
+  m_pending_partner(-1) {
 
   // Deep copy
   m_workspace_weights.clear();
@@ -306,10 +426,20 @@ lbann_callback_ltfb& lbann_callback_ltfb::operator=(const lbann_callback_ltfb& o
   lbann_callback::operator=(other);
 
   // Shallow copies
+  m_tournament_interval = other.m_tournament_interval;
   m_metric_name = other.m_metric_name;
   m_weights_names = other.m_weights_names;
   m_low_score_wins = other.m_low_score_wins;
   m_comm_algo = other.m_comm_algo;
+  m_eval_mini_batches = other.m_eval_mini_batches;
+  m_async_exchange = other.m_async_exchange;
+
+  // Exchanges in progress are not copied
+  if (m_pending_partner >= 0) {
+    El::mpi::WaitAll(m_requests.size(), m_requests.data());
+  }
+  m_pending_partner = -1;
+  m_requests.clear();
 
   // Deep copy
   m_workspace_weights.clear();
@@ -321,6 +451,13 @@ lbann_callback_ltfb& lbann_callback_ltfb::operator=(const lbann_callback_ltfb& o
   return *this;
 }
 
+lbann_callback_ltfb::~lbann_callback_ltfb() {
+  // Make sure no exchange is using the communication buffers
+  if (m_pending_partner >= 0) {
+    El::mpi::WaitAll(m_requests.size(), m_requests.data());
+  }
+}
+
 void lbann_callback_ltfb::setup(model *m) {
 
   // Create workspace objects
@@ -353,23 +490,88 @@ void lbann_callback_ltfb::on_batch_begin(model *m) {
                                + "model \"" + m->get_name() + "\", "
                                + "step " + std::to_string(step)
                                + "): ");
+
+  // Finish tournament with asynchronous exchange
+  if (m_pending_partner >= 0) {
+    finish_tournament(*m, m_pending_partner, message_prefix);
+  }
+  if (step % m_tournament_interval != 0) { return; }
+
   if (comm.am_world_master()) {
     std::cout << message_prefix + "starting tournament...\n";
   }
 
+  // Start asynchronous exchange
+  // Note: The tournament is finished at the next step.
+  if (m_async_exchange) {
+    start_async_exchange(*m, message_prefix);
+    return;
+  }
+
   // Determine partner model for tournament
-  const El::Int local_trainer = comm.get_model_rank();
   const El::Int partner_trainer
     = get_partner_trainer(comm, message_prefix);
+  finish_tournament(*m, partner_trainer, message_prefix);
+
+}
+
+void lbann_callback_ltfb::start_async_exchange(model& m,
+                                               const std::string& message_prefix) {
+  auto&& comm = *m.get_comm();
+
+  // Determine partner model for tournament
+  const El::Int partner_trainer
+    = get_partner_trainer(comm, message_prefix);
+  const El::Int rank_in_trainer = comm.get_rank_in_model();
+  const El::Int procs_per_trainer = comm.get_procs_per_model();
+  const El::Int partner_rank_in_world = (partner_trainer * procs_per_trainer
+                                         + rank_in_trainer);
+
+  // Take snapshot of local model data
+  copy_model_data(m.get_weights(), m_weights_names, m_send_buffer, true);
+  m_recv_buffer.resize(m_send_buffer.size());
+  if (m_send_buffer.size() > (size_t) std::numeric_limits<int>::max()) {
+    LBANN_ERROR("model data is too large for asynchronous LTFB exchange");
+  }
+  const int count = m_send_buffer.size();
+
+  // Start exchange with partner trainer
+  if (comm.am_world_master()) {
+    std::cout << message_prefix + "exchanging model data asynchronously...\n";
+  }
+  m_requests.resize(2);
+  comm.nb_tagged_recv(m_recv_buffer.data(), count,
+                      partner_rank_in_world, 0,
+                      m_requests[0], comm.get_world_comm());
+  comm.nb_tagged_send(m_send_buffer.data(), count,
+                      partner_rank_in_world, 0,
+                      m_requests[1], comm.get_world_comm());
+  m_pending_partner = partner_trainer;
+
+}
+
+void lbann_callback_ltfb::finish_tournament(model& m,
+                                            El::Int partner_trainer,
+                                            const std::string& message_prefix) {
+  auto&& comm = *m.get_comm();
+  const El::Int local_trainer = comm.get_model_rank();
+
+  // Wait for asynchronous exchange
+  const bool async_exchange = (m_pending_partner >= 0);
+  if (async_exchange) {
+    comm.wait_all(m_requests);
+    m_requests.clear();
+    m_pending_partner = -1;
+  }
 
   // Evaluate local model
   if (comm.am_world_master()) {
     std::cout << message_prefix + "evaluating local model...\n";
   }
-  const auto local_score = evaluate(*m, m_metric_name);
+  const auto local_score = evaluate(m, m_metric_name, m_eval_mini_batches);
 
   // Store local model data
-  auto&& model_weights = m->get_weights();
+  auto&& model_weights = m.get_weights();
   std::vector<weights*> local_weights;
   for (size_t i = 0; i < model_weights.size(); ++i) {
     local_weights.push_back(m_workspace_weights[i].get());
@@ -377,33 +579,43 @@ void lbann_callback_ltfb::on_batch_begin(model *m) {
   }
 
   // Exchange model data with partner trainer
-  if (comm.am_world_master()) {
-    std::cout << message_prefix + "exchanging model data...\n";
-  }
-  switch (m_comm_algo) {
-  case communication_algorithm::sendrecv_weights:
-    exchange_models__sendrecv_weights(comm,
-                                      partner_trainer,
-                                      m_weights_names,
-                                      local_weights,
-                                      model_weights);
-    break;
-  case communication_algorithm::checkpoint_file:
-    exchange_models__checkpoint_file(comm,
-                                     partner_trainer,
-                                     *m,
-                                     m_weights_names,
-                                     local_weights);
-    break;
-  default:
-    LBANN_ERROR("invalid LTFB communication algorithm");
+  if (async_exchange) {
+    copy_model_data(model_weights, m_weights_names, m_recv_buffer, false);
+  } else {
+    if (comm.am_world_master()) {
+      std::cout << message_prefix + "exchanging model data...\n";
+    }
+    switch (m_comm_algo) {
+    case communication_algorithm::sendrecv_weights:
+      exchange_models__sendrecv_weights(comm,
+                                        partner_trainer,
+                                        m_weights_names,
+                                        local_weights,
+                                        model_weights);
+      break;
+    case communication_algorithm::checkpoint_file:
+      exchange_models__checkpoint_file(comm,
+                                       partner_trainer,
+                                       m,
+                                       m_weights_names,
+                                       local_weights);
+      break;
+    default:
+      LBANN_ERROR("invalid LTFB communication algorithm");
+    }
   }
 
   // Evaluate partner model
   if (comm.am_world_master()) {
     std::cout << message_prefix + "evaluating partner model...\n";
   }
-  const auto& partner_score = evaluate(*m, m_metric_name);
+  const auto& partner_score = evaluate(m, m_metric_name, m_eval_mini_batches);
+
+  // Rewind validation data set so that regular validation is not
+  // affected by tournament
+  if (m_eval_mini_batches > 0) {
+    m.reset_data_set(execution_mode::validation);
+  }
 
   // Choose tournament winner
   // Note: restore local model data if it got a better score.
@@ -418,7 +630,7 @@ void lbann_callback_ltfb::on_batch_begin(model *m) {
       }
       break;
     case communication_algorithm::checkpoint_file:
-      restore_local_model__checkpoint_file(comm, *m);
+      restore_local_model__checkpoint_file(comm, m);
       break;
     default:
       LBANN_ERROR("invalid LTFB communication algorithm");
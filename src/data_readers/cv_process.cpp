@@ -45,7 +45,8 @@ namespace lbann {
 cv_process::cv_process(const cv_process& rhs)
   : m_flip(rhs.m_flip), m_split(rhs.m_split),
     m_is_normalizer_set(rhs.m_is_normalizer_set),
-    m_normalizer_idx(rhs.m_normalizer_idx)
+    m_normalizer_idx(rhs.m_normalizer_idx),
+    m_reduced_decoding(rhs.m_reduced_decoding)
 {
   for (size_t i = 0u; i < rhs.m_transforms.size(); ++i) {
     std::unique_ptr<cv_transform> p(rhs.m_transforms[i]->clone());
@@ -74,6 +75,7 @@ cv_process& cv_process::operator=(const cv_process& rhs) {
   m_split = rhs.m_split;
   m_is_normalizer_set = rhs.m_is_normalizer_set;
   m_normalizer_idx = rhs.m_normalizer_idx;
+  m_reduced_decoding = rhs.m_reduced_decoding;
 
   m_transforms.clear();
 
@@ -169,6 +171,36 @@ std::vector<unsigned int> cv_process::get_data_dims() const {
   return {0u, 0u};
 }
 
+int cv_process::get_decoding_reduction(const int width, const int height) const {
+  if (!m_reduced_decoding || m_transforms.empty()) {
+    return 1;
+  }
+
+  // The size to which the first transform shrinks an image
+  int target_width = 0;
+  int target_height = 0;
+  const auto* const c = dynamic_cast<const cv_cropper*>(m_transforms[0].get());
+  const auto* const r = dynamic_cast<const cv_resizer*>(m_transforms[0].get());
+  if ((c != nullptr) && c->is_roi_set()) {
+    target_width = c->get_roi_size().first;
+    target_height = c->get_roi_size().second;
+  } else if (r != nullptr) {
+    target_width = static_cast<int>(r->get_width());
+    target_height = static_cast<int>(r->get_height());
+  }
+  if ((target_width <= 0) || (target_height <= 0)) {
+    return 1;
+  }
+
+  for (int reduction = 8; reduction > 1; reduction /= 2) {
+    if ((width / reduction >= target_width) &&
+        (height / reduction >= target_height)) {
+      return reduction;
+    }
+  }
+  return 1;
+}
+
 /**
  * Call this before image saving/exporting in postprocessing if inverse normalization
  * is needed to save image.  Unless normalization is followed by a transform, inverse
@@ -291,7 +323,8 @@ std::string cv_process::get_description() const {
   os << get_type() + ":" << std::endl
      << " - flip: " << cv_transform::flip_desc(m_flip) << std::endl
      << " - split channels: " << m_split << std::endl
-     << " - is normalizer set: " << m_is_normalizer_set << std::endl;
+     << " - is normalizer set: " << m_is_normalizer_set << std::endl
+     << " - reduced decoding: " << m_reduced_decoding << std::endl;
 
   if (m_is_normalizer_set)
      os << " - normalizer index: " << m_normalizer_idx << std::endl;
@@ -30,6 +30,7 @@
 #include "lbann/utils/exception.hpp"
 #include "lbann/utils/timer.hpp"
 #include "lbann/utils/file_utils.hpp"
+#include <algorithm>
 //#include <iostream>
 
 #ifdef LBANN_HAS_OPENCV
@@ -107,6 +108,96 @@ cv::Mat cv_utils::lbann_imread(const std::string& img_file_path, int flags, std:
   return image;
 }
 
+cv::Mat cv_utils::lbann_imread(const std::string& img_file_path, const cv_process& pp, std::vector<char>& buf, cv::Mat* cv_buf) {
+  bool ok = lbann::load_file(img_file_path, buf);
+  if (!ok) {
+    throw lbann_exception("lbann_imread() : failed to load " + img_file_path);
+  }
+
+  using InputBuf_T = lbann::cv_image_type<uint8_t>;
+  const cv::Mat inbuf(1, buf.size(), InputBuf_T::T(1), buf.data());
+
+  return lbann_imdecode(inbuf, pp, cv_buf);
+}
+
+cv::Mat cv_utils::lbann_imdecode(cv::InputArray inbuf, const cv_process& pp, cv::Mat* cv_buf) {
+  int flags = cv::IMREAD_ANYCOLOR | cv::IMREAD_ANYDEPTH;
+
+#ifdef _LBANN_CV_REDUCED_DECODING_
+  if (pp.is_reduced_decoding()) {
+    const cv::Mat buf = inbuf.getMat();
+    int width = 0, height = 0, channels = 0;
+    if (buf.isContinuous() &&
+        get_jpeg_info(buf.ptr<uint8_t>(), buf.total() * buf.elemSize(), width, height, channels) &&
+        ((channels == 1) || (channels == 3))) {
+      // The decoder may rotate the image according to its EXIF orientation,
+      // so the reduction must be valid for either orientation. The reduced
+      // modes also fix the number of channels, which is the same as what
+      // cv::IMREAD_ANYCOLOR produces for 8-bit JPEG images.
+      const int reduction = std::min(pp.get_decoding_reduction(width, height),
+                                     pp.get_decoding_reduction(height, width));
+      switch (reduction) {
+        case 2: flags = (channels == 1)? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_REDUCED_COLOR_2; break;
+        case 4: flags = (channels == 1)? cv::IMREAD_REDUCED_GRAYSCALE_4 : cv::IMREAD_REDUCED_COLOR_4; break;
+        case 8: flags = (channels == 1)? cv::IMREAD_REDUCED_GRAYSCALE_8 : cv::IMREAD_REDUCED_COLOR_8; break;
+        default: break;
+      }
+    }
+  }
+#endif // _LBANN_CV_REDUCED_DECODING_
+
+  if (cv_buf != nullptr) {
+    return cv::imdecode(inbuf, flags, cv_buf);
+  }
+  return cv::imdecode(inbuf, flags);
+}
+
+bool cv_utils::get_jpeg_info(const uint8_t* data, const size_t size, int& width, int& height, int& channels) {
+  // A JPEG stream starts with the SOI marker (0xFFD8) followed by segments,
+  // each of which begins with a marker (0xFF, code) and a 2-byte big-endian
+  // length that includes the length field itself. The image size and the
+  // number of components are in the start-of-frame (SOF) segment.
+  if ((data == nullptr) || (size < 4u) || (data[0] != 0xFF) || (data[1] != 0xD8)) {
+    return false;
+  }
+
+  size_t pos = 2u;
+  while (pos + 4u <= size) {
+    if (data[pos] != 0xFF) {
+      return false;
+    }
+    const uint8_t code = data[pos+1];
+    if (code == 0xFF) { // fill byte
+      ++pos;
+      continue;
+    }
+    if ((code == 0x01) || ((code >= 0xD0) && (code <= 0xD7))) { // standalone markers
+      pos += 2u;
+      continue;
+    }
+    if ((code == 0xD9) || (code == 0xDA)) { // end of image or start of scan before any frame
+      return false;
+    }
+    const size_t length = (static_cast<size_t>(data[pos+2]) << 8) | data[pos+3];
+    if (length < 2u) {
+      return false;
+    }
+    // SOF0 to SOF15, except DHT (0xC4), JPG (0xC8), and DAC (0xCC)
+    if ((code >= 0xC0) && (code <= 0xCF) &&
+        (code != 0xC4) && (code != 0xC8) && (code != 0xCC)) {
+      if ((length < 8u) || (pos + 10u > size)) {
+        return false;
+      }
+      height = (static_cast<int>(data[pos+5]) << 8) | data[pos+6];
+      width = (static_cast<int>(data[pos+7]) << 8) | data[pos+8];
+      channels = data[pos+9];
+      return ((width > 0) && (height > 0));
+    }
+    pos += 2u + length;
+  }
+  return false;
+}
+
 
 } // end of namespace lbann
 #endif // LBANN_HAS_OPENCV
@@ -76,7 +76,7 @@ void generic_data_reader::shuffle_indices(rng_gen& gen) {
 bool lbann::generic_data_reader::fetch_data_block(CPUMat& X, El::Int thread_id, El::Int mb_size, El::Matrix<El::Int>& indices_fetched) {
   std::string error_message;
   for (int s = thread_id; s < mb_size; s+=m_io_thread_pool->get_num_threads()) {
-    int n = m_current_pos + (s * m_sample_stride);
+    int n = m_fetch_pos + (s * m_sample_stride);
     int index = m_shuffled_indices[n];
     bool valid = fetch_datum(X, index, s);
     if (!valid) {
@@ -88,9 +88,28 @@ bool lbann::generic_data_reader::fetch_data_block(CPUMat& X, El::Int thread_id,
   return true;
 }
 
+bool lbann::generic_data_reader::fetch_data_dynamic(CPUMat& X, El::Int mb_size, El::Matrix<El::Int>& indices_fetched, std::atomic<El::Int>& next_sample) {
+  const El::Int chunk_size = m_dynamic_fetch_chunk_size;
+  for (El::Int first = next_sample.fetch_add(chunk_size);
+       first < mb_size;
+       first = next_sample.fetch_add(chunk_size)) {
+    const El::Int last = std::min(first + chunk_size, mb_size);
+    for (El::Int s = first; s < last; ++s) {
+      int n = m_fetch_pos + (s * m_sample_stride);
+      int index = m_shuffled_indices[n];
+      bool valid = fetch_datum(X, index, s);
+      if (!valid) {
+        LBANN_ERROR("invalid datum (index " + std::to_string(index) + ")");
+      }
+      indices_fetched.Set(s, 0, index);
+    }
+  }
+  return true;
+}
+
 int lbann::generic_data_reader::fetch_data(CPUMat& X, El::Matrix<El::Int>& indices_fetched) {
   #ifdef DEBUG
-  if (m_current_pos == 0) {
+  if (m_fetch_pos == 0) {
     if (is_master()) {
       std::cout << "role: " << get_role() << " model: " << m_model->get_name()
                 << " shuffled indices: ";
@@ -104,21 +123,23 @@ int lbann::generic_data_reader::fetch_data(CPUMat& X, El::Matrix<El::Int>& indic
 
   int loaded_batch_size = get_loaded_mini_batch_size();
 
-  const int end_pos = std::min(static_cast<size_t>(m_current_pos+loaded_batch_size), m_shuffled_indices.size());
-  const int mb_size = std::min(El::Int{((end_pos - m_current_pos) + m_sample_stride - 1) / m_sample_stride},
+  const int end_pos = std::min(static_cast<size_t>(m_fetch_pos+loaded_batch_size), m_shuffled_indices.size());
+  const int mb_size = std::min(El::Int{((end_pos - m_fetch_pos) + m_sample_stride - 1) / m_sample_stride},
       X.Width());
 
-  if (!m_save_minibatch_indices) {
-    El::Zeros_seq(X, X.Height(), X.Width());
-    El::Zeros_seq(indices_fetched, mb_size, 1);
-  }
+  // Columns that are not fetched must not keep stale data. Only
+  // indices are recorded when saving mini-batch indices, so no column
+  // is filled in that case.
+  m_zero_filled_bytes.m_value = 0;
+  zero_fill_mini_batch(X, mb_size, m_save_minibatch_indices);
+  El::Zeros_seq(indices_fetched, mb_size, 1);
 
   if(!position_valid()) {
     if(position_is_overrun()) {
       return 0;
     }else {
       LBANN_ERROR(std::string{} + "generic data reader load error: !position_valid"
-                  + " -- current pos = " + std::to_string(m_current_pos)
+                  + " -- fetch pos = " + std::to_string(m_fetch_pos)
                   + " and there are " + std::to_string(m_shuffled_indices.size()) + " indices");
     }
   }
@@ -140,12 +161,33 @@ int lbann::generic_data_reader::fetch_data(CPUMat& X, El::Matrix<El::Int>& indic
   if (m_save_minibatch_indices) {
     m_my_minibatch_indices.resize(m_my_minibatch_indices.size() + 1);
     for (int s = 0; s < mb_size; s++) {
-      int n = m_current_pos + (s * m_sample_stride);
+      int n = m_fetch_pos + (s * m_sample_stride);
       m_my_minibatch_indices.back().push_back(n);
     }
   }
 
+  else if (m_dynamic_fetch_chunk_size > 0) {
+    // Every thread claims chunks of samples from a shared cursor, so
+    // the mini-batch completes when the total work is done rather
+    // than when the slowest static block is done
+    std::atomic<El::Int> next_sample(0);
+    thread_pool::work_group group;
+    const int num_threads = m_io_thread_pool->get_num_threads();
+    const El::Int num_chunks = (mb_size + m_dynamic_fetch_chunk_size - 1) / m_dynamic_fetch_chunk_size;
+    for (El::Int t = 1; t < std::min(El::Int{num_threads}, num_chunks); t++) {
+      m_io_thread_pool->submit_job_to_work_group(
+        group,
+        std::bind(&generic_data_reader::fetch_data_dynamic, this, std::ref(X),
+                  mb_size, std::ref(indices_fetched), std::ref(next_sample)));
+    }
+    fetch_data_dynamic(X, mb_size, indices_fetched, next_sample);
+
+    // Wait for all of the threads to finish
+    m_io_thread_pool->finish_work_group(group);
+  }
+
   else {
+    thread_pool::work_group group;
     for (int t = 0; t < static_cast<int>(m_io_thread_pool->get_num_threads()); t++) {
       // Queue up work into other threads and then finish off the
       // mini-batch in the active thread
@@ -153,6 +195,7 @@ int lbann::generic_data_reader::fetch_data(CPUMat& X, El::Matrix<El::Int>& indic
         continue;
       }else {
         m_io_thread_pool->submit_job_to_work_group(
+          group,
           std::bind(&generic_data_reader::fetch_data_block, this, std::ref(X), t,
                     mb_size, std::ref(indices_fetched)));
       }
@@ -160,8 +203,10 @@ int lbann::generic_data_reader::fetch_data(CPUMat& X, El::Matrix<El::Int>& indic
     fetch_data_block(X, m_io_thread_pool->get_local_thread_id(), mb_size, indices_fetched);
 
     // Wait for all of the threads to finish
-    m_io_thread_pool->finish_work_group();
+    m_io_thread_pool->finish_work_group(group);
+  }
 
+  if (!m_save_minibatch_indices) {
     /// Allow each thread to perform any postprocessing necessary on the
     /// data source prior to fetching data
     for (int t = 0; t < static_cast<int>(m_io_thread_pool->get_num_threads()); t++) {
@@ -172,6 +217,20 @@ int lbann::generic_data_reader::fetch_data(CPUMat& X, El::Matrix<El::Int>& indic
   return mb_size;
 }
 
+void lbann::generic_data_reader::zero_fill_mini_batch(CPUMat& X, El::Int mb_size, bool all_columns) {
+  El::Int first_col = 0;
+  if (m_zero_fill_tail_only && !all_columns) {
+    first_col = std::min(std::max(mb_size, El::Int{0}), X.Width());
+  }
+  if (first_col == 0) {
+    El::Zeros_seq(X, X.Height(), X.Width());
+  } else if (first_col < X.Width()) {
+    auto X_tail = X(El::ALL, El::IR(first_col, X.Width()));
+    El::Zero(X_tail);
+  }
+  m_zero_filled_bytes.m_value += X.Height() * (X.Width() - first_col) * sizeof(DataType);
+}
+
 void lbann::generic_data_reader::set_jag_variables(int mb_size) {
   // all min_batches have the same number of indices;
   // this probably causes a few indices to be discarded,
@@ -185,6 +244,7 @@ void lbann::generic_data_reader::set_jag_variables(int mb_size) {
 
   m_reset_mini_batch_index = 0;
   m_loaded_mini_batch_idx = 0;
+  m_consumed_mini_batch_idx = 0;
   m_current_mini_batch_idx = 0;
 
   m_stride_to_next_mini_batch = mb_size;
@@ -200,20 +260,21 @@ void lbann::generic_data_reader::set_jag_variables(int mb_size) {
 
 int lbann::generic_data_reader::fetch_labels(CPUMat& Y) {
   int loaded_batch_size = get_loaded_mini_batch_size();
-  const int end_pos = std::min(static_cast<size_t>(m_current_pos+loaded_batch_size),
+  const int end_pos = std::min(static_cast<size_t>(m_fetch_pos+loaded_batch_size),
                                m_shuffled_indices.size());
   const int mb_size = std::min(
-    El::Int{((end_pos - m_current_pos) + m_sample_stride - 1) / m_sample_stride},
+    El::Int{((end_pos - m_fetch_pos) + m_sample_stride - 1) / m_sample_stride},
     Y.Width());
 
-  El::Zeros_seq(Y, Y.Height(), Y.Width());
+  // fetch_label only sets the label's entry, so every column is zeroed
+  zero_fill_mini_batch(Y, mb_size, true);
 
   if(!position_valid()) {
     if(position_is_overrun()) {
       return 0;
     }else {
       LBANN_ERROR(std::string{} + "generic data reader load error: !position_valid"
-                  + " -- current pos = " + std::to_string(m_current_pos)
+                  + " -- fetch pos = " + std::to_string(m_fetch_pos)
                   + " and there are " + std::to_string(m_shuffled_indices.size()) + " indices");
     }
   }
@@ -225,7 +286,7 @@ int lbann::generic_data_reader::fetch_labels(CPUMat& Y) {
 //  else {
     std::string error_message;
     for (int s = 0; s < mb_size; s++) {
-      int n = m_current_pos + (s * m_sample_stride);
+      int n = m_fetch_pos + (s * m_sample_stride);
       int index = m_shuffled_indices[n];
       bool valid = fetch_label(Y, index, s);
       if (!valid) {
@@ -239,27 +300,27 @@ int lbann::generic_data_reader::fetch_labels(CPUMat& Y) {
 
 int lbann::generic_data_reader::fetch_responses(CPUMat& Y) {
   int loaded_batch_size = get_loaded_mini_batch_size();
-  const int end_pos = std::min(static_cast<size_t>(m_current_pos+loaded_batch_size),
+  const int end_pos = std::min(static_cast<size_t>(m_fetch_pos+loaded_batch_size),
                                m_shuffled_indices.size());
   const int mb_size = std::min(
-    El::Int{((end_pos - m_current_pos) + m_sample_stride - 1) / m_sample_stride},
+    El::Int{((end_pos - m_fetch_pos) + m_sample_stride - 1) / m_sample_stride},
     Y.Width());
 
-  El::Zeros_seq(Y, Y.Height(), Y.Width());
+  zero_fill_mini_batch(Y, mb_size);
 
   if(!position_valid()) {
     if(position_is_overrun()) {
       return 0;
     }else {
       LBANN_ERROR(std::string{} + "generic data reader load error: !position_valid"
-                  + " -- current pos = " + std::to_string(m_current_pos)
+                  + " -- fetch pos = " + std::to_string(m_fetch_pos)
                   + " and there are " + std::to_string(m_shuffled_indices.size()) + " indices");
     }
   }
 
   std::string error_message;
   for (int s = 0; s < mb_size; s++) {
-    int n = m_current_pos + (s * m_sample_stride);
+    int n = m_fetch_pos + (s * m_sample_stride);
     int index = m_shuffled_indices[n];
     bool valid = fetch_response(Y, index, s);
     if (!valid) {
@@ -276,9 +337,9 @@ bool generic_data_reader::update(bool is_active_reader) {
 
   if(is_active_reader) {
     m_current_pos = get_next_position();
-    m_loaded_mini_batch_idx += m_iteration_stride;
+    m_consumed_mini_batch_idx += m_iteration_stride;
   }
-  if (m_loaded_mini_batch_idx >= m_num_iterations_per_epoch) {
+  if (m_consumed_mini_batch_idx >= m_num_iterations_per_epoch) {
     reader_not_done = false;
   }
   if ((size_t)m_current_pos >= m_shuffled_indices.size()) {
@@ -294,7 +355,7 @@ bool generic_data_reader::update(bool is_active_reader) {
         + " and there are " + std::to_string(m_shuffled_indices.size()) + " indices"
         + " : iteration="
         + std::to_string(m_current_mini_batch_idx) + "C ["
-        + std::to_string(m_loaded_mini_batch_idx) +"L] of "
+        + std::to_string(m_consumed_mini_batch_idx) +"L] of "
         + std::to_string(m_num_iterations_per_epoch) + "+"
         + std::to_string(m_iteration_stride) + " : "
         + " index stride="
@@ -328,6 +389,14 @@ int generic_data_reader::get_loaded_mini_batch_size() const {
   }
 }
 
+int generic_data_reader::get_fetch_mini_batch_size() const {
+  if (m_loaded_mini_batch_idx == (m_reset_mini_batch_index + m_num_iterations_per_epoch-1)) {
+    return m_last_mini_batch_size + m_world_master_mini_batch_adjustment;
+  } else {
+    return m_mini_batch_size;
+  }
+}
+
 int generic_data_reader::get_current_mini_batch_size() const {
   if (m_current_mini_batch_idx == (m_num_iterations_per_epoch-1)) {
     return m_last_mini_batch_size + m_world_master_mini_batch_adjustment;
@@ -367,6 +436,17 @@ int generic_data_reader::get_next_position() const {
   }
 }
 
+void generic_data_reader::advance_fetch_position() {
+  /// Mirror get_next_position() for the mini-batch that was just
+  /// fetched, which may be ahead of the current mini-batch
+  if ((m_loaded_mini_batch_idx - m_reset_mini_batch_index + m_iteration_stride) == (m_num_iterations_per_epoch-1)) {
+    m_fetch_pos += m_stride_to_last_mini_batch;
+  } else {
+    m_fetch_pos += m_stride_to_next_mini_batch;
+  }
+  m_loaded_mini_batch_idx += m_iteration_stride;
+}
+
 void generic_data_reader::select_subset_of_data_partitioned() {
 
   //sanity checks
@@ -30,10 +30,174 @@
 #include "lbann/data_readers/data_reader_csv.hpp"
 #include "lbann/data_store/data_store_csv.hpp"
 #include "lbann/utils/options.hpp"
+#include "lbann/utils/omp_pragma.hpp"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <omp.h>
 
 namespace lbann {
 
+namespace {
+
+/// Identifies binary cache files and their version.
+constexpr uint64_t csv_cache_magic = 0x3130434353564C42;
+
+/// Header of a binary cache file.
+struct csv_cache_header {
+  uint64_t magic;
+  /// Size and modification time of the CSV file.
+  uint64_t csv_size;
+  int64_t csv_mtime;
+  uint64_t data_type_size;
+  /// Reader settings the cache was written with.
+  int32_t separator;
+  int32_t skip_cols;
+  int32_t skip_rows;
+  int32_t has_header;
+  int32_t label_col;
+  int32_t response_col;
+  int32_t disable_labels;
+  int32_t disable_responses;
+  uint64_t sample_count;
+  /// Parsed file information.
+  uint64_t num_cols;
+  uint64_t num_samples;
+  uint64_t num_features;
+  uint64_t num_labels;
+  /// Offsets of the row index, features, labels, and responses.
+  uint64_t index_offset;
+  uint64_t features_offset;
+  uint64_t labels_offset;
+  uint64_t responses_offset;
+  uint64_t file_size;
+};
+
+/// Round up to a multiple of 64 bytes.
+uint64_t align_offset(uint64_t offset) {
+  return (offset + 63) / 64 * 64;
+}
+
+/// Map a whole file read-only; the mapping is released with the pointer.
+std::shared_ptr<const char> map_whole_file(const std::string& filename,
+                                           size_t& size) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw lbann_exception(
+      "csv_reader: failed to open " + filename + ": " + std::strerror(errno));
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw lbann_exception(
+      "csv_reader: failed to stat " + filename + ": " + std::strerror(errno));
+  }
+  size = st.st_size;
+  if (size == 0) {
+    close(fd);
+    return std::shared_ptr<const char>();
+  }
+  void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    throw lbann_exception(
+      "csv_reader: failed to map " + filename + ": " + std::strerror(errno));
+  }
+  return std::shared_ptr<const char>(
+    static_cast<const char*>(addr),
+    [size](const char *p) { munmap(const_cast<char*>(p), size); });
+}
+
+/// Exact powers of ten in double precision.
+constexpr double exact_powers_of_ten[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * Parse a floating-point number from [begin, end). Decimal numbers with
+ * at most 19 significant digits and small exponents are converted
+ * exactly without a copy (Clinger's fast path); anything else falls back
+ * to strtod. Returns false if the text is not a number.
+ */
+bool parse_value(const char *begin, const char *end, double& val) {
+  while (begin < end && std::isspace((unsigned char) *begin)) { ++begin; }
+  while (end > begin && std::isspace((unsigned char) end[-1])) { --end; }
+  const char *p = begin;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    ++p;
+  }
+  uint64_t mantissa = 0;
+  int num_digits = 0, exponent = 0;
+  bool has_digits = false, exact = true;
+  for (; p < end && std::isdigit((unsigned char) *p); ++p) {
+    has_digits = true;
+    const int d = *p - '0';
+    if (num_digits < 19) {
+      mantissa = mantissa * 10 + d;
+      if (mantissa > 0) { ++num_digits; }
+    } else {
+      ++exponent;
+      exact = exact && d == 0;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && std::isdigit((unsigned char) *p); ++p) {
+      has_digits = true;
+      const int d = *p - '0';
+      if (num_digits < 19) {
+        mantissa = mantissa * 10 + d;
+        if (mantissa > 0) { ++num_digits; }
+        --exponent;
+      } else {
+        exact = exact && d == 0;
+      }
+    }
+  }
+  if (has_digits && p < end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negative_exponent = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      negative_exponent = (*p == '-');
+      ++p;
+    }
+    int e = 0;
+    bool has_exponent_digits = false;
+    for (; p < end && std::isdigit((unsigned char) *p); ++p) {
+      has_exponent_digits = true;
+      if (e < 100000) { e = e * 10 + (*p - '0'); }
+    }
+    if (!has_exponent_digits) { has_digits = false; }
+    exponent += negative_exponent ? -e : e;
+  }
+  if (has_digits && p == end && exact
+      && mantissa <= (uint64_t(1) << 53)
+      && exponent >= -22 && exponent <= 22) {
+    val = (exponent < 0 ?
+           mantissa / exact_powers_of_ten[-exponent] :
+           mantissa * exact_powers_of_ten[exponent]);
+    if (negative) { val = -val; }
+    return true;
+  }
+
+  // Fall back to strtod, e.g. for "inf", "nan", or many digits
+  const std::string str(begin, end);
+  if (str.empty()) { return false; }
+  char *str_end = nullptr;
+  val = std::strtod(str.c_str(), &str_end);
+  return str_end == str.c_str() + str.size();
+}
+
+}  // namespace
+
 csv_reader::csv_reader(bool shuffle)
   : generic_data_reader(shuffle) {}
 
@@ -50,17 +214,18 @@ csv_reader::csv_reader(const csv_reader& other) :
   m_num_cols(other.m_num_cols),
   m_num_samples(other.m_num_samples),
   m_num_labels(other.m_num_labels),
+  m_use_binary_cache(other.m_use_binary_cache),
+  m_custom_transforms(other.m_custom_transforms),
+  m_file(other.m_file),
+  m_file_size(other.m_file_size),
+  m_cache(other.m_cache),
+  m_cache_data(other.m_cache_data),
   m_index(other.m_index),
   m_labels(other.m_labels),
   m_responses(other.m_responses),
   m_col_transforms(other.m_col_transforms),
   m_label_transform(other.m_label_transform),
-  m_response_transform(other.m_response_transform) {
-  if (!other.m_ifstreams.empty()) {
-    // Need to set these up again manually.
-    setup_ifstreams();
-  }
-}
+  m_response_transform(other.m_response_transform) {}
 
 csv_reader& csv_reader::operator=(const csv_reader& other) {
   generic_data_reader::operator=(other);
@@ -75,198 +240,473 @@ csv_reader& csv_reader::operator=(const csv_reader& other) {
   m_num_cols = other.m_num_cols;
   m_num_samples = other.m_num_samples;
   m_num_labels = other.m_num_labels;
+  m_use_binary_cache = other.m_use_binary_cache;
+  m_custom_transforms = other.m_custom_transforms;
+  m_file = other.m_file;
+  m_file_size = other.m_file_size;
+  m_cache = other.m_cache;
+  m_cache_data = other.m_cache_data;
   m_index = other.m_index;
   m_labels = other.m_labels;
   m_responses = other.m_responses;
   m_col_transforms = other.m_col_transforms;
   m_label_transform = other.m_label_transform;
   m_response_transform = other.m_response_transform;
-  if (!other.m_ifstreams.empty()) {
-    // Possibly free our current ifstreams, set them up again.
-    for (std::ifstream* ifs : m_ifstreams) {
-      delete ifs;
-    }
-    setup_ifstreams();
-  }
   return *this;
 }
 
-csv_reader::~csv_reader() {
-  for (auto&& ifs : m_ifstreams) {
-    delete ifs;
-  }
-}
+csv_reader::~csv_reader() {}
 
 void csv_reader::load() {
   bool master = m_comm->am_world_master();
-  setup_ifstreams();
-  std::ifstream& ifs = *m_ifstreams[0];
   const El::mpi::Comm world_comm = m_comm->get_world_comm();
-  // Parse the header to determine how many columns there are.
-  // Skip rows if needed.
-  if (master) {
-    skip_rows(ifs, m_skip_rows);
-  }
-  m_comm->broadcast<int>(0, m_skip_rows, world_comm);
+  map_file();
 
-  //This will be broadcast from root to other procs, and will
-  //then be converted to std::vector<int> m_labels; this is because
-  //El::mpi::Broadcast<std::streampos> doesn't work
-  std::vector<long long> index;
+  // The binary cache can only be checked against the reader settings if
+  // no custom transforms are used.
+  if (options::get()->get_bool("csv_binary_cache")) {
+    m_use_binary_cache = true;
+  }
+  const bool use_cache = m_use_binary_cache && !m_custom_transforms;
+  if (master && m_use_binary_cache && m_custom_transforms) {
+    std::cerr << "csv_reader: not using binary cache for "
+              << get_data_filename() << " since custom transforms are set\n";
+  }
 
+  // Parse the CSV file on the master, or map the binary cache if it
+  // is up to date.
+  int have_cache = 0;
   if (master) {
-    std::string line;
-    std::streampos header_start = ifs.tellg();
-    // TODO: Skip comment lines.
-    if (std::getline(ifs, line)) {
-      m_num_cols = std::count(line.begin(), line.end(), m_separator) + 1;
-      if (m_skip_cols >= m_num_cols) {
-        throw lbann_exception(
-          "csv_reader: asked to skip more columns than are present");
+    if (use_cache && open_cache()) {
+      have_cache = 1;
+    } else {
+      build_index(parse_header());
+      if (use_cache && write_cache()) {
+        have_cache = open_cache();
+      } else {
+        parse_rows();
       }
+    }
+  }
+  m_comm->broadcast<int>(0, have_cache, world_comm);
 
-      if (!m_disable_labels) {
-        if (m_label_col < 0) {
-          // Last column becomes the label column.
-          m_label_col = m_num_cols - 1;
-        }
-        if (m_label_col >= m_num_cols) {
-          throw lbann_exception(
-            "csv_reader: label column" + std::to_string(m_label_col) +
-            " is not present");
-        }
-      }
+  if (have_cache) {
+    if (!master && !open_cache()) {
+      throw lbann_exception(
+        "csv_reader: failed to open binary cache " + get_cache_filename());
+    }
+  } else {
+    m_comm->broadcast<int>(0, m_num_cols, world_comm);
+    m_comm->broadcast<int>(0, m_label_col, world_comm);
+    m_comm->broadcast<int>(0, m_response_col, world_comm);
+    m_comm->broadcast<int>(0, m_num_labels, world_comm);
 
-      if (!m_disable_responses) {
-        if (m_response_col < 0) {
-          // Last column becomes the response column.
-          m_response_col = m_num_cols - 1;
-        }
-        if (m_response_col >= m_num_cols) {
-          throw lbann_exception(
-            "csv_reader: response column" + std::to_string(m_response_col) +
-            " is not present");
-        }
-      }
+    //bcast the index vector
+    m_comm->world_broadcast<long long>(0, m_index);
 
-    } else {
+    //optionally bcast the response vector
+    if (!m_disable_responses) {
+      m_comm->world_broadcast<DataType>(0, m_responses);
+    }
+
+    //optionally bcast the label vector
+    if (!m_disable_labels) {
+      m_comm->world_broadcast<int>(0, m_labels);
+    }
+  }
+  m_num_samples = m_index.size() - 1;
+  if (m_master) std::cerr << "num samples: " << m_num_samples << "\n";
+
+  // Reset indices.
+  m_shuffled_indices.resize(m_num_samples);
+  std::iota(m_shuffled_indices.begin(), m_shuffled_indices.end(), 0);
+  select_subset_of_data();
+}
+
+size_t csv_reader::parse_header() {
+  const char *data = m_file.get();
+  const char *end = data + m_file_size;
+
+  // Skip rows if needed.
+  const char *pos = data;
+  for (int i = 0; i < m_skip_rows; ++i) {
+    const char *nl = pos < end ?
+      static_cast<const char*>(std::memchr(pos, '\n', end - pos)) : nullptr;
+    if (nl == nullptr) {
+      throw lbann_exception("csv_reader: error on skipping rows");
+    }
+    pos = nl + 1;
+  }
+
+  // Parse the header to determine how many columns there are.
+  // TODO: Skip comment lines.
+  if (pos >= end) {
+    throw lbann_exception(
+      "csv_reader: failed to read header in " + get_data_filename());
+  }
+  const char *header_start = pos;
+  const char *header_nl =
+    static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+  const char *header_end = header_nl != nullptr ? header_nl : end;
+  m_num_cols = std::count(header_start, header_end, m_separator) + 1;
+  if (m_skip_cols >= m_num_cols) {
+    throw lbann_exception(
+      "csv_reader: asked to skip more columns than are present");
+  }
+
+  if (!m_disable_labels) {
+    if (m_label_col < 0) {
+      // Last column becomes the label column.
+      m_label_col = m_num_cols - 1;
+    }
+    if (m_label_col >= m_num_cols) {
       throw lbann_exception(
-        "csv_reader: failed to read header in " + get_data_filename());
+        "csv_reader: label column" + std::to_string(m_label_col) +
+        " is not present");
+    }
+  }
+
+  if (!m_disable_responses) {
+    if (m_response_col < 0) {
+      // Last column becomes the response column.
+      m_response_col = m_num_cols - 1;
     }
-    if (ifs.eof()) {
+    if (m_response_col >= m_num_cols) {
       throw lbann_exception(
-        "csv_reader: reached EOF after reading header");
+        "csv_reader: response column" + std::to_string(m_response_col) +
+        " is not present");
     }
-    // If there was no header, skip back to the beginning.
-    if (!m_has_header) {
-      ifs.clear();
-      ifs.seekg(header_start, std::ios::beg);
+  }
+
+  if (header_nl == nullptr || header_nl + 1 == end) {
+    throw lbann_exception(
+      "csv_reader: reached EOF after reading header");
+  }
+  // If there was no header, the first row is data.
+  return (m_has_header ? header_nl + 1 : header_start) - data;
+}
+
+void csv_reader::build_index(size_t data_start) {
+  const char *data = m_file.get();
+  const size_t data_size = m_file_size - data_start;
+
+  // Each thread finds the lines that start within its chunk of the file.
+  std::vector<std::vector<long long>> thread_index(omp_get_max_threads());
+  LBANN_OMP_PARALLEL
+  {
+    const int tid = omp_get_thread_num();
+    const int num_threads = omp_get_num_threads();
+    const size_t chunk_start = data_start + (data_size * tid) / num_threads;
+    const size_t chunk_end = data_start + (data_size * (tid+1)) / num_threads;
+    auto& index = thread_index[tid];
+    size_t pos = chunk_start;
+    if (pos > data_start && data[pos-1] != '\n') {
+      const char *nl = static_cast<const char*>(
+        std::memchr(data + pos, '\n', chunk_end - pos));
+      pos = nl != nullptr ? nl - data + 1 : chunk_end;
     }
-    // Construct an index mapping each line (sample) to its offset.
-    // TODO: Skip comment lines.
-    // Used to count the number of label classes.
-    std::unordered_set<int> label_classes;
-    index.push_back(ifs.tellg());
-
-    int num_samples_to_use = get_absolute_sample_count();
-    int line_num = 0;
-    if (num_samples_to_use == 0) {
-      num_samples_to_use = -1;
+    while (pos < chunk_end) {
+      index.push_back(pos);
+      const char *nl = static_cast<const char*>(
+        std::memchr(data + pos, '\n', m_file_size - pos));
+      if (nl == nullptr) { break; }
+      pos = nl - data + 1;
     }
-    while (std::getline(ifs, line)) {
-      if (line_num == num_samples_to_use) {
-        break;
-      }
-      ++line_num;
+  }
+
+  m_index.clear();
+  for (const auto& index : thread_index) {
+    m_index.insert(m_index.end(), index.begin(), index.end());
+  }
+
+  // Only keep as many samples as requested.
+  const size_t num_samples_to_use = get_absolute_sample_count();
+  if (num_samples_to_use > 0 && num_samples_to_use < m_index.size()) {
+    m_index.resize(num_samples_to_use + 1);
+  } else if (!m_index.empty()) {
+    // The final entry is one past the newline of the last line.
+    const size_t last = m_index.back();
+    const char *nl = static_cast<const char*>(
+      std::memchr(data + last, '\n', m_file_size - last));
+    m_index.push_back(nl != nullptr ? nl - data + 1 : m_file_size + 1);
+  }
+  if (m_index.size() < 2) {
+    throw lbann_exception(
+      "csv_reader: no samples in " + get_data_filename());
+  }
+}
+
+void csv_reader::parse_rows(DataType *features) {
+  const char *data = m_file.get();
+  const int num_samples = m_index.size() - 1;
+  const int num_features = get_num_features();
+  if (!m_disable_labels) { m_labels.assign(num_samples, 0); }
+  if (!m_disable_responses) { m_responses.assign(num_samples, 0); }
 
+  // Exceptions cannot leave the parallel region, so the first error is
+  // recorded and thrown afterwards.
+  std::string error;
+  LBANN_OMP_PARALLEL_FOR
+  for (int i = 0; i < num_samples; ++i) {
+    try {
+      const char *line = data + m_index[i];
+      const char *line_end = data + m_index[i+1] - 1;
       // Verify the line has the right number of columns.
-      if (std::count(line.begin(), line.end(), m_separator) + 1 != m_num_cols) {
+      if (std::count(line, line_end, m_separator) + 1 != m_num_cols) {
         throw lbann_exception(
-          "csv_reader: line " + std::to_string(line_num) +
+          "csv_reader: line " + std::to_string(i+1) +
           " does not have right number of entries");
       }
-      index.push_back(ifs.tellg());
-      // Extract the label.
-      if (!m_disable_labels) {
-        size_t cur_pos = 0;
-        for (int col = 0; col < m_num_cols; ++col) {
-          size_t end_pos = line.find_first_of(m_separator, cur_pos);
-          if (col == m_label_col) {
-            int label = m_label_transform(line.substr(cur_pos, end_pos - cur_pos));
-            label_classes.insert(label);
-            m_labels.push_back(label);
-            break;
-          }
-          cur_pos = end_pos + 1;
+      // Extract the label and possibly the response.
+      const char *cur = line;
+      for (int col = 0; col < m_num_cols; ++col) {
+        const char *col_end = static_cast<const char*>(
+          std::memchr(cur, m_separator, line_end - cur));
+        if (col_end == nullptr) { col_end = line_end; }
+        if (!m_disable_labels && col == m_label_col) {
+          m_labels[i] = m_label_transform(std::string(cur, col_end));
         }
-      }
-      // Possibly extract the response.
-      if (!m_disable_responses) {
-        size_t cur_pos = 0;
-        for (int col = 0; col < m_num_cols; ++col) {
-          size_t end_pos = line.find_first_of(m_separator, cur_pos);
-          if (col == m_response_col) {
-            DataType response = m_response_transform(
-              line.substr(cur_pos, end_pos - cur_pos));
-            m_responses.push_back(response);
-            break;
-          }
-          cur_pos = end_pos + 1;
+        if (!m_disable_responses && col == m_response_col) {
+          m_responses[i] = m_response_transform(std::string(cur, col_end));
         }
+        cur = col_end + 1;
+      }
+      if (features != nullptr) {
+        parse_features(i, features + (size_t) i * num_features);
+      }
+    } catch (std::exception& e) {
+      OMP_CRITICAL
+      {
+        if (error.empty()) { error = e.what(); }
       }
     }
+  }
+  if (!error.empty()) {
+    throw lbann_exception(error);
+  }
 
-    if (!ifs.eof() && num_samples_to_use == 0) {
-       //If we didn't get to EOF, something went wrong.
+  if (!m_disable_labels) {
+    // Do some simple validation checks on the classes.
+    // Ensure the elements begin with 0, and there are no gaps.
+    std::unordered_set<int> label_classes(m_labels.begin(), m_labels.end());
+    auto minmax = std::minmax_element(label_classes.begin(), label_classes.end());
+    if (*minmax.first != 0) {
       throw lbann_exception(
-        "csv_reader: did not reach EOF");
+        "csv_reader: classes are not indexed from 0");
     }
-    if (!m_disable_labels) {
-      // Do some simple validation checks on the classes.
-      // Ensure the elements begin with 0, and there are no gaps.
-      auto minmax = std::minmax_element(label_classes.begin(), label_classes.end());
-      if (*minmax.first != 0) {
-        throw lbann_exception(
-          "csv_reader: classes are not indexed from 0");
-      }
-      if (*minmax.second != (int) label_classes.size() - 1) {
-        throw lbann_exception(
-          "csv_reader: label classes are not contiguous");
+    if (*minmax.second != (int) label_classes.size() - 1) {
+      throw lbann_exception(
+        "csv_reader: label classes are not contiguous");
+    }
+    m_num_labels = label_classes.size();
+  }
+}
+
+void csv_reader::parse_features(int data_id, DataType *out) const {
+  const char *line = m_file.get() + m_index[data_id];
+  const char *line_end = m_file.get() + m_index[data_id+1] - 1;
+  // Note: load already verified that every line is properly formatted.
+  const char *cur = line;  // Current *start* of a column.
+  int i = 0;
+  for (int col = 0; col < m_num_cols; ++col) {
+    const char *col_end = static_cast<const char*>(
+      std::memchr(cur, m_separator, line_end - cur));
+    if (col_end == nullptr) { col_end = line_end; }
+    // Skip the label, response, and any columns if needed.
+    if (!((!m_disable_labels && col == m_label_col) ||
+          (!m_disable_responses && col == m_response_col) ||
+          col < m_skip_cols)) {
+      auto transform = m_col_transforms.find(col);
+      if (transform != m_col_transforms.end()) {
+        out[i] = transform->second(std::string(cur, col_end));
+      } else {
+        // No easy way to parameterize based on DataType, so always use double.
+        double val;
+        if (!parse_value(cur, col_end, val)) {
+          throw lbann_exception(
+            "csv_reader: could not convert '" + std::string(cur, col_end) + "'");
+        }
+        out[i] = val;
       }
-      m_num_labels = label_classes.size();
+      ++i;
     }
-    ifs.clear();
-  } // if (master)
+    cur = col_end + 1;
+  }
+}
+
+int csv_reader::get_num_features() const {
+  int num_features = 0;
+  for (int col = m_skip_cols; col < m_num_cols; ++col) {
+    if (!((!m_disable_labels && col == m_label_col) ||
+          (!m_disable_responses && col == m_response_col))) {
+      ++num_features;
+    }
+  }
+  return num_features;
+}
 
-  m_comm->broadcast<int>(0, m_num_cols, world_comm);
-  m_label_col = m_num_cols - 1;
+std::string csv_reader::get_cache_filename() const {
+  return get_file_dir() + get_data_filename() + ".lbann_cache";
+}
 
-  //bcast the index vector
-  m_comm->world_broadcast<long long>(0, index);
-  m_num_samples = index.size() - 1;
-  if (m_master) std::cerr << "num samples: " << m_num_samples << "\n";
+bool csv_reader::open_cache() {
+  const std::string filename = get_cache_filename();
+  struct stat csv_st, cache_st;
+  if (stat((get_file_dir() + get_data_filename()).c_str(), &csv_st) != 0
+      || stat(filename.c_str(), &cache_st) != 0
+      || (size_t) cache_st.st_size < sizeof(csv_cache_header)) {
+    return false;
+  }
+  size_t size;
+  auto cache = map_whole_file(filename, size);
+  csv_cache_header h;
+  std::memcpy(&h, cache.get(), sizeof(h));
 
-  m_index.reserve(index.size());
-  for (auto t : index) {
-    m_index.push_back(t);
+  // Make sure the cache matches the CSV file and reader settings.
+  // Note: The label and response columns default to the last column.
+  const int label_col = ((!m_disable_labels && m_label_col < 0) ?
+                         (int) h.num_cols - 1 : m_label_col);
+  const int response_col = ((!m_disable_responses && m_response_col < 0) ?
+                            (int) h.num_cols - 1 : m_response_col);
+  if (h.magic != csv_cache_magic
+      || h.file_size != size
+      || h.csv_size != (uint64_t) csv_st.st_size
+      || h.csv_mtime != (int64_t) csv_st.st_mtime
+      || h.data_type_size != sizeof(DataType)
+      || h.separator != m_separator
+      || h.skip_cols != m_skip_cols
+      || h.skip_rows != m_skip_rows
+      || h.has_header != m_has_header
+      || h.label_col != label_col
+      || h.response_col != response_col
+      || h.disable_labels != m_disable_labels
+      || h.disable_responses != m_disable_responses
+      || h.sample_count != get_absolute_sample_count()) {
+    if (m_comm->am_world_master()) {
+      std::cerr << "csv_reader: binary cache " << filename
+                << " is out of date\n";
+    }
+    return false;
   }
 
-  //optionally bcast the response vector
+  m_num_cols = h.num_cols;
+  m_label_col = label_col;
+  m_response_col = response_col;
+  m_num_labels = h.num_labels;
+  const long long *index =
+    reinterpret_cast<const long long*>(cache.get() + h.index_offset);
+  m_index.assign(index, index + h.num_samples + 1);
+  if (!m_disable_labels) {
+    const int32_t *labels =
+      reinterpret_cast<const int32_t*>(cache.get() + h.labels_offset);
+    m_labels.assign(labels, labels + h.num_samples);
+  }
   if (!m_disable_responses) {
-    m_response_col = m_num_cols - 1;
-    m_comm->world_broadcast<DataType>(0, m_responses);
+    const DataType *responses =
+      reinterpret_cast<const DataType*>(cache.get() + h.responses_offset);
+    m_responses.assign(responses, responses + h.num_samples);
+  }
+  m_cache_data =
+    reinterpret_cast<const DataType*>(cache.get() + h.features_offset);
+  m_cache = std::move(cache);
+  return true;
+}
+
+bool csv_reader::write_cache() {
+  const std::string filename = get_cache_filename();
+  const std::string tmp_filename =
+    filename + ".tmp." + std::to_string(getpid());
+  struct stat csv_st;
+  if (stat((get_file_dir() + get_data_filename()).c_str(), &csv_st) != 0) {
+    return false;
   }
 
-  //optionally bcast the label vector
+  // Layout: header, row index, features, labels, responses.
+  const uint64_t num_samples = m_index.size() - 1;
+  const uint64_t num_features = get_num_features();
+  csv_cache_header h;
+  std::memset(&h, 0, sizeof(h));
+  h.magic = csv_cache_magic;
+  h.csv_size = csv_st.st_size;
+  h.csv_mtime = csv_st.st_mtime;
+  h.data_type_size = sizeof(DataType);
+  h.separator = m_separator;
+  h.skip_cols = m_skip_cols;
+  h.skip_rows = m_skip_rows;
+  h.has_header = m_has_header;
+  h.disable_labels = m_disable_labels;
+  h.disable_responses = m_disable_responses;
+  h.sample_count = get_absolute_sample_count();
+  h.label_col = m_label_col;
+  h.response_col = m_response_col;
+  h.num_cols = m_num_cols;
+  h.num_samples = num_samples;
+  h.num_features = num_features;
+  h.index_offset = align_offset(sizeof(h));
+  h.features_offset = align_offset(h.index_offset
+                                   + (num_samples + 1) * sizeof(long long));
+  h.labels_offset = align_offset(h.features_offset
+                                 + num_samples * num_features * sizeof(DataType));
+  h.responses_offset = align_offset(h.labels_offset
+                                    + num_samples * sizeof(int32_t));
+  h.file_size = h.responses_offset + num_samples * sizeof(DataType);
+
+  int fd = open(tmp_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    std::cerr << "csv_reader: failed to create binary cache " << tmp_filename
+              << ": " << std::strerror(errno) << "\n";
+    return false;
+  }
+  if (ftruncate(fd, h.file_size) != 0) {
+    std::cerr << "csv_reader: failed to allocate binary cache " << tmp_filename
+              << ": " << std::strerror(errno) << "\n";
+    close(fd);
+    unlink(tmp_filename.c_str());
+    return false;
+  }
+  void *addr = mmap(nullptr, h.file_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    std::cerr << "csv_reader: failed to map binary cache " << tmp_filename
+              << ": " << std::strerror(errno) << "\n";
+    unlink(tmp_filename.c_str());
+    return false;
+  }
+  char *cache = static_cast<char*>(addr);
+
+  // Parse the CSV file directly into the cache.
+  try {
+    parse_rows(reinterpret_cast<DataType*>(cache + h.features_offset));
+  } catch (...) {
+    munmap(addr, h.file_size);
+    unlink(tmp_filename.c_str());
+    throw;
+  }
+  h.num_labels = m_num_labels;
+  std::memcpy(cache + h.index_offset, m_index.data(),
+              m_index.size() * sizeof(long long));
   if (!m_disable_labels) {
-    m_comm->world_broadcast<int>(0, m_labels);
-    m_num_labels = m_labels.size();
+    int32_t *labels = reinterpret_cast<int32_t*>(cache + h.labels_offset);
+    std::copy(m_labels.begin(), m_labels.end(), labels);
+  }
+  if (!m_disable_responses) {
+    std::memcpy(cache + h.responses_offset, m_responses.data(),
+                m_responses.size() * sizeof(DataType));
   }
 
-  // Reset indices.
-  m_shuffled_indices.resize(m_num_samples);
-  std::iota(m_shuffled_indices.begin(), m_shuffled_indices.end(), 0);
-  select_subset_of_data();
+  // The header is written last and the file is renamed once complete,
+  // so a partially written cache is never used.
+  std::memcpy(cache, &h, sizeof(h));
+  const bool synced = (msync(addr, h.file_size, MS_SYNC) == 0);
+  munmap(addr, h.file_size);
+  if (!synced || std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+    std::cerr << "csv_reader: failed to write binary cache " << filename
+              << ": " << std::strerror(errno) << "\n";
+    unlink(tmp_filename.c_str());
+    return false;
+  }
+  return true;
 }
 
 bool csv_reader::fetch_datum(CPUMat& X, int data_id, int mb_idx) {
@@ -276,12 +716,12 @@ bool csv_reader::fetch_datum(CPUMat& X, int data_id, int mb_idx) {
     for (size_t i = 0; i < buf->size(); ++i) {
       X(i, mb_idx) = (*buf)[i];
     }
+  } else if (m_cache_data != nullptr) {
+    const int num_features = get_num_features();
+    const DataType *row = m_cache_data + (size_t) data_id * num_features;
+    std::copy(row, row + num_features, X.Buffer(0, mb_idx));
   } else {
-    auto line = fetch_line_label_response(data_id);
-    // TODO: Avoid unneeded copies.
-    for (size_t i = 0; i < line.size(); ++i) {
-      X(i, mb_idx) = line[i];
-    }
+    parse_features(data_id, X.Buffer(0, mb_idx));
   }
   return true;
 }
@@ -326,82 +766,35 @@ std::vector<DataType> csv_reader::fetch_line(int data_id) {
 
 std::vector<DataType> csv_reader::fetch_line_label_response(
   int data_id) {
-  std::string line = fetch_raw_line(data_id);
-  std::vector<DataType> parsed_line;
-  // Note: load already verified that every line is properly formatted.
-  size_t cur_pos = 0;  // Current *start* of a column.
-  for (int col = 0; col < m_num_cols; ++col) {
-    // Note for last column, this returns std::npos, which substr handles.
-    size_t end_pos = line.find_first_of(m_separator, cur_pos);
-    // Skip the label, response, and any columns if needed.
-    if ((!m_disable_labels && col == m_label_col) ||
-        (!m_disable_responses && col == m_response_col) ||
-        col < m_skip_cols) {
-      cur_pos = end_pos + 1;
-      continue;
-    }
-    // Note: This results in a copy, switch to string_view when we can.
-    std::string str_val = line.substr(cur_pos, end_pos - cur_pos);
-    cur_pos = end_pos + 1;
-    DataType val;
-    if (m_col_transforms.count(col)) {
-      val = m_col_transforms[col](str_val);
-    } else {
-      // No easy way to parameterize based on DataType, so always use double.
-      try {
-        val = std::stod(str_val);
-      } catch (std::invalid_argument& e) {
-        throw lbann_exception(
-          "csv_reader: could not convert '" + str_val + "'");
-      }
-    }
-    parsed_line.push_back(val);
+  const int num_features = get_num_features();
+  std::vector<DataType> parsed_line(num_features);
+  if (m_cache_data != nullptr) {
+    const DataType *row = m_cache_data + (size_t) data_id * num_features;
+    std::copy(row, row + num_features, parsed_line.begin());
+  } else {
+    parse_features(data_id, parsed_line.data());
   }
   return parsed_line;
 }
 
 std::string csv_reader::fetch_raw_line(int data_id) {
-static int n = 0;
-  std::ifstream& ifs = *m_ifstreams[omp_get_thread_num()];
-  // Seek to the start of this datum's line.
-  ifs.seekg(m_index[data_id], std::ios::beg);
-  // Compute the length of the line to read, excluding newline.
-  std::streamsize cnt = m_index[data_id+1] - m_index[data_id] - 1;
-  // Read directly into a string buffer.
-  std::string line;
-  line.resize(cnt);
-  if (!ifs.read(&line[0], cnt)) {
+  if (data_id < 0 || data_id >= m_num_samples) {
     std::stringstream err;
     err << __FILE__ << " " << __LINE__ << " :: "
         << "csv_reader: error on reading data_id: " << data_id << "\n"
-        <<"index.size(): " << m_index.size() << "  m_index["<< data_id
-        << ")=" <<m_index[data_id] << "; index[" << data_id+1
-        << ")= " << m_index[data_id+1] << "\ncnt: " << cnt << " role: "
-        << get_role() << " gcount: " << ifs.gcount() << " n: " << n;
+        << "index.size(): " << m_index.size() << " role: " << get_role();
     throw lbann_exception(err.str());
   }
-++n;
-  return line;
+  // Exclude the newline.
+  return std::string(m_file.get() + m_index[data_id],
+                     m_index[data_id+1] - m_index[data_id] - 1);
 }
 
-void csv_reader::skip_rows(std::ifstream& s, int rows) {
-  std::string unused;  // Unused buffer for extracting lines.
-  for (int i = 0; i < rows; ++i) {
-    if (!std::getline(s, unused)) {
-      throw lbann_exception("csv_reader: error on skipping rows");
-    }
-  }
-}
-
-void csv_reader::setup_ifstreams() {
-  m_ifstreams.resize(omp_get_max_threads());
-  for (int i = 0; i < omp_get_max_threads(); ++i) {
-    m_ifstreams[i] = new std::ifstream(
-      get_file_dir() + get_data_filename(), std::ios::in | std::ios::binary);
-    if (m_ifstreams[i]->fail()) {
-      throw lbann_exception(
-        "csv_reader: failed to open " + get_file_dir() + get_data_filename());
-    }
+void csv_reader::map_file() {
+  m_file = map_whole_file(get_file_dir() + get_data_filename(), m_file_size);
+  if (m_file == nullptr) {
+    throw lbann_exception(
+      "csv_reader: failed to read header in " + get_data_filename());
   }
 }
 
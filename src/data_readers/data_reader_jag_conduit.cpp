@@ -49,6 +49,7 @@
 #include "lbann/utils/timer.hpp"
 #include "lbann/utils/glob.hpp"
 #include "lbann/utils/peek_map.hpp"
+#include "lbann/utils/options.hpp"
 #include "conduit/conduit_relay.hpp"
 #include "conduit/conduit_relay_hdf5.hpp"
 
@@ -128,13 +129,13 @@ const std::set<std::string> data_reader_jag_conduit::non_numeric_vars = {
 #ifndef _JAG_OFFLINE_TOOL_MODE_
 // These methods are overriden to allow each process to load and consume a unique set of data files
 bool data_reader_jag_conduit::position_valid() const {
-  const bool ok = (static_cast<size_t>(m_shuffled_indices[m_current_pos]) < m_valid_samples.size())
-    && (m_current_pos < (int)m_shuffled_indices.size());
+  const bool ok = (static_cast<size_t>(m_shuffled_indices[m_fetch_pos]) < m_valid_samples.size())
+    && (m_fetch_pos < (int)m_shuffled_indices.size());
   if (!ok) {
     const size_t my_rank = static_cast<size_t>(m_comm->get_rank_in_model());
     std::stringstream err;
     err << "rank " << my_rank << " position invalid: m_shuffled_indices["
-        << m_current_pos << "] (" << m_shuffled_indices[m_current_pos]
+        << m_fetch_pos << "] (" << m_shuffled_indices[m_fetch_pos]
         << ") >= m_valid_samples.size() (" << m_valid_samples.size() << ")" << std::endl;
     std::cerr << err.str();
   }
@@ -329,6 +330,9 @@ void data_reader_jag_conduit::copy_members(const data_reader_jag_conduit& rhs) {
   m_io_buffer_type = rhs.m_io_buffer_type;
   m_local_reader_id = rhs.m_local_reader_id;
   m_open_hdf5_files = rhs.m_open_hdf5_files;
+  // Records depend on the selected keys, which may differ between copies
+  m_sample_cache_size = rhs.m_sample_cache_size;
+  m_sample_cache = std::make_shared<sample_cache_t>(rhs.m_sample_cache->get_capacity());
   //TODO: need  to make sure this is what we want
   m_leading_reader = rhs.m_leading_reader;
 
@@ -392,6 +396,8 @@ void data_reader_jag_conduit::set_defaults() {
   m_io_buffer_type = "";
   m_local_reader_id = 0;
   m_open_hdf5_files = nullptr;
+  m_sample_cache_size = 0u;
+  m_sample_cache = std::make_shared<sample_cache_t>();
   m_leading_reader = this;
   m_cached_data_mb_size = 0;
   m_cached_response_mb_size = 0;
@@ -954,6 +960,11 @@ void data_reader_jag_conduit::load() {
     return;
   }
 
+  options *opts = options::get();
+  if (opts->has_int("jag_sample_cache_size")) {
+    set_sample_cache_size(static_cast<size_t>(opts->get_int("jag_sample_cache_size")));
+  }
+
   const std::string data_dir = add_delimiter(get_file_dir());
   const std::string conduit_file_name = get_data_filename();
   const std::string pattern = data_dir + conduit_file_name;
@@ -1367,10 +1378,88 @@ bool data_reader_jag_conduit::check_non_numeric(const std::string key) {
 }
 
 
+void data_reader_jag_conduit::set_sample_cache_size(const size_t n) {
+  m_sample_cache_size = n;
+  m_sample_cache->set_capacity(std::max(n, m_sample_cache->get_capacity()));
+}
+
+bool data_reader_jag_conduit::uses_variable_type(const variable_t t) const {
+  return (std::find(m_independent.cbegin(), m_independent.cend(), t) != m_independent.cend())
+      || (std::find(m_dependent.cbegin(), m_dependent.cend(), t) != m_dependent.cend());
+}
+
+data_reader_jag_conduit::sample_record_ptr
+data_reader_jag_conduit::load_sample_record(const size_t sample_id) const {
+  auto rec = std::make_shared<sample_record>();
+  if (uses_variable_type(JAG_Image)) {
+    rec->m_images = read_image_data(sample_id);
+    rec->m_has_images = true;
+  }
+  if (uses_variable_type(JAG_Scalar)) {
+    rec->m_scalars = read_scalars(sample_id);
+    rec->m_has_scalars = true;
+  }
+  if (uses_variable_type(JAG_Input)) {
+    rec->m_inputs = read_inputs(sample_id, rec->m_input_ends);
+    rec->m_has_inputs = true;
+  }
+  return rec;
+}
+
+data_reader_jag_conduit::sample_record_ptr
+data_reader_jag_conduit::get_sample_record(const size_t sample_id) const {
+  if (sample_id >= m_valid_samples.size()) {
+    _THROW_LBANN_EXCEPTION_(_CN_, "get_sample_record() : invalid sample index");
+  }
+  sample_record_ptr rec;
+  if (!m_sample_cache->get(m_valid_samples[sample_id], rec)) {
+    rec = load_sample_record(sample_id);
+    m_sample_cache->put(m_valid_samples[sample_id], rec);
+  }
+  return rec;
+}
+
+void data_reader_jag_conduit::load_mini_batch_records() {
+  // Keep the current and the next mini-batch
+  const int mb_size = get_loaded_mini_batch_size();
+  const size_t min_capacity = 2u * static_cast<size_t>(std::max(mb_size, 1));
+  if (m_sample_cache->get_capacity() < min_capacity) {
+    m_sample_cache->set_capacity(std::max(min_capacity, m_sample_cache_size));
+  }
+
+  const int end_pos = std::min(static_cast<size_t>(m_fetch_pos + mb_size), m_shuffled_indices.size());
+  std::vector<size_t> to_load;
+  for (int n = m_fetch_pos; n < end_pos; n += m_sample_stride) {
+    const size_t sample_id = static_cast<size_t>(m_shuffled_indices[n]);
+    if ((sample_id < m_valid_samples.size()) && !m_sample_cache->has(m_valid_samples[sample_id])) {
+      to_load.push_back(sample_id);
+    }
+  }
+
+  // Read in the order of files and samples within them
+  std::sort(to_load.begin(), to_load.end(), [this](const size_t a, const size_t b) {
+    return (m_valid_samples[a].second < m_valid_samples[b].second)
+        || ((m_valid_samples[a].second == m_valid_samples[b].second)
+            && (m_valid_samples[a].first < m_valid_samples[b].first));
+  });
+  for (const auto sample_id : to_load) {
+    m_sample_cache->put(m_valid_samples[sample_id], load_sample_record(sample_id));
+  }
+}
+
 std::vector< std::vector<data_reader_jag_conduit::ch_t> >
 data_reader_jag_conduit::get_image_data(const size_t sample_id) const {
+  const sample_record_ptr rec = get_sample_record(sample_id);
+  if (rec->m_has_images) {
+    return rec->m_images;
+  }
+  return read_image_data(sample_id);
+}
+
+std::vector< std::vector<data_reader_jag_conduit::ch_t> >
+data_reader_jag_conduit::read_image_data(const size_t sample_id) const {
   if (sample_id >= m_valid_samples.size()) {
-    _THROW_LBANN_EXCEPTION_(_CN_, "get_image_data() : invalid sample index");
+    _THROW_LBANN_EXCEPTION_(_CN_, "read_image_data() : invalid sample index");
   }
 
   std::vector< std::vector<ch_t> > image_ptrs;
@@ -1485,101 +1574,91 @@ std::vector<data_reader_jag_conduit::ch_t> data_reader_jag_conduit::get_images(c
 }
 
 std::vector<data_reader_jag_conduit::scalar_t> data_reader_jag_conduit::get_scalars(const size_t sample_id) const {
-  if (sample_id >= m_valid_samples.size()) {
-    _THROW_LBANN_EXCEPTION_(_CN_, "get_scalars() : invalid sample index");
+  const sample_record_ptr rec = get_sample_record(sample_id);
+  std::vector<scalar_t> scalars(rec->m_has_scalars? rec->m_scalars : read_scalars(sample_id));
+
+  auto tr = m_scalar_normalization_params.cbegin();
+  for (auto& val : scalars) {
+    val = static_cast<scalar_t>(val * tr->first + tr->second);
+    tr ++;
   }
+  return scalars;
+}
 
-  #define _LBANN_DATA_READER_JAG_CONDUIT_IO_PER_SCALAR_KEY_ // fetching by individual file I/O per key
+std::vector<data_reader_jag_conduit::scalar_t> data_reader_jag_conduit::read_scalars(const size_t sample_id) const {
+  if (sample_id >= m_valid_samples.size()) {
+    _THROW_LBANN_EXCEPTION_(_CN_, "read_scalars() : invalid sample index");
+  }
 
-  #if !defined(_LBANN_DATA_READER_JAG_CONDUIT_IO_PER_SCALAR_KEY_)
+  // fetching the entire scalar outputs of a sample by a single file I/O
   conduit::Node n_scalar;
   load_conduit_node(sample_id, "/outputs/scalars", n_scalar);
-  #endif // !_LBANN_DATA_READER_JAG_CONDUIT_IO_PER_SCALAR_KEY_
 
   std::vector<scalar_t> scalars;
   scalars.reserve(m_scalar_keys.size());
 
-  auto tr = m_scalar_normalization_params.cbegin();
-
   for(const auto key: m_scalar_keys) {
-  #if defined(_LBANN_DATA_READER_JAG_CONDUIT_IO_PER_SCALAR_KEY_)
-    conduit::Node n_scalar;
-    // TODO: optimize by loading the entire set of scalars of the samples
-    load_conduit_node(sample_id, "/outputs/scalars/" + key, n_scalar);
-    // All the scalar output currently seems to be scalar_t.
-    // If not, use add_val(key, n_scalar, scalars);
-
-    const scalar_t val_raw = static_cast<scalar_t>(n_scalar.to_value());
-  #else
     conduit::Node n_scalar_var = get_conduit_node(n_scalar, key);
     // All the scalar output currently seems to be scalar_t.
     // If not, use add_val(key, n_scalar_var, scalars);
-
-    const scalar_t val_raw = static_cast<scalar_t>(n_scalar_var.to_value());
-  #endif // _LBANN_DATA_READER_JAG_CONDUIT_IO_PER_SCALAR_KEY_
-    const scalar_t val = static_cast<scalar_t>(val_raw * tr->first + tr->second);
-    scalars.push_back(val);
-    tr ++;
+    scalars.push_back(static_cast<scalar_t>(n_scalar_var.to_value()));
   }
-  #undef _LBANN_DATA_READER_JAG_CONDUIT_IO_PER_SCALAR_KEY_
   return scalars;
 }
 
 std::vector<data_reader_jag_conduit::input_t> data_reader_jag_conduit::get_inputs(const size_t sample_id) const {
-  if (sample_id >= m_valid_samples.size()) {
-    _THROW_LBANN_EXCEPTION_(_CN_, "get_inputs() : invalid sample index");
+  const sample_record_ptr rec = get_sample_record(sample_id);
+  std::vector<size_t> ends;
+  std::vector<input_t> inputs;
+  if (rec->m_has_inputs) {
+    inputs = rec->m_inputs;
+    ends = rec->m_input_ends;
+  } else {
+    inputs = read_inputs(sample_id, ends);
+  }
+
+  // The sequence of normalization parameters should follow the same order as
+  // that of the variable keys. The last value read for each key is normalized.
+  auto tr = m_input_normalization_params.cbegin();
+  for (const auto e : ends) {
+    if (e > 0u) {
+      input_t& val = inputs[e-1];
+      val = static_cast<input_t>(val * tr->first + tr->second);
+    }
+    tr ++;
   }
+  return inputs;
+}
 
-  //#define _LBANN_DATA_READER_JAG_CONDUIT_IO_PER_INPUT_KEY_ // fetching by individual file I/O per key
+std::vector<data_reader_jag_conduit::input_t> data_reader_jag_conduit::read_inputs(const size_t sample_id, std::vector<size_t>& ends) const {
+  if (sample_id >= m_valid_samples.size()) {
+    _THROW_LBANN_EXCEPTION_(_CN_, "read_inputs() : invalid sample index");
+  }
 
-  #if !defined(_LBANN_DATA_READER_JAG_CONDUIT_IO_PER_INPUT_KEY_)
   // fetching the entire input parameters of a sample by a single file I/O
   conduit::Node n_input;
   load_conduit_node(sample_id, "/inputs", n_input);
-  #endif // !_LBANN_DATA_READER_JAG_CONDUIT_IO_PER_INPUT_KEY_
 
   std::vector<input_t> inputs;
   inputs.reserve(m_input_keys.size());
-
-  // The sequence of normalization parameters should follow the same order as
-  // that of the variable keys.
-  auto tr = m_input_normalization_params.cbegin();
+  ends.clear();
+  ends.reserve(m_input_keys.size());
 
   // automatically determine which method to use based on if all the variables are of input_t
   if (m_uniform_input_type) {
     // avoid some overhead by taking advantage of the fact that all the variables are of the same type
     for(const auto key: m_input_keys) {
-    #if defined(_LBANN_DATA_READER_JAG_CONDUIT_IO_PER_INPUT_KEY_)
-      // TODO: whether to fetch by individual I/O or not can be dynamically
-      // determined based on how many of the variables are to be fetched.
-      conduit::Node n_input;
-      load_conduit_node(sample_id, "/inputs/" + key, n_input);
-      const input_t val_raw = static_cast<input_t>(n_input.value());
-    #else
       conduit::Node n_input_var = get_conduit_node(n_input, key);
-      const input_t val_raw = static_cast<input_t>(n_input_var.value());
-    #endif // _LBANN_DATA_READER_JAG_CONDUIT_IO_PER_INPUT_KEY_
-      const input_t val = static_cast<input_t>(val_raw * tr->first + tr->second);
-      inputs.push_back(val);
-      tr ++;
+      inputs.push_back(static_cast<input_t>(n_input_var.value()));
+      ends.push_back(inputs.size());
     }
   } else {
     for(const auto key: m_input_keys) {
-    #if defined(_LBANN_DATA_READER_JAG_CONDUIT_IO_PER_INPUT_KEY_)
-      conduit::Node n_input;
-      load_conduit_node(sample_id, "/inputs/" + key, n_input);
-      add_val(key, n_input, inputs); // more overhead but general
-    #else
       conduit::Node n_input_var = get_conduit_node(n_input, key);
       add_val(key, n_input_var, inputs); // more overhead but general
-    #endif // _LBANN_DATA_READER_JAG_CONDUIT_IO_PER_INPUT_KEY_
-
-      input_t& val = inputs.back();
-      val = static_cast<input_t>(val * tr->first + tr->second);
-      tr ++;
+      ends.push_back(inputs.size());
     }
   }
-  #undef _LBANN_DATA_READER_JAG_CONDUIT_IO_PER_INPUT_KEY_
 
   return inputs;
 }
@@ -1656,6 +1735,7 @@ int data_reader_jag_conduit::fetch_data(CPUMat& X, El::Matrix<El::Int>& indices_
   if ((m_leading_reader != this) && (m_leading_reader != nullptr)) {
     return m_leading_reader->reuse_data(X);
   }
+  load_mini_batch_records();
   m_cached_data_mb_size = generic_data_reader::fetch_data(X, indices_fetched);
   El::Copy(X, m_data_cache);
 
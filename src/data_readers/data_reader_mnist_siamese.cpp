@@ -93,7 +93,7 @@ int data_reader_mnist_siamese::fetch_data(CPUMat& X, El::Matrix<El::Int>& indice
     throw lbann_exception(
       std::string{} + __FILE__ + " " + std::to_string(__LINE__)
       + " :: " + get_type() + "  load error: !position_valid"
-      + " -- current pos = " + std::to_string(m_current_pos)
+      + " -- fetch pos = " + std::to_string(m_fetch_pos)
       + " and there are " + std::to_string(m_shuffled_indices.size()) + " indices");
   }
 
@@ -104,18 +104,19 @@ int data_reader_mnist_siamese::fetch_data(CPUMat& X, El::Matrix<El::Int>& indice
   }
 
   int loaded_batch_size = get_loaded_mini_batch_size();
-  const int end_pos = std::min(static_cast<size_t>(m_current_pos+loaded_batch_size),
+  const int end_pos = std::min(static_cast<size_t>(m_fetch_pos+loaded_batch_size),
                                m_shuffled_indices.size());
   const int mb_size = std::min(
-    El::Int{((end_pos - m_current_pos) + m_sample_stride - 1) / m_sample_stride},
+    El::Int{((end_pos - m_fetch_pos) + m_sample_stride - 1) / m_sample_stride},
     X.Width());
 
-  El::Zeros_seq(X, X.Height(), X.Width());
+  m_zero_filled_bytes.m_value = 0;
+  zero_fill_mini_batch(X, mb_size);
   El::Zeros_seq(indices_fetched, mb_size, 1);
 
   std::string error_message;
   for (int s = 0; s < mb_size; s++) {
-    int n = m_current_pos + (s * m_sample_stride);
+    int n = m_fetch_pos + (s * m_sample_stride);
     sample_t index = std::make_pair(m_shuffled_indices[n], m_shuffled_indices2[n]);
     bool valid = fetch_datum(X, index, s);
     if (valid) {
@@ -148,10 +149,10 @@ int data_reader_mnist_siamese::fetch_labels(CPUMat& Y) {
   }
 
   int loaded_batch_size = get_loaded_mini_batch_size();
-  const int end_pos = std::min(static_cast<size_t>(m_current_pos+loaded_batch_size),
+  const int end_pos = std::min(static_cast<size_t>(m_fetch_pos+loaded_batch_size),
                                m_shuffled_indices.size());
   const int mb_size = std::min(
-    El::Int{((end_pos - m_current_pos) + m_sample_stride - 1) / m_sample_stride},
+    El::Int{((end_pos - m_fetch_pos) + m_sample_stride - 1) / m_sample_stride},
     Y.Width());
 
   El::Zeros(Y, Y.Height(), Y.Width());
@@ -164,7 +165,7 @@ int data_reader_mnist_siamese::fetch_labels(CPUMat& Y) {
 //  else {
     std::string error_message;
     for (int s = 0; s < mb_size; s++) {
-      int n = m_current_pos + (s * m_sample_stride);
+      int n = m_fetch_pos + (s * m_sample_stride);
       sample_t index = std::make_pair(m_shuffled_indices[n], m_shuffled_indices2[n]);
       bool valid = fetch_label(Y, index, s);
       if (!valid) {
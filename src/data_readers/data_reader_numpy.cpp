@@ -27,13 +27,236 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "lbann/data_readers/data_reader_numpy.hpp"
+#include "lbann/utils/options.hpp"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
 #include <cstdio>
+#include <cstring>
+#include <sstream>
 #include <string>
 #include <unordered_set>
 #include <cnpy.h>
 
 namespace lbann {
 
+namespace {
+
+/// Read a little-endian integer.
+template <typename T>
+T read_le(const char *p) {
+  T val;
+  std::memcpy(&val, p, sizeof(T));
+  return val;
+}
+
+/// Throw an exception if [offset, offset+count) is not within a buffer.
+void check_bounds(size_t offset, size_t count, size_t size,
+                  const std::string& filename) {
+  if (offset > size || count > size - offset) {
+    throw lbann_exception(
+      "numpy_reader: " + filename + " is truncated or corrupt");
+  }
+}
+
+/**
+ * Parse the header of a .npy array at the start of buf.
+ * @return Offset of the array data.
+ */
+size_t parse_npy_header(const char *buf, size_t size,
+                        const std::string& filename,
+                        size_t& word_size,
+                        std::vector<size_t>& shape,
+                        bool& fortran_order) {
+  check_bounds(0, 10, size, filename);
+  if (std::memcmp(buf, "\x93NUMPY", 6) != 0) {
+    throw lbann_exception(
+      "numpy_reader: " + filename + " is not a numpy array");
+  }
+  const int major_version = buf[6];
+  size_t header_start, header_len;
+  if (major_version == 1) {
+    header_start = 10;
+    header_len = read_le<uint16_t>(buf + 8);
+  } else {
+    check_bounds(0, 12, size, filename);
+    header_start = 12;
+    header_len = read_le<uint32_t>(buf + 8);
+  }
+  check_bounds(header_start, header_len, size, filename);
+  const std::string header(buf + header_start, header_len);
+
+  // Data type, e.g. '<f4'
+  auto pos = header.find("'descr'");
+  pos = (pos == std::string::npos) ? pos : header.find('\'', pos + 7);
+  const auto descr_end = ((pos == std::string::npos) ?
+                          pos : header.find('\'', pos + 1));
+  if (descr_end == std::string::npos) {
+    throw lbann_exception(
+      "numpy_reader: could not parse data type in " + filename);
+  }
+  const std::string descr = header.substr(pos + 1, descr_end - pos - 1);
+  if (descr.size() < 3 || descr[0] == '>' || descr[1] != 'f') {
+    throw lbann_exception(
+      "numpy_reader: data type " + descr + " in " + filename +
+      " not supported for memory-mapping");
+  }
+  word_size = std::stoul(descr.substr(2));
+
+  // Memory layout
+  pos = header.find("'fortran_order'");
+  pos = ((pos == std::string::npos) ?
+         pos : header.find_first_not_of(" :", pos + 15));
+  if (pos == std::string::npos) {
+    throw lbann_exception(
+      "numpy_reader: could not parse memory layout in " + filename);
+  }
+  fortran_order = (header.compare(pos, 4, "True") == 0);
+
+  // Shape, e.g. (100, 10)
+  pos = header.find("'shape'");
+  pos = (pos == std::string::npos) ? pos : header.find('(', pos);
+  const auto shape_end = ((pos == std::string::npos) ?
+                          pos : header.find(')', pos));
+  if (shape_end == std::string::npos) {
+    throw lbann_exception(
+      "numpy_reader: could not parse shape in " + filename);
+  }
+  shape.clear();
+  std::stringstream ss(header.substr(pos + 1, shape_end - pos - 1));
+  std::string dim;
+  while (std::getline(ss, dim, ',')) {
+    if (dim.find_first_not_of(" ") != std::string::npos) {
+      shape.push_back(std::stoul(dim));
+    }
+  }
+
+  return header_start + header_len;
+}
+
+/**
+ * Find the array with the first name in a .npz (zip) archive.
+ * @param offset   Offset of the array's .npy data within the archive.
+ * @param size     Size of the array's .npy data.
+ * @return False if the array is compressed.
+ */
+bool find_npz_array(const char *buf, size_t file_size,
+                    const std::string& filename,
+                    size_t& offset, size_t& size) {
+
+  // Find end of central directory record
+  const size_t eocd_size = 22;
+  check_bounds(0, eocd_size, file_size, filename);
+  size_t eocd = file_size - eocd_size;
+  const size_t eocd_min = (file_size > eocd_size + 65535 ?
+                           file_size - eocd_size - 65535 : 0);
+  while (read_le<uint32_t>(buf + eocd) != 0x06054b50) {
+    if (eocd == eocd_min) {
+      throw lbann_exception(
+        "numpy_reader: " + filename + " is not a zip archive");
+    }
+    --eocd;
+  }
+  uint64_t num_entries = read_le<uint16_t>(buf + eocd + 10);
+  uint64_t cd_offset = read_le<uint32_t>(buf + eocd + 16);
+
+  // Large archives have a ZIP64 end of central directory record
+  if (eocd >= 20 && read_le<uint32_t>(buf + eocd - 20) == 0x07064b50) {
+    const uint64_t eocd64 = read_le<uint64_t>(buf + eocd - 20 + 8);
+    check_bounds(eocd64, 56, file_size, filename);
+    if (read_le<uint32_t>(buf + eocd64) != 0x06064b50) {
+      throw lbann_exception(
+        "numpy_reader: " + filename + " has a corrupt ZIP64 record");
+    }
+    num_entries = read_le<uint64_t>(buf + eocd64 + 32);
+    cd_offset = read_le<uint64_t>(buf + eocd64 + 48);
+  }
+
+  // Find array with the first name in central directory
+  std::string array_name;
+  uint64_t array_header_offset = 0, array_size = 0;
+  uint16_t array_method = 0;
+  size_t entry = cd_offset;
+  for (uint64_t i = 0; i < num_entries; ++i) {
+    check_bounds(entry, 46, file_size, filename);
+    if (read_le<uint32_t>(buf + entry) != 0x02014b50) {
+      throw lbann_exception(
+        "numpy_reader: " + filename + " has a corrupt central directory");
+    }
+    const uint16_t method = read_le<uint16_t>(buf + entry + 10);
+    uint64_t compressed_size = read_le<uint32_t>(buf + entry + 20);
+    uint64_t uncompressed_size = read_le<uint32_t>(buf + entry + 24);
+    const uint16_t name_len = read_le<uint16_t>(buf + entry + 28);
+    const uint16_t extra_len = read_le<uint16_t>(buf + entry + 30);
+    const uint16_t comment_len = read_le<uint16_t>(buf + entry + 32);
+    uint64_t header_offset = read_le<uint32_t>(buf + entry + 42);
+    check_bounds(entry + 46, name_len + extra_len, file_size, filename);
+    const std::string name(buf + entry + 46, name_len);
+
+    // ZIP64 extra field holds the values that do not fit in 32 bits
+    const char *extra = buf + entry + 46 + name_len;
+    for (size_t e = 0; e + 4 <= extra_len; ) {
+      const uint16_t id = read_le<uint16_t>(extra + e);
+      const uint16_t len = read_le<uint16_t>(extra + e + 2);
+      if (id == 0x0001) {
+        size_t field = e + 4;
+        if (uncompressed_size == 0xFFFFFFFF && field + 8 <= e + 4 + len) {
+          uncompressed_size = read_le<uint64_t>(extra + field);
+          field += 8;
+        }
+        if (compressed_size == 0xFFFFFFFF && field + 8 <= e + 4 + len) {
+          compressed_size = read_le<uint64_t>(extra + field);
+          field += 8;
+        }
+        if (header_offset == 0xFFFFFFFF && field + 8 <= e + 4 + len) {
+          header_offset = read_le<uint64_t>(extra + field);
+        }
+      }
+      e += 4 + len;
+    }
+
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".npy") == 0
+        && (array_name.empty() || name < array_name)) {
+      array_name = name;
+      array_header_offset = header_offset;
+      array_size = (method == 0 ? uncompressed_size : compressed_size);
+      array_method = method;
+    }
+    entry += 46 + name_len + extra_len + comment_len;
+  }
+  if (array_name.empty()) {
+    throw lbann_exception(
+      "numpy_reader: no arrays in " + filename);
+  }
+  if (array_method != 0) {
+    return false;
+  }
+
+  // Array data follows its local file header
+  check_bounds(array_header_offset, 30, file_size, filename);
+  if (read_le<uint32_t>(buf + array_header_offset) != 0x04034b50) {
+    throw lbann_exception(
+      "numpy_reader: " + filename + " has a corrupt file header");
+  }
+  offset = (array_header_offset + 30
+            + read_le<uint16_t>(buf + array_header_offset + 26)
+            + read_le<uint16_t>(buf + array_header_offset + 28));
+  size = array_size;
+  check_bounds(offset, size, file_size, filename);
+  return true;
+
+}
+
+bool ends_with(const std::string& str, const std::string& suffix) {
+  return (str.size() >= suffix.size()
+          && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0);
+}
+
+}  // namespace
+
 numpy_reader::numpy_reader(bool shuffle)
   : generic_data_reader(shuffle), m_num_samples(0),
     m_num_features(0) {}
@@ -45,7 +268,12 @@ numpy_reader::numpy_reader(const numpy_reader& other) :
   m_num_labels(other.m_num_labels),
   m_has_labels(other.m_has_labels),
   m_has_responses(other.m_has_responses),
-  m_data(other.m_data) {}
+  m_use_mmap(other.m_use_mmap),
+  m_shape(other.m_shape),
+  m_word_size(other.m_word_size),
+  m_data(other.m_data),
+  m_mapping(other.m_mapping),
+  m_raw_data(other.m_raw_data) {}
 
 numpy_reader& numpy_reader::operator=(const numpy_reader& other) {
   generic_data_reader::operator=(other);
@@ -54,7 +282,12 @@ numpy_reader& numpy_reader::operator=(const numpy_reader& other) {
   m_num_labels = other.m_num_labels;
   m_has_labels = other.m_has_labels;
   m_has_responses = other.m_has_responses;
+  m_use_mmap = other.m_use_mmap;
+  m_shape = other.m_shape;
+  m_word_size = other.m_word_size;
   m_data = other.m_data;
+  m_mapping = other.m_mapping;
+  m_raw_data = other.m_raw_data;
   return *this;
 }
 
@@ -69,20 +302,43 @@ void numpy_reader::load() {
   }
   ifs.close();
 
-  m_data = cnpy::npy_load(infile);
-  m_num_samples = m_data.shape[0];
+  if (options::get()->get_bool("numpy_mmap")) {
+    m_use_mmap = true;
+  }
+  bool fortran_order = false;
+  if (!(m_use_mmap && map_file(infile))) {
+    m_mapping.reset();
+    if (ends_with(infile, ".npz")) {
+      auto arrays = cnpy::npz_load(infile);
+      if (arrays.empty()) {
+        throw lbann_exception("numpy_reader: no arrays in " + infile);
+      }
+      m_data = arrays.begin()->second;
+    } else {
+      m_data = cnpy::npy_load(infile);
+    }
+    m_shape = m_data.shape;
+    m_word_size = m_data.word_size;
+    fortran_order = m_data.fortran_order;
+    m_raw_data = m_data.data<char>();
+  }
+  if (m_shape.empty()) {
+    throw lbann_exception(
+      "numpy_reader: array in " + infile + " has no sample axis");
+  }
+  m_num_samples = m_shape[0];
   m_num_features = std::accumulate(
-    m_data.shape.begin() + 1, m_data.shape.end(), (unsigned) 1,
+    m_shape.begin() + 1, m_shape.end(), (unsigned) 1,
     std::multiplies<unsigned>());
 
   // Ensure we understand the word size.
-  if (!(m_data.word_size == 4 || m_data.word_size == 8)) {
+  if (!(m_word_size == 4 || m_word_size == 8)) {
     throw lbann_exception(
-      "numpy_reader: word size " + std::to_string(m_data.word_size) +
+      "numpy_reader: word size " + std::to_string(m_word_size) +
       " not supported");
   }
   // Fortran order not yet supported.
-  if (m_data.fortran_order) {
+  if (fortran_order) {
     throw lbann_exception(
       "numpy_reader: fortran order not supported");
   }
@@ -96,27 +352,32 @@ void numpy_reader::load() {
     // Shift feature count because the last becomes the label.
     m_num_features -= 1;
     // Determine number of label classes.
-    std::unordered_set<int> label_classes;
-    for (int i = 0; i < m_num_samples; ++i) {
-      if (m_data.word_size == 4) {
-        float *data = m_data.data<float>() + i*(m_num_features+1);
-        label_classes.insert((int) data[m_num_features+1]);
-      } else if (m_data.word_size == 8) {
-        double *data = m_data.data<double>() + i*(m_num_features+1);
-        label_classes.insert((int) data[m_num_features+1]);
+    // Note: With a memory-mapped file, this touches every page, so only
+    // the master does it.
+    if (m_mapping == nullptr || m_comm->am_world_master()) {
+      std::unordered_set<int> label_classes;
+      for (int i = 0; i < m_num_samples; ++i) {
+        if (m_word_size == 4) {
+          label_classes.insert((int) get_row<float>(i)[m_num_features]);
+        } else if (m_word_size == 8) {
+          label_classes.insert((int) get_row<double>(i)[m_num_features]);
+        }
       }
+      // Sanity checks.
+      auto minmax = std::minmax_element(label_classes.begin(), label_classes.end());
+      if (*minmax.first != 0) {
+        throw lbann_exception(
+          "numpy_reader: classes are not indexed from 0");
+      }
+      if (*minmax.second != (int) label_classes.size() - 1) {
+        throw lbann_exception(
+          "numpy_reader: label classes are not contiguous");
+      }
+      m_num_labels = label_classes.size();
     }
-    // Sanity checks.
-    auto minmax = std::minmax_element(label_classes.begin(), label_classes.end());
-    if (*minmax.first != 0) {
-      throw lbann_exception(
-        "numpy_reader: classes are not indexed from 0");
-    }
-    if (*minmax.second != (int) label_classes.size() - 1) {
-      throw lbann_exception(
-        "numpy_reader: label classes are not contiguous");
+    if (m_mapping != nullptr) {
+      m_comm->broadcast<int>(0, m_num_labels, m_comm->get_world_comm());
     }
-    m_num_labels = label_classes.size();
   }
   if (m_has_responses) {
     // Last feature becomes the response.
@@ -130,18 +391,70 @@ void numpy_reader::load() {
   select_subset_of_data();
 }
 
-bool numpy_reader::fetch_datum(Mat& X, int data_id, int mb_idx) {
-  int features_size = m_num_features;
-  if (m_has_labels || m_has_responses) {
-    features_size += 1;
+bool numpy_reader::map_file(const std::string& filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw lbann_exception(
+      "numpy_reader: failed to open " + filename + ": " + std::strerror(errno));
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw lbann_exception(
+      "numpy_reader: failed to stat " + filename + ": " + std::strerror(errno));
   }
-  if (m_data.word_size == 4) {
-    float *data = m_data.data<float>() + data_id * features_size;
+  const size_t file_size = st.st_size;
+  if (file_size == 0) {
+    close(fd);
+    throw lbann_exception("numpy_reader: " + filename + " is empty");
+  }
+  void *addr = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    throw lbann_exception(
+      "numpy_reader: failed to map " + filename + ": " + std::strerror(errno));
+  }
+  std::shared_ptr<const char> mapping(
+    static_cast<const char*>(addr),
+    [file_size](const char *p) { munmap(const_cast<char*>(p), file_size); });
+
+  // Find the .npy data
+  size_t offset = 0, size = file_size;
+  if (ends_with(filename, ".npz")
+      && !find_npz_array(mapping.get(), file_size, filename, offset, size)) {
+    if (m_comm->am_world_master()) {
+      std::cerr << "numpy_reader: array in " << filename << " is compressed, "
+                << "so it is read into memory instead of being mapped\n";
+    }
+    return false;
+  }
+
+  bool fortran_order;
+  const size_t data_offset = parse_npy_header(mapping.get() + offset, size,
+                                              filename, m_word_size,
+                                              m_shape, fortran_order);
+  if (fortran_order) {
+    throw lbann_exception(
+      "numpy_reader: fortran order not supported");
+  }
+  size_t num_entries = 1;
+  for (const auto& d : m_shape) { num_entries *= d; }
+  check_bounds(data_offset, num_entries * m_word_size, size, filename);
+
+  m_data = cnpy::NpyArray();
+  m_mapping = std::move(mapping);
+  m_raw_data = m_mapping.get() + offset + data_offset;
+  return true;
+}
+
+bool numpy_reader::fetch_datum(Mat& X, int data_id, int mb_idx) {
+  if (m_word_size == 4) {
+    const float *data = get_row<float>(data_id);
     for (int j = 0; j < m_num_features; ++j) {
       X(j, mb_idx) = data[j];
     }
-  } else if (m_data.word_size == 8) {
-    double *data = m_data.data<double>() + data_id * features_size;
+  } else if (m_word_size == 8) {
+    const double *data = get_row<double>(data_id);
     for (int j = 0; j < m_num_features; ++j) {
       X(j, mb_idx) = data[j];
     }
@@ -154,12 +467,10 @@ bool numpy_reader::fetch_label(Mat& Y, int data_id, int mb_idx) {
     throw lbann_exception("numpy_reader: do not have labels");
   }
   int label = 0;
-  if (m_data.word_size == 4) {
-    float *data = m_data.data<float>() + data_id*(m_num_features+1);
-    label = (int) data[m_num_features+1];
-  } else if (m_data.word_size == 8) {
-    double *data = m_data.data<double>() + data_id*(m_num_features+1);
-    label = (int) data[m_num_features+1];
+  if (m_word_size == 4) {
+    label = (int) get_row<float>(data_id)[m_num_features];
+  } else if (m_word_size == 8) {
+    label = (int) get_row<double>(data_id)[m_num_features];
   }
   Y(label, mb_idx) = 1;
   return true;
@@ -170,12 +481,10 @@ bool numpy_reader::fetch_response(Mat& Y, int data_id, int mb_idx) {
     throw lbann_exception("numpy_reader: do not have responses");
   }
   auto response = DataType(0);
-  if (m_data.word_size == 4) {
-    float *data = m_data.data<float>() + data_id*(m_num_features+1);
-    response = (DataType) data[m_num_features+1];
-  } else if (m_data.word_size == 8) {
-    double *data = m_data.data<double>() + data_id*(m_num_features+1);
-    response = (DataType) data[m_num_features+1];
+  if (m_word_size == 4) {
+    response = (DataType) get_row<float>(data_id)[m_num_features];
+  } else if (m_word_size == 8) {
+    response = (DataType) get_row<double>(data_id)[m_num_features];
   }
   Y(0, mb_idx) = response;
   return true;
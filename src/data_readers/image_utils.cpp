@@ -201,7 +201,7 @@ bool image_utils::process_image(cv::Mat& image, int& Width, int& Height, int& Ty
 bool image_utils::load_image(const std::string& filename,
                              int& Width, int& Height, int& Type, cv_process& pp, CPUMat& data, std::vector<char>& buf, cv::Mat* cv_buf) {
 #ifdef LBANN_HAS_OPENCV
-  cv::Mat image = cv_utils::lbann_imread(filename, cv::IMREAD_ANYCOLOR | cv::IMREAD_ANYDEPTH, buf, cv_buf);
+  cv::Mat image = cv_utils::lbann_imread(filename, pp, buf, cv_buf);
 
   return process_image(image, Width, Height, Type, pp, data);
 #else
@@ -283,12 +283,7 @@ bool image_utils::save_image(const std::string& filename,
 bool image_utils::import_image(cv::InputArray inbuf,
                                       int& Width, int& Height, int& Type, cv_process& pp, CPUMat& data, cv::Mat* cv_buf) {
 #ifdef LBANN_HAS_OPENCV
-  cv::Mat image;
-  if(cv_buf != nullptr) {
-    image = cv::imdecode(inbuf, cv::IMREAD_ANYCOLOR | cv::IMREAD_ANYDEPTH, cv_buf);
-  }else {
-    image = cv::imdecode(inbuf, cv::IMREAD_ANYCOLOR | cv::IMREAD_ANYDEPTH);
-  }
+  cv::Mat image = cv_utils::lbann_imdecode(inbuf, pp, cv_buf);
 
   return process_image(image, Width, Height, Type, pp, data);
 #else
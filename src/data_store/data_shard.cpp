@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lbann/data_store/data_shard.hpp"
+#include "lbann/utils/exception.hpp"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+namespace lbann {
+
+uint64_t data_shard_checksum(const unsigned char *data, size_t sz, uint64_t h) {
+  for (size_t j=0; j<sz; j++) {
+    h ^= data[j];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
+//=========================================================================
+// data_shard_writer
+//=========================================================================
+
+data_shard_writer::data_shard_writer(const std::string &filename) :
+  m_filename(filename),
+  m_out(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc),
+  m_offset(0),
+  m_checksum(data_shard_checksum(nullptr, 0)) {
+  if (!m_out) {
+    std::stringstream err;
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << "failed to open " << m_filename << " for writing";
+    throw lbann_exception(err.str());
+  }
+}
+
+data_shard_writer::~data_shard_writer() {
+  if (m_out.is_open()) {
+    try {
+      close();
+    } catch (...) {}
+  }
+}
+
+void data_shard_writer::add(int index, const unsigned char *data, size_t sz) {
+  m_out.write((const char*)data, sz);
+  if (!m_out) {
+    std::stringstream err;
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << "failed to write " << sz << " bytes to " << m_filename;
+    throw lbann_exception(err.str());
+  }
+  m_index.push_back(index);
+  m_index.push_back(m_offset);
+  m_index.push_back(sz);
+  m_offset += sz;
+  m_checksum = data_shard_checksum(data, sz, m_checksum);
+}
+
+void data_shard_writer::close() {
+  const uint64_t footer[] = { data_shard::magic, m_index.size()/3,
+                              m_offset, m_checksum };
+  m_out.write((const char*)m_index.data(), m_index.size()*sizeof(uint64_t));
+  m_out.write((const char*)footer, sizeof(footer));
+  m_out.close();
+  if (!m_out) {
+    std::stringstream err;
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << "failed to write index to " << m_filename;
+    throw lbann_exception(err.str());
+  }
+}
+
+//=========================================================================
+// data_shard
+//=========================================================================
+
+data_shard::data_shard(const std::string &filename) :
+  m_filename(filename),
+  m_map(nullptr),
+  m_map_size(0),
+  m_data_size(0),
+  m_checksum(0) {
+  std::stringstream err;
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1) {
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << "failed to open " << filename << " for reading;\n"
+        << "error code is: " << std::strerror(errno);
+    throw lbann_exception(err.str());
+  }
+  struct stat stat_buf;
+  if (fstat(fd, &stat_buf) == -1 || (size_t)stat_buf.st_size < footer_size) {
+    close(fd);
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << filename << " is not a data store shard";
+    throw lbann_exception(err.str());
+  }
+  m_map_size = stat_buf.st_size;
+  void *p = mmap(nullptr, m_map_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << "failed to map " << filename << ";\n"
+        << "error code is: " << std::strerror(errno);
+    throw lbann_exception(err.str());
+  }
+  m_map = (const unsigned char*)p;
+  // files are fetched in shuffled order, but every file is read
+  // each epoch, so ask the kernel to read the whole shard ahead
+  madvise(p, m_map_size, MADV_WILLNEED);
+
+  uint64_t footer[4];
+  memcpy(footer, m_map + m_map_size - footer_size, footer_size);
+  const uint64_t num_entries = footer[1];
+  m_data_size = footer[2];
+  m_checksum = footer[3];
+  const size_t max_entries = (m_map_size - footer_size) / (3*sizeof(uint64_t));
+  if (footer[0] != magic
+      || num_entries > max_entries
+      || m_data_size != m_map_size - footer_size - num_entries*3*sizeof(uint64_t)) {
+    munmap(p, m_map_size);
+    m_map = nullptr;
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << filename << " is not a data store shard, or is truncated";
+    throw lbann_exception(err.str());
+  }
+
+  std::vector<uint64_t> index(num_entries*3);
+  memcpy(index.data(), m_map + m_data_size, index.size()*sizeof(uint64_t));
+  m_entries.reserve(num_entries);
+  for (size_t j=0; j<index.size(); j+=3) {
+    const uint64_t offset = index[j+1];
+    const uint64_t size = index[j+2];
+    if (offset > m_data_size || size > m_data_size - offset) {
+      munmap(p, m_map_size);
+      m_map = nullptr;
+      err << __FILE__ << " " << __LINE__ << " :: "
+          << "entry " << index[j] << " in shard " << filename
+          << " is outside the shard's data section";
+      throw lbann_exception(err.str());
+    }
+    m_entries[index[j]] = std::make_pair(offset, size);
+  }
+}
+
+data_shard::~data_shard() {
+  if (m_map != nullptr) {
+    munmap((void*)m_map, m_map_size);
+  }
+}
+
+const unsigned char * data_shard::get_data(int index) const {
+  auto it = m_entries.find(index);
+  if (it == m_entries.end()) {
+    std::stringstream err;
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << "failed to find index: " << index << " in shard " << m_filename;
+    throw lbann_exception(err.str());
+  }
+  return m_map + it->second.first;
+}
+
+size_t data_shard::get_size(int index) const {
+  auto it = m_entries.find(index);
+  if (it == m_entries.end()) {
+    std::stringstream err;
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << "failed to find index: " << index << " in shard " << m_filename;
+    throw lbann_exception(err.str());
+  }
+  return it->second.second;
+}
+
+std::vector<int> data_shard::get_indices() const {
+  std::vector<int> indices;
+  indices.reserve(m_entries.size());
+  for (auto t : m_entries) {
+    indices.push_back(t.first);
+  }
+  return indices;
+}
+
+void data_shard::verify() const {
+  if (data_shard_checksum(m_map, m_data_size) != m_checksum) {
+    std::stringstream err;
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << "checksum mismatch for shard " << m_filename
+        << "; the shard is corrupt";
+    throw lbann_exception(err.str());
+  }
+}
+
+}  // namespace lbann
@@ -37,9 +37,47 @@
 #endif // LBANN_SYS_SENDFILE_OK
 
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <random>
 
 namespace lbann {
 
+namespace {
+
+/** Copy a file with large reads and writes. */
+void copy_file(const std::string &src, const std::string &dst) {
+  std::stringstream err;
+  std::ifstream in(src.c_str(), std::ios::in | std::ios::binary);
+  if (!in) {
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << "failed to open " << src << " for reading";
+    throw lbann_exception(err.str());
+  }
+  std::ofstream out(dst.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!out) {
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << "failed to open " << dst << " for writing";
+    throw lbann_exception(err.str());
+  }
+  std::vector<char> buf(size_t(1) << 24);
+  while (in) {
+    in.read(buf.data(), buf.size());
+    out.write(buf.data(), in.gcount());
+  }
+  out.close();
+  if (in.bad() || !out) {
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << "failed to copy " << src << " to " << dst;
+    throw lbann_exception(err.str());
+  }
+}
+
+} // namespace
+
 data_store_image::~data_store_image() {
 }
 
@@ -56,7 +94,7 @@ void data_store_image::setup() {
   }
 
   if (using_tarball) {
-    stage_tarball();
+    stage_shard();
     m_comm->global_barrier();
   }
 
@@ -81,18 +119,15 @@ void data_store_image::setup() {
       get_my_datastore_indices();
     }
 
-    if (m_master) std::cerr << "data_store_image - calling build_data_filepaths\n";
-    if (using_tarball) {
-      read_data_filepaths();
-    } else {
+    if (! using_tarball) {
+      if (m_master) std::cerr << "data_store_image - calling build_data_filepaths\n";
       build_data_filepaths();
     }
 
     if (m_master) std::cerr << "data_store_image - calling get_file_sizes\n";
     tm = get_time();
     if (using_tarball) {
-      read_file_sizes();
-      read_datastore_indices();
+      read_shard_index();
     } else {
       get_file_sizes();
     }
@@ -103,19 +138,19 @@ void data_store_image::setup() {
     build_index_owner();
     if (m_master) std::cerr << "TIME for build_index_owner: " << get_time() - tm << "\n";
 
-    if (! using_tarball) {
+    if (! using_tarball && ! creating_tarball) {
       if (m_master) std::cerr << "data_store_image - calling stage_files\n";
       tm = get_time();
       stage_files();
       if (m_master) std::cerr << "TIME for stage_files: " << get_time() - tm << "\n";
     }
 
-    // create tarball and copy to lscratch (or where ever)
+    // pack files into a shard on lscratch (or where ever)
     if (creating_tarball) {
-      if (m_master) std::cerr << "data_store_image - creating tarball\n";
+      if (m_master) std::cerr << "data_store_image - creating shard\n";
       tm = get_time();
-      create_tarball();
-      if (m_master) std::cerr << "TIME for creating tarball: " << get_time() - tm << "\n";
+      create_shard();
+      if (m_master) std::cerr << "TIME for creating shard: " << get_time() - tm << "\n";
     }
 
     m_is_setup = true;
@@ -153,6 +188,14 @@ void data_store_image::setup() {
     read_files();
     if (m_master) std::cerr << "TIME for read_files: " << get_time() - tma << "\n";
 
+    options *opts = options::get();
+    if (opts->has_bool("node_shm_cache") && opts->get_bool("node_shm_cache")) {
+      if (m_master) std::cerr << "data_store_image - calling setup_node_cache\n";
+      tma = get_time();
+      setup_node_cache();
+      if (m_master) std::cerr << "TIME for setup_node_cache: " << get_time() - tma << "\n";
+    }
+
     if (m_master) std::cerr << "data_store_image - calling exchange_data\n";
     exchange_data();
 
@@ -224,6 +267,10 @@ void data_store_image::exchange_data() {
   //start sends
   std::vector<std::vector<El::mpi::Request<unsigned char>>> send_req(m_np);
   for (int p=0; p<m_np; p++) {
+    //processors on this node read my files from the node cache
+    if (in_node_cache(p)) {
+      continue;
+    }
     send_req[p].resize(proc_to_indices[p].size()*m_num_img_srcs);
     size_t jj = 0;
     for (auto idx : proc_to_indices[p]) {
@@ -235,8 +282,11 @@ void data_store_image::exchange_data() {
           throw lbann_exception(err.str());
         }
         int len = m_file_sizes[index];
+        const unsigned char *data = (m_node_cache != nullptr
+                                     ? m_node_cache.get() + m_node_cache_offsets[index]
+                                     : m_data[index].data());
         m_comm->nb_tagged_send<unsigned char>(
-            m_data[index].data(), len, p, index,
+            data, len, p, index,
             send_req[p][jj++], m_comm->get_model_comm());
 
       }
@@ -252,14 +302,18 @@ void data_store_image::exchange_data() {
     proc_to_indices[owner].insert(index);
   }
 
-  //start recvs
+  //start recvs; files owned by processors on this node are copied
+  //directly from the node cache
   m_my_minibatch_data.clear();
   std::vector<std::vector<El::mpi::Request<unsigned char>>> recv_req(m_np);
   for (auto t : proc_to_indices) {
     int owner = t.first;
     size_t jj = 0;
     const std::unordered_set<int> &s = t.second;
-    recv_req[owner].resize(s.size()*m_num_img_srcs);
+    const bool local = in_node_cache(owner);
+    if (!local) {
+      recv_req[owner].resize(s.size()*m_num_img_srcs);
+    }
     for (auto idx : s) {
       for (size_t k=0; k<m_num_img_srcs; k++) {
         size_t index = idx*m_num_img_srcs+k;
@@ -271,6 +325,11 @@ void data_store_image::exchange_data() {
         }
         size_t len = m_file_sizes[index];
         m_my_minibatch_data[index].resize(len);
+        if (local) {
+          memcpy(m_my_minibatch_data[index].data(),
+                 m_node_cache.get() + m_node_cache_offsets[index], len);
+          continue;
+        }
         m_comm->nb_tagged_recv<unsigned char>(
             m_my_minibatch_data[index].data(), len, owner,
             index, recv_req[owner][jj++], m_comm->get_model_comm());
@@ -328,6 +387,127 @@ void data_store_image::exchange_file_sizes(
   }
 }
 
+void data_store_image::setup_node_cache() {
+  std::stringstream err;
+
+  //lay out the files owned by processors on this node, ordered by
+  //owner then global index; every processor on the node computes the
+  //same layout
+  std::vector<int> node_local(m_np);
+  for (int p=0; p<m_np; p++) {
+    node_local[p] = m_comm->is_rank_node_local(p, m_comm->get_model_comm());
+  }
+  std::vector<std::pair<int, int>> files;
+  for (auto t : m_owner) {
+    if (node_local[t.second]) {
+      for (size_t k=0; k<m_num_img_srcs; k++) {
+        files.push_back(std::make_pair(t.second, t.first*m_num_img_srcs+k));
+      }
+    }
+  }
+  std::sort(files.begin(), files.end());
+  m_node_cache_offsets.clear();
+  size_t size = 0;
+  for (auto t : files) {
+    m_node_cache_offsets[t.second] = size;
+    size += m_file_sizes[t.second];
+  }
+  size = std::max(size, size_t(1));
+
+  //the layout is per model, so each model on the node gets its own
+  //segment, created by the model's first processor on the node; the
+  //name is unique to this run, model and role
+  El::mpi::Comm node_comm;
+  El::mpi::Split(m_comm->get_node_comm(), m_comm->get_model_rank(),
+                 m_comm->get_rank_in_node(), node_comm);
+  const bool creator = El::mpi::Rank(node_comm) == 0;
+  std::vector<int> id(2);
+  if (creator) {
+    id[0] = getpid();
+    id[1] = std::random_device()();
+  }
+  m_comm->broadcast<int>(0, id, node_comm);
+  std::stringstream name;
+  name << "/lbann_data_store_" << id[0] << "_" << std::hex << (unsigned int)id[1]
+       << std::dec << "_" << m_comm->get_model_rank()
+       << "_" << m_reader->get_role();
+  int fd = -1;
+  if (creator) {
+    fd = shm_open(name.str().c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd != -1 && ftruncate(fd, size) == -1) {
+      const int ftruncate_errno = errno;
+      close(fd);
+      shm_unlink(name.str().c_str());
+      errno = ftruncate_errno;
+      fd = -1;
+    }
+  }
+  m_comm->barrier(node_comm);
+  if (!creator) {
+    fd = shm_open(name.str().c_str(), O_RDWR, 0);
+  }
+  void *p = MAP_FAILED;
+  if (fd == -1) {
+    const int shm_errno = errno;
+    err << __FILE__ << " " << __LINE__ << " :: "
+        << "failed to create shared memory segment " << name.str()
+        << " of " << size << " bytes;\n"
+        << "error code is: " << std::strerror(shm_errno);
+  } else {
+    p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int mmap_errno = errno;
+    close(fd);
+    if (p == MAP_FAILED) {
+      err << __FILE__ << " " << __LINE__ << " :: "
+          << "failed to map shared memory segment " << name.str()
+          << ";\nerror code is: " << std::strerror(mmap_errno);
+    }
+  }
+
+  //fail on every processor on the node if any of them could not map
+  //the segment; otherwise the others would block in the barriers below
+  const int mapped = (p != MAP_FAILED);
+  if (m_comm->allreduce(mapped, node_comm, El::mpi::MIN) == 0) {
+    if (p != MAP_FAILED) {
+      munmap(p, size);
+    }
+    if (creator && fd != -1) {
+      shm_unlink(name.str().c_str());
+    }
+    El::mpi::Free(node_comm);
+    if (mapped) {
+      err << __FILE__ << " " << __LINE__ << " :: "
+          << "failed to map shared memory segment " << name.str()
+          << " on another processor on this node";
+    }
+    throw lbann_exception(err.str());
+  }
+  m_node_cache.reset((unsigned char*)p,
+                     [size](unsigned char *q) { munmap(q, size); });
+
+  //once every processor has mapped the segment, remove its name, so
+  //it is released when the last processor exits
+  m_comm->barrier(node_comm);
+  if (creator) {
+    shm_unlink(name.str().c_str());
+  }
+
+  //move my files into the segment
+  for (auto &t : m_data) {
+    memcpy(m_node_cache.get() + m_node_cache_offsets[t.first],
+           t.second.data(), t.second.size());
+  }
+  std::unordered_map<int, std::vector<unsigned char>>().swap(m_data);
+  m_comm->barrier(node_comm);
+  El::mpi::Free(node_comm);
+
+  if (m_master) {
+    std::cerr << "node cache for " << m_reader->get_role() << ": "
+              << files.size() << " files, " << ((double)size/1000000)
+              << " MB on this node\n";
+  }
+}
+
 size_t data_store_image::get_global_num_file_bytes() {
   size_t n = get_my_num_file_bytes();
   size_t g = 0;
@@ -598,13 +778,19 @@ void data_store_image::fetch_data() {
     if (m_all_partitioned_indices[p].size() >= m_cur_minibatch
         && proc_to_indices.find(p) != proc_to_indices.end()) {
       const std::unordered_set<int> &s = proc_to_indices[p];
-      read_files(s);
+      //files in a staged shard are sent directly from the mapping
+      if (m_shard == nullptr) {
+        read_files(s);
+      }
       for (auto idx : s) {
         for (size_t k=0; k<m_num_img_srcs; k++) {
           int index = idx*m_num_img_srcs+k;
           int len = m_file_sizes[index];
+          const unsigned char *data = (m_shard != nullptr
+                                       ? m_shard->get_data(index)
+                                       : m_data[index].data());
           m_comm->nb_tagged_send<unsigned char>(
-                         m_data[index].data(), len, p, index,
+                         data, len, p, index,
                          send_req[req_idx++], m_comm->get_model_comm());
         }
       }
@@ -672,94 +858,44 @@ void data_store_image::fetch_data() {
   }
 }
 
-void data_store_image::write_data_filepaths() {
-  std::string local_dir = m_reader->get_local_file_dir();
-  std::stringstream s;
-  s << local_dir << "/data_filepaths.txt";
-  std::ofstream out(s.str().c_str());
-  if (! out.good()) {
-    std::stringstream err;
-    err << __FILE__ << " " << __LINE__ << " :: "
-        << "failed to open " << s.str() << " for reading";
-    throw lbann_exception(err.str());
-  }
-  for (auto t : m_data_filepaths) {
-    out << t.first << " " << t.second << "\n";
-  }
-  out.close();
-}
-
-void data_store_image::read_data_filepaths() {
-  std::string local_dir = m_reader->get_local_file_dir();
+std::string data_store_image::get_shard_filename(const std::string &name, int rank, int np) {
+  std::pair<std::string, std::string> names = get_pathname_and_prefix(name);
   std::stringstream s;
-  s << local_dir << "/data_filepaths.txt";
-  std::ifstream in(s.str().c_str());
-  //note: file_sizes.txt may not exist on all processors;
-  //      this is the case where we're using tarballed data, and
-  //      running with more processors than were used to create
-  //      the tarball
-  if (in.good()) {
-    std::string path;
-    int idx;
-    while (in >> idx >> path) {
-      m_data_filepaths[idx] = path;
-    }
-    in.close();
-  }
+  s << names.second << '/' << names.first << "_" << m_reader->get_role()
+    << "_rank=" << rank << "_np=" << np << ".shard";
+  return s.str();
 }
 
-void data_store_image::write_file_sizes() {
-  std::string local_dir = m_reader->get_local_file_dir();
-  std::stringstream s;
-  s << local_dir << "/file_sizes.txt";
-  std::ofstream out(s.str().c_str());
-  if (! out.good()) {
-    std::stringstream err;
-    err << __FILE__ << " " << __LINE__ << " :: "
-        << "failed to open " << s.str() << " for reading";
-    throw lbann_exception(err.str());
-  }
-  for (auto t : m_file_sizes) {
-    out << t.first << " " << t.second << "\n";
-  }
-  out.close();
-}
-
-std::pair<std::string, std::string>  data_store_image::get_tarball_exe() {
-  std::pair<std::string, std::string> names = get_pathname_and_prefix(
-                           options::get()->get_string("create_tarball"));
-  if (m_master) {
-    std::cerr << "tarball dir: " << names.second << "\n"
-              << "tarball prefix: " << names.first << "\n\n";
+void data_store_image::create_shard() {
+  std::string filename = get_shard_filename(
+                           options::get()->get_string("create_tarball"),
+                           m_rank, m_np);
+  if (m_master) std::cerr << "\nwriting shard: " << filename << "\n";
+
+  //write files in a fixed order, so shards are reproducible
+  std::vector<int> indices(m_my_datastore_indices.begin(),
+                           m_my_datastore_indices.end());
+  std::sort(indices.begin(), indices.end());
+
+  std::string dir = m_reader->get_file_dir() + '/';
+  data_shard_writer writer(filename);
+  std::vector<unsigned char> buf;
+  for (auto idx : indices) {
+    for (size_t k=0; k<m_num_img_srcs; k++) {
+      int index = idx*m_num_img_srcs+k;
+      if (m_data_filepaths.find(index) == m_data_filepaths.end()) {
+        std::stringstream err;
+        err << __FILE__ << " " << __LINE__ << " :: "
+            << " m_data_filepaths.find(" << index << ") failed";
+        throw lbann_exception(err.str());
+      }
+      size_t len = m_file_sizes[index];
+      buf.resize(len);
+      load_file(dir, m_data_filepaths[index], buf.data(), len);
+      writer.add(index, buf.data(), len);
+    }
   }
-
-  //This is somewhat fragile. For now I assume the local_dir is
-  //of the form: /l/ssd/train
-  std::string local_dir = m_reader->get_local_file_dir();
-  size_t j = local_dir.rfind('/', local_dir.size()-2);
-  std::string work_dir = local_dir.substr(0, j);
-
-  std::stringstream tarball_name;
-  tarball_name << names.first << "_" << m_reader->get_role()
-      << "_rank=" << m_rank << "_np=" << m_np << ".tar";
-  std::stringstream exe_1;
-  std::stringstream exe_2;
-  exe_1 << "tar cf " << work_dir << '/' << tarball_name.str()
-      << " " << local_dir;
-  exe_2 << "cp -f " << work_dir << '/' << tarball_name.str()
-      << " " << names.second;
-  return std::make_pair(exe_1.str(), exe_2.str());
-}
-
-void data_store_image::create_tarball() {
-  write_file_sizes();
-  write_datastore_indices();
-  write_data_filepaths();
-  std::pair<std::string, std::string> cmds = get_tarball_exe();
-  if (m_master)  std::cerr << "\nabout to execute: " << cmds.first << "\n";
-  run_cmd(cmds.first);
-  if (m_master)  std::cerr << "\nabout to execute: " << cmds.second << "\n";
-  run_cmd(cmds.second);
+  writer.close();
 }
 
 bool data_store_image::are_we_creating_tarballs() {
@@ -782,77 +918,24 @@ bool data_store_image::are_we_creating_tarballs() {
   return retval;
 }
 
-void data_store_image::read_file_sizes() {
-  std::stringstream s;
-  s << m_reader->get_local_file_dir() << "/file_sizes.txt";
-  //note: file_sizes.txt may not exist on all processors;
-  //      this is the case where we're using tarballed data, and
-  //      running with more processors than were used to create
-  //      the tarball
-  std::ifstream in(s.str().c_str());
-  if (in.good()) {
-    size_t idx;
-    size_t len;
-    while (in >> idx >> len) {
-      m_file_sizes[idx] = len;
-    }
-  }
-  m_comm->global_barrier();
-  int n = m_file_sizes.size();
-  m_comm->broadcast<int>(0, n, m_comm->get_world_comm());
-  std::vector<int> s2(n*2);
-  if (m_rank == 0) {
-    size_t j = 0;
-    for (auto t : m_file_sizes) {
-      s2[j++] = t.first;
-      s2[j++] = t.second;
-    }
-  }
-
-  m_comm->broadcast(0, s2.data(), s2.size(), m_comm->get_model_comm());
-  for (size_t j=0; j<s2.size(); j+=2) {
-    m_file_sizes[s2[j]] = s2[j+1];
-  }
-}
-
-void data_store_image::write_datastore_indices() {
-  std::string local_dir = m_reader->get_local_file_dir();
-  std::stringstream s;
-  s << local_dir << "/datastore_indices.txt";
-  std::ofstream out(s.str().c_str());
-  if (! out.good()) {
-    std::stringstream err;
-    err << __FILE__ << " " << __LINE__ << " :: "
-        << "failed to open " << s.str() << " for reading";
-    throw lbann_exception(err.str());
-  }
-  for (auto t: m_my_datastore_indices) {
-    out << t << "\n";
-  }
-}
-
-void data_store_image::read_datastore_indices() {
+void data_store_image::read_shard_index() {
+  //note: only processors that staged a shard own files; this is the
+  //      case where we're running with more processors than were used
+  //      to create the shards
   m_my_datastore_indices.clear();
-  if (m_comm->get_rank_in_node() == 0) {
-    std::stringstream s;
-    s << m_reader->get_local_file_dir() << "/datastore_indices.txt";
-    std::ifstream in(s.str().c_str());
-
-    //note: datastore_indices.txt may not exist on all processors;
-    //      this is the case where we're using tarballed data, and
-    //      running with more processors than were used to create
-    //      the tarball
-    if (in.good()) {
-      int idx;
-      while (in >> idx) {
-        m_my_datastore_indices.insert(idx);
-      }
-      in.close();
+  std::vector<int> global_indices;
+  std::vector<int> num_bytes;
+  if (m_shard != nullptr) {
+    global_indices = m_shard->get_indices();
+    for (auto index : global_indices) {
+      num_bytes.push_back(m_shard->get_size(index));
+      m_my_datastore_indices.insert(index / m_num_img_srcs);
     }
   }
+  exchange_file_sizes(global_indices, num_bytes);
 }
 
-void data_store_image::stage_tarball() {
+void data_store_image::stage_shard() {
   if (m_reader->get_role() == "validate") {
     return;
   }
@@ -866,15 +949,6 @@ void data_store_image::stage_tarball() {
     throw lbann_exception(err.str());
   }
 
-/*
-  for (int j=0; j<m_np; j++) {
-    m_comm->global_barrier();
-    if (m_rank == j) {
-      std::cerr << "rank: " << m_rank << " rank in node: " << m_comm->get_rank_in_node() << " procs_per_node: " << procs_per_node << "
-    }
-  }
-*/
-
   options *opts = options::get();
   if (!opts->has_int("num_tarballs")) {
     err << __FILE__ << " " << __LINE__ << " :: "
@@ -882,39 +956,24 @@ void data_store_image::stage_tarball() {
     throw lbann_exception(err.str());
   }
   int num_tarballs = opts->get_int("num_tarballs");
+  if (m_master) std::cerr << "num shards: " << num_tarballs << "\n";
+
+  std::string local_dir = m_reader->get_local_file_dir();
+  create_dirs(local_dir);
 
   int fake_rank = m_rank / procs_per_node;
   if (m_comm->get_rank_in_node() == 0 && fake_rank < num_tarballs) {
-    std::string raw_name = options::get()->get_string("use_tarball");
-    std::pair<std::string, std::string> names = get_pathname_and_prefix(raw_name);
-
-  if (m_master) std::cerr << "num tarballs: " << num_tarballs << "\n";
-    std::stringstream tarball_filename(names.first);
-    tarball_filename << names.first << "_" << m_reader->get_role()
-              << "_rank=" << fake_rank << "_np=" << num_tarballs << ".tar";
-
-    //This is somewhat fragile. For now I assume the local_dir is
-    //of the form: /l/ssd/train
-    std::string local_dir = m_reader->get_local_file_dir();
-    size_t j = local_dir.rfind('/', local_dir.size()-2);
-    std::string ssd = local_dir.substr(0, j);
-
-    std::stringstream s;
-    s << "cp -f " << names.second << "/" << tarball_filename.str() << " " << ssd;
-    if (m_master)  std::cerr << "\nabout to execute: " << s.str()<< "\n";
-    run_cmd(s.str());
-
-    s.clear();
-    s.str("");
-    s << "cd " << ssd << "; tar xf " << tarball_filename.str();
-    if (m_master)  std::cerr << "\nabout to execute: " << s.str()<< "\n";
-    run_cmd(s.str());
-
-    s.clear();
-    s.str("");
-    s << "mv " << ssd  << "/" << local_dir << " " << ssd;
-    if (m_master)  std::cerr << "\nabout to execute: " << s.str()<< "\n";
-    run_cmd(s.str());
+    std::string remote = get_shard_filename(opts->get_string("use_tarball"),
+                                            fake_rank, num_tarballs);
+    std::string local = local_dir + '/' + remote.substr(remote.rfind('/') + 1);
+    if (m_master) std::cerr << "\ncopying shard: " << remote << " to " << local << "\n";
+    copy_file(remote, local);
+
+    m_shard = std::make_shared<data_shard>(local);
+    if (opts->has_bool("verify_shards") && opts->get_bool("verify_shards")) {
+      if (m_master) std::cerr << "verifying shard: " << local << "\n";
+      m_shard->verify();
+    }
   }
   m_comm->global_barrier();
 }
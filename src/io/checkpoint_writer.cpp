@@ -0,0 +1,222 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lbann/io/checkpoint_writer.hpp"
+#include "lbann/io/file_io.hpp"
+#include "lbann/utils/exception.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace lbann {
+
+namespace {
+
+/** Largest request passed to a single write call. */
+constexpr size_t max_write_size = size_t(1) << 30;
+
+/** Write a buffer to a new file.
+ *  Returns an empty string on success and an error message
+ *  otherwise.
+ */
+std::string write_file(const std::string& filename,
+                       const char *buf,
+                       size_t size) {
+  int fd = openwrite(filename.c_str());
+  if (fd < 0) {
+    return "failed to open file (" + filename + ")";
+  }
+  size_t offset = 0;
+  while (offset < size) {
+    const size_t count = std::min(size - offset, max_write_size);
+    ssize_t rc = write(fd, buf + offset, count);
+    if (rc < 0 && errno == EINTR) { continue; }
+    if (rc <= 0) {
+      std::string err = ("failed to write file (" + filename + "): "
+                         + std::strerror(errno));
+      closewrite(fd, filename.c_str());
+      return err;
+    }
+    offset += rc;
+  }
+  if (closewrite(fd, filename.c_str()) != 0) {
+    return "failed to close file (" + filename + ")";
+  }
+  return std::string();
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////
+// Staging area
+////////////////////////////////////////////////////////////
+
+int checkpoint_writer::stage::add_file(const std::string& filename) {
+  if (m_num_files == m_files.size()) {
+    m_files.emplace_back();
+  }
+  auto& f = m_files[m_num_files];
+  f.m_filename = filename;
+  f.m_data.clear();
+  return m_num_files++;
+}
+
+void checkpoint_writer::stage::append(int file, const void *buf, size_t size) {
+  if (file < 0 || file >= (int) m_num_files) {
+    std::stringstream err;
+    err << "invalid staged file index (" << file << ")";
+    LBANN_ERROR(err.str());
+  }
+  auto& data = m_files[file].m_data;
+  const auto *bytes = static_cast<const char*>(buf);
+  data.insert(data.end(), bytes, bytes + size);
+}
+
+void checkpoint_writer::stage::add_completion_file(const std::string& filename,
+                                                   const std::string& contents) {
+  m_completion_files.emplace_back(filename, contents);
+}
+
+size_t checkpoint_writer::stage::get_size() const {
+  size_t size = 0;
+  for (size_t i = 0; i < m_num_files; ++i) {
+    size += m_files[i].m_data.size();
+  }
+  return size;
+}
+
+void checkpoint_writer::stage::clear() {
+  for (size_t i = 0; i < m_num_files; ++i) {
+    m_files[i].m_data.clear();
+  }
+  m_num_files = 0;
+  m_completion_files.clear();
+}
+
+////////////////////////////////////////////////////////////
+// Checkpoint writer
+////////////////////////////////////////////////////////////
+
+checkpoint_writer::checkpoint_writer(int num_stages)
+  : m_num_writing(0), m_stop(false) {
+  for (int i = 0; i < std::max(num_stages, 1); ++i) {
+    m_stages.emplace_back(new stage());
+    m_free_stages.push_back(m_stages.back().get());
+  }
+  m_thread = std::thread(&checkpoint_writer::drain_loop, this);
+}
+
+checkpoint_writer::~checkpoint_writer() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_submitted.notify_all();
+  m_thread.join();
+  if (!m_error.empty()) {
+    std::cerr << "error while writing checkpoint: " << m_error << std::endl;
+  }
+}
+
+checkpoint_writer::stage& checkpoint_writer::acquire() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_written.wait(lock, [this] {
+    return !m_free_stages.empty() || !m_error.empty();
+  });
+  check_error_locked();
+  auto* s = m_free_stages.front();
+  m_free_stages.pop_front();
+  s->clear();
+  return *s;
+}
+
+void checkpoint_writer::submit(stage& s) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending_stages.push_back(&s);
+  }
+  m_submitted.notify_one();
+}
+
+void checkpoint_writer::wait() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_written.wait(lock, [this] {
+    return m_pending_stages.empty() && m_num_writing == 0;
+  });
+  check_error_locked();
+}
+
+void checkpoint_writer::drain_loop() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_submitted.wait(lock, [this] {
+      return m_stop || !m_pending_stages.empty();
+    });
+    // Finish writing pending checkpoints before exiting
+    if (m_pending_stages.empty()) { return; }
+    auto* s = m_pending_stages.front();
+    m_pending_stages.pop_front();
+    m_num_writing++;
+    lock.unlock();
+    const auto err = write_stage(*s);
+    lock.lock();
+    if (!err.empty() && m_error.empty()) { m_error = err; }
+    m_num_writing--;
+    m_free_stages.push_back(s);
+    m_written.notify_all();
+  }
+}
+
+std::string checkpoint_writer::write_stage(const stage& s) {
+  for (size_t i = 0; i < s.m_num_files; ++i) {
+    const auto& f = s.m_files[i];
+    const auto err = write_file(f.m_filename, f.m_data.data(), f.m_data.size());
+    if (!err.empty()) { return err; }
+  }
+  // Completion files are only written once the checkpoint is
+  // complete on disk
+  for (const auto& f : s.m_completion_files) {
+    const auto err = write_file(f.first, f.second.data(), f.second.size());
+    if (!err.empty()) { return err; }
+  }
+  return std::string();
+}
+
+void checkpoint_writer::check_error_locked() {
+  if (!m_error.empty()) {
+    const auto err = m_error;
+    m_error.clear();
+    LBANN_ERROR("failed to write checkpoint: " + err);
+  }
+}
+
+} // namespace lbann
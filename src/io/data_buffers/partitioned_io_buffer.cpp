@@ -49,10 +49,9 @@ lbann::partitioned_io_buffer& lbann::partitioned_io_buffer::operator=(const lban
   return *this;
 }
 
-void lbann::partitioned_io_buffer::fp_setup_data(El::Int cur_mini_batch_size, int idx) {
-  for (auto& buf : m_data_buffers) {
-    buf.second->m_input_buffers[idx]->Resize(buf.second->m_input_buffers[idx]->Height(), cur_mini_batch_size);
-  }
+void lbann::partitioned_io_buffer::fp_setup_data(El::Int cur_mini_batch_size, int idx, execution_mode mode) {
+  data_buffer *buf = get_data_buffer(mode);
+  buf->m_input_buffers[idx]->Resize(buf->m_input_buffers[idx]->Height(), cur_mini_batch_size);
 }
 
 void lbann::partitioned_io_buffer::setup_data(El::Int num_neurons, El::Int num_targets, El::Int max_mini_batch_size) {
@@ -88,9 +87,9 @@ int lbann::partitioned_io_buffer::fetch_to_local_matrix(generic_data_reader *dat
   data_buffer *buf = get_data_buffer(mode);
   buf->m_num_samples_fetched = 0;
   if (m_comm->get_rank_in_model() < num_parallel_readers && (buf->m_input_buffers[0]->Height() != 0 && buf->m_input_buffers[0]->Width() != 0)) {
-    for(auto& m : buf->m_input_buffers) {
-      El::Zeros_seq(*m, m->Height(), m->Width());
-    }
+    /// The data reader clears the local matrices before it fills
+    /// them (see generic_data_reader::zero_fill_mini_batch), so they
+    /// are not zeroed here.
 
     /// Each data reader needs to either have independent / split
     /// data, or take an offset / stride
@@ -158,6 +157,11 @@ int lbann::partitioned_io_buffer::num_samples_ready(execution_mode mode) {
   return buf->m_num_samples_fetched;
 }
 
+void lbann::partitioned_io_buffer::discard_samples(execution_mode mode) {
+  data_buffer *buf = get_data_buffer(mode);
+  buf->m_num_samples_fetched = 0;
+}
+
 void lbann::partitioned_io_buffer::set_data_fetch_future(std::future<void> future, execution_mode mode) {
   data_buffer *buf = get_data_buffer(mode);
   buf->m_data_fetch_future = std::move(future);
@@ -30,6 +30,7 @@
 #include <cerrno>
 #include <cstring>
 #include <cstdio>
+#include <memory>
 
 #include "lbann/utils/exception.hpp"
 #include "lbann/io/file_io.hpp"
@@ -38,6 +39,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 #include "El.hpp"
@@ -48,7 +50,8 @@
  * using a file-per-process
  ****************************************************/
 
-/* TODO: user buffered I/O for more efficient writes */
+/* Asynchronous checkpoints (see persist::set_async) stage these
+ * writes in memory and aggregate them into one write per file. */
 
 /** Stores meta data needed to reconstruct matrix in memory after reading
  *  it back from a file */
@@ -61,30 +64,52 @@ struct layer_header {
   uint64_t ldim;       /**< specifies padding of first dimension in local storage */
 };
 
+/** Aggregated matrices (see persist::set_aggregate) are appended to
+ *  a single container file. Each record has the same layout as a
+ *  per-matrix file, i.e. a layer_header followed by the local data.
+ *  The records are followed by an index, where each entry is
+ *    uint64_t      length of matrix file name
+ *    char[]        matrix file name (e.g. "model_<name>")
+ *    uint64_t      offset of record in container file
+ *    layer_header  matrix dimensions
+ *  and the file ends with a container_footer. */
+struct container_footer {
+  uint64_t magic;       /**< identifies container files */
+  uint64_t index_offset;/**< offset of index in container file */
+  uint64_t num_entries; /**< number of matrices in container file */
+};
+static const uint64_t container_magic = 0x4c42414e4e435446ULL; // "LBANNCTF"
+static const char container_name[] = "rank_matrices";
+
+/** Append a value to a serialized buffer */
+template <typename T>
+static void serialize(std::vector<char>& buf, const T& val) {
+  const auto *bytes = reinterpret_cast<const char*>(&val);
+  buf.insert(buf.end(), bytes, bytes + sizeof(T));
+}
+
 /** \brief Given an open file descriptor, file name, and a matrix, write the matrix
  *         to the file descriptor, return the number of bytes written */
 
 bool lbann::persist::write_rank_distmat(persist_type type, const char *name, const AbsDistMat& M) {
   // TODO: store in network order
-  std::string filename = m_checkpoint_dir;
+  std::string key;
   if (type == persist_type::train) {
-    filename += std::string("/train_") + name;
+    key = std::string("train_") + name;
   } else if (type == persist_type::model) {
-    filename += std::string("/model_") + name;
+    key = std::string("model_") + name;
   } else {
     std::stringstream err;
     err << "invalid persist_type (" << static_cast<int>(type) << ")";
     LBANN_ERROR(err.str());
   }
+  std::string filename = std::string(m_checkpoint_dir) + "/" + key;
   // skip all of this if matrix is not held on rank
   const El::Int localHeight = M.LocalHeight();
   const El::Int localWidth = M.LocalWidth();
   // If this is the case we will try to grab the matrix from model rank 0 on reload
   if(localHeight * localWidth == 0) { return true; }
 
-
-  int fd = lbann::openwrite(filename.c_str());
-
   // build our header
   struct layer_header header;
   header.rank        = (uint64_t) M.Grid().Rank();
@@ -94,39 +119,54 @@ bool lbann::persist::write_rank_distmat(persist_type type, const char *name, con
   header.localheight = (uint64_t) M.LocalHeight();
   header.ldim        = (uint64_t) M.LDim();
 
-  // write the header to the file
-  ssize_t write_rc = write(fd, &header, sizeof(header));
-  if (write_rc != sizeof(header)) {
-    // error!
+  // Choose destination: the container file, a staged file for
+  // asynchronous checkpoints, or a new file
+  const bool aggregated = (m_container_fd >= 0 || m_container_file >= 0);
+  int fd = -1;
+  int staged_file = -1;
+  if (aggregated) {
+    fd = m_container_fd;
+    staged_file = m_container_file;
+    serialize(m_container_index, (uint64_t) key.size());
+    m_container_index.insert(m_container_index.end(), key.begin(), key.end());
+    serialize(m_container_index, m_container_size);
+    serialize(m_container_index, header);
+    m_container_num_entries++;
+  } else if (m_stage != nullptr) {
+    staged_file = m_stage->add_file(filename);
+  } else {
+    fd = lbann::openwrite(filename.c_str());
+    if (fd < 0) {
+      LBANN_ERROR("failed to open file (" + filename + ")");
+    }
   }
-  m_bytes += write_rc;
+  const uint64_t bytes_start = m_bytes;
+
+  // write the header to the file
+  write_data(fd, staged_file, filename.c_str(), &header, sizeof(header));
 
   // now write the data for our part of the distributed matrix
   const El::Int lDim = M.LDim();
   if(localHeight == lDim) {
     // the local dimension in memory matches the local height,
     // so we can write our data in a single shot
-    auto *buf = (void *) M.LockedBuffer();
     El::Int bufsize = localHeight * localWidth * sizeof(DataType);
-    write_rc = write(fd, buf, bufsize);
-    if (write_rc != bufsize) {
-      // error!
-    }
-    m_bytes += write_rc;
+    write_data(fd, staged_file, filename.c_str(), M.LockedBuffer(), bufsize);
   } else {
     // TODO: if this padding is small, may not be a big deal to write it out anyway
     // we've got some padding along the first dimension
     // while storing the matrix in memory, avoid writing the padding
     for(El::Int j = 0; j < localWidth; ++j) {
-      auto *buf = (void *) M.LockedBuffer(0, j);
       El::Int bufsize = localHeight * sizeof(DataType);
-      write_rc = write(fd, buf, bufsize);
-      if (write_rc != bufsize) {
-        // error!
-      }
-      m_bytes += write_rc;
+      write_data(fd, staged_file, filename.c_str(), M.LockedBuffer(0, j), bufsize);
     }
   }
+
+  if (aggregated) {
+    m_container_size += m_bytes - bytes_start;
+  } else if (fd >= 0) {
+    lbann::closewrite(fd, filename.c_str());
+  }
   return true;
 }
 
@@ -136,98 +176,217 @@ bool lbann::persist::read_rank_distmat(persist_type type, const char *name, AbsD
   std::stringstream err;
 
   // read in the header
-  std::string filename = m_checkpoint_dir;
+  std::string key;
   if (type == persist_type::train) {
-    filename += std::string("/train_") + name;
+    key = std::string("train_") + name;
   } else if (type == persist_type::model) {
-    filename += std::string("/model_") + name;
+    key = std::string("model_") + name;
   } else {
     err << "invalid persist_type (" << static_cast<int>(type) << ")";
     LBANN_ERROR(err.str());
   }
-  int fd = openread(filename.c_str());
-  // file does not exist. we will try to grab matrix from rank 0
-   if( fd == -1 ) {return false;}
+  std::string filename = std::string(m_checkpoint_dir) + "/" + key;
+
+  // Find matrix record in the mapped container file or map the
+  // matrix's own file. Data is copied straight from the page cache
+  // into the local matrix, without intermediate read buffers.
+  const char *record = nullptr;
+  size_t record_size = 0;
+  std::shared_ptr<const char> map;
+  const auto entry = m_container_offsets.find(key);
+  if (entry != m_container_offsets.end()) {
+    filename = m_container_filename;
+    record = m_container_map + entry->second;
+    record_size = m_container_data_size - entry->second;
+  } else {
+    int fd = openread(filename.c_str());
+    // file does not exist. we will try to grab matrix from rank 0
+    if( fd == -1 ) {return false;}
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+      closeread(fd, filename.c_str());
+      err << "failed to read layer header from file " << filename;
+      LBANN_ERROR(err.str());
+    }
+    const size_t map_size = file_stat.st_size;
+    void *addr = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    closeread(fd, filename.c_str());
+    if (addr == MAP_FAILED) {
+      err << "failed to map file " << filename << " "
+          << "(" << strerror(errno) << ")";
+      LBANN_ERROR(err.str());
+    }
+    madvise(addr, map_size, MADV_SEQUENTIAL);
+    // Unmap on every exit path, including the errors below
+    map = std::shared_ptr<const char>(
+      static_cast<const char*>(addr),
+      [map_size](const char *p) { munmap(const_cast<char*>(p), map_size); });
+    record = map.get();
+    record_size = map_size;
+  }
 
   struct layer_header header;
-  ssize_t read_rc = read(fd, &header, sizeof(header));
-  if (read_rc != sizeof(header)) {
+  if (record_size < sizeof(header)) {
     err << "failed to read layer header from file "
         << "(attempted to read " << sizeof(header) << " bytes "
         << "from " << filename << ", "
-        << "but got " << read_rc << " bytes)";
+        << "but got " << record_size << " bytes)";
     LBANN_ERROR(err.str());
   }
-  m_bytes += read_rc;
+  memcpy(&header, record, sizeof(header));
+  m_bytes += sizeof(header);
 
   // resize our global matrix
   El::Int height = header.height;
   El::Int width  = header.width;
   M.Resize(height, width);
-  // TODO: check that header values match up
   const El::Int localheight = header.localheight;
   const El::Int localwidth = header.localwidth;
-  if(M.ColStride() == 1 && M.RowStride() == 1) {
-    if(M.Height() == M.LDim()) {
-      auto *buf = (void *) M.Buffer();
-      El::Int bufsize = localheight * localwidth * sizeof(DataType);
-      read_rc = read(fd, buf, bufsize);
-      if (read_rc != bufsize) {
-        err << "failed to read layer data from file "
-            << "(attempted to read " << bufsize << " bytes "
-            << "from " << filename << ", "
-            << "but got " << read_rc << " bytes)";
-        LBANN_ERROR(err.str());
-      }
-      m_bytes += read_rc;
-    } else {
-      for(El::Int j = 0; j <  localwidth; ++j) {
-        auto *buf = (void *) M.Buffer(0, j);
-        El::Int bufsize = localheight * sizeof(DataType);
-        read_rc = read(fd, buf, bufsize);
-        if (read_rc != bufsize) {
-          err << "failed to read layer data from file "
-              << "(attempted to read " << bufsize << " bytes "
-              << "from " << filename << ", "
-              << "but got " << read_rc << " bytes)";
-          LBANN_ERROR(err.str());
-        }
-        m_bytes += read_rc;
-      }
-    }
+  if (M.LocalHeight() != localheight || M.LocalWidth() != localwidth) {
+    err << "local matrix in file " << filename << " "
+        << "is " << localheight << " x " << localwidth << ", "
+        << "but expected " << M.LocalHeight() << " x " << M.LocalWidth();
+    LBANN_ERROR(err.str());
+  }
+  const size_t bufsize = localheight * localwidth * sizeof(DataType);
+  if (record_size - sizeof(header) < bufsize) {
+    err << "failed to read layer data from file "
+        << "(attempted to read " << bufsize << " bytes "
+        << "from " << filename << ", "
+        << "but got " << record_size - sizeof(header) << " bytes)";
+    LBANN_ERROR(err.str());
+  }
+
+  // copy data into our part of the distributed matrix
+  const char *data = record + sizeof(header);
+  if(localheight == M.LDim()) {
+    memcpy(M.Buffer(), data, bufsize);
   } else {
-    const El::Int lDim = M.LDim();
-    if(localheight == lDim) {
-      auto *buf = (void *) M.Buffer();
-      El::Int bufsize = localheight * localwidth * sizeof(DataType);
-      read_rc = read(fd, buf, bufsize);
-      if (read_rc != bufsize) {
-        err << "failed to read layer data from file "
-            << "(attempted to read " << bufsize << " bytes "
-            << "from " << filename << ", "
-            << "but got " << read_rc << " bytes)";
-        LBANN_ERROR(err.str());
-      }
-      m_bytes += read_rc;
-    } else {
-      for(El::Int jLoc = 0; jLoc < localwidth; ++jLoc) {
-        auto *buf = (void *) M.Buffer(0, jLoc);
-        El::Int bufsize = localheight * sizeof(DataType);
-        read_rc = read(fd, buf, bufsize);
-        if (read_rc != bufsize) {
-          err << "failed to read layer data from file "
-              << "(attempted to read " << bufsize << " bytes "
-              << "from " << filename << ", "
-              << "but got " << read_rc << " bytes)";
-          LBANN_ERROR(err.str());
-        }
-        m_bytes += read_rc;
-      }
+    const size_t colsize = localheight * sizeof(DataType);
+    for(El::Int j = 0; j < localwidth; ++j) {
+      memcpy(M.Buffer(0, j), data + j * colsize, colsize);
     }
   }
+  m_bytes += bufsize;
+
   return true;
 }
 
+void lbann::persist::write_data(int fd, int staged_file, const char *name,
+                                const void *buf, size_t size) {
+  if (staged_file >= 0) {
+    m_stage->append(staged_file, buf, size);
+  } else {
+    ssize_t rc = write(fd, buf, size);
+    if (rc != (ssize_t) size) {
+      LBANN_ERROR(std::string{} + "failed to write file (" + name + ")");
+    }
+  }
+  m_bytes += size;
+}
+
+void lbann::persist::close_container_checkpoint() {
+  if (m_container_fd < 0 && m_container_file < 0) { return; }
+
+  // Append index and footer to container file
+  container_footer footer;
+  footer.magic = container_magic;
+  footer.index_offset = m_container_size;
+  footer.num_entries = m_container_num_entries;
+  serialize(m_container_index, footer);
+  write_data(m_container_fd, m_container_file, m_container_filename,
+             m_container_index.data(), m_container_index.size());
+
+  if (m_container_fd >= 0) {
+    lbann::closewrite(m_container_fd, m_container_filename);
+  }
+  m_container_fd = -1;
+  m_container_file = -1;
+  m_container_size = 0;
+  m_container_index.clear();
+  m_container_num_entries = 0;
+}
+
+void lbann::persist::open_container_restart() {
+  close_container_restart();
+  sprintf(m_container_filename, "%s/%s", m_checkpoint_dir, container_name);
+  if (!lbann::exists(m_container_filename)) { return; }
+  int fd = lbann::openread(m_container_filename);
+  if (fd < 0) {
+    LBANN_ERROR(std::string{}
+                + "failed to read file (" + m_container_filename + ")");
+  }
+
+  // Map container file and ask the kernel to start reading it
+  std::stringstream err;
+  struct stat file_stat;
+  container_footer footer;
+  if (fstat(fd, &file_stat) != 0
+      || file_stat.st_size < (off_t) sizeof(footer)) {
+    closeread(fd, m_container_filename);
+    err << "invalid checkpoint container file (" << m_container_filename << ")";
+    LBANN_ERROR(err.str());
+  }
+  m_container_map_size = file_stat.st_size;
+  void *map = mmap(nullptr, m_container_map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  closeread(fd, m_container_filename);
+  if (map == MAP_FAILED) {
+    err << "failed to map file " << m_container_filename << " "
+        << "(" << strerror(errno) << ")";
+    LBANN_ERROR(err.str());
+  }
+  madvise(map, m_container_map_size, MADV_WILLNEED);
+  m_container_map = static_cast<const char*>(map);
+
+  // Read footer and index
+  const size_t footer_offset = m_container_map_size - sizeof(footer);
+  memcpy(&footer, m_container_map + footer_offset, sizeof(footer));
+  if (footer.magic != container_magic
+      || footer.index_offset > footer_offset) {
+    close_container_restart();
+    err << "invalid checkpoint container file (" << m_container_filename << ")";
+    LBANN_ERROR(err.str());
+  }
+  m_container_data_size = footer.index_offset;
+  const char *index = m_container_map + footer.index_offset;
+  const size_t index_size = footer_offset - footer.index_offset;
+  m_bytes += sizeof(footer) + index_size;
+
+  // Parse index
+  size_t pos = 0;
+  for (uint64_t i = 0; i < footer.num_entries; ++i) {
+    uint64_t name_length, offset;
+    if (pos + sizeof(name_length) > index_size) { break; }
+    memcpy(&name_length, &index[pos], sizeof(name_length));
+    pos += sizeof(name_length);
+    if (pos + name_length + sizeof(offset) + sizeof(layer_header) > index_size) {
+      break;
+    }
+    std::string key(&index[pos], name_length);
+    pos += name_length;
+    memcpy(&offset, &index[pos], sizeof(offset));
+    pos += sizeof(offset) + sizeof(layer_header);
+    if (offset >= footer.index_offset) { break; }
+    m_container_offsets[key] = offset;
+  }
+  if (m_container_offsets.size() != footer.num_entries) {
+    close_container_restart();
+    err << "corrupt index in checkpoint container file "
+        << "(" << m_container_filename << ")";
+    LBANN_ERROR(err.str());
+  }
+}
+
+void lbann::persist::close_container_restart() {
+  if (m_container_map != nullptr) {
+    munmap(const_cast<char*>(m_container_map), m_container_map_size);
+    m_container_map = nullptr;
+    m_container_map_size = 0;
+  }
+  m_container_data_size = 0;
+  m_container_offsets.clear();
+}
+
 /****************************************************
  * Functions to read/write values to files
  ****************************************************/
@@ -240,6 +399,38 @@ lbann::persist::persist() {
   m_model_fd = -1;
   m_train_fd = -1;
   m_validate_fd = -1;
+
+  // initialize asynchronous checkpoint state
+  m_async = false;
+  m_stage = nullptr;
+  m_model_file = -1;
+  m_train_file = -1;
+  m_validate_file = -1;
+
+  // initialize container file state
+  m_aggregate = false;
+  m_container_fd = -1;
+  m_container_file = -1;
+  m_container_size = 0;
+  m_container_num_entries = 0;
+  m_container_map = nullptr;
+  m_container_map_size = 0;
+  m_container_data_size = 0;
+}
+
+lbann::persist::persist(const persist& other)
+  : persist() {
+  *this = other;
+}
+
+lbann::persist& lbann::persist::operator=(const persist& other) {
+  // Open files and the background writer are not copied
+  m_bytes = other.m_bytes;
+  ckpt_type = other.ckpt_type;
+  m_async = other.m_async;
+  m_aggregate = other.m_aggregate;
+  memcpy(m_checkpoint_dir, other.m_checkpoint_dir, sizeof(m_checkpoint_dir));
+  return *this;
 }
 
 void lbann::persist::open_checkpoint(const char *dir) {
@@ -255,7 +446,44 @@ void lbann::persist::open_checkpoint(const char *dir) {
   // define filename for train state
   sprintf(m_train_filename, "%s/train", dir);
 
+  // define filename for aggregated matrices
+  sprintf(m_container_filename, "%s/%s", dir, container_name);
+  m_container_size = 0;
+  m_container_index.clear();
+  m_container_num_entries = 0;
+
+  // In asynchronous mode, stage files in memory until the
+  // checkpoint is closed
+  if (m_async) {
+    if (m_writer == nullptr) {
+      m_writer.reset(new checkpoint_writer());
+    }
+    m_stage = &m_writer->acquire();
+    if(ckpt_type != callback_type::validation && ckpt_type != callback_type::inference){
+      if (m_aggregate) {
+        m_container_file = m_stage->add_file(m_container_filename);
+      }
+      m_model_file = m_stage->add_file(m_model_filename);
+      m_train_file = m_stage->add_file(m_train_filename);
+    }
+    if (ckpt_type == callback_type::validation || ckpt_type == callback_type::batch){
+      sprintf(m_validate_filename, "%s/validate", dir);
+      m_validate_file = m_stage->add_file(m_validate_filename);
+    }
+    return;
+  }
+
   if(ckpt_type != callback_type::validation && ckpt_type != callback_type::inference){
+    // Validation checkpoints share the epoch directory but write no
+    // matrices, so they must not truncate its container file
+    if (m_aggregate) {
+      m_container_fd = lbann::openwrite(m_container_filename);
+      if (m_container_fd < 0) {
+        LBANN_ERROR(std::string{}
+                    + "failed to open file (" + m_container_filename + ")");
+      }
+    }
+
     m_model_fd = lbann::openwrite(m_model_filename);
     if (m_model_fd < 0) {
       LBANN_ERROR(std::string{}
@@ -279,6 +507,9 @@ void lbann::persist::open_checkpoint(const char *dir) {
 }
 
 void lbann::persist::close_checkpoint() {
+  // finish container file
+  close_container_checkpoint();
+
   // close model file
   if (m_model_fd >= 0) {
     lbann::closewrite(m_model_fd, m_model_filename);
@@ -294,9 +525,46 @@ void lbann::persist::close_checkpoint() {
     lbann::closewrite(m_validate_fd, m_validate_filename);
     m_validate_fd = -1;
   }
+
+  // hand staged files to background writer
+  if (m_stage != nullptr) {
+    for (const auto& f : m_completion_files) {
+      m_stage->add_completion_file(f.first, f.second);
+    }
+    m_completion_files.clear();
+    m_writer->submit(*m_stage);
+    m_stage = nullptr;
+    m_model_file = -1;
+    m_train_file = -1;
+    m_validate_file = -1;
+  }
+
+  // write files that mark the checkpoint as complete
+  for (const auto& f : m_completion_files) {
+    int fd = lbann::openwrite(f.first.c_str());
+    if (fd >= 0) {
+      lbann::write_bytes(fd, f.first.c_str(), f.second.data(), f.second.size());
+      lbann::closewrite(fd, f.first.c_str());
+    }
+  }
+  m_completion_files.clear();
+}
+
+void lbann::persist::add_completion_file(const std::string& filename,
+                                         const std::string& contents) {
+  m_completion_files.emplace_back(filename, contents);
+}
+
+void lbann::persist::wait_for_checkpoints() {
+  if (m_writer != nullptr) {
+    m_writer->wait();
+  }
 }
 
 void lbann::persist::open_restart(const char *dir) {
+  // make sure asynchronous checkpoints are on disk
+  wait_for_checkpoints();
+
   // copy checkpoint directory
   strcpy(m_checkpoint_dir, dir);
   // open the file for writing
@@ -324,6 +592,9 @@ void lbann::persist::open_restart(const char *dir) {
                   + "failed to read file (" + m_validate_filename + "), "
                   + "which is not an error if validation percent = 0");
   }
+
+  // read index of aggregated matrices
+  open_container_restart();
 }
 
 void lbann::persist::close_restart() {
@@ -336,6 +607,8 @@ void lbann::persist::close_restart() {
   // close validate file
   lbann::closeread(m_validate_fd, m_validate_filename);
   m_validate_fd = -1;
+  // unmap container file
+  close_container_restart();
 
 }
 
@@ -390,6 +663,14 @@ bool lbann::persist::read_distmat(persist_type type, const char *name, AbsDistMa
 }
 
 bool lbann::persist::write_bytes(persist_type type, const char *name, const void *buf, size_t size) {
+  if (m_stage != nullptr) {
+    const int file = get_staged_file(type);
+    if (file >= 0) {
+      m_stage->append(file, buf, size);
+      m_bytes += size;
+    }
+    return true;
+  }
   int fd = get_fd(type);
   if (fd >= 0) {
     ssize_t rc = write(fd, buf, size);
@@ -488,6 +769,18 @@ int lbann::persist::get_fd(persist_type type) const {
   return fd;
 }
 
+int lbann::persist::get_staged_file(persist_type type) const {
+  int file = -1;
+  if (type == persist_type::train) {
+    file = m_train_file;
+  } else if (type == persist_type::model) {
+    file = m_model_file;
+  } else if (type == persist_type::validate) {
+    file = m_validate_file;
+  }
+  return file;
+}
+
 /****************************************************
  * Functions to read/write values to files
  ****************************************************/
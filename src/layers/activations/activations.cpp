@@ -25,6 +25,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "lbann/layers/activations/activations.hpp"
+#include "lbann/layers/math/fused_entrywise.hpp"
 #include "lbann/utils/entrywise_operator.hpp"
 
 namespace lbann {
@@ -166,4 +167,20 @@ struct softsign_op {
   INSTANTIATE(softplus_layer, softplus_op)
   INSTANTIATE(softsign_layer, softsign_op)
 
+// Stage lookup for fused entry-wise layers
+#define FUSE(layer, op)                                                 \
+  if (is_cpu_instance<layer>(l)) {                                      \
+    stage = make_unary_entrywise_stage<op>(l);                          \
+    return true;                                                        \
+  }
+bool get_activation_entrywise_stage(const Layer& l, entrywise_stage& stage) {
+  FUSE(log_sigmoid_layer, log_sigmoid_op)
+  FUSE(relu_layer, relu_op)
+  FUSE(selu_layer, selu_op)
+  FUSE(sigmoid_layer, sigmoid_op)
+  FUSE(softplus_layer, softplus_op)
+  FUSE(softsign_layer, softsign_op)
+  return false;
+}
+
 } // namespace lbann
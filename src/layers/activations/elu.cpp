@@ -25,6 +25,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "lbann/layers/activations/elu.hpp"
+#include "lbann/layers/math/fused_entrywise.hpp"
 
 namespace lbann {
 
@@ -67,6 +68,35 @@ void local_bp(DataType alpha,
   }
 }
 
+/** Forward prop kernel for fused entry-wise layers.
+ *  The parameter is the scale for the negative region.
+ */
+void fused_fp(const DataType* params,
+              const DataType* x,
+              const DataType*,
+              DataType* y,
+              El::Int size) {
+  const auto& alpha = params[0];
+  for (El::Int i = 0; i < size; ++i) {
+    const auto xi = x[i];
+    y[i] = (xi > zero) ? xi : alpha * std::expm1(xi);
+  }
+}
+
+/** Backprop kernel for fused entry-wise layers. */
+void fused_bp(const DataType* params,
+              const DataType* x,
+              const DataType*,
+              const DataType* dy,
+              DataType* dx,
+              DataType*,
+              El::Int size) {
+  const auto& alpha = params[0];
+  for (El::Int i = 0; i < size; ++i) {
+    dx[i] = (x[i] > zero) ? dy[i] : dy[i] * alpha * std::exp(x[i]);
+  }
+}
+
 } // namespace
 
 template <>
@@ -100,4 +130,21 @@ void elu_layer<data_layout::MODEL_PARALLEL, El::Device::CPU>
            get_local_error_signals());
 }
 
+bool get_elu_entrywise_stage(const Layer& l, entrywise_stage& stage) {
+  const auto* dp_layer
+    = dynamic_cast<const elu_layer<data_layout::DATA_PARALLEL, El::Device::CPU>*>(&l);
+  const auto* mp_layer
+    = dynamic_cast<const elu_layer<data_layout::MODEL_PARALLEL, El::Device::CPU>*>(&l);
+  if (dp_layer == nullptr && mp_layer == nullptr) { return false; }
+  stage.m_name = l.get_name();
+  stage.m_type = l.get_type();
+  stage.m_num_operands = 1;
+  stage.m_params[0] = (dp_layer != nullptr ?
+                       dp_layer->get_alpha() :
+                       mp_layer->get_alpha());
+  stage.m_fp = &fused_fp;
+  stage.m_bp = &fused_bp;
+  return true;
+}
+
 } // namespace lbann
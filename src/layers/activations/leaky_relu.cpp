@@ -25,6 +25,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "lbann/layers/activations/leaky_relu.hpp"
+#include "lbann/layers/math/fused_entrywise.hpp"
 
 namespace lbann {
 
@@ -67,6 +68,35 @@ void local_bp(DataType negative_slope,
   }
 }
 
+/** Forward prop kernel for fused entry-wise layers.
+ *  The parameter is the slope in the negative region.
+ */
+void fused_fp(const DataType* params,
+              const DataType* x,
+              const DataType*,
+              DataType* y,
+              El::Int size) {
+  const auto& negative_slope = params[0];
+  for (El::Int i = 0; i < size; ++i) {
+    const auto xi = x[i];
+    y[i] = (xi > zero) ? xi : negative_slope * xi;
+  }
+}
+
+/** Backprop kernel for fused entry-wise layers. */
+void fused_bp(const DataType* params,
+              const DataType* x,
+              const DataType*,
+              const DataType* dy,
+              DataType* dx,
+              DataType*,
+              El::Int size) {
+  const auto& negative_slope = params[0];
+  for (El::Int i = 0; i < size; ++i) {
+    dx[i] = (x[i] > zero) ? dy[i] : negative_slope * dy[i];
+  }
+}
+
 } // namespace
 
 template <>
@@ -100,4 +130,21 @@ void leaky_relu_layer<data_layout::MODEL_PARALLEL, El::Device::CPU>
            get_local_error_signals());
 }
 
+bool get_leaky_relu_entrywise_stage(const Layer& l, entrywise_stage& stage) {
+  const auto* dp_layer
+    = dynamic_cast<const leaky_relu_layer<data_layout::DATA_PARALLEL, El::Device::CPU>*>(&l);
+  const auto* mp_layer
+    = dynamic_cast<const leaky_relu_layer<data_layout::MODEL_PARALLEL, El::Device::CPU>*>(&l);
+  if (dp_layer == nullptr && mp_layer == nullptr) { return false; }
+  stage.m_name = l.get_name();
+  stage.m_type = l.get_type();
+  stage.m_num_operands = 1;
+  stage.m_params[0] = (dp_layer != nullptr ?
+                       dp_layer->get_negative_slope() :
+                       mp_layer->get_negative_slope());
+  stage.m_fp = &fused_fp;
+  stage.m_bp = &fused_bp;
+  return true;
+}
+
 } // namespace lbann
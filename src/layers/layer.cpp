@@ -115,10 +115,13 @@ Layer& Layer::operator=(const Layer& other) {
   m_hint_layer = other.m_hint_layer;
 
   // Deep matrix copies
+  // Note: Copies allocate their own memory, even if the other layer's
+  // tensors use memory assigned by a memory planner.
   m_inputs.clear();
   m_outputs.clear();
   m_gradient_wrt_outputs.clear();
   m_gradient_wrt_inputs.clear();
+  clear_tensor_buffers();
   m_inputs.reserve(other.m_inputs.size());
   m_outputs.reserve(other.m_outputs.size());
   m_gradient_wrt_outputs.reserve(other.m_gradient_wrt_outputs.size());
@@ -1013,7 +1016,7 @@ void Layer::fp_setup_outputs(El::Int mini_batch_size) {
     auto& output = get_activations(i);
     output.Empty(false);
     if (align_outputs) { output.AlignWith(alignment_dist); }
-    output.Resize(get_output_size(i), mini_batch_size);
+    allocate_activations(i, mini_batch_size);
   }
 
 }
@@ -1071,10 +1074,93 @@ void Layer::bp_setup_gradient_wrt_inputs(El::Int mini_batch_size) {
     auto& gradient_wrt_input = get_error_signals(i);
     gradient_wrt_input.Empty(false);
     gradient_wrt_input.AlignWith(get_prev_activations(i));
-    gradient_wrt_input.Resize(get_input_size(i), mini_batch_size);
+    allocate_error_signals(i, mini_batch_size);
   }
 }
 
+void Layer::allocate_activations(int child_index, El::Int mini_batch_size) {
+  auto& output = get_activations(child_index);
+  const auto& height = get_output_size(child_index);
+  if (has_activations_buffer(child_index)) {
+    const auto& buffer = m_activations_buffers[child_index];
+    auto& output_elmat = dynamic_cast<ElMat&>(output);
+    output_elmat.Attach(height, mini_batch_size,
+                        output_elmat.Grid(),
+                        output_elmat.ColAlign(),
+                        output_elmat.RowAlign(),
+                        buffer.m_data, buffer.m_ldim,
+                        output_elmat.Root());
+  } else {
+    output.Resize(height, mini_batch_size);
+  }
+}
+
+void Layer::allocate_error_signals(int parent_index, El::Int mini_batch_size) {
+  auto& gradient_wrt_input = get_error_signals(parent_index);
+  const auto& height = get_input_size(parent_index);
+  if (has_error_signals_buffer(parent_index)) {
+    const auto& buffer = m_error_signals_buffers[parent_index];
+    auto& gradient_wrt_input_elmat = dynamic_cast<ElMat&>(gradient_wrt_input);
+    gradient_wrt_input_elmat.Attach(height, mini_batch_size,
+                                    gradient_wrt_input_elmat.Grid(),
+                                    gradient_wrt_input_elmat.ColAlign(),
+                                    gradient_wrt_input_elmat.RowAlign(),
+                                    buffer.m_data, buffer.m_ldim,
+                                    gradient_wrt_input_elmat.Root());
+  } else {
+    gradient_wrt_input.Resize(height, mini_batch_size);
+  }
+}
+
+void Layer::set_activations_buffer(int child_index,
+                                   DataType* buffer,
+                                   El::Int ldim) {
+  if (child_index < 0 || child_index >= get_num_children()) {
+    std::stringstream err;
+    err << "attempted to assign memory to invalid activation matrix "
+        << "of layer \"" << get_name() << "\" "
+        << "(requested index " << child_index << ", but there are "
+        << get_num_children() << " activation matrices)";
+    LBANN_ERROR(err.str());
+  }
+  m_activations_buffers.resize(get_num_children());
+  m_activations_buffers[child_index].m_data = buffer;
+  m_activations_buffers[child_index].m_ldim = ldim;
+}
+
+void Layer::set_error_signals_buffer(int parent_index,
+                                     DataType* buffer,
+                                     El::Int ldim) {
+  if (parent_index < 0 || parent_index >= get_num_parents()) {
+    std::stringstream err;
+    err << "attempted to assign memory to invalid error signal matrix "
+        << "of layer \"" << get_name() << "\" "
+        << "(requested index " << parent_index << ", but there are "
+        << get_num_parents() << " error signal matrices)";
+    LBANN_ERROR(err.str());
+  }
+  m_error_signals_buffers.resize(get_num_parents());
+  m_error_signals_buffers[parent_index].m_data = buffer;
+  m_error_signals_buffers[parent_index].m_ldim = ldim;
+}
+
+bool Layer::has_activations_buffer(int child_index) const {
+  return (child_index >= 0
+          && child_index < (int) m_activations_buffers.size()
+          && m_activations_buffers[child_index].m_data != nullptr);
+}
+
+bool Layer::has_error_signals_buffer(int parent_index) const {
+  return (parent_index >= 0
+          && parent_index < (int) m_error_signals_buffers.size()
+          && m_error_signals_buffers[parent_index].m_data != nullptr);
+}
+
+void Layer::clear_tensor_buffers() {
+  m_activations_buffers.clear();
+  m_error_signals_buffers.clear();
+}
+
 std::string Layer::get_data_layout_string(data_layout d) const {
   switch(d) {
   case data_layout::DATA_PARALLEL:
@@ -25,6 +25,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "lbann/layers/math/binary.hpp"
+#include "lbann/layers/math/fused_entrywise.hpp"
 #include "lbann/utils/entrywise_operator.hpp"
 
 namespace lbann {
@@ -481,4 +482,33 @@ struct logical_xor_op {
   INSTANTIATE(logical_or_layer, logical_or_op)
   INSTANTIATE(logical_xor_layer, logical_xor_op)
 
+// Stage lookup for fused entry-wise layers
+#define FUSE(layer, op)                                                 \
+  if (is_cpu_instance<layer>(l)) {                                      \
+    stage = make_binary_entrywise_stage<op>(l);                         \
+    return true;                                                        \
+  }
+bool get_binary_entrywise_stage(const Layer& l, entrywise_stage& stage) {
+  FUSE(add_layer, add_op)
+  FUSE(subtract_layer, subtract_op)
+  FUSE(multiply_layer, multiply_op)
+  FUSE(divide_layer, divide_op)
+  FUSE(mod_layer, mod_op)
+  FUSE(pow_layer, pow_op)
+  FUSE(safe_divide_layer, safe_divide_op)
+  FUSE(squared_difference_layer, squared_difference_op)
+  FUSE(max_layer, max_op)
+  FUSE(min_layer, min_op)
+  FUSE(equal_layer, equal_op)
+  FUSE(not_equal_layer, not_equal_op)
+  FUSE(less_layer, less_op)
+  FUSE(less_equal_layer, less_equal_op)
+  FUSE(greater_layer, greater_op)
+  FUSE(greater_equal_layer, greater_equal_op)
+  FUSE(logical_and_layer, logical_and_op)
+  FUSE(logical_or_layer, logical_or_op)
+  FUSE(logical_xor_layer, logical_xor_op)
+  return false;
+}
+
 } // namespace lbann
@@ -25,6 +25,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "lbann/layers/math/clamp.hpp"
+#include "lbann/layers/math/fused_entrywise.hpp"
 
 namespace lbann {
 
@@ -68,6 +69,39 @@ void local_bp(DataType min,
   }
 }
 
+/** Forward prop kernel for fused entry-wise layers.
+ *  Parameters are the minimum and maximum outputs.
+ */
+void fused_fp(const DataType* params,
+              const DataType* x,
+              const DataType*,
+              DataType* y,
+              El::Int size) {
+  const auto& min = params[0];
+  const auto& max = params[1];
+  for (El::Int i = 0; i < size; ++i) {
+    const auto xi = x[i];
+    if (xi <= min)      { y[i] = min; }
+    else if (xi >= max) { y[i] = max; }
+    else               { y[i] = xi;  }
+  }
+}
+
+/** Backprop kernel for fused entry-wise layers. */
+void fused_bp(const DataType* params,
+              const DataType* x,
+              const DataType*,
+              const DataType* dy,
+              DataType* dx,
+              DataType*,
+              El::Int size) {
+  const auto& min = params[0];
+  const auto& max = params[1];
+  for (El::Int i = 0; i < size; ++i) {
+    dx[i] = (x[i] <= min || x[i] >= max) ? DataType(0) : dy[i];
+  }
+}
+
 } // namespace
 
 template <>
@@ -101,4 +135,23 @@ void clamp_layer<data_layout::MODEL_PARALLEL, El::Device::CPU>
            get_local_error_signals());
 }
 
+bool get_clamp_entrywise_stage(const Layer& l, entrywise_stage& stage) {
+  const auto* dp_layer
+    = dynamic_cast<const clamp_layer<data_layout::DATA_PARALLEL, El::Device::CPU>*>(&l);
+  const auto* mp_layer
+    = dynamic_cast<const clamp_layer<data_layout::MODEL_PARALLEL, El::Device::CPU>*>(&l);
+  if (dp_layer == nullptr && mp_layer == nullptr) { return false; }
+  stage.m_name = l.get_name();
+  stage.m_type = l.get_type();
+  stage.m_num_operands = 1;
+  if (dp_layer != nullptr) {
+    stage.m_params = {{dp_layer->get_min(), dp_layer->get_max()}};
+  } else {
+    stage.m_params = {{mp_layer->get_min(), mp_layer->get_max()}};
+  }
+  stage.m_fp = &fused_fp;
+  stage.m_bp = &fused_bp;
+  return true;
+}
+
 } // namespace lbann
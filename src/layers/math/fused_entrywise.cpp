@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lbann/layers/math/fused_entrywise.hpp"
+#include <algorithm>
+
+namespace lbann {
+
+namespace {
+
+/** Number of entries per tile.
+ *  The working set of a tile should stay in cache while all stages
+ *  are applied to it.
+ */
+constexpr El::Int tile_size = 512;
+
+/** Local forward prop computation.
+ *  Stages are applied in place to a tile of the output.
+ */
+void local_fp(const std::vector<entrywise_stage>& stages,
+              const std::vector<const AbsMat*>& inputs,
+              AbsMat& output) {
+  const El::Int height = output.Height();
+  const El::Int width = output.Width();
+  const El::Int num_tiles = (height + tile_size - 1) / tile_size;
+  LBANN_OMP_PARALLEL_FOR_COLLAPSE2
+  for (El::Int col = 0; col < width; ++col) {
+    for (El::Int tile = 0; tile < num_tiles; ++tile) {
+      const El::Int row = tile * tile_size;
+      const El::Int size = std::min(tile_size, height - row);
+      const DataType* x = inputs[0]->LockedBuffer(row, col);
+      auto* y = output.Buffer(row, col);
+      for (const auto& s : stages) {
+        const DataType* other = nullptr;
+        if (s.m_num_operands > 1) {
+          other = inputs[s.m_external_input]->LockedBuffer(row, col);
+        }
+        if (s.m_chain_operand == 0) {
+          s.m_fp(s.m_params.data(), x, other, y, size);
+        } else {
+          s.m_fp(s.m_params.data(), other, x, y, size);
+        }
+        x = y;
+      }
+    }
+  }
+}
+
+/** Local backprop computation.
+ *  The inputs to each stage are recomputed for a tile and the
+ *  gradient is then propagated back through the stages. The
+ *  workspace holds the recomputed values and two gradient tiles for
+ *  each thread.
+ */
+void local_bp(const std::vector<entrywise_stage>& stages,
+              const std::vector<const AbsMat*>& inputs,
+              const AbsMat& gradient_wrt_output,
+              const std::vector<AbsMat*>& gradient_wrt_inputs,
+              std::vector<DataType>& workspace) {
+  const El::Int num_stages = stages.size();
+  const El::Int height = gradient_wrt_output.Height();
+  const El::Int width = gradient_wrt_output.Width();
+  const El::Int num_tiles = (height + tile_size - 1) / tile_size;
+  const El::Int thread_workspace_size = (num_stages + 1) * tile_size;
+  workspace.resize(omp_get_max_threads() * thread_workspace_size);
+  LBANN_OMP_PARALLEL_FOR_COLLAPSE2
+  for (El::Int col = 0; col < width; ++col) {
+    for (El::Int tile = 0; tile < num_tiles; ++tile) {
+      const El::Int row = tile * tile_size;
+      const El::Int size = std::min(tile_size, height - row);
+      auto* thread_workspace = (workspace.data()
+                                + omp_get_thread_num() * thread_workspace_size);
+
+      // Recompute stage inputs
+      auto stage_input = [&](El::Int i) -> const DataType* {
+        return (i == 0 ?
+                inputs[0]->LockedBuffer(row, col) :
+                thread_workspace + (i-1) * tile_size);
+      };
+      for (El::Int i = 0; i < num_stages - 1; ++i) {
+        const auto& s = stages[i];
+        const DataType* other = nullptr;
+        if (s.m_num_operands > 1) {
+          other = inputs[s.m_external_input]->LockedBuffer(row, col);
+        }
+        auto* y = thread_workspace + i * tile_size;
+        if (s.m_chain_operand == 0) {
+          s.m_fp(s.m_params.data(), stage_input(i), other, y, size);
+        } else {
+          s.m_fp(s.m_params.data(), other, stage_input(i), y, size);
+        }
+      }
+
+      // Propagate gradient back through stages
+      auto* gradient_buffer_a = thread_workspace + (num_stages-1) * tile_size;
+      auto* gradient_buffer_b = gradient_buffer_a + tile_size;
+      const DataType* dy = gradient_wrt_output.LockedBuffer(row, col);
+      for (El::Int i = num_stages - 1; i >= 0; --i) {
+        const auto& s = stages[i];
+        const DataType* other = nullptr;
+        DataType* other_dx = nullptr;
+        if (s.m_num_operands > 1) {
+          other = inputs[s.m_external_input]->LockedBuffer(row, col);
+          other_dx = gradient_wrt_inputs[s.m_external_input]->Buffer(row, col);
+        }
+        auto* dx = (i == 0 ?
+                    gradient_wrt_inputs[0]->Buffer(row, col) :
+                    (dy == gradient_buffer_a ?
+                     gradient_buffer_b :
+                     gradient_buffer_a));
+        if (s.m_chain_operand == 0) {
+          s.m_bp(s.m_params.data(), stage_input(i), other,
+                 dy, dx, other_dx, size);
+        } else {
+          s.m_bp(s.m_params.data(), other, stage_input(i),
+                 dy, other_dx, dx, size);
+        }
+        dy = dx;
+      }
+
+    }
+  }
+}
+
+} // namespace
+
+bool get_entrywise_stage(const Layer& l, entrywise_stage& stage) {
+  return (get_unary_entrywise_stage(l, stage)
+          || get_activation_entrywise_stage(l, stage)
+          || get_binary_entrywise_stage(l, stage)
+          || get_clamp_entrywise_stage(l, stage)
+          || get_elu_entrywise_stage(l, stage)
+          || get_leaky_relu_entrywise_stage(l, stage));
+}
+
+#define INSTANTIATE(layout)                                             \
+  template <>                                                           \
+  void fused_entrywise_layer<layout, El::Device::CPU>::fp_compute() {   \
+    std::vector<const AbsMat*> inputs;                                  \
+    for (int i = 0; i < get_num_parents(); ++i) {                       \
+      inputs.push_back(&get_local_prev_activations(i));                 \
+    }                                                                   \
+    local_fp(m_stages, inputs, get_local_activations());                \
+  }                                                                     \
+  template <>                                                           \
+  void fused_entrywise_layer<layout, El::Device::CPU>::bp_compute() {   \
+    std::vector<const AbsMat*> inputs;                                  \
+    std::vector<AbsMat*> gradient_wrt_inputs;                           \
+    for (int i = 0; i < get_num_parents(); ++i) {                       \
+      inputs.push_back(&get_local_prev_activations(i));                 \
+      gradient_wrt_inputs.push_back(&get_local_error_signals(i));       \
+    }                                                                   \
+    local_bp(m_stages, inputs, get_local_prev_error_signals(),          \
+             gradient_wrt_inputs, m_workspace);                         \
+  }
+INSTANTIATE(data_layout::DATA_PARALLEL)
+INSTANTIATE(data_layout::MODEL_PARALLEL)
+
+} // namespace lbann
@@ -25,6 +25,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "lbann/layers/math/unary.hpp"
+#include "lbann/layers/math/fused_entrywise.hpp"
 #include "lbann/utils/entrywise_operator.hpp"
 
 namespace lbann {
@@ -399,4 +400,42 @@ struct atanh_op {
   INSTANTIATE(asinh_layer, asinh_op)
   INSTANTIATE(atanh_layer, atanh_op)
 
+// Stage lookup for fused entry-wise layers
+#define FUSE(layer, op)                                                 \
+  if (is_cpu_instance<layer>(l)) {                                      \
+    stage = make_unary_entrywise_stage<op>(l);                          \
+    return true;                                                        \
+  }
+bool get_unary_entrywise_stage(const Layer& l, entrywise_stage& stage) {
+  FUSE(logical_not_layer, logical_not_op)
+  FUSE(abs_layer, abs_op)
+  FUSE(negative_layer, negative_op)
+  FUSE(sign_layer, sign_op)
+  FUSE(round_layer, round_op)
+  FUSE(ceil_layer, ceil_op)
+  FUSE(floor_layer, floor_op)
+  FUSE(reciprocal_layer, reciprocal_op)
+  FUSE(square_layer, square_op)
+  FUSE(sqrt_layer, sqrt_op)
+  FUSE(rsqrt_layer, rsqrt_op)
+  FUSE(safe_reciprocal_layer, safe_reciprocal_op)
+  FUSE(exp_layer, exp_op)
+  FUSE(expm1_layer, expm1_op)
+  FUSE(log_layer, log_op)
+  FUSE(log1p_layer, log1p_op)
+  FUSE(cos_layer, cos_op)
+  FUSE(sin_layer, sin_op)
+  FUSE(tan_layer, tan_op)
+  FUSE(acos_layer, acos_op)
+  FUSE(asin_layer, asin_op)
+  FUSE(atan_layer, atan_op)
+  FUSE(cosh_layer, cosh_op)
+  FUSE(sinh_layer, sinh_op)
+  FUSE(tanh_layer, tanh_op)
+  FUSE(acosh_layer, acosh_op)
+  FUSE(asinh_layer, asinh_op)
+  FUSE(atanh_layer, atanh_op)
+  return false;
+}
+
 } // namespace lbann
@@ -25,12 +25,74 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "lbann/layers/regularizers/batch_normalization.hpp"
+#include <algorithm>
+#include <vector>
 
 namespace lbann {
 
+namespace {
+
+/** Maximum number of entries summed directly by compute_moments.
+ *  Longer arrays are split into blocks whose moments are merged.
+ */
+constexpr El::Int moments_block_size = 1024;
+
+/** Merge moments of two sets of values.
+ *  Uses the parallel update formula from Chan, Golub, and LeVeque,
+ *  "Updating formulae and a pairwise algorithm for computing sample
+ *  variances" (1979).
+ *  @param count   Number of values in first set (in/out).
+ *  @param mean    Mean of first set (in/out).
+ *  @param m2      Sum of squared deviations from mean of first set
+ *                 (in/out).
+ */
+inline void merge_moments(El::Int& count, DataType& mean, DataType& m2,
+                          El::Int other_count,
+                          DataType other_mean,
+                          DataType other_m2) {
+  const El::Int total_count = count + other_count;
+  if (total_count == 0) { return; }
+  const DataType delta = other_mean - mean;
+  const DataType other_frac = DataType(other_count) / total_count;
+  mean += delta * other_frac;
+  m2 += other_m2 + delta * delta * count * other_frac;
+  count = total_count;
+}
+
+/** Mean and sum of squared deviations of a contiguous array.
+ *  Each block is summed about its first entry and blocks are merged
+ *  with merge_moments, so the result does not suffer from the
+ *  cancellation in E[x^2] - E[x]^2 when the mean is large compared
+ *  to the standard deviation.
+ */
+inline void compute_moments(const DataType* __restrict__ x,
+                            El::Int size,
+                            DataType& mean,
+                            DataType& m2) {
+  El::Int count = 0;
+  mean = DataType(0);
+  m2 = DataType(0);
+  for (El::Int start = 0; start < size; start += moments_block_size) {
+    const El::Int block_size = std::min(moments_block_size, size - start);
+    const DataType shift = x[start];
+    DataType sum = 0;
+    DataType sqsum = 0;
+    for (El::Int i = start; i < start + block_size; ++i) {
+      const DataType d = x[i] - shift;
+      sum += d;
+      sqsum += d * d;
+    }
+    const DataType block_mean = shift + sum / block_size;
+    const DataType block_m2 = std::max(sqsum - sum * sum / block_size,
+                                       DataType(0));
+    merge_moments(count, mean, m2, block_size, block_mean, block_m2);
+  }
+}
+
+} // namespace
+
 template <>
 void batch_normalization_layer<data_layout::DATA_PARALLEL, El::Device::CPU>::fp_compute() {
-  constexpr DataType zero = 0;
   constexpr DataType one = 1;
   const bool is_training = this->m_model->get_execution_mode() == execution_mode::training;
 
@@ -45,6 +107,8 @@ void batch_normalization_layer<data_layout::DATA_PARALLEL, El::Device::CPU>::fp_
   const auto& output_dims = get_output_dims();
   const auto& num_channels = output_dims[0];
   const auto& channel_size = get_output_size() / num_channels;
+  const DataType* __restrict__ input_buffer = local_input.LockedBuffer();
+  const El::Int input_ldim = local_input.LDim();
 
   // Compute statistics
   if (is_training) {
@@ -55,33 +119,48 @@ void batch_normalization_layer<data_layout::DATA_PARALLEL, El::Device::CPU>::fp_
     auto& local_running_mean = this->m_weights[2]->get_values().Matrix();
     auto& local_running_var = this->m_weights[3]->get_values().Matrix();
 
-    // Compute sums and sums of squares
+    // Compute moments of each channel in each local sample
+    std::vector<DataType> sample_means(num_channels * local_width);
+    std::vector<DataType> sample_m2s(num_channels * local_width);
+    LBANN_OMP_PARALLEL_FOR_COLLAPSE2
+    for (El::Int channel = 0; channel < num_channels; ++channel) {
+      for (El::Int col = 0; col < local_width; ++col) {
+        const El::Int i = channel + col * num_channels;
+        compute_moments(&input_buffer[channel * channel_size + col * input_ldim],
+                        channel_size, sample_means[i], sample_m2s[i]);
+      }
+    }
+
+    // Merge moments of local samples
+    // Note: local_mean holds the local sum until the global mean is
+    // known.
+    std::vector<DataType> proc_means(num_channels);
     LBANN_OMP_PARALLEL_FOR
     for (El::Int channel = 0; channel < num_channels; ++channel) {
-      DataType sum = zero;
-      DataType sqsum = zero;
-      const auto& row_start = channel * channel_size;
-      const auto& row_end = (channel+1) * channel_size;
+      El::Int count = 0;
+      DataType mean = 0;
+      DataType m2 = 0;
       for (El::Int col = 0; col < local_width; ++col) {
-        for (El::Int row = row_start; row < row_end; ++row) {
-          const auto& x = local_input(row, col);
-          sum += x;
-          sqsum += x * x;
-        }
+        const El::Int i = channel + col * num_channels;
+        merge_moments(count, mean, m2,
+                      channel_size, sample_means[i], sample_m2s[i]);
       }
-      local_mean(channel, 0) = sum;
-      local_var(channel, 0) = sqsum;
+      proc_means[channel] = mean;
+      local_mean(channel, 0) = mean * count;
+      local_var(channel, 0) = m2;
     }
+
+    // Merge moments across processes
+    // Note: Sums of squared deviations are shifted to the global mean
+    // before they are summed, as in merge_moments.
     El::Int num_per_sum;
     switch (m_stats_aggregation) {
     case batch_normalization_stats_aggregation::global:
       m_comm->allreduce(*m_mean, m_mean->RedundantComm(), El::mpi::SUM);
-      m_comm->allreduce(*m_var, m_var->RedundantComm(), El::mpi::SUM);
       num_per_sum = channel_size * width;
       break;
     case batch_normalization_stats_aggregation::node_local:
       m_comm->allreduce(*m_mean, m_comm->get_node_comm(), El::mpi::SUM);
-      m_comm->allreduce(*m_var, m_comm->get_node_comm(), El::mpi::SUM);
       if (m_num_per_sum_cache.count(width) == 0) {
         num_per_sum = channel_size * local_width;
         num_per_sum = m_comm->allreduce(num_per_sum, m_comm->get_node_comm());
@@ -96,6 +175,19 @@ void batch_normalization_layer<data_layout::DATA_PARALLEL, El::Device::CPU>::fp_
     default:
       LBANN_ERROR("Unknown batch normalization stats aggregation");
     }
+    const El::Int local_count = channel_size * local_width;
+    LBANN_OMP_PARALLEL_FOR
+    for (El::Int channel = 0; channel < num_channels; ++channel) {
+      const DataType mean = local_mean(channel, 0) / std::max(num_per_sum, El::Int(1));
+      const DataType delta = proc_means[channel] - mean;
+      local_mean(channel, 0) = mean;
+      local_var(channel, 0) += local_count * delta * delta;
+    }
+    if (m_stats_aggregation == batch_normalization_stats_aggregation::global) {
+      m_comm->allreduce(*m_var, m_var->RedundantComm(), El::mpi::SUM);
+    } else if (m_stats_aggregation == batch_normalization_stats_aggregation::node_local) {
+      m_comm->allreduce(*m_var, m_comm->get_node_comm(), El::mpi::SUM);
+    }
 
     // Compute minibatch statistics
     if (num_per_sum <= 1) {
@@ -103,11 +195,9 @@ void batch_normalization_layer<data_layout::DATA_PARALLEL, El::Device::CPU>::fp_
     } else {
       LBANN_OMP_PARALLEL_FOR
       for (El::Int channel = 0; channel < num_channels; ++channel) {
-        const auto& mean = local_mean(channel, 0) / num_per_sum;
-        const auto& sqmean = local_var(channel, 0) / num_per_sum;
-        auto var = num_per_sum * (sqmean - mean * mean) / (num_per_sum - 1);
+        const auto& mean = local_mean(channel, 0);
+        auto var = local_var(channel, 0) / (num_per_sum - 1);
         var = std::max(var, m_epsilon);
-        local_mean(channel, 0) = mean;
         local_var(channel, 0) = var;
         auto& running_mean = local_running_mean(channel, 0);
         auto& running_var = local_running_var(channel, 0);
@@ -127,30 +217,30 @@ void batch_normalization_layer<data_layout::DATA_PARALLEL, El::Device::CPU>::fp_
   const auto& local_var = (is_training ?
                            m_var->LockedMatrix() :
                            this->m_weights[3]->get_values().LockedMatrix());
+  DataType* __restrict__ output_buffer = local_output.Buffer();
+  const El::Int output_ldim = local_output.LDim();
 
-  // Iterate through channels
-  LBANN_OMP_PARALLEL_FOR
+  // Normalize, scale, and shift each channel in each sample
+  LBANN_OMP_PARALLEL_FOR_COLLAPSE2
   for (El::Int channel = 0; channel < num_channels; ++channel) {
+    for (El::Int col = 0; col < local_width; ++col) {
 
-    // Get channel parameters
-    const auto& mean = local_mean(channel, 0);
-    const auto& var = local_var(channel, 0);
-    const DataType inv_stdev = 1 / std::sqrt(var + m_epsilon);
-    const auto& scale = local_scale(channel, 0);
-    const auto& bias = local_bias(channel, 0);
+      // Get channel parameters
+      const DataType mean = local_mean(channel, 0);
+      const DataType inv_stdev = 1 / std::sqrt(local_var(channel, 0) + m_epsilon);
+      const DataType scale = local_scale(channel, 0) * inv_stdev;
+      const DataType bias = local_bias(channel, 0);
 
-    // Apply batch normalization to inputs in channel
-    const auto& row_start = channel * channel_size;
-    const auto& row_end = (channel+1) * channel_size;
-    for (El::Int col = 0; col < local_width; ++col) {
-      for (El::Int row = row_start; row < row_end; ++row) {
-        const auto& x = local_input(row, col);
-        const auto& xhat = (x - mean) * inv_stdev;
-        auto& y = local_output(row, col);
-        y = scale * xhat + bias;
+      // Apply batch normalization to inputs in channel
+      const DataType* __restrict__ x = &input_buffer[channel * channel_size
+                                                     + col * input_ldim];
+      DataType* __restrict__ y = &output_buffer[channel * channel_size
+                                                + col * output_ldim];
+      for (El::Int row = 0; row < channel_size; ++row) {
+        y[row] = scale * (x[row] - mean) + bias;
       }
-    }
 
+    }
   }
 
 }
@@ -0,0 +1,435 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lbann/models/inference_server.hpp"
+#include "lbann/models/model.hpp"
+#include "lbann/layers/io/input/generic_input_layer.hpp"
+#include "lbann/utils/exception.hpp"
+#include "lbann/utils/timer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace lbann {
+
+namespace {
+
+/** Read from a socket until the buffer is full.
+ *  Returns false if the connection is closed or fails.
+ */
+bool read_all(int fd, void* data, size_t size) {
+  auto* buffer = static_cast<char*>(data);
+  while (size > 0) {
+    const auto bytes = ::recv(fd, buffer, size, 0);
+    if (bytes < 0 && errno == EINTR) { continue; }
+    if (bytes <= 0) { return false; }
+    buffer += bytes;
+    size -= bytes;
+  }
+  return true;
+}
+
+/** Write a buffer to a socket.
+ *  Returns false if the connection is closed or fails.
+ */
+bool write_all(int fd, const void* data, size_t size) {
+  const auto* buffer = static_cast<const char*>(data);
+  while (size > 0) {
+    const auto bytes = ::send(fd, buffer, size, MSG_NOSIGNAL);
+    if (bytes < 0 && errno == EINTR) { continue; }
+    if (bytes <= 0) { return false; }
+    buffer += bytes;
+    size -= bytes;
+  }
+  return true;
+}
+
+} // namespace
+
+inference_server::inference_server(model* m,
+                                   const std::string& output_layer,
+                                   int max_batch_size,
+                                   double max_delay)
+  : m_model(m),
+    m_max_batch_size(max_batch_size),
+    m_max_delay(std::max(max_delay, 0.0)) {
+  if (m_model == nullptr) {
+    LBANN_ERROR("attempted to construct inference server without a model");
+  }
+
+  // Find input and output layers
+  for (const auto& l : m_model->get_layers()) {
+    if (dynamic_cast<generic_input_layer*>(l) != nullptr) {
+      if (m_input_layer != nullptr) {
+        LBANN_ERROR("inference server requires a model with one input layer, "
+                    "but model \"" + m_model->get_name() + "\" "
+                    + "has more than one");
+      }
+      m_input_layer = l;
+    }
+    if (l->get_name() == output_layer) {
+      m_output_layer = l;
+    }
+  }
+  if (m_input_layer == nullptr) {
+    LBANN_ERROR("inference server requires a model with one input layer, "
+                "but model \"" + m_model->get_name() + "\" has none");
+  }
+  if (m_output_layer == nullptr) {
+    LBANN_ERROR("could not find layer \"" + output_layer + "\" "
+                + "in model \"" + m_model->get_name() + "\"");
+  }
+
+  // Mini-batches are limited by the size of the layer tensors
+  if (m_max_batch_size <= 0
+      || m_max_batch_size > m_model->get_max_mini_batch_size()) {
+    m_max_batch_size = m_model->get_max_mini_batch_size();
+  }
+
+  // Samples are not fetched by the input layer
+  m_model->collect_background_data_fetch(execution_mode::testing);
+  m_model->allow_background_io_activity(false);
+
+}
+
+inference_server::~inference_server() {
+  shutdown();
+  {
+    // Requests that were never served fail with a broken promise
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    m_queue.clear();
+  }
+  stop_listening();
+}
+
+std::future<std::vector<DataType>>
+inference_server::submit(std::vector<DataType> sample) {
+  if (!m_model->get_comm()->am_model_master()) {
+    LBANN_ERROR("inference requests must be submitted "
+                "on the model master process");
+  }
+  const size_t input_size = m_input_layer->get_output_size();
+  if (sample.size() != input_size) {
+    std::stringstream err;
+    err << "inference request has " << sample.size() << " entries, "
+        << "but input layer \"" << m_input_layer->get_name() << "\" "
+        << "expects " << input_size;
+    LBANN_ERROR(err.str());
+  }
+  request r;
+  r.m_sample = std::move(sample);
+  r.m_arrival_time = get_time();
+  auto result = r.m_result.get_future();
+  {
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    if (m_shutdown) {
+      LBANN_ERROR("inference server has been shut down");
+    }
+    m_queue.push_back(std::move(r));
+  }
+  m_queue_cv.notify_one();
+  return result;
+}
+
+void inference_server::shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    m_shutdown = true;
+  }
+  m_queue_cv.notify_all();
+}
+
+void inference_server::serve() {
+  auto* comm = m_model->get_comm();
+  const int root = comm->get_model_master();
+  std::vector<request> batch;
+  while (true) {
+
+    // Master process decides on the mini-batch
+    // Note: A negative size signals that the server is shut down.
+    int batch_size = -1;
+    if (comm->am_model_master()) {
+      if (get_next_batch(batch)) { batch_size = batch.size(); }
+    }
+    comm->model_broadcast(root, batch_size);
+    if (batch_size < 0) { break; }
+
+    process_batch(batch, batch_size);
+
+  }
+}
+
+bool inference_server::get_next_batch(std::vector<request>& batch) {
+  batch.clear();
+  std::unique_lock<std::mutex> lock(m_queue_mutex);
+  m_queue_cv.wait(lock, [this] { return m_shutdown || !m_queue.empty(); });
+  if (m_queue.empty()) { return false; }
+
+  // Wait for more requests until the mini-batch is full or the
+  // oldest request has waited long enough
+  const double deadline = m_queue.front().m_arrival_time + m_max_delay;
+  while (!m_shutdown && (int) m_queue.size() < m_max_batch_size) {
+    const double wait_time = deadline - get_time();
+    if (wait_time <= 0) { break; }
+    m_queue_cv.wait_for(lock, std::chrono::duration<double>(wait_time));
+  }
+
+  // Take requests in order of arrival
+  const size_t batch_size = std::min(m_queue.size(),
+                                     size_t(m_max_batch_size));
+  for (size_t i = 0; i < batch_size; ++i) {
+    batch.push_back(std::move(m_queue.front()));
+    m_queue.pop_front();
+  }
+  return true;
+}
+
+void inference_server::process_batch(std::vector<request>& batch,
+                                     int batch_size) {
+  auto* comm = m_model->get_comm();
+  const bool master = comm->am_model_master();
+  const auto& grid = comm->get_model_grid();
+  const int root = comm->get_model_master();
+  const El::Int input_size = m_input_layer->get_output_size();
+  const El::Int output_size = m_output_layer->get_output_size();
+
+  try {
+
+    // Gather samples on master process
+    CircMat<El::Device::CPU> samples(grid, root);
+    samples.Resize(input_size, batch_size);
+    if (master) {
+      auto& local_samples = samples.Matrix();
+      for (int j = 0; j < batch_size; ++j) {
+        std::copy(batch[j].m_sample.begin(), batch[j].m_sample.end(),
+                  local_samples.Buffer(0, j));
+      }
+    }
+
+    // Forward prop and gather outputs on master process
+    m_model->infer_mini_batch(samples);
+    CircMat<El::Device::CPU> outputs(grid, root);
+    El::Copy(m_output_layer->get_activations(), outputs);
+
+    // Return results
+    if (master) {
+      const auto& local_outputs = outputs.LockedMatrix();
+      const double end_time = get_time();
+      if (m_latencies.empty() && batch_size > 0) {
+        m_start_time = batch.front().m_arrival_time;
+      }
+      for (int j = 0; j < batch_size; ++j) {
+        const auto* output = local_outputs.LockedBuffer(0, j);
+        batch[j].m_result.set_value(std::vector<DataType>(output,
+                                                          output + output_size));
+        m_latencies.push_back(end_time - batch[j].m_arrival_time);
+      }
+      m_end_time = end_time;
+    }
+    ++m_num_batches;
+
+  } catch (...) {
+    if (master) {
+      for (auto& r : batch) {
+        r.m_result.set_exception(std::current_exception());
+      }
+    }
+    throw;
+  }
+
+}
+
+void inference_server::print_statistics(std::ostream& os) const {
+  const size_t num_requests = m_latencies.size();
+  if (num_requests == 0) {
+    os << "inference server: no requests served" << std::endl;
+    return;
+  }
+
+  // Latency percentiles
+  auto latencies = m_latencies;
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) -> double {
+    const size_t rank = std::ceil(p * latencies.size());
+    return latencies[std::max(rank, size_t(1)) - 1];
+  };
+  const double mean_latency = (std::accumulate(latencies.begin(),
+                                               latencies.end(),
+                                               0.0)
+                               / num_requests);
+
+  const double elapsed_time = m_end_time - m_start_time;
+  os << "inference server: "
+     << num_requests << " requests in "
+     << m_num_batches << " mini-batches "
+     << "(" << double(num_requests) / m_num_batches << " requests per mini-batch)"
+     << std::endl
+     << "  latency (ms): "
+     << "mean " << mean_latency * 1e3 << ", "
+     << "p50 " << percentile(0.5) * 1e3 << ", "
+     << "p90 " << percentile(0.9) * 1e3 << ", "
+     << "p99 " << percentile(0.99) * 1e3 << ", "
+     << "max " << latencies.back() * 1e3
+     << std::endl;
+  if (elapsed_time > 0) {
+    os << "  throughput: " << num_requests / elapsed_time
+       << " requests/sec" << std::endl;
+  }
+}
+
+void inference_server::listen(const std::string& socket_path) {
+  if (!m_model->get_comm()->am_model_master()) {
+    LBANN_ERROR("inference server can only listen "
+                "on the model master process");
+  }
+  if (m_listen_fd >= 0) {
+    LBANN_ERROR("inference server is already listening "
+                "on \"" + m_socket_path + "\"");
+  }
+
+  // Bind socket to path
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path.empty()
+      || socket_path.size() >= sizeof(address.sun_path)) {
+    LBANN_ERROR("invalid socket path \"" + socket_path + "\"");
+  }
+  std::strncpy(address.sun_path, socket_path.c_str(),
+               sizeof(address.sun_path) - 1);
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    LBANN_ERROR(std::string("could not create socket (")
+                + std::strerror(errno) + ")");
+  }
+  ::unlink(socket_path.c_str());
+  if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+      || ::listen(fd, SOMAXCONN) != 0) {
+    const std::string error_message = std::strerror(errno);
+    ::close(fd);
+    LBANN_ERROR("could not listen on \"" + socket_path + "\" "
+                + "(" + error_message + ")");
+  }
+
+  m_listen_fd = fd;
+  m_socket_path = socket_path;
+  m_accept_thread = std::thread(&inference_server::accept_connections, this);
+}
+
+void inference_server::accept_connections() {
+  while (true) {
+    const int fd = ::accept(m_listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) { continue; }
+      return; // Socket has been shut down
+    }
+    std::lock_guard<std::mutex> lock(m_connection_mutex);
+    m_connection_fds.push_back(fd);
+    m_connection_threads.emplace_back(&inference_server::handle_connection,
+                                      this, fd);
+  }
+}
+
+void inference_server::handle_connection(int fd) {
+  const uint64_t input_size = m_input_layer->get_output_size();
+  while (true) {
+
+    // Receive sample
+    uint64_t size;
+    if (!read_all(fd, &size, sizeof(size))) { break; }
+    if (size == 0) {
+      shutdown();
+      break;
+    }
+    if (size != input_size) {
+      // Connection can't be resynchronized after a malformed message
+      std::stringstream err;
+      err << "closing inference connection after request with "
+          << size << " entries (expected " << input_size << ")";
+      LBANN_WARNING(err.str());
+      break;
+    }
+    std::vector<DataType> sample(size);
+    if (!read_all(fd, sample.data(), size * sizeof(DataType))) { break; }
+
+    // Wait for result and send it
+    std::vector<DataType> output;
+    try {
+      output = submit(std::move(sample)).get();
+    } catch (const std::exception& e) {
+      LBANN_WARNING(std::string("inference request failed: ") + e.what());
+      output.clear();
+    }
+    const uint64_t output_size = output.size();
+    if (!write_all(fd, &output_size, sizeof(output_size))
+        || !write_all(fd, output.data(), output_size * sizeof(DataType))) {
+      break;
+    }
+
+  }
+
+  // Close connection
+  std::lock_guard<std::mutex> lock(m_connection_mutex);
+  m_connection_fds.erase(std::remove(m_connection_fds.begin(),
+                                     m_connection_fds.end(),
+                                     fd),
+                         m_connection_fds.end());
+  ::close(fd);
+}
+
+void inference_server::stop_listening() {
+  if (m_listen_fd < 0) { return; }
+
+  // Stop accepting connections
+  ::shutdown(m_listen_fd, SHUT_RDWR);
+  if (m_accept_thread.joinable()) { m_accept_thread.join(); }
+  ::close(m_listen_fd);
+  ::unlink(m_socket_path.c_str());
+  m_listen_fd = -1;
+
+  // Interrupt open connections and wait for their threads
+  // Note: Connection threads close their own sockets on exit.
+  {
+    std::lock_guard<std::mutex> lock(m_connection_mutex);
+    for (const auto& fd : m_connection_fds) {
+      ::shutdown(fd, SHUT_RDWR);
+    }
+  }
+  for (auto& t : m_connection_threads) {
+    if (t.joinable()) { t.join(); }
+  }
+  m_connection_threads.clear();
+
+}
+
+} // namespace lbann
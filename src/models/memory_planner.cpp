@@ -0,0 +1,216 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lbann/models/memory_planner.hpp"
+#include "lbann/layers/layer.hpp"
+#include "lbann/layers/io/input/generic_input_layer.hpp"
+#include "lbann/utils/exception.hpp"
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace lbann {
+
+void memory_planner::plan(const std::vector<Layer*>& layers) {
+
+  // Discard previous plan
+  m_tensors.clear();
+  m_arenas.clear();
+
+  find_tensors(layers);
+  assign_arenas();
+
+  // Attach tensors to arenas
+  for (const auto& t : m_tensors) {
+    auto* buffer = m_arenas[t.m_arena].data();
+    if (t.m_is_activations) {
+      t.m_layer->set_activations_buffer(t.m_index, buffer, t.m_ldim);
+    } else {
+      t.m_layer->set_error_signals_buffer(t.m_index, buffer, t.m_ldim);
+    }
+  }
+
+}
+
+size_t memory_planner::get_naive_size() const {
+  size_t size = 0;
+  for (const auto& t : m_tensors) { size += t.m_size; }
+  return size * sizeof(DataType);
+}
+
+size_t memory_planner::get_planned_size() const {
+  size_t size = 0;
+  for (const auto& arena : m_arenas) { size += arena.size(); }
+  return size * sizeof(DataType);
+}
+
+void memory_planner::find_tensors(const std::vector<Layer*>& layers) {
+
+  // Execution schedule
+  // Note: Forward prop steps are numbered by layer position and
+  // backward prop steps follow in reverse layer order.
+  const int num_layers = layers.size();
+  std::unordered_map<const Layer*, int> positions;
+  for (int pos = 0; pos < num_layers; ++pos) {
+    positions[layers[pos]] = pos;
+  }
+  auto bp_step = [&](const Layer* l) -> int {
+    const auto& it = positions.find(l);
+    if (it == positions.end()) {
+      LBANN_ERROR("layer \"" + l->get_name() + "\" "
+                  + "is not part of the planned model");
+    }
+    return 2 * num_layers - 1 - it->second;
+  };
+
+  // Last backward prop step that may read an error signal sent to
+  // a layer. Error signals may be passed on as views (e.g. by
+  // identity layers), in which case the parent layers read them too.
+  auto last_error_signal_step = [&](const Layer* receiver) -> int {
+    int last_step = 0;
+    std::vector<const Layer*> readers(1, receiver);
+    std::unordered_set<const Layer*> visited;
+    while (!readers.empty()) {
+      const auto* r = readers.back();
+      readers.pop_back();
+      if (!visited.insert(r).second) { continue; }
+      last_step = std::max(last_step, bp_step(r));
+      for (int i = 0; i < r->get_num_parents(); ++i) {
+        if (r->get_error_signals(i).Viewing()) {
+          readers.push_back(r->get_parent_layers()[i]);
+        }
+      }
+    }
+    return last_step;
+  };
+
+  // Add tensor if it owns its memory
+  // Note: Tensors that already use external memory, e.g. aliases
+  // into a concatenation layer's output, are not planned.
+  auto add_tensor = [&](Layer& l, bool is_activations, int index,
+                        const AbsDistMat& mat,
+                        int first_step, int last_step) {
+    if (mat.Viewing() || dynamic_cast<const ElMat*>(&mat) == nullptr) {
+      return;
+    }
+    if (is_activations ?
+        l.has_activations_buffer(index) :
+        l.has_error_signals_buffer(index)) {
+      return;
+    }
+    const El::Int local_height = mat.LocalHeight();
+    const El::Int local_width = mat.LocalWidth();
+    if (local_height <= 0 || local_width <= 0) { return; }
+    m_tensors.push_back({&l, is_activations, index, local_height,
+                         size_t(local_height * local_width),
+                         first_step, last_step, -1});
+  };
+
+  for (int pos = 0; pos < num_layers; ++pos) {
+    auto& l = *layers[pos];
+    if (l.get_device_allocation() != El::Device::CPU) { continue; }
+    if (dynamic_cast<const generic_input_layer*>(&l) != nullptr) { continue; }
+
+    // Activations are live from forward prop until the layer's
+    // backward prop, since children are computed in between. If the
+    // layer passes error signals on as views, its parents may read
+    // them after that.
+    int activations_last_step = bp_step(&l);
+    for (int i = 0; i < l.get_num_parents(); ++i) {
+      if (l.get_error_signals(i).Viewing()) {
+        activations_last_step = std::max(activations_last_step,
+                                         last_error_signal_step(&l));
+      }
+    }
+    for (int i = 0; i < l.get_num_children(); ++i) {
+      add_tensor(l, true, i, l.get_activations(i),
+                 pos, activations_last_step);
+    }
+
+    // Error signals are live from backward prop until the parent
+    // layer has finished backward prop
+    for (int i = 0; i < l.get_num_parents(); ++i) {
+      const auto* parent = l.get_parent_layers()[i];
+      add_tensor(l, false, i, l.get_error_signals(i),
+                 bp_step(&l), last_error_signal_step(parent));
+    }
+
+  }
+
+}
+
+void memory_planner::assign_arenas() {
+
+  // Place large tensors first
+  // Note: Since tensors are placed in order of decreasing size, an
+  // arena is always at least as large as the tensors placed in it
+  // afterwards.
+  std::vector<size_t> order(m_tensors.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [this](size_t a, size_t b) {
+                     return m_tensors[a].m_size > m_tensors[b].m_size;
+                   });
+
+  // Assign each tensor to the smallest arena with no live tensors
+  // during its lifetime
+  std::vector<size_t> arena_sizes;
+  std::vector<std::vector<size_t>> arena_tensors;
+  for (const auto& i : order) {
+    auto& t = m_tensors[i];
+    int arena = -1;
+    for (size_t a = 0; a < arena_sizes.size(); ++a) {
+      const bool disjoint
+        = std::all_of(arena_tensors[a].begin(), arena_tensors[a].end(),
+                      [&](size_t j) {
+                        const auto& other = m_tensors[j];
+                        return (t.m_last_step < other.m_first_step
+                                || other.m_last_step < t.m_first_step);
+                      });
+      if (disjoint
+          && (arena < 0 || arena_sizes[a] < arena_sizes[arena])) {
+        arena = a;
+      }
+    }
+    if (arena < 0) {
+      arena = arena_sizes.size();
+      arena_sizes.push_back(t.m_size);
+      arena_tensors.emplace_back();
+    }
+    arena_tensors[arena].push_back(i);
+    t.m_arena = arena;
+  }
+
+  // Allocate arenas
+  m_arenas.resize(arena_sizes.size());
+  for (size_t a = 0; a < arena_sizes.size(); ++a) {
+    m_arenas[a].resize(arena_sizes[a]);
+  }
+
+}
+
+} // namespace lbann
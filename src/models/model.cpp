@@ -29,6 +29,7 @@
 #include "lbann/callbacks/callback_save_model.hpp"
 #include "lbann/io/persist.hpp"
 #include "lbann/layers/io/input/generic_input_layer.hpp"
+#include "lbann/layers/math/fused_entrywise.hpp"
 #include "lbann/layers/transform/dummy.hpp"
 #include "lbann/layers/transform/split.hpp"
 #include "lbann/layers/transform/evaluation.hpp"
@@ -83,7 +84,11 @@ model::model(lbann_comm *comm,
     m_comm(comm),
     m_default_optimizer(default_optimizer),
     m_io_thread_pool(),
-    m_background_io_allowed(true) {
+    m_background_io_allowed(true),
+    m_gradient_bucket_size(0),
+    m_multi_tensor_step_enabled(false),
+    m_memory_planner_enabled(false),
+    m_fuse_entrywise_layers_enabled(false) {
 
   // Default model name
   static El::Int num_models = 0;
@@ -104,7 +109,11 @@ model::model(const model& other) :
   m_effective_mini_batch_size(other.m_effective_mini_batch_size),
   m_current_phase(other.m_current_phase),
   m_comm(other.m_comm),
-  m_background_io_allowed(other.m_background_io_allowed) {
+  m_background_io_allowed(other.m_background_io_allowed),
+  m_gradient_bucket_size(other.m_gradient_bucket_size),
+  m_multi_tensor_step_enabled(other.m_multi_tensor_step_enabled),
+  m_memory_planner_enabled(other.m_memory_planner_enabled),
+  m_fuse_entrywise_layers_enabled(other.m_fuse_entrywise_layers_enabled) {
 
   // Deep copies
   m_objective_function = other.m_objective_function;
@@ -135,6 +144,7 @@ model::model(const model& other) :
     w = w_copy;
   }
   remap_pointers(layer_map, weights_map);
+  if (other.m_gradient_buckets != nullptr) { setup_gradient_buckets(); }
 
 }
 
@@ -160,6 +170,10 @@ model& model::operator=(const model& other) {
   m_current_phase = other.m_current_phase;
   m_comm = other.m_comm;
   m_background_io_allowed = other.m_background_io_allowed;
+  m_gradient_bucket_size = other.m_gradient_bucket_size;
+  m_multi_tensor_step_enabled = other.m_multi_tensor_step_enabled;
+  m_memory_planner_enabled = other.m_memory_planner_enabled;
+  m_fuse_entrywise_layers_enabled = other.m_fuse_entrywise_layers_enabled;
 
   // Deep copies
   m_objective_function = other.m_objective_function;
@@ -186,6 +200,9 @@ model& model::operator=(const model& other) {
     w = weights_map[w] = w->copy();
   }
   remap_pointers(layer_map, weights_map);
+  m_gradient_buckets.reset();
+  if (other.m_gradient_buckets != nullptr) { setup_gradient_buckets(); }
+  m_memory_planner.reset();
 
   return *this;
 }
@@ -546,9 +563,11 @@ void model::setup(std::shared_ptr<thread_pool> io_thread_pool) {
   setup_layer_topology();
   setup_layer_execution_order();
   setup_layers();
+  setup_memory_plan();
 
   // Setup weights
   setup_weights();
+  setup_gradient_buckets();
 
   // Setup objective function
   m_objective_function->setup(*this);
@@ -583,6 +602,9 @@ void model::setup_layer_topology() {
   add_evaluation_layers();
   add_dummy_layers();
   add_split_layers();
+  if (m_fuse_entrywise_layers_enabled) {
+    fuse_entrywise_layers();
+  }
 
   // Check that layer names are unique
   std::unordered_set<std::string> names;
@@ -622,6 +644,10 @@ void model::setup_layer_execution_order() {
 }
 
 void model::setup_layers() {
+  // Layers may assign memory to each other's tensors during setup
+  for (const auto& layer : m_layers) {
+    layer->clear_tensor_buffers();
+  }
   for (const auto& layer : m_layers) {
     layer->set_model(this);
     layer->setup();
@@ -629,6 +655,31 @@ void model::setup_layers() {
   }
 }
 
+void model::setup_memory_plan() {
+  if (!m_memory_planner_enabled) {
+    m_memory_planner.reset();
+    return;
+  }
+  if (m_memory_planner == nullptr) {
+    m_memory_planner.reset(new memory_planner());
+  }
+  m_memory_planner->plan(m_layers);
+
+  // Report memory savings
+  if (m_comm->am_model_master()) {
+    const double mb = 1024.0 * 1024.0;
+    std::cout << "model \"" << get_name() << "\" memory plan: "
+              << m_memory_planner->get_num_tensors() << " tensors in "
+              << m_memory_planner->get_num_arenas() << " arenas, "
+              << std::fixed << std::setprecision(1)
+              << m_memory_planner->get_planned_size() / mb << " MB planned vs. "
+              << m_memory_planner->get_naive_size() / mb << " MB naive "
+              << "per process"
+              << std::defaultfloat << std::endl;
+  }
+
+}
+
 void model::setup_weights() {
 
   // List of used and unused weights
@@ -668,6 +719,19 @@ void model::setup_weights() {
 
 }
 
+void model::setup_gradient_buckets() {
+  if (m_gradient_bucket_size > 0) {
+    m_gradient_buckets.reset(new gradient_bucket_manager(m_comm,
+                                                         m_gradient_bucket_size));
+  } else {
+    m_gradient_buckets.reset();
+  }
+  for (auto* w : m_weights) {
+    auto* opt = w->get_optimizer();
+    if (opt != nullptr) { opt->set_gradient_buckets(m_gradient_buckets.get()); }
+  }
+}
+
 void model::add_connected_layers() {
 
   // Initialize breadth-first search queue with layer list
@@ -910,6 +974,142 @@ void model::add_split_layers() {
   }
 }
 
+void model::fuse_entrywise_layers() {
+
+  // Find entry-wise layers that can be fused
+  std::unordered_map<const Layer*, entrywise_stage> stages;
+  for (const auto& l : m_layers) {
+    entrywise_stage stage;
+    if (get_entrywise_stage(*l, stage)) {
+      stages[l] = stage;
+    }
+  }
+
+  // Input through which a layer continues a chain, or -1 if the
+  // layer starts a chain or can't be fused
+  // Note: The parent must be fusable, have the same data layout,
+  // and have no other children.
+  auto get_chain_input = [&](const Layer* l) -> int {
+    if (stages.count(l) == 0) { return -1; }
+    const auto& parents = l->get_parent_layers();
+    for (size_t i = 0; i < parents.size(); ++i) {
+      const auto* p = parents[i];
+      if (stages.count(p) > 0
+          && p->get_data_layout() == l->get_data_layout()
+          && p->get_num_children() == 1) {
+        return i;
+      }
+    }
+    return -1;
+  };
+  std::vector<Layer*> heads;
+  for (const auto& l : m_layers) {
+    if (stages.count(l) > 0 && get_chain_input(l) < 0) {
+      heads.push_back(l);
+    }
+  }
+
+  int num_fused_layers = 0, num_chains = 0;
+  for (auto* head : heads) {
+
+    // Follow chain until a layer can't be fused
+    std::vector<Layer*> chain(1, head);
+    std::vector<entrywise_stage> chain_stages(1, stages[head]);
+    std::vector<const Layer*> parents = head->get_parent_layers();
+    if (chain_stages[0].m_num_operands > 1) {
+      chain_stages[0].m_chain_operand = 0;
+      chain_stages[0].m_external_input = 1;
+    }
+    while (chain.back()->get_num_children() == 1) {
+      const auto* tail = chain.back();
+      auto* next = const_cast<Layer*>(tail->get_child_layers()[0]);
+      const int input = get_chain_input(next);
+      if (input < 0 || next->get_parent_layers()[input] != tail) { break; }
+      auto stage = stages[next];
+      if (stage.m_num_operands > 1) {
+        const auto* other = next->get_parent_layers()[1 - input];
+        if (std::find(parents.begin(), parents.end(), other)
+            != parents.end()) {
+          break;
+        }
+        stage.m_chain_operand = input;
+        stage.m_external_input = parents.size();
+        parents.push_back(other);
+      }
+      chain.push_back(next);
+      chain_stages.push_back(stage);
+    }
+    if (chain.size() < 2) { continue; }
+    auto* tail = chain.back();
+
+    // Create fused layer
+    Layer *fused = nullptr;
+    switch (head->get_data_layout()) {
+    case data_layout::DATA_PARALLEL:
+      fused = new fused_entrywise_layer<data_layout::DATA_PARALLEL, El::Device::CPU>(m_comm, chain_stages);
+      break;
+    case data_layout::MODEL_PARALLEL:
+      fused = new fused_entrywise_layer<data_layout::MODEL_PARALLEL, El::Device::CPU>(m_comm, chain_stages);
+      break;
+    default: {
+      std::stringstream err;
+      err << "could not construct fused entry-wise layer corresponding to "
+          << "layer \"" << tail->get_name() << "\" "
+          << "in model \"" << get_name() << "\"";
+      LBANN_ERROR(err.str());
+    }
+    }
+    fused->set_name(tail->get_name());
+
+    // Setup relationships between fused layer and parent layers
+    fused->get_parent_layers() = parents;
+    for (auto&& const_parent : head->get_parent_layers()) {
+      auto& parent_children = const_cast<Layer*>(const_parent)->get_child_layers();
+      std::replace(parent_children.begin(), parent_children.end(),
+                   head, fused);
+    }
+    for (size_t i = 1; i < chain.size(); ++i) {
+      const auto& stage = chain_stages[i];
+      if (stage.m_num_operands > 1) {
+        auto* parent = const_cast<Layer*>(parents[stage.m_external_input]);
+        auto& parent_children = parent->get_child_layers();
+        std::replace(parent_children.begin(), parent_children.end(),
+                     chain[i], fused);
+      }
+    }
+
+    // Setup relationships between fused layer and child layers
+    fused->get_child_layers() = tail->get_child_layers();
+    for (auto&& const_child : tail->get_child_layers()) {
+      auto& child_parents = const_cast<Layer*>(const_child)->get_parent_layers();
+      std::replace(child_parents.begin(), child_parents.end(),
+                   tail, fused);
+    }
+
+    // Replace chain with fused layer
+    // Note: The fused layer takes the position of the last layer in
+    // the chain, which comes after all of the fused layer's parents.
+    std::replace(m_layers.begin(), m_layers.end(), tail, fused);
+    std::unordered_set<Layer*> chain_set(chain.begin(), chain.end());
+    m_layers.erase(std::remove_if(m_layers.begin(), m_layers.end(),
+                                  [&](Layer* l) {
+                                    return chain_set.count(l) > 0;
+                                  }),
+                   m_layers.end());
+    for (auto* l : chain) { delete l; }
+    num_fused_layers += chain.size();
+    num_chains++;
+
+  }
+
+  if (num_chains > 0 && m_comm->am_model_master()) {
+    std::cout << "model \"" << get_name() << "\" fused "
+              << num_fused_layers << " entry-wise layers into "
+              << num_chains << " layers" << std::endl;
+  }
+
+}
+
 int model::get_num_iterations_per_epoch(execution_mode mode) const {
   generic_input_layer* input = nullptr;
   for (auto&& l : m_layers) {
@@ -944,7 +1144,9 @@ void model::evaluate(execution_mode mode, int num_batches) {
   reset_mode_and_model(mode);
   do_evaluate_begin_cbs(mode);
   if (num_batches > 0) {
-    for (int i = 0; i < num_batches; i++) { evaluate_mini_batch(mode); }
+    for (int i = 0; i < num_batches; i++) {
+      if (evaluate_mini_batch(mode)) { break; }
+    }
   } else {
     while (!evaluate_mini_batch(mode)) {}
   }
@@ -976,6 +1178,15 @@ void model::collect_background_data_fetch(execution_mode mode) {
   return;
 }
 
+void model::reset_data_set(execution_mode mode) {
+  for (const auto& layer : m_layers) {
+    auto *input = dynamic_cast<generic_input_layer*>(layer);
+    if (input != nullptr) {
+      input->reset_data_set(mode);
+    }
+  }
+}
+
 void model::train(int num_epochs, int num_batches) {
   do_train_begin_cbs();
   for (int epoch = m_current_epoch; epoch < num_epochs; ++epoch) {
@@ -1046,6 +1257,42 @@ bool model::evaluate_mini_batch(execution_mode mode) {
   return finished;
 }
 
+void model::infer_mini_batch(const AbsDistMat& samples) {
+  reset_mode_and_model(execution_mode::testing);
+  const int mini_batch_size = samples.Width();
+  if (mini_batch_size > get_max_mini_batch_size()) {
+    std::stringstream err;
+    err << "attempted to infer a mini-batch with " << mini_batch_size << " "
+        << "samples, but the maximum mini-batch size is "
+        << get_max_mini_batch_size();
+    LBANN_ERROR(err.str());
+  }
+  set_current_mini_batch_size(mini_batch_size);
+  set_effective_mini_batch_size(mini_batch_size);
+  for (const auto& layer : m_layers) {
+    if (dynamic_cast<generic_input_layer*>(layer) != nullptr) {
+      if (samples.Height() != layer->get_output_size()) {
+        std::stringstream err;
+        err << "input layer \"" << layer->get_name() << "\" "
+            << "expects samples with " << layer->get_output_size() << " "
+            << "entries, but got " << samples.Height();
+        LBANN_ERROR(err.str());
+      }
+      // Setup outputs as in forward prop, since they may be attached
+      // to memory shared with other layers. The input layer's own
+      // setup is skipped since it takes the mini-batch size from its
+      // data reader.
+      layer->Layer::fp_setup_outputs(mini_batch_size);
+      El::Copy(samples, layer->get_activations(0));
+      for (int i = 1; i < layer->get_num_children(); ++i) {
+        El::Zero(layer->get_activations(i));
+      }
+    } else {
+      layer->forward_prop();
+    }
+  }
+}
+
 bool model::train_mini_batch() {
   reset_mode_and_model(execution_mode::training);
   do_batch_begin_cbs(execution_mode::training);
@@ -1093,6 +1340,7 @@ bool model::train_mini_batch() {
 }
 
 void model::clear_gradients() {
+  if (m_gradient_buckets != nullptr) { m_gradient_buckets->reset(); }
   for (const auto& w : m_weights) {
     optimizer* opt = w->get_optimizer();
     if (opt != nullptr) { opt->clear_gradient(); }
@@ -1119,32 +1367,54 @@ void model::backward_prop() {
     layer->back_prop();
     do_layer_backward_prop_end_cbs(layer);
 
-    // Terminate early if all gradients have been computed
+    // Poll gradient allreduces that have started, so that they
+    // progress while earlier layers are computed
+    // Note: An allreduce is started as soon as the last layer that
+    // contributes to a gradient has finished its backward prop step.
     bool all_gradients_computed = true;
     for (auto&& w : m_weights) {
       auto&& opt = w->get_optimizer();
-      if (opt != nullptr && opt->get_num_gradient_sources() != 0) {
-        all_gradients_computed = false;
-        break;
+      if (opt != nullptr) {
+        opt->test_gradient_staging_allreduce();
+        if (opt->get_num_gradient_sources() != 0) {
+          all_gradients_computed = false;
+        }
       }
     }
+    if (m_gradient_buckets != nullptr) { m_gradient_buckets->progress(); }
+
+    // Terminate early if all gradients have been computed
     if (all_gradients_computed) { break; }
 
   }
+
+  // Launch allreduces on partially filled gradient buckets
+  if (m_gradient_buckets != nullptr) { m_gradient_buckets->flush(); }
+
   do_model_backward_prop_end_cbs();
 }
 
 void model::update_weights() {
   do_model_optimize_begin_cbs();
+  std::vector<weights*> fused_weights;
   for (int i = m_weights.size() - 1; i >= 0; --i) {
     auto& w = m_weights[i];
     optimizer* opt = w->get_optimizer();
     if (opt != nullptr) {
       do_weight_optimize_begin_cbs(w);
-      opt->step();
-      do_weight_optimize_end_cbs(w);
+      if (m_multi_tensor_step_enabled && opt->can_fuse_step()) {
+        m_multi_tensor_step.add(*opt);
+        fused_weights.push_back(w);
+      } else {
+        opt->step();
+        do_weight_optimize_end_cbs(w);
+      }
     }
   }
+  if (!fused_weights.empty()) {
+    m_multi_tensor_step.apply();
+    for (auto* w : fused_weights) { do_weight_optimize_end_cbs(w); }
+  }
   do_model_optimize_end_cbs();
 }
 
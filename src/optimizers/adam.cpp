@@ -159,6 +159,41 @@ void adam::step_compute(AbsDistMat& values, const AbsDistMat& gradient) {
   }
 }
 
+void adam::step_compute_local_setup() {
+  m_current_beta1 *= m_beta1;
+  m_current_beta2 *= m_beta2;
+  m_correction = m_learning_rate *
+                 (std::sqrt(DataType(1) - m_current_beta2)
+                  / (DataType(1) - m_current_beta1));
+}
+
+bool adam::step_compute_local_contiguous() const {
+  return (m_moment1->LDim() == m_moment1->LocalHeight()
+          && m_moment2->LDim() == m_moment2->LocalHeight());
+}
+
+void adam::step_compute_local(AbsDistMat& values,
+                              const AbsDistMat& gradient,
+                              El::Int col,
+                              El::Int row_begin,
+                              El::Int row_end) {
+  const El::Int size = row_end - row_begin;
+  DataType* __restrict__ x = values.Buffer() + row_begin + col * values.LDim();
+  const DataType* __restrict__ g = (gradient.LockedBuffer()
+                                    + row_begin + col * gradient.LDim());
+  DataType* __restrict__ m1 = (m_moment1->Buffer()
+                               + row_begin + col * m_moment1->LDim());
+  DataType* __restrict__ m2 = (m_moment2->Buffer()
+                               + row_begin + col * m_moment2->LDim());
+  for (El::Int i = 0; i < size; ++i) {
+    // Add eps to avoid denormalized g*g, as in step_compute
+    const DataType gi = g[i] + m_eps;
+    m1[i] = m_beta1 * m1[i] + (DataType(1) - m_beta1) * gi;
+    m2[i] = m_beta2 * m2[i] + (DataType(1) - m_beta2) * gi * gi;
+    x[i] -= m_correction * m1[i] / (std::sqrt(m2[i]) + m_eps);
+  }
+}
+
 ////////////////////////////////////////////////////////////
 // Checkpointing
 ////////////////////////////////////////////////////////////
@@ -0,0 +1,246 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lbann/optimizers/gradient_bucket.hpp"
+#include "lbann/utils/exception.hpp"
+
+namespace lbann {
+
+namespace {
+
+/** Copy between a local matrix and a segment of a bucket buffer. */
+template <El::Device Device>
+void copy_bucket_segment(AbsMat& local,
+                         AbsMat& buffer,
+                         El::Int offset,
+                         bool pack) {
+  using MatType = El::Matrix<DataType, Device>;
+  const El::Int height = local.Height();
+  const El::Int width = local.Width();
+  auto& buffer_d = static_cast<MatType&>(buffer);
+  MatType segment;
+  segment.Attach(height, width, buffer_d.Buffer() + offset, height);
+  if (pack) {
+    El::Copy(local, segment);
+  } else {
+    El::Copy(segment, local);
+  }
+}
+
+void copy_bucket_segment(AbsMat& local,
+                         AbsMat& buffer,
+                         El::Int offset,
+                         bool pack) {
+  switch (buffer.GetDevice()) {
+  case El::Device::CPU:
+    copy_bucket_segment<El::Device::CPU>(local, buffer, offset, pack);
+    break;
+#ifdef LBANN_HAS_GPU
+  case El::Device::GPU:
+    copy_bucket_segment<El::Device::GPU>(local, buffer, offset, pack);
+    break;
+#endif // LBANN_HAS_GPU
+  default:
+    std::stringstream err;
+    err << "invalid device (" << (int) buffer.GetDevice() << ")";
+    LBANN_ERROR(err.str());
+  }
+}
+
+} // namespace
+
+gradient_bucket_manager::gradient_bucket_manager(lbann_comm* comm,
+                                                 size_t bucket_size)
+  : m_comm(comm),
+    m_bucket_size(bucket_size),
+    m_num_buckets_used(0),
+    m_num_allreduces(0) {}
+
+gradient_bucket_manager::~gradient_bucket_manager() {
+  // Make sure no allreduce is writing to a bucket buffer
+  for (size_t i = 0; i < m_num_buckets_used; ++i) {
+    auto& b = *m_buckets[i];
+    if (b.m_started && !b.m_finished) { m_comm->wait(b.m_req); }
+  }
+}
+
+bool gradient_bucket_manager::add(const optimizer& opt,
+                                  AbsDistMat& gradient) {
+  const El::Int capacity = m_bucket_size / sizeof(DataType);
+  const auto& local_gradient = gradient.LockedMatrix();
+  const El::Int size = local_gradient.Height() * local_gradient.Width();
+
+  // Only bucket gradients that need communication and that are
+  // small enough to benefit from being fused
+  if (size < 1 || size >= capacity
+      || El::mpi::Size(gradient.RedundantComm()) == 1) {
+    return false;
+  }
+
+  // Find bucket with enough room for gradient
+  auto* b = find_open_bucket(gradient);
+  if (b != nullptr && b->m_size + size > capacity) {
+    start_allreduce(*b);
+    b = nullptr;
+  }
+  if (b == nullptr) { b = &new_bucket(gradient); }
+
+  // Pack gradient into bucket
+  copy_bucket_segment(gradient.Matrix(), *b->m_buffer, b->m_size, true);
+  b->m_entries.push_back({&gradient, b->m_size});
+  b->m_size += size;
+  m_optimizer_buckets[&opt] = b;
+
+  // Launch allreduce if bucket is full
+  if (b->m_size == capacity) { start_allreduce(*b); }
+  return true;
+
+}
+
+void gradient_bucket_manager::flush() {
+  for (size_t i = 0; i < m_num_buckets_used; ++i) {
+    auto& b = *m_buckets[i];
+    if (!b.m_started) { start_allreduce(b); }
+  }
+}
+
+void gradient_bucket_manager::wait(const optimizer& opt) {
+  auto it = m_optimizer_buckets.find(&opt);
+  if (it == m_optimizer_buckets.end()) {
+    LBANN_ERROR("attempted to wait for a gradient that has not been bucketed");
+  }
+  auto& b = *it->second;
+  if (!b.m_started) { start_allreduce(b); }
+  if (!b.m_finished) { finish_allreduce(b); }
+}
+
+void gradient_bucket_manager::progress() {
+  for (size_t i = 0; i < m_num_buckets_used; ++i) {
+    auto& b = *m_buckets[i];
+    if (b.m_started && !b.m_finished && m_comm->test(b.m_req)) {
+      finish_allreduce(b);
+    }
+  }
+}
+
+void gradient_bucket_manager::reset() {
+  for (size_t i = 0; i < m_num_buckets_used; ++i) {
+    auto& b = *m_buckets[i];
+    if (b.m_started && !b.m_finished) {
+      m_comm->wait(b.m_req);
+      b.m_finished = true;
+    }
+    b.m_entries.clear();
+  }
+  m_num_buckets_used = 0;
+  m_optimizer_buckets.clear();
+}
+
+gradient_bucket_manager::bucket*
+gradient_bucket_manager::find_open_bucket(const AbsDistMat& gradient) {
+  for (size_t i = m_num_buckets_used; i > 0; --i) {
+    auto& b = *m_buckets[i-1];
+    if (!b.m_started
+        && b.m_grid == &gradient.Grid()
+        && b.m_col_dist == gradient.ColDist()
+        && b.m_row_dist == gradient.RowDist()
+        && b.m_device == gradient.GetLocalDevice()) {
+      return &b;
+    }
+  }
+  return nullptr;
+}
+
+gradient_bucket_manager::bucket&
+gradient_bucket_manager::new_bucket(const AbsDistMat& gradient) {
+  if (m_num_buckets_used == m_buckets.size()) {
+    m_buckets.emplace_back(new bucket());
+  }
+  auto& b = *m_buckets[m_num_buckets_used++];
+  b.m_grid = &gradient.Grid();
+  b.m_col_dist = gradient.ColDist();
+  b.m_row_dist = gradient.RowDist();
+  b.m_size = 0;
+  b.m_entries.clear();
+  b.m_started = false;
+  b.m_finished = false;
+
+  // Allocate buffer if needed
+  const auto& device = gradient.GetLocalDevice();
+  if (b.m_buffer == nullptr || b.m_device != device) {
+    switch (device) {
+    case El::Device::CPU:
+      b.m_buffer.reset(new CPUMat());
+      break;
+#ifdef LBANN_HAS_GPU
+    case El::Device::GPU:
+      b.m_buffer.reset(new GPUMat());
+      break;
+#endif // LBANN_HAS_GPU
+    default:
+      std::stringstream err;
+      err << "invalid device (" << (int) device << ")";
+      LBANN_ERROR(err.str());
+    }
+  }
+  b.m_device = device;
+  b.m_buffer->Resize(m_bucket_size / sizeof(DataType), 1);
+  return b;
+
+}
+
+void gradient_bucket_manager::start_allreduce(bucket& b) {
+  b.m_started = true;
+  b.m_finished = false;
+  if (b.m_entries.empty()) {
+    b.m_finished = true;
+    return;
+  }
+
+  // Shrink buffer to packed data. Shrinking a matrix does not
+  // reallocate its memory, so the packed data is preserved.
+  b.m_buffer->Resize(b.m_size, 1);
+
+  b.m_req = Al::request();
+  m_comm->nb_allreduce(*b.m_buffer,
+                       b.m_entries.front().m_gradient->RedundantComm(),
+                       b.m_req,
+                       El::mpi::SUM);
+  m_num_allreduces++;
+}
+
+void gradient_bucket_manager::finish_allreduce(bucket& b) {
+  m_comm->wait(b.m_req);
+  for (auto& entry : b.m_entries) {
+    copy_bucket_segment(entry.m_gradient->Matrix(),
+                        *b.m_buffer,
+                        entry.m_offset,
+                        false);
+  }
+  b.m_finished = true;
+}
+
+} // namespace lbann
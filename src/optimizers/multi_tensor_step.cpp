@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lbann/optimizers/multi_tensor_step.hpp"
+#include "lbann/optimizers/optimizer.hpp"
+#include "lbann/utils/exception.hpp"
+#include "lbann/utils/timer.hpp"
+#include <algorithm>
+
+namespace lbann {
+
+multi_tensor_step::multi_tensor_step(El::Int chunk_size)
+  : m_chunk_size(std::max(chunk_size, El::Int(1))) {}
+
+void multi_tensor_step::add(optimizer& opt) {
+  if (!opt.can_fuse_step()) {
+    LBANN_ERROR(opt.get_type() + " optimizer "
+                + "does not support multi-tensor optimization steps");
+  }
+
+  double add_start = get_time();
+
+  // Finalize gradient and prepare optimizer for step
+  auto& values = opt.get_weights().get_values();
+  const auto& gradient = opt.get_gradient();
+  opt.step_compute_local_setup();
+
+  // Split local data into chunks. Contiguous data is chunked as one
+  // flat range so that short, wide weights do not become many tiny
+  // chunks. Otherwise chunks are cut within columns.
+  const El::Int local_height = values.LocalHeight();
+  const El::Int local_width = values.LocalWidth();
+  const El::Int local_size = local_height * local_width;
+  const size_t entry_index = m_entries.size();
+  m_entries.push_back({&opt, &values, &gradient, local_size});
+  const bool contiguous = (values.LDim() == local_height
+                           && gradient.LDim() == local_height
+                           && opt.step_compute_local_contiguous());
+  if (contiguous && local_size > 0) {
+    const El::Int num_chunks = (local_size + m_chunk_size - 1) / m_chunk_size;
+    for (El::Int i = 0; i < num_chunks; ++i) {
+      m_chunks.push_back({entry_index, 0,
+                          (i * local_size) / num_chunks,
+                          ((i+1) * local_size) / num_chunks});
+    }
+  } else if (local_height > 0) {
+    const El::Int num_chunks = (local_height + m_chunk_size - 1) / m_chunk_size;
+    for (El::Int col = 0; col < local_width; ++col) {
+      for (El::Int i = 0; i < num_chunks; ++i) {
+        m_chunks.push_back({entry_index, col,
+                            (i * local_height) / num_chunks,
+                            ((i+1) * local_height) / num_chunks});
+      }
+    }
+  }
+
+  opt.m_step_time += get_time() - add_start;
+
+}
+
+void multi_tensor_step::apply() {
+  double apply_start = get_time();
+
+  // Apply optimization step to all chunks in one parallel region
+  const int num_chunks = m_chunks.size();
+  LBANN_OMP_PARALLEL_FOR
+  for (int i = 0; i < num_chunks; ++i) {
+    const auto& c = m_chunks[i];
+    const auto& e = m_entries[c.m_entry];
+    e.m_optimizer->step_compute_local(*e.m_values, *e.m_gradient,
+                                      c.m_col, c.m_row_begin, c.m_row_end);
+  }
+
+  // Attribute time to optimizers in proportion to their data size
+  const double apply_time = get_time() - apply_start;
+  El::Int total_size = 0;
+  for (const auto& e : m_entries) { total_size += e.m_size; }
+  if (total_size > 0) {
+    for (const auto& e : m_entries) {
+      e.m_optimizer->m_step_time += apply_time * e.m_size / total_size;
+    }
+  }
+
+  m_entries.clear();
+  m_chunks.clear();
+
+}
+
+} // namespace lbann
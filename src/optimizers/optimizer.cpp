@@ -25,6 +25,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "lbann/optimizers/optimizer.hpp"
+#include "lbann/optimizers/gradient_bucket.hpp"
 #include "lbann/utils/timer.hpp"
 
 namespace lbann {
@@ -37,7 +38,9 @@ optimizer::optimizer(lbann_comm *comm, DataType learning_rate)
     m_gradient_staging(nullptr),
     m_gradient_allreduce_needed(false),
     m_gradient_allreduce_started(false),
-    m_gradient_allreduce_finished(false) {}
+    m_gradient_allreduce_finished(false),
+    m_gradient_allreduce_bucketed(false),
+    m_gradient_buckets(nullptr) {}
 
 optimizer::optimizer(const optimizer& other)
   : m_comm(other.m_comm),
@@ -48,6 +51,8 @@ optimizer::optimizer(const optimizer& other)
     m_gradient_allreduce_needed(other.m_gradient_allreduce_needed),
     m_gradient_allreduce_started(other.m_gradient_allreduce_started),
     m_gradient_allreduce_finished(other.m_gradient_allreduce_finished),
+    m_gradient_allreduce_bucketed(other.m_gradient_allreduce_bucketed),
+    m_gradient_buckets(other.m_gradient_buckets),
     m_step_time(other.m_step_time)
 {
   if (m_gradient != nullptr) {
@@ -67,6 +72,8 @@ optimizer& optimizer::operator=(const optimizer& other) {
   m_gradient_allreduce_started = other.m_gradient_allreduce_started;
   m_gradient_allreduce_finished = other.m_gradient_allreduce_finished;
   m_gradient_allreduce_started = other.m_gradient_allreduce_started;
+  m_gradient_allreduce_bucketed = other.m_gradient_allreduce_bucketed;
+  m_gradient_buckets = other.m_gradient_buckets;
 
   // Deep copy matrices
   if (m_gradient != nullptr) { delete m_gradient; }
@@ -113,7 +120,11 @@ const AbsDistMat& optimizer::get_gradient() {
     start_gradient_staging_allreduce();
   }
   if (m_gradient_allreduce_started && !m_gradient_allreduce_finished) {
-    m_comm->wait(m_gradient_allreduce_req);
+    if (m_gradient_allreduce_bucketed) {
+      m_gradient_buckets->wait(*this);
+    } else {
+      m_comm->wait(m_gradient_allreduce_req);
+    }
     m_gradient_allreduce_finished = true;
   }
   if (m_gradient_allreduce_needed) {
@@ -122,6 +133,7 @@ const AbsDistMat& optimizer::get_gradient() {
   m_gradient_allreduce_needed = false;
   m_gradient_allreduce_started = false;
   m_gradient_allreduce_finished = false;
+  m_gradient_allreduce_bucketed = false;
 
   return *m_gradient;
 
@@ -133,11 +145,25 @@ void optimizer::start_gradient_staging_allreduce() {
   }
 
   m_gradient_allreduce_started = true;
-  m_comm->nb_allreduce(*m_gradient_staging,
-                       m_gradient_staging->RedundantComm(),
-                       m_gradient_allreduce_req,
-                       El::mpi::SUM);
   m_gradient_allreduce_finished = false;
+  m_gradient_allreduce_bucketed = (m_gradient_buckets != nullptr
+                                   && m_gradient_buckets->add(*this, *m_gradient_staging));
+  if (!m_gradient_allreduce_bucketed) {
+    m_comm->nb_allreduce(*m_gradient_staging,
+                         m_gradient_staging->RedundantComm(),
+                         m_gradient_allreduce_req,
+                         El::mpi::SUM);
+  }
+}
+
+bool optimizer::test_gradient_staging_allreduce() {
+  if (!m_gradient_allreduce_started
+      || m_gradient_allreduce_finished
+      || m_gradient_allreduce_bucketed) {
+    return true;
+  }
+  m_gradient_allreduce_finished = m_comm->test(m_gradient_allreduce_req);
+  return m_gradient_allreduce_finished;
 }
 
 void optimizer::clear_gradient() {
@@ -149,6 +175,7 @@ void optimizer::clear_gradient() {
   m_gradient_allreduce_needed = false;
   m_gradient_allreduce_started = false;
   m_gradient_allreduce_finished = false;
+  m_gradient_allreduce_bucketed = false;
 
 }
 
@@ -275,6 +302,21 @@ void optimizer::step() {
 
 }
 
+bool optimizer::can_fuse_step() const {
+  return (is_initialized()
+          && supports_step_compute_local()
+          && m_weights->get_values().GetLocalDevice() == El::Device::CPU);
+}
+
+void optimizer::step_compute_local(AbsDistMat& values,
+                                   const AbsDistMat& gradient,
+                                   El::Int col,
+                                   El::Int row_begin,
+                                   El::Int row_end) {
+  LBANN_ERROR(get_type() + " optimizer "
+              + "does not implement step_compute_local");
+}
+
 #ifdef LBANN_HAS_GPU
 void optimizer::step_compute_gpu(AbsDistMat& values, const AbsDistMat& gradient) {
   /// @todo Automatically use CPU implementation
@@ -123,6 +123,26 @@ void rmsprop::step_compute(AbsDistMat& values, const AbsDistMat& gradient) {
   }
 }
 
+bool rmsprop::step_compute_local_contiguous() const {
+  return m_cache->LDim() == m_cache->LocalHeight();
+}
+
+void rmsprop::step_compute_local(AbsDistMat& values,
+                                 const AbsDistMat& gradient,
+                                 El::Int col,
+                                 El::Int row_begin,
+                                 El::Int row_end) {
+  const El::Int size = row_end - row_begin;
+  DataType* __restrict__ x = values.Buffer() + row_begin + col * values.LDim();
+  const DataType* __restrict__ g = (gradient.LockedBuffer()
+                                    + row_begin + col * gradient.LDim());
+  DataType* __restrict__ c = m_cache->Buffer() + row_begin + col * m_cache->LDim();
+  for (El::Int i = 0; i < size; ++i) {
+    c[i] = m_decay_rate * c[i] + (DataType(1) - m_decay_rate) * g[i] * g[i];
+    x[i] -= m_learning_rate * g[i] / (std::sqrt(c[i]) + m_eps);
+  }
+}
+
 bool rmsprop::save_to_checkpoint_shared(persist& p, std::string name_prefix) {
   optimizer::save_to_checkpoint_shared(p, name_prefix);
 
@@ -139,6 +139,41 @@ void sgd::step_compute(AbsDistMat& values, const AbsDistMat& gradient) {
 
 }
 
+bool sgd::step_compute_local_contiguous() const {
+  return (m_velocity == nullptr
+          || m_velocity->LDim() == m_velocity->LocalHeight());
+}
+
+void sgd::step_compute_local(AbsDistMat& values,
+                             const AbsDistMat& gradient,
+                             El::Int col,
+                             El::Int row_begin,
+                             El::Int row_end) {
+  const El::Int size = row_end - row_begin;
+  DataType* __restrict__ x = values.Buffer() + row_begin + col * values.LDim();
+  const DataType* __restrict__ g = (gradient.LockedBuffer()
+                                    + row_begin + col * gradient.LDim());
+  if (m_momentum == DataType(0)) {
+    for (El::Int i = 0; i < size; ++i) {
+      x[i] -= m_learning_rate * g[i];
+    }
+    return;
+  }
+  DataType* __restrict__ v = (m_velocity->Buffer()
+                              + row_begin + col * m_velocity->LDim());
+  if (m_nesterov) {
+    for (El::Int i = 0; i < size; ++i) {
+      v[i] = m_momentum * v[i] + g[i];
+      x[i] -= m_learning_rate * (m_momentum * v[i] + g[i]);
+    }
+  } else {
+    for (El::Int i = 0; i < size; ++i) {
+      v[i] = m_momentum * v[i] + g[i];
+      x[i] -= m_learning_rate * v[i];
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////
 // Checkpointing
 ////////////////////////////////////////////////////////////
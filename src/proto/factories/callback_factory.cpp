@@ -103,6 +103,8 @@ lbann_callback* construct_callback(lbann_comm* comm,
                                    parse_set<std::string>(params.weights()),
                                    params.low_score_wins(),
                                    lbann_callback_ltfb::string_to_comm_algo(params.communication_algorithm()),
+                                   params.eval_mini_batches(),
+                                   params.async_exchange(),
                                    summarizer);
   }
   /// @todo
@@ -216,13 +218,16 @@ lbann_callback* construct_callback(lbann_comm* comm,
 
   if (proto_cb.has_checkpoint()) {
     const auto& params = proto_cb.checkpoint();
-    return new lbann_callback_checkpoint(params.checkpoint_dir(),
-                                         params.checkpoint_epochs(),
-                                         params.checkpoint_steps(),
-                                         params.checkpoint_secs(),
-                                         params.per_rank_dir(),
-                                         params.ckpt_dist_epochs(),
-                                         params.ckpt_dist_steps());
+    auto* cb = new lbann_callback_checkpoint(params.checkpoint_dir(),
+                                             params.checkpoint_epochs(),
+                                             params.checkpoint_steps(),
+                                             params.checkpoint_secs(),
+                                             params.per_rank_dir(),
+                                             params.ckpt_dist_epochs(),
+                                             params.ckpt_dist_steps());
+    cb->set_checkpoint_async(params.async_checkpoint());
+    cb->set_checkpoint_aggregate(params.aggregate_checkpoint());
+    return cb;
   }
   if (proto_cb.has_save_model()) {
     const auto& params = proto_cb.save_model();
@@ -86,7 +86,8 @@ Layer* construct_layer(lbann_comm* comm,
                                                                  num_parallel_readers,
                                                                  data_readers,
                                                                  !params.data_set_per_model(),
-                                                                 target_mode);
+                                                                 target_mode,
+                                                                 params.prefetch_depth());
     }
   }
 
@@ -188,10 +189,13 @@ Layer* construct_layer(lbann_comm* comm,
         dilations.resize(dims.size(), 1);
       }
       if (layout == data_layout::DATA_PARALLEL) {
-        return new convolution_layer<data_layout::DATA_PARALLEL, Dev>(
+        auto* l = new convolution_layer<data_layout::DATA_PARALLEL, Dev>(
                      comm, dims.size(), num_output_channels,
                      dims, pads, strides, dilations, num_groups, bias
                    );
+        l->set_im2col_batch_size(params.im2col_batch_size());
+        l->set_direct_convolution(params.direct_convolution());
+        return l;
       }
       LAYOUT_ERR(proto_layer.name(), "convolution");
     } else {
@@ -204,10 +208,13 @@ Layer* construct_layer(lbann_comm* comm,
         dilation = 1;
       }
       if (layout == data_layout::DATA_PARALLEL) {
-        return new convolution_layer<data_layout::DATA_PARALLEL, Dev>(
+        auto* l = new convolution_layer<data_layout::DATA_PARALLEL, Dev>(
                      comm, num_dims, num_output_channels,
                      dim, pad, stride, dilation, num_groups, bias
                    );
+        l->set_im2col_batch_size(params.im2col_batch_size());
+        l->set_direct_convolution(params.direct_convolution());
+        return l;
       }
       LAYOUT_ERR(proto_layer.name(), "convolution");
     }
@@ -236,10 +243,13 @@ Layer* construct_layer(lbann_comm* comm,
         dilations.resize(dims.size(), 1);
       }
       if (layout == data_layout::DATA_PARALLEL) {
-        return new deconvolution_layer<data_layout::DATA_PARALLEL, Dev>(
+        auto* l = new deconvolution_layer<data_layout::DATA_PARALLEL, Dev>(
                      comm, dims.size(), num_output_channels,
                      dims, pads, strides, dilations, num_groups, bias
                    );
+        l->set_im2col_batch_size(params.im2col_batch_size());
+        l->set_direct_convolution(params.direct_convolution());
+        return l;
       }
       LAYOUT_ERR(proto_layer.name(), "deconvolution");
     } else {
@@ -252,10 +262,13 @@ Layer* construct_layer(lbann_comm* comm,
         dilation = 1;
       }
       if (layout == data_layout::DATA_PARALLEL) {
-        return new deconvolution_layer<data_layout::DATA_PARALLEL, Dev>(
+        auto* l = new deconvolution_layer<data_layout::DATA_PARALLEL, Dev>(
                      comm, num_dims, num_output_channels,
                      dim, pad, stride, dilation, num_groups, bias
                    );
+        l->set_im2col_batch_size(params.im2col_batch_size());
+        l->set_direct_convolution(params.direct_convolution());
+        return l;
       }
       LAYOUT_ERR(proto_layer.name(), "deconvolution");
     }
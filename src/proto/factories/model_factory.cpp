@@ -285,6 +285,10 @@ model* construct_model(lbann_comm* comm,
   if (!name.empty()) {
     m->set_name(name);
   }
+  m->set_gradient_bucket_size(proto_model.gradient_bucket_size());
+  m->set_multi_tensor_step(proto_model.multi_tensor_step());
+  m->set_memory_planner(proto_model.memory_planner());
+  m->set_fuse_entrywise_layers(proto_model.fuse_entrywise_layers());
   for (auto t : data_readers) {
     t.second->set_model(m);
   }
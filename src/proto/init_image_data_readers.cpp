@@ -279,6 +279,10 @@ void init_image_preprocessor(const lbann_data::Reader& pb_readme, const bool mas
     set_colorizer(pb_preprocessor, master, pp, channels);
   }
   set_normalizer(pb_preprocessor, master, pp);
+  if (pb_preprocessor.reduced_decoding()) {
+    pp->set_reduced_decoding(true);
+    if (master) std::cout << "image processor: reduced resolution decoding is set" << std::endl;
+  }
 
   // create a data reader
   if (name == "imagenet_patches") {
@@ -174,6 +174,7 @@ void init_data_readers(lbann_comm *comm, const lbann_data::LbannPB& p, std::map<
       reader_csv->set_skip_cols(readme.skip_cols());
       reader_csv->set_skip_rows(readme.skip_rows());
       reader_csv->set_has_header(readme.has_header());
+      reader_csv->set_use_binary_cache(readme.csv_binary_cache());
       reader = reader_csv;
     } else if (name == "numpy") {
       auto* reader_numpy = new numpy_reader(shuffle);
@@ -221,6 +222,7 @@ void init_data_readers(lbann_comm *comm, const lbann_data::LbannPB& p, std::map<
           reader_csv->set_skip_cols(readme.skip_cols());
           reader_csv->set_skip_rows(readme.skip_rows());
           reader_csv->set_has_header(readme.has_header());
+          reader_csv->set_use_binary_cache(readme.csv_binary_cache());
           reader_csv->set_absolute_sample_count( readme.absolute_sample_count() );
           reader_csv->set_use_percent( readme.percent_of_data_to_use() );
           reader_csv->set_first_n( readme.first_n() );
@@ -310,6 +312,8 @@ void init_data_readers(lbann_comm *comm, const lbann_data::LbannPB& p, std::map<
       reader->set_file_dir( readme.data_filedir() );
     }
     reader->set_max_files_to_load( readme.max_files_to_load() );
+    reader->set_zero_fill_tail_only( readme.zero_fill_tail_only() );
+    reader->set_dynamic_fetch_chunk_size( readme.dynamic_fetch_chunk_size() );
     if (readme.data_local_filedir() != "") {
       reader->set_local_file_dir( readme.data_local_filedir() );
     }
@@ -692,6 +696,18 @@ void get_cmdline_overrides(lbann_comm *comm, lbann_data::LbannPB& p)
   if (opts->has_int("num_parallel_readers")) {
     model->set_num_parallel_readers(opts->get_int("num_parallel_readers"));
   }
+  if (opts->has_int("gradient_bucket_size")) {
+    model->set_gradient_bucket_size(opts->get_int("gradient_bucket_size"));
+  }
+  if (opts->has_bool("multi_tensor_step")) {
+    model->set_multi_tensor_step(opts->get_bool("multi_tensor_step"));
+  }
+  if (opts->has_bool("memory_planner")) {
+    model->set_memory_planner(opts->get_bool("memory_planner"));
+  }
+  if (opts->has_bool("fuse_entrywise_layers")) {
+    model->set_fuse_entrywise_layers(opts->get_bool("fuse_entrywise_layers"));
+  }
   if (opts->has_bool("disable_cuda")) {
     model->set_disable_cuda(opts->get_bool("disable_cuda"));
   }
@@ -778,6 +794,10 @@ void print_parameters(lbann_comm *comm, lbann_data::LbannPB& p)
             << "  procs_per_model:         " << m.procs_per_model()  << std::endl
             << "  num_parallel_readers:    " << m.num_parallel_readers()  << std::endl
             << "  serialize_background_io: " << m.serialize_background_io()  << std::endl
+            << "  gradient_bucket_size:    " << m.gradient_bucket_size()  << std::endl
+            << "  multi_tensor_step:       " << m.multi_tensor_step()  << std::endl
+            << "  memory_planner:          " << m.memory_planner()  << std::endl
+            << "  fuse_entrywise_layers:   " << m.fuse_entrywise_layers()  << std::endl
             << "  disable_cuda:            " << m.disable_cuda()  << std::endl
             << "  random_seed:             " << m.random_seed() << std::endl
             << "  data_layout:             " << m.data_layout()  << std::endl
@@ -804,6 +824,14 @@ void print_help(lbann_comm *comm)
        "\n"
        "  To reload from a previous checkpoint you specify --ckpt_dir=<string>\n"
        "\n"
+       "  lbann_inf serves inference requests on a local socket if you specify\n"
+       "  --serve=<string> --serve_layer=<string>\n"
+       "  --serve_layer is the layer whose output is returned for each sample\n"
+       "  --serve_max_batch=<int>       maximum requests per mini-batch\n"
+       "                                (default: mini-batch size)\n"
+       "  --serve_max_delay=<float>     maximum time (in ms) that a request waits\n"
+       "                                for others to join its mini-batch (default: 1)\n"
+       "\n"
        "Some prototext values can be over-riden on the command line;\n"
        "(notes: use '1' or '0' for bool; if no value is given for a flag,\n"
        "        e.g: --disable_cuda, then a value of '1' is assigned)\n"
@@ -818,6 +846,15 @@ void print_help(lbann_comm *comm)
        "  --num_parallel_readers=<int>\n"
        "  --num_io_threads=<int>\n"
        "  --disable_background_io_activity=<bool>\n"
+       "  --gradient_bucket_size=<int>\n"
+       "      size in bytes of buckets for fused gradient allreduces;\n"
+       "      0 disables gradient bucketing\n"
+       "  --multi_tensor_step=<bool>\n"
+       "      apply all CPU optimizers in one fused parallel loop\n"
+       "  --memory_planner=<bool>\n"
+       "      share memory between CPU layer tensors with disjoint lifetimes\n"
+       "  --fuse_entrywise_layers=<bool>\n"
+       "      replace chains of CPU entry-wise layers with fused layers\n"
        "  --disable_cuda=<bool>\n"
        "     has no effect unless lbann was compiled with: LBANN_HAS_CUDNN\n"
        "  --random_seed=<int>\n"
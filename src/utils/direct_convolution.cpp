@@ -0,0 +1,381 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lbann/utils/direct_convolution.hpp"
+#include "lbann/utils/exception.hpp"
+#include <algorithm>
+
+namespace lbann {
+
+namespace {
+
+/** Number of output channels accumulated together in forward prop. */
+constexpr int output_channel_block = 4;
+/** Number of output positions accumulated together in forward prop.
+ *  The accumulator tile has output_channel_block x this many entries
+ *  and should stay in L1 cache.
+ */
+constexpr int output_position_block = 64;
+/** Number of partial sums in backward prop w.r.t. kernel. */
+constexpr int reduction_lanes = 8;
+
+/** Convolution geometry.
+ *  Spatial dimensions are split into "outer" dimensions and the last,
+ *  contiguous dimension. Kernels loop over outer positions and process
+ *  contiguous rows along the last dimension.
+ */
+struct conv_geometry {
+  int num_dims;
+  const int * input_dims;
+  const int * output_dims;
+  const int * window_dims;
+  const int * pads;
+  const int * strides;
+  /** Number of input spatial positions. */
+  int input_size;
+  /** Number of output spatial positions. */
+  int output_size;
+  /** Number of kernel spatial positions. */
+  int window_size;
+  /** Number of output rows along last dimension. */
+  int num_output_rows;
+  /** Number of kernel rows along last dimension. */
+  int num_window_rows;
+  /** Last dimension of input, output, and kernel. */
+  int input_width, output_width, window_width;
+  /** Pad and stride for last dimension. */
+  int pad, stride;
+
+  conv_geometry(int num_dims_,
+                const int * input_dims_,
+                const int * output_dims_,
+                const int * window_dims_,
+                const int * pads_,
+                const int * strides_)
+    : num_dims(num_dims_),
+      input_dims(input_dims_),
+      output_dims(output_dims_),
+      window_dims(window_dims_),
+      pads(pads_),
+      strides(strides_) {
+    if (num_dims < 1) {
+      LBANN_ERROR("direct convolution requires at least one spatial dimension");
+    }
+    input_size = output_size = window_size = 1;
+    for (int d = 0; d < num_dims; ++d) {
+      input_size *= input_dims[d];
+      output_size *= output_dims[d];
+      window_size *= window_dims[d];
+    }
+    input_width = input_dims[num_dims-1];
+    output_width = output_dims[num_dims-1];
+    window_width = window_dims[num_dims-1];
+    pad = pads[num_dims-1];
+    stride = strides[num_dims-1];
+    num_output_rows = output_size / output_width;
+    num_window_rows = window_size / window_width;
+  }
+
+  /** Offset of an input row.
+   *  Returns -1 if the row corresponding to an output row and a
+   *  kernel row is entirely in the zero padding.
+   */
+  int input_row_offset(int output_row, int window_row) const {
+    int offset = 0;
+    for (int d = num_dims - 2; d >= 0; --d) {
+      const int output_pos = output_row % output_dims[d];
+      const int window_pos = window_row % window_dims[d];
+      output_row /= output_dims[d];
+      window_row /= window_dims[d];
+      const int input_pos = output_pos * strides[d] - pads[d] + window_pos;
+      if (input_pos < 0 || input_pos >= input_dims[d]) { return -1; }
+      offset += input_pos * input_stride(d);
+    }
+    return offset;
+  }
+
+  /** Range of output positions along last dimension whose input
+   *  position for a kernel offset is not in the zero padding.
+   */
+  void valid_output_range(int kx, int& lo, int& hi) const {
+    const int first = pad - kx;
+    const int last = input_width - 1 + pad - kx;
+    lo = (first > 0) ? (first + stride - 1) / stride : 0;
+    hi = (last >= 0) ? std::min(last / stride + 1, output_width) : 0;
+    hi = std::max(hi, lo);
+  }
+
+private:
+  /** Stride between input entries along a spatial dimension. */
+  int input_stride(int d) const {
+    int s = 1;
+    for (int i = d + 1; i < num_dims; ++i) { s *= input_dims[i]; }
+    return s;
+  }
+
+};
+
+} // namespace
+
+void direct_convolution_forward(const DataType * input,
+                                int input_ldim,
+                                const DataType * kernel,
+                                DataType * output,
+                                int output_ldim,
+                                int num_samples,
+                                int num_input_channels,
+                                int num_output_channels,
+                                int num_dims,
+                                const int * input_dims,
+                                const int * output_dims,
+                                const int * window_dims,
+                                const int * pads,
+                                const int * strides) {
+  const conv_geometry g(num_dims, input_dims, output_dims,
+                        window_dims, pads, strides);
+  const int kernel_ldim = num_input_channels * g.window_size;
+  const int num_blocks = ((num_output_channels + output_channel_block - 1)
+                          / output_channel_block);
+
+  LBANN_OMP_PARALLEL_FOR_COLLAPSE2
+  for (int sample = 0; sample < num_samples; ++sample) {
+    for (int block = 0; block < num_blocks; ++block) {
+      const int first_oc = block * output_channel_block;
+      const int block_size = std::min(output_channel_block,
+                                      num_output_channels - first_oc);
+      const DataType *__restrict__ x = input + (size_t) sample * input_ldim;
+      DataType *__restrict__ y = output + (size_t) sample * output_ldim;
+      DataType acc[output_channel_block][output_position_block];
+      DataType w[output_channel_block];
+
+      for (int row = 0; row < g.num_output_rows; ++row) {
+        for (int t0 = 0; t0 < g.output_width; t0 += output_position_block) {
+          const int t1 = std::min(t0 + output_position_block, g.output_width);
+          for (int j = 0; j < block_size; ++j) {
+            std::fill(&acc[j][0], &acc[j][0] + (t1 - t0), DataType(0));
+          }
+
+          // Accumulate contributions from each input channel and
+          // kernel position
+          for (int ic = 0; ic < num_input_channels; ++ic) {
+            const DataType *__restrict__ x_channel = x + (size_t) ic * g.input_size;
+            for (int wrow = 0; wrow < g.num_window_rows; ++wrow) {
+              const int offset = g.input_row_offset(row, wrow);
+              if (offset < 0) { continue; }
+              const DataType *__restrict__ x_row = x_channel + offset;
+              for (int kx = 0; kx < g.window_width; ++kx) {
+                int lo, hi;
+                g.valid_output_range(kx, lo, hi);
+                lo = std::max(lo, t0);
+                hi = std::min(hi, t1);
+                if (lo >= hi) { continue; }
+                const int kernel_row = (ic * g.window_size
+                                        + wrow * g.window_width + kx);
+                for (int j = 0; j < block_size; ++j) {
+                  w[j] = kernel[kernel_row + (first_oc + j) * kernel_ldim];
+                }
+                const DataType *__restrict__ x_shifted = x_row + kx - g.pad;
+                if (g.stride == 1) {
+                  for (int j = 0; j < block_size; ++j) {
+                    const DataType wj = w[j];
+                    DataType *__restrict__ acc_j = &acc[j][0] - t0;
+                    for (int ox = lo; ox < hi; ++ox) {
+                      acc_j[ox] += wj * x_shifted[ox];
+                    }
+                  }
+                } else {
+                  for (int j = 0; j < block_size; ++j) {
+                    const DataType wj = w[j];
+                    DataType *__restrict__ acc_j = &acc[j][0] - t0;
+                    for (int ox = lo; ox < hi; ++ox) {
+                      acc_j[ox] += wj * x_shifted[ox * g.stride];
+                    }
+                  }
+                }
+              }
+            }
+          }
+
+          // Write accumulators to output
+          for (int j = 0; j < block_size; ++j) {
+            DataType *__restrict__ y_row = (y + (size_t) (first_oc + j) * g.output_size
+                                            + row * g.output_width);
+            std::copy(&acc[j][0], &acc[j][0] + (t1 - t0), y_row + t0);
+          }
+
+        }
+      }
+    }
+  }
+
+}
+
+void direct_convolution_backward_data(const DataType * gradient_wrt_output,
+                                      int gradient_wrt_output_ldim,
+                                      const DataType * kernel,
+                                      DataType * gradient_wrt_input,
+                                      int gradient_wrt_input_ldim,
+                                      int num_samples,
+                                      int num_input_channels,
+                                      int num_output_channels,
+                                      int num_dims,
+                                      const int * input_dims,
+                                      const int * output_dims,
+                                      const int * window_dims,
+                                      const int * pads,
+                                      const int * strides) {
+  const conv_geometry g(num_dims, input_dims, output_dims,
+                        window_dims, pads, strides);
+  const int kernel_ldim = num_input_channels * g.window_size;
+
+  // Each thread owns an input channel of a sample, so contributions
+  // can be scattered without synchronization
+  LBANN_OMP_PARALLEL_FOR_COLLAPSE2
+  for (int sample = 0; sample < num_samples; ++sample) {
+    for (int ic = 0; ic < num_input_channels; ++ic) {
+      const DataType *__restrict__ dy
+        = gradient_wrt_output + (size_t) sample * gradient_wrt_output_ldim;
+      DataType *__restrict__ dx
+        = (gradient_wrt_input + (size_t) sample * gradient_wrt_input_ldim
+           + (size_t) ic * g.input_size);
+      std::fill(dx, dx + g.input_size, DataType(0));
+
+      for (int row = 0; row < g.num_output_rows; ++row) {
+        for (int wrow = 0; wrow < g.num_window_rows; ++wrow) {
+          const int offset = g.input_row_offset(row, wrow);
+          if (offset < 0) { continue; }
+          DataType *__restrict__ dx_row = dx + offset - g.pad;
+          for (int oc = 0; oc < num_output_channels; ++oc) {
+            const DataType *__restrict__ dy_row
+              = dy + (size_t) oc * g.output_size + row * g.output_width;
+            const DataType *__restrict__ w
+              = (kernel + (size_t) oc * kernel_ldim
+                 + ic * g.window_size + wrow * g.window_width);
+            for (int kx = 0; kx < g.window_width; ++kx) {
+              int lo, hi;
+              g.valid_output_range(kx, lo, hi);
+              const DataType wk = w[kx];
+              DataType *__restrict__ dx_shifted = dx_row + kx;
+              if (g.stride == 1) {
+                for (int ox = lo; ox < hi; ++ox) {
+                  dx_shifted[ox] += wk * dy_row[ox];
+                }
+              } else {
+                for (int ox = lo; ox < hi; ++ox) {
+                  dx_shifted[ox * g.stride] += wk * dy_row[ox];
+                }
+              }
+            }
+          }
+        }
+      }
+
+    }
+  }
+
+}
+
+void direct_convolution_backward_filter(const DataType * input,
+                                        int input_ldim,
+                                        const DataType * gradient_wrt_output,
+                                        int gradient_wrt_output_ldim,
+                                        DataType * kernel_gradient,
+                                        int num_samples,
+                                        int num_input_channels,
+                                        int num_output_channels,
+                                        int num_dims,
+                                        const int * input_dims,
+                                        const int * output_dims,
+                                        const int * window_dims,
+                                        const int * pads,
+                                        const int * strides) {
+  const conv_geometry g(num_dims, input_dims, output_dims,
+                        window_dims, pads, strides);
+  const int kernel_ldim = num_input_channels * g.window_size;
+
+  // Each thread owns the kernel entries for a pair of input and
+  // output channels, so contributions from all samples are summed
+  // without synchronization
+  LBANN_OMP_PARALLEL_FOR_COLLAPSE2
+  for (int oc = 0; oc < num_output_channels; ++oc) {
+    for (int ic = 0; ic < num_input_channels; ++ic) {
+      DataType *__restrict__ dw
+        = kernel_gradient + (size_t) oc * kernel_ldim + ic * g.window_size;
+      std::fill(dw, dw + g.window_size, DataType(0));
+
+      for (int sample = 0; sample < num_samples; ++sample) {
+        const DataType *__restrict__ x
+          = (input + (size_t) sample * input_ldim
+             + (size_t) ic * g.input_size);
+        const DataType *__restrict__ dy
+          = (gradient_wrt_output + (size_t) sample * gradient_wrt_output_ldim
+             + (size_t) oc * g.output_size);
+        for (int row = 0; row < g.num_output_rows; ++row) {
+          const DataType *__restrict__ dy_row = dy + row * g.output_width;
+          for (int wrow = 0; wrow < g.num_window_rows; ++wrow) {
+            const int offset = g.input_row_offset(row, wrow);
+            if (offset < 0) { continue; }
+            const DataType *__restrict__ x_row = x + offset - g.pad;
+            DataType *__restrict__ dw_row = dw + wrow * g.window_width;
+            for (int kx = 0; kx < g.window_width; ++kx) {
+              int lo, hi;
+              g.valid_output_range(kx, lo, hi);
+              const DataType *__restrict__ x_shifted = x_row + kx;
+              DataType sum = 0;
+              if (g.stride == 1) {
+                // Independent partial sums allow the reduction to be
+                // vectorized without reassociating floating-point
+                // operations
+                DataType partial[reduction_lanes] = {};
+                int ox = lo;
+                for (; ox + reduction_lanes <= hi; ox += reduction_lanes) {
+                  for (int l = 0; l < reduction_lanes; ++l) {
+                    partial[l] += dy_row[ox+l] * x_shifted[ox+l];
+                  }
+                }
+                for (; ox < hi; ++ox) {
+                  sum += dy_row[ox] * x_shifted[ox];
+                }
+                for (int l = 0; l < reduction_lanes; ++l) {
+                  sum += partial[l];
+                }
+              } else {
+                for (int ox = lo; ox < hi; ++ox) {
+                  sum += dy_row[ox] * x_shifted[ox * g.stride];
+                }
+              }
+              dw_row[kx] += sum;
+            }
+          }
+        }
+      }
+
+    }
+  }
+
+}
+
+} // namespace lbann
@@ -39,12 +39,11 @@ void im2col(const CPUMat& im,
             const int * window_strides) {
 
   // Input and output parameters
-  const int col_height = col.Height();
-  const int col_width = col.Width();
   const DataType *__restrict__ im_buffer = im.LockedBuffer();
   DataType *__restrict__ col_buffer = col.Buffer();
 
-  // im2col parameters
+  #ifdef LBANN_DEBUG
+  // Window offsets, only needed to check col dimensions
   std::vector<int> offset_start(im_num_dims);
   std::vector<int> offset_end(im_num_dims);
   std::vector<int> offset_stride(im_num_dims);
@@ -55,9 +54,9 @@ void im2col(const CPUMat& im,
     offset_stride[d] = window_strides[d];
     offset_num[d] = (offset_end[d] - offset_start[d] + offset_stride[d] - 1) / offset_stride[d];
   }
-
-  #ifdef LBANN_DEBUG
   const int im_size = im.Height();
+  const int col_height = col.Height();
+  const int col_width = col.Width();
   // Check matrix dimensions
   const int expected_im_size = std::accumulate(im_dims,
                                                im_dims + im_num_dims,
@@ -106,49 +105,10 @@ void im2col(const CPUMat& im,
     return;
   }
 
-  // Iterate through col matrix columns
-  LBANN_OMP_PARALLEL_FOR
-  for(int col_col = 0; col_col < col_width; ++col_col) {
-
-    // Initialize arrays
-    std::vector<int> offset_pos(im_num_dims);
-    std::vector<int> window_pos(im_num_dims);
-
-    // Get position of current offset
-    int col_col_remainder = col_col;
-    for(int d = im_num_dims-1; d >= 0; --d) {
-      const int offset = col_col_remainder % offset_num[d];
-      offset_pos[d] = offset_start[d] + offset * offset_stride[d];
-      col_col_remainder /= offset_num[d];
-    }
-
-    // Iterate through col matrix entries
-    for(int col_row = 0; col_row < col_height; ++col_row) {
-      const int col_index = col_row + col_col * col_height;
-
-      // Get position in window and channel
-      int col_row_remainder = col_row;
-      for(int d = im_num_dims-1; d >= 0; --d) {
-        window_pos[d] = col_row_remainder % window_dims[d];
-        col_row_remainder /= window_dims[d];
-      }
-      const int channel = col_row_remainder;
-
-      // Get im matrix entry
-      bool im_pos_valid = true;
-      int im_index = channel;
-      for(int d = 0; d < im_num_dims; ++d) {
-        const int im_pos = offset_pos[d] + window_pos[d];
-        im_pos_valid = im_pos_valid && 0 <= im_pos && im_pos < im_dims[d];
-        im_index = im_pos + im_index * im_dims[d];
-      }
-
-      // Copy im matrix entry to col matrix if valid
-      col_buffer[col_index] = (im_pos_valid ?
-                               im_buffer[im_index] : DataType(0));
-
-    }
-  }
+  // Call optimized routine for N-D data
+  im2col_nd(im_buffer, col_buffer,
+            num_channels, im_num_dims, im_dims, im_pads,
+            window_dims, window_strides);
 
 }
 
@@ -165,7 +125,8 @@ void col2im(const CPUMat& col,
   const DataType *__restrict__ col_buffer = col.LockedBuffer();
   DataType *__restrict__ im_buffer = im.Buffer();
 
-  // col2im parameters
+  #ifdef LBANN_DEBUG
+  // Window offsets, only needed to check col dimensions
   std::vector<int> offset_start(im_num_dims);
   std::vector<int> offset_end(im_num_dims);
   std::vector<int> offset_stride(im_num_dims);
@@ -176,8 +137,6 @@ void col2im(const CPUMat& col,
     offset_stride[d] = window_strides[d];
     offset_num[d] = (offset_end[d] - offset_start[d] + offset_stride[d] - 1) / offset_stride[d];
   }
-
-  #ifdef LBANN_DEBUG
   const int im_size = im.Height();
   const int col_height = col.Height();
   const int col_width = col.Width();
@@ -229,6 +188,15 @@ void col2im(const CPUMat& col,
     return;
   }
 
+  // Call optimized routine for N-D data if there are enough
+  // channels to keep every thread busy
+  if(num_channels >= omp_get_max_threads()) {
+    col2im_nd(col_buffer, im_buffer,
+              num_channels, im_num_dims, im_dims, im_pads,
+              window_dims, window_strides);
+    return;
+  }
+
   // Default algorithm
   col2im(col, im, num_channels, im_num_dims,
          im_dims, im_pads, window_dims, window_strides,
@@ -426,6 +394,239 @@ void im2col_2d(const DataType *__restrict__ input_buffer,
 
 }
 
+void im2col_nd(const DataType *__restrict__ input_buffer,
+               DataType *__restrict__ output_buffer,
+               const int num_channels,
+               const int num_dims,
+               const int * input_dims,
+               const int * input_pads,
+               const int * window_dims,
+               const int * offset_strides) {
+
+  // im2col parameters
+  std::vector<int> offset_start(num_dims);
+  std::vector<int> offset_num(num_dims);
+  for(int d = 0; d < num_dims; ++d) {
+    const int offset_end = input_dims[d] + input_pads[d] - window_dims[d] + 1;
+    offset_start[d] = -input_pads[d];
+    offset_num[d] = (offset_end - offset_start[d] + offset_strides[d] - 1) / offset_strides[d];
+  }
+  const int last_dim = num_dims - 1;
+  const int last_input_dim = input_dims[last_dim];
+  const int last_window_dim = window_dims[last_dim];
+  const int window_size = std::accumulate(window_dims,
+                                          window_dims + num_dims,
+                                          1,
+                                          std::multiplies<int>());
+  const int num_window_rows = window_size / last_window_dim;
+  const int input_channel_size = std::accumulate(input_dims,
+                                                 input_dims + num_dims,
+                                                 1,
+                                                 std::multiplies<int>());
+  const int output_height = num_channels * window_size;
+  const int output_width = std::accumulate(offset_num.begin(),
+                                           offset_num.end(),
+                                           1,
+                                           std::multiplies<int>());
+
+  // Work is split into tiles of output columns for each channel.
+  // Each (tile, channel) pair writes a disjoint set of contiguous
+  // output blocks, so no synchronization is needed.
+  const int tile_size = 32;
+  const int num_tiles = (output_width + tile_size - 1) / tile_size;
+
+  LBANN_OMP_PARALLEL_FOR
+  for(int task = 0; task < num_tiles * num_channels; ++task) {
+    const int channel = task % num_channels;
+    const int tile = task / num_channels;
+    const int first_col = tile * tile_size;
+    const int last_col = std::min(first_col + tile_size, output_width);
+    const DataType *__restrict__ input_channel
+      = &input_buffer[channel * input_channel_size];
+
+    // Workspace
+    std::vector<int> offset_pos(num_dims);
+    std::vector<int> window_pos(num_dims, 0);
+
+    for(int output_col = first_col; output_col < last_col; ++output_col) {
+
+      // Get position of current offset
+      int output_col_remainder = output_col;
+      for(int d = last_dim; d >= 0; --d) {
+        const int offset = output_col_remainder % offset_num[d];
+        offset_pos[d] = offset_start[d] + offset * offset_strides[d];
+        output_col_remainder /= offset_num[d];
+      }
+      DataType *__restrict__ output_block
+        = &output_buffer[channel * window_size + output_col * output_height];
+
+      // Valid range of window positions in the last dimension
+      const int last_offset_pos = offset_pos[last_dim];
+      const int valid_begin = std::min(std::max(-last_offset_pos, 0),
+                                       last_window_dim);
+      const int valid_end = std::max(std::min(last_input_dim - last_offset_pos,
+                                              last_window_dim),
+                                     valid_begin);
+
+      // Iterate through window rows, i.e. window positions in all
+      // but the last dimension. Each window row is a contiguous run
+      // in both the input and output.
+      std::fill(window_pos.begin(), window_pos.end(), 0);
+      for(int window_row = 0; window_row < num_window_rows; ++window_row) {
+        DataType *__restrict__ output_run = &output_block[window_row * last_window_dim];
+
+        // Get input position of window row
+        bool input_pos_valid = true;
+        int input_index = 0;
+        for(int d = 0; d < last_dim; ++d) {
+          const int input_pos = offset_pos[d] + window_pos[d];
+          input_pos_valid = input_pos_valid && 0 <= input_pos && input_pos < input_dims[d];
+          input_index = input_pos + input_index * input_dims[d];
+        }
+        input_index = last_offset_pos + input_index * last_input_dim;
+
+        // Copy window row, zeroing entries in the padding
+        if(input_pos_valid) {
+          for(int i = 0; i < valid_begin; ++i) {
+            output_run[i] = DataType(0);
+          }
+          const DataType *__restrict__ input_run = &input_channel[input_index + valid_begin];
+          const int valid_size = valid_end - valid_begin;
+          for(int i = 0; i < valid_size; ++i) {
+            output_run[valid_begin + i] = input_run[i];
+          }
+          for(int i = valid_end; i < last_window_dim; ++i) {
+            output_run[i] = DataType(0);
+          }
+        } else {
+          for(int i = 0; i < last_window_dim; ++i) {
+            output_run[i] = DataType(0);
+          }
+        }
+
+        // Move to next window row
+        for(int d = last_dim - 1; d >= 0; --d) {
+          if(++window_pos[d] < window_dims[d]) { break; }
+          window_pos[d] = 0;
+        }
+
+      }
+
+    }
+
+  }
+
+}
+
+void col2im_nd(const DataType *__restrict__ input_buffer,
+               DataType *__restrict__ output_buffer,
+               const int num_channels,
+               const int num_dims,
+               const int * output_dims,
+               const int * output_pads,
+               const int * window_dims,
+               const int * offset_strides) {
+
+  // col2im parameters
+  std::vector<int> offset_start(num_dims);
+  std::vector<int> offset_num(num_dims);
+  for(int d = 0; d < num_dims; ++d) {
+    const int offset_end = output_dims[d] + output_pads[d] - window_dims[d] + 1;
+    offset_start[d] = -output_pads[d];
+    offset_num[d] = (offset_end - offset_start[d] + offset_strides[d] - 1) / offset_strides[d];
+  }
+  const int last_dim = num_dims - 1;
+  const int last_output_dim = output_dims[last_dim];
+  const int last_window_dim = window_dims[last_dim];
+  const int window_size = std::accumulate(window_dims,
+                                          window_dims + num_dims,
+                                          1,
+                                          std::multiplies<int>());
+  const int num_window_rows = window_size / last_window_dim;
+  const int output_channel_size = std::accumulate(output_dims,
+                                                  output_dims + num_dims,
+                                                  1,
+                                                  std::multiplies<int>());
+  const int input_height = num_channels * window_size;
+  const int input_width = std::accumulate(offset_num.begin(),
+                                          offset_num.end(),
+                                          1,
+                                          std::multiplies<int>());
+
+  // Each channel of the output only receives contributions from its
+  // own block of input rows, so channels are processed
+  // independently. Within a channel, window rows are accumulated as
+  // contiguous runs.
+  LBANN_OMP_PARALLEL_FOR
+  for(int channel = 0; channel < num_channels; ++channel) {
+    DataType *__restrict__ output_channel
+      = &output_buffer[channel * output_channel_size];
+    std::fill(output_channel, output_channel + output_channel_size, DataType(0));
+
+    // Workspace
+    std::vector<int> offset_pos(num_dims);
+    std::vector<int> window_pos(num_dims, 0);
+
+    for(int input_col = 0; input_col < input_width; ++input_col) {
+
+      // Get position of current offset
+      int input_col_remainder = input_col;
+      for(int d = last_dim; d >= 0; --d) {
+        const int offset = input_col_remainder % offset_num[d];
+        offset_pos[d] = offset_start[d] + offset * offset_strides[d];
+        input_col_remainder /= offset_num[d];
+      }
+      const DataType *__restrict__ input_block
+        = &input_buffer[channel * window_size + input_col * input_height];
+
+      // Valid range of window positions in the last dimension
+      const int last_offset_pos = offset_pos[last_dim];
+      const int valid_begin = std::min(std::max(-last_offset_pos, 0),
+                                       last_window_dim);
+      const int valid_end = std::max(std::min(last_output_dim - last_offset_pos,
+                                              last_window_dim),
+                                     valid_begin);
+      const int valid_size = valid_end - valid_begin;
+
+      // Accumulate window rows into output
+      std::fill(window_pos.begin(), window_pos.end(), 0);
+      for(int window_row = 0; window_row < num_window_rows; ++window_row) {
+
+        // Get output position of window row
+        bool output_pos_valid = true;
+        int output_index = 0;
+        for(int d = 0; d < last_dim; ++d) {
+          const int output_pos = offset_pos[d] + window_pos[d];
+          output_pos_valid = output_pos_valid && 0 <= output_pos && output_pos < output_dims[d];
+          output_index = output_pos + output_index * output_dims[d];
+        }
+        output_index = last_offset_pos + output_index * last_output_dim;
+
+        // Add window row to output
+        if(output_pos_valid) {
+          const DataType *__restrict__ input_run
+            = &input_block[window_row * last_window_dim + valid_begin];
+          DataType *__restrict__ output_run
+            = &output_channel[output_index + valid_begin];
+          for(int i = 0; i < valid_size; ++i) {
+            output_run[i] += input_run[i];
+          }
+        }
+
+        // Move to next window row
+        for(int d = last_dim - 1; d >= 0; --d) {
+          if(++window_pos[d] < window_dims[d]) { break; }
+          window_pos[d] = 0;
+        }
+
+      }
+
+    }
+
+  }
+
+}
+
 void col2im_1x1(const DataType * input_buffer,
                 DataType * output_buffer,
                 const int num_channels,
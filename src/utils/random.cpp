@@ -54,10 +54,66 @@ extern lbann::rng_gen data_seq_generator;
 #pragma omp threadprivate(data_seq_generator)
 lbann::rng_gen data_seq_generator;
 #endif
+
+/** Seed for counter-based random number generators. */
+uint32_t counter_rng_seed = 0;
+/** Number of calls to procdet fill functions since seeding.
+ *  Used as the step for their counter-based generator.
+ */
+uint64_t procdet_fill_count = 0;
 }
 
 namespace lbann {
 
+namespace {
+
+/** Fill a matrix with a counter-based generator.
+ *  Each entry is computed from the random numbers for the block of
+ *  global entries that contains it, so the result does not depend on
+ *  the matrix distribution. The seed and step are taken from the
+ *  grid's root process since processes may be seeded differently
+ *  (e.g. with a rank-dependent seed or a seed of -1).
+ */
+template <typename Transform>
+void counter_rng_fill(AbsDistMat& mat, El::Int m, El::Int n,
+                      El::Int entries_per_block, Transform transform) {
+  mat.Resize(m, n);
+  El::Int key[2] = {El::Int(get_counter_rng_seed()),
+                    El::Int(::procdet_fill_count++)};
+  El::mpi::Broadcast(key, 2, 0, mat.Grid().Comm(),
+                     El::SyncInfo<El::Device::CPU>{});
+  const counter_rng rng(uint32_t(key[0]),
+                        get_counter_rng_stream("procdet_fill"));
+  const uint64_t step = key[1];
+
+  // Generate local entries on CPU
+  const El::Int local_height = mat.LocalHeight();
+  const El::Int local_width = mat.LocalWidth();
+  const El::Int col_shift = mat.ColShift();
+  const El::Int col_stride = mat.ColStride();
+  const El::Int row_shift = mat.RowShift();
+  const El::Int row_stride = mat.RowStride();
+  const bool on_cpu = (mat.GetLocalDevice() == El::Device::CPU);
+  CPUMat cpu_vals;
+  if (!on_cpu) { cpu_vals.Resize(local_height, local_width); }
+  auto& local_vals = (on_cpu ?
+                      static_cast<CPUMat&>(mat.Matrix()) :
+                      cpu_vals);
+  LBANN_OMP_PARALLEL_FOR
+  for (El::Int col = 0; col < local_width; ++col) {
+    const uint64_t global_col = row_shift + col * row_stride;
+    for (El::Int row = 0; row < local_height; ++row) {
+      const uint64_t global_row = col_shift + row * col_stride;
+      const uint64_t index = global_row + global_col * m;
+      const auto r = rng(step, index / entries_per_block);
+      local_vals(row, col) = transform(r, index % entries_per_block);
+    }
+  }
+  if (!on_cpu) { El::Copy(cpu_vals, mat.Matrix()); }
+}
+
+} // namespace
+
 rng_gen& get_generator() {
   return ::generator;
 }
@@ -70,6 +126,19 @@ rng_gen& get_data_seq_generator() {
   return ::data_seq_generator;
 }
 
+uint32_t get_counter_rng_seed() {
+  return ::counter_rng_seed;
+}
+
+uint32_t get_counter_rng_stream(const std::string& name) {
+  // 32-bit FNV-1a hash
+  uint32_t hash = 2166136261u;
+  for (const auto& c : name) {
+    hash = (hash ^ uint32_t((unsigned char) c)) * 16777619u;
+  }
+  return hash;
+}
+
 bool save_rng_to_checkpoint_shared(persist& p, const lbann_comm* comm) {
   std::string dirname = std::string(p.m_checkpoint_dir) + "/rng_state";
   makedir(dirname.c_str());
@@ -174,6 +243,8 @@ void init_random(int seed, lbann_comm *comm) {
     get_generator().seed(seed);
     get_fast_generator().seed(seed);
 #endif
+    ::counter_rng_seed = seed;
+    ::procdet_fill_count = 0;
 #ifdef LBANN_SET_EL_RNG
     if (comm != nullptr) {
       El::Generator().seed(seed ^ comm->get_rank_in_model());
@@ -195,6 +266,8 @@ void init_random(int seed, lbann_comm *comm) {
     get_generator().seed(rand_val);
     get_fast_generator().seed(rand_val);
 #endif
+    ::counter_rng_seed = rand_val;
+    ::procdet_fill_count = 0;
 #ifdef LBANN_SET_EL_RNG
     El::Generator().seed(rand_val);
 #endif
@@ -248,50 +321,35 @@ void uniform_fill(AbsDistMat& mat, El::Int m, El::Int n, DataType center,
 
 void gaussian_fill_procdet(AbsDistMat& mat, El::Int m, El::Int n, DataType mean,
                            DataType stddev) {
-  CircMat<El::Device::CPU> vals(m, n, mat.Grid(), 0);
-  if (vals.Participating()) {
-    auto& local_vals = vals.Matrix();
-    auto& gen = get_generator();
-    std::normal_distribution<DataType> dist(mean, stddev);
-    for (El::Int col = 0; col < local_vals.Width(); ++col) {
-      for (El::Int row = 0; row < local_vals.Height(); ++row) {
-        local_vals(row, col) = dist(gen);
-      }
-    }
-  }
-  El::Copy(vals, mat);
+  // Box-Muller transform, two entries per block
+  const DataType two_pi = 6.283185307179586;
+  counter_rng_fill(mat, m, n, 2,
+                   [mean, stddev, two_pi](const counter_rng::result_type& r,
+                                          El::Int i) -> DataType {
+                     const DataType u1 = 1 - counter_rng::to_uniform(r[2*i]);
+                     const DataType u2 = counter_rng::to_uniform(r[2*i+1]);
+                     return (mean + stddev * std::sqrt(-2 * std::log(u1))
+                             * std::cos(two_pi * u2));
+                   });
 }
 
 void bernoulli_fill_procdet(AbsDistMat& mat, El::Int m, El::Int n, double p) {
-  CircMat<El::Device::CPU> vals(m, n, mat.Grid(), 0);
-  if (vals.Participating()) {
-    auto& local_vals = vals.Matrix();
-    auto& gen = get_generator();
-    std::bernoulli_distribution dist(p);
-    for (El::Int col = 0; col < local_vals.Width(); ++col) {
-      for (El::Int row = 0; row < local_vals.Height(); ++row) {
-        local_vals(row, col) = dist(gen);
-      }
-    }
-  }
-  El::Copy(vals, mat);
+  const uint64_t threshold = counter_rng::bernoulli_threshold(p);
+  counter_rng_fill(mat, m, n, 4,
+                   [threshold](const counter_rng::result_type& r,
+                               El::Int i) -> DataType {
+                     return r[i] < threshold ? DataType(1) : DataType(0);
+                   });
 }
 
 void uniform_fill_procdet(AbsDistMat& mat, El::Int m, El::Int n, DataType center,
                           DataType radius) {
-  CircMat<El::Device::CPU> vals(m, n, mat.Grid(), 0);
-  if (vals.Participating()) {
-    auto& local_vals = vals.Matrix();
-    auto& gen = get_generator();
-    std::uniform_real_distribution<DataType> dist(center - radius,
-                                                  center + radius);
-    for (El::Int col = 0; col < local_vals.Width(); ++col) {
-      for (El::Int row = 0; row < local_vals.Height(); ++row) {
-        local_vals(row, col) = dist(gen);
-      }
-    }
-  }
-  El::Copy(vals, mat);
+  counter_rng_fill(mat, m, n, 4,
+                   [center, radius](const counter_rng::result_type& r,
+                                    El::Int i) -> DataType {
+                     return (center - radius
+                             + 2 * radius * counter_rng::to_uniform(r[i]));
+                   });
 }
 
 }  // namespace lbann
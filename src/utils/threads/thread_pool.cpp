@@ -5,10 +5,22 @@
 
 namespace lbann {
 
+namespace {
+
+/** \brief Pool that owns the calling thread, if any */
+thread_local const thread_pool* current_pool_ = nullptr;
+/** \brief Local id of the calling thread within its pool */
+thread_local int current_tid_ = -1;
+
+}// namespace
+
 thread_pool::thread_pool()
-  : thread_joiner_{threads_},
+  : num_pending_tasks_{0},
+    num_sleeping_threads_{0},
+    next_queue_{0},
     all_work_done_{false},
-    m_threads_offset{0}
+    m_threads_offset{0},
+    thread_joiner_{threads_}
 {
 }
 
@@ -21,13 +33,14 @@ thread_pool::thread_pool(size_type max_threads)
 
 void thread_pool::launch_threads(size_type num_threads)
 {
+  setup_task_queues_(num_threads);
   threads_.reserve(num_threads);
 
   // Try to launch each worker thread
   try
   {
     for (size_type cnt = 0; cnt < num_threads; ++cnt) {
-      threads_.emplace_back(&thread_pool::do_thread_work_,this);
+      threads_.emplace_back(&thread_pool::do_thread_work_,this, cnt);
     }
   }
   catch(...)
@@ -38,9 +51,8 @@ void thread_pool::launch_threads(size_type num_threads)
 }
 
 void thread_pool::launch_pinned_threads(size_type num_threads, int cpu_offset) {
+  setup_task_queues_(num_threads);
   threads_.reserve(num_threads);
-  m_work_group.reserve(num_threads);
-  m_thread_id_to_local_id_map.reserve(num_threads);
 
   m_threads_offset = cpu_offset;
 
@@ -77,19 +89,16 @@ void thread_pool::launch_pinned_threads(size_type num_threads, int cpu_offset) {
 }
 
 void thread_pool::reap_threads() {
+  // Workers drain their queues before exiting
   all_work_done_ = true;
-  do {
-    global_work_queue_.wake_all(true);
-  }while(!global_work_queue_.empty());
+  wake_all_threads_();
 
   for (auto& t : threads_) if (t.joinable()) t.join();
 
-  m_work_group.clear();
-  m_thread_id_to_local_id_map.clear();
   threads_.clear();
+  task_queues_.clear();
   /// Reset the flag so that new threads can be started
   all_work_done_ = false;
-  global_work_queue_.set_stop_threads(false);
   return;
 }
 
@@ -99,15 +108,115 @@ void thread_pool::relaunch_pinned_threads(size_type num_threads) {
   return;
 }
 
-void thread_pool::do_thread_work_()
+void thread_pool::setup_task_queues_(size_type num_threads)
+{
+  if (!threads_.empty()) {
+    LBANN_ERROR("attempted to launch threads in a thread pool "
+                "that already has threads; reap them first");
+  }
+  task_queues_.clear();
+  for (size_type cnt = 0; cnt < num_threads; ++cnt) {
+    task_queues_.emplace_back(make_unique<work_stealing_queue<task_>>());
+  }
+  num_pending_tasks_ = 0;
+  next_queue_ = 0;
+}
+
+void thread_pool::push_task_(type_erased_function func, const work_group* group)
+{
+  const auto num_queues = task_queues_.size();
+  if (num_queues == 0) {
+    LBANN_ERROR("attempted to submit a job to a thread pool without threads");
+  }
+
+  // Workers keep their own jobs; other threads spread them out
+  const int tid = get_worker_id_();
+  const size_type queue_id = (tid >= 0 ?
+                              static_cast<size_type>(tid) :
+                              next_queue_++ % num_queues);
+  task_queues_[queue_id]->push_back(task_{std::move(func), group});
+
+  // Only take the lock if a worker may be waiting. Workers announce
+  // themselves before checking for pending tasks, so either they see
+  // this task or we see them.
+  ++num_pending_tasks_;
+  if (num_sleeping_threads_ > 0) {
+    { std::lock_guard<std::mutex> lk(sleep_mtx_); }
+    work_available_.notify_one();
+  }
+}
+
+std::unique_ptr<thread_pool::task_> thread_pool::get_task_(int tid)
 {
-  while (not all_work_done_)
+  const auto num_queues = task_queues_.size();
+
+  // Newest task from own queue
+  auto task = task_queues_[tid]->try_pop_back();
+
+  // Oldest task from another worker's queue
+  for (size_type i = 1; !task && i < num_queues; ++i) {
+    if (num_pending_tasks_ <= 0) { break; }
+    task = task_queues_[(tid + i) % num_queues]->try_steal();
+  }
+
+  if (task) { --num_pending_tasks_; }
+  return task;
+}
+
+bool thread_pool::run_group_task_(const work_group& group)
+{
+  const auto num_queues = task_queues_.size();
+  const int tid = get_worker_id_();
+  const size_type first = (tid >= 0 ? static_cast<size_type>(tid) : 0);
+  const auto in_group = [&group](const task_& t) { return t.group == &group; };
+  for (size_type i = 0; i < num_queues; ++i) {
+    auto task = task_queues_[(first + i) % num_queues]->try_remove_if(in_group);
+    if (task) {
+      --num_pending_tasks_;
+      task->func();
+      return true;
+    }
+  }
+  return false;
+}
+
+void thread_pool::wake_all_threads_()
+{
+  { std::lock_guard<std::mutex> lk(sleep_mtx_); }
+  work_available_.notify_all();
+}
+
+int thread_pool::get_worker_id_() const
+{
+  return (current_pool_ == this ? current_tid_ : -1);
+}
+
+void thread_pool::do_thread_work_(int tid)
+{
+  current_pool_ = this;
+  current_tid_ = tid;
+
+  while (true)
   {
-    auto task = global_work_queue_.wait_and_pop();
+    auto task = get_task_(tid);
     if (task) {
-      (*task)();
+      task->func();
+      continue;
+    }
+
+    // Sleep until there is more work or the pool shuts down
+    std::unique_lock<std::mutex> lk(sleep_mtx_);
+    ++num_sleeping_threads_;
+    work_available_.wait(lk, [&]{ return (num_pending_tasks_ > 0
+                                          || all_work_done_); });
+    --num_sleeping_threads_;
+    if (all_work_done_ && num_pending_tasks_ <= 0) {
+      break;
     }
   }
+
+  current_pool_ = nullptr;
+  current_tid_ = -1;
 }
 
 void thread_pool::do_thread_work_pinned_thread_(int tid, cpu_set_t cpu_set)
@@ -118,24 +227,12 @@ void thread_pool::do_thread_work_pinned_thread_(int tid, cpu_set_t cpu_set)
     std::cerr << "error in pthread_setaffinity_np, error=" << error << std::endl;
   }
 
-  {
-    std::lock_guard<std::mutex> guard(m_thread_map_mutex);
-    // Establish a local thread id
-    std::thread::id this_id = std::this_thread::get_id();
-    m_thread_id_to_local_id_map[this_id] = tid;
-  }
-  while (not all_work_done_)
-  {
-    auto task = global_work_queue_.wait_and_pop();
-    if (task) {
-      (*task)();
-    }
-  }
+  do_thread_work_(tid);
 }
 
 int thread_pool::get_local_thread_id() {
-  std::thread::id this_id = std::this_thread::get_id();
-  return m_thread_id_to_local_id_map[this_id];
+  const int tid = get_worker_id_();
+  return (tid >= 0 ? tid : 0);
 }
 
 }// namespace lbann
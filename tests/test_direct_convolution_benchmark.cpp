@@ -0,0 +1,235 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+//
+// test_direct_convolution_benchmark.cpp - benchmark for CPU convolution
+//
+// Compares the direct convolution kernels against the im2col GEMM
+// algorithm used by base_convolution_layer, on convolution shapes
+// taken from LeNet, AlexNet, and ResNet-50. For each shape, forward
+// prop, backward prop w.r.t. data, and backward prop w.r.t. the
+// kernel are timed and the maximum difference between the two
+// algorithms is reported.
+//
+// Usage: test_direct_convolution_benchmark [mini_batch_size] [num_iterations]
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lbann/base.hpp"
+#include "lbann/utils/direct_convolution.hpp"
+#include "lbann/utils/im2col.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace lbann;
+
+namespace {
+
+/** 2D convolution shape. */
+struct conv_shape {
+  std::string name;
+  int input_channels;
+  int output_channels;
+  int height;
+  int width;
+  int kernel;
+  int pad;
+  int stride;
+};
+
+/** Average run time (ms) of a function. */
+double time_ms(const std::function<void()>& f, int num_iterations) {
+  f(); // Warm up
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_iterations; ++i) { f(); }
+  const std::chrono::duration<double, std::milli> elapsed
+    = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / num_iterations;
+}
+
+/** Maximum entry-wise difference between two matrices. */
+DataType max_diff(const CPUMat& a, const CPUMat& b) {
+  DataType diff = 0;
+  for (El::Int col = 0; col < a.Width(); ++col) {
+    for (El::Int row = 0; row < a.Height(); ++row) {
+      diff = std::max(diff, std::abs(a(row, col) - b(row, col)));
+    }
+  }
+  return diff;
+}
+
+void benchmark(const conv_shape& s, int mb_size, int num_iterations) {
+
+  // Tensor dimensions
+  const int output_height = (s.height + 2 * s.pad - s.kernel) / s.stride + 1;
+  const int output_width = (s.width + 2 * s.pad - s.kernel) / s.stride + 1;
+  const std::vector<int> input_dims = {s.height, s.width};
+  const std::vector<int> output_dims = {output_height, output_width};
+  const std::vector<int> window_dims = {s.kernel, s.kernel};
+  const std::vector<int> pads = {s.pad, s.pad};
+  const std::vector<int> strides = {s.stride, s.stride};
+  const int input_size = s.height * s.width;
+  const int output_size = output_height * output_width;
+  const int window_size = s.kernel * s.kernel;
+
+  // Initialize matrices
+  const int k = s.input_channels * window_size;
+  CPUMat x, dy, w;
+  El::Uniform(x, s.input_channels * input_size, mb_size);
+  El::Uniform(dy, s.output_channels * output_size, mb_size);
+  El::Uniform(w, k, s.output_channels);
+  CPUMat y_gemm(s.output_channels * output_size, mb_size);
+  CPUMat y_direct(s.output_channels * output_size, mb_size);
+  CPUMat dx_gemm(s.input_channels * input_size, mb_size);
+  CPUMat dx_direct(s.input_channels * input_size, mb_size);
+  CPUMat dw_gemm(k, s.output_channels), dw_direct(k, s.output_channels);
+  CPUMat col(k, output_size), col_t(k, output_size);
+
+  // im2col GEMM algorithms, as in base_convolution_layer
+  auto fp_gemm = [&] {
+    for (int j = 0; j < mb_size; ++j) {
+      const auto& x_j = El::LockedView(x, El::ALL, El::IR(j));
+      CPUMat y_j(output_size, s.output_channels, y_gemm.Buffer(0, j), output_size);
+      im2col(x_j, col, s.input_channels, 2, input_dims.data(),
+             pads.data(), window_dims.data(), strides.data());
+      El::Gemm(El::TRANSPOSE, El::NORMAL,
+               DataType(1), col, w, DataType(0), y_j);
+    }
+  };
+  auto bp_data_gemm = [&] {
+    for (int j = 0; j < mb_size; ++j) {
+      CPUMat dy_j;
+      dy_j.LockedAttach(output_size, s.output_channels,
+                        dy.LockedBuffer(0, j), output_size);
+      auto dx_j = El::View(dx_gemm, El::ALL, El::IR(j));
+      El::Gemm(El::NORMAL, El::TRANSPOSE,
+               DataType(1), w, dy_j, DataType(0), col_t);
+      col2im(col_t, dx_j, s.input_channels, 2, input_dims.data(),
+             pads.data(), window_dims.data(), strides.data());
+    }
+  };
+  auto bp_filter_gemm = [&] {
+    El::Zero(dw_gemm);
+    for (int j = 0; j < mb_size; ++j) {
+      const auto& x_j = El::LockedView(x, El::ALL, El::IR(j));
+      CPUMat dy_j;
+      dy_j.LockedAttach(output_size, s.output_channels,
+                        dy.LockedBuffer(0, j), output_size);
+      im2col(x_j, col, s.input_channels, 2, input_dims.data(),
+             pads.data(), window_dims.data(), strides.data());
+      El::Gemm(El::NORMAL, El::NORMAL,
+               DataType(1), col, dy_j, DataType(1), dw_gemm);
+    }
+  };
+
+  // Direct algorithms
+  auto fp_direct = [&] {
+    direct_convolution_forward(x.LockedBuffer(), x.LDim(),
+                               w.LockedBuffer(),
+                               y_direct.Buffer(), y_direct.LDim(),
+                               mb_size, s.input_channels, s.output_channels,
+                               2, input_dims.data(), output_dims.data(),
+                               window_dims.data(), pads.data(), strides.data());
+  };
+  auto bp_data_direct = [&] {
+    direct_convolution_backward_data(dy.LockedBuffer(), dy.LDim(),
+                                     w.LockedBuffer(),
+                                     dx_direct.Buffer(), dx_direct.LDim(),
+                                     mb_size, s.input_channels, s.output_channels,
+                                     2, input_dims.data(), output_dims.data(),
+                                     window_dims.data(), pads.data(), strides.data());
+  };
+  auto bp_filter_direct = [&] {
+    direct_convolution_backward_filter(x.LockedBuffer(), x.LDim(),
+                                       dy.LockedBuffer(), dy.LDim(),
+                                       dw_direct.Buffer(),
+                                       mb_size, s.input_channels, s.output_channels,
+                                       2, input_dims.data(), output_dims.data(),
+                                       window_dims.data(), pads.data(), strides.data());
+  };
+
+  const double t_fp_gemm = time_ms(fp_gemm, num_iterations);
+  const double t_fp_direct = time_ms(fp_direct, num_iterations);
+  const double t_bpd_gemm = time_ms(bp_data_gemm, num_iterations);
+  const double t_bpd_direct = time_ms(bp_data_direct, num_iterations);
+  const double t_bpf_gemm = time_ms(bp_filter_gemm, num_iterations);
+  const double t_bpf_direct = time_ms(bp_filter_direct, num_iterations);
+  const DataType err = std::max({max_diff(y_gemm, y_direct),
+                                 max_diff(dx_gemm, dx_direct),
+                                 max_diff(dw_gemm, dw_direct)});
+
+  std::cout << std::setw(22) << std::left << s.name << std::right
+            << std::fixed << std::setprecision(3)
+            << std::setw(10) << t_fp_gemm
+            << std::setw(10) << t_fp_direct
+            << std::setw(10) << t_bpd_gemm
+            << std::setw(10) << t_bpd_direct
+            << std::setw(10) << t_bpf_gemm
+            << std::setw(10) << t_bpf_direct
+            << std::scientific << std::setprecision(2)
+            << std::setw(12) << err
+            << std::endl;
+
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  El::Initialize(argc, argv);
+  const int mb_size = (argc > 1 ? std::atoi(argv[1]) : 16);
+  const int num_iterations = (argc > 2 ? std::atoi(argv[2]) : 5);
+
+  const std::vector<conv_shape> shapes = {
+    {"lenet conv1",      1,  20,  28,  28,  5, 0, 1},
+    {"lenet conv2",     20,  50,  12,  12,  5, 0, 1},
+    {"alexnet conv1",    3,  96, 227, 227, 11, 0, 4},
+    {"alexnet conv3",  256, 384,  13,  13,  3, 1, 1},
+    {"resnet50 3x3",    64,  64,  56,  56,  3, 1, 1},
+    {"resnet50 1x1",   256,  64,  56,  56,  1, 0, 1},
+  };
+
+  std::cout << "mini-batch size " << mb_size << ", times in ms" << std::endl
+            << std::setw(22) << std::left << "shape" << std::right
+            << std::setw(10) << "fp gemm"
+            << std::setw(10) << "fp dir"
+            << std::setw(10) << "bpd gemm"
+            << std::setw(10) << "bpd dir"
+            << std::setw(10) << "bpf gemm"
+            << std::setw(10) << "bpf dir"
+            << std::setw(12) << "max diff"
+            << std::endl;
+  for (const auto& s : shapes) {
+    benchmark(s, mb_size, num_iterations);
+  }
+
+  El::Finalize();
+  return EXIT_SUCCESS;
+}
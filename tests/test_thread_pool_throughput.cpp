@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2014-2016, Lawrence Livermore National Security, LLC.
+// Produced at the Lawrence Livermore National Laboratory.
+// Written by the LBANN Research Team (B. Van Essen, et al.) listed in
+// the CONTRIBUTORS file. <lbann-dev@llnl.gov>
+//
+// LLNL-CODE-697807.
+// All rights reserved.
+//
+// This file is part of LBANN: Livermore Big Artificial Neural Network
+// Toolkit. For details, see http://software.llnl.gov/LBANN or
+// https://github.com/LLNL/LBANN.
+//
+// Licensed under the Apache License, Version 2.0 (the "Licensee"); you
+// may not use this file except in compliance with the License.  You may
+// obtain a copy of the License at:
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the license.
+//
+// test_thread_pool_throughput.cpp - microbenchmark for lbann::thread_pool
+//
+// Compares task throughput of the work-stealing thread_pool against a
+// pool that funnels every task through a single thread_safe_queue
+// (the previous thread_pool design). Two workloads are measured:
+//   external: the main thread submits many tiny jobs
+//   nested:   a worker repeatedly fans out one tiny job per thread
+//             into a work group and waits for it, which is the
+//             pattern generic_data_reader::fetch_data uses
+//
+// Usage: test_thread_pool_throughput [num_tasks] [max_threads]
+////////////////////////////////////////////////////////////////////////////////
+
+#include "lbann/utils/threads/thread_pool.hpp"
+#include "lbann/utils/threads/thread_safe_queue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace lbann;
+
+namespace {
+
+/** Thread pool with a single shared queue (the previous design). */
+class locked_queue_pool {
+public:
+  locked_queue_pool(size_t num_threads) : m_done(false) {
+    for (size_t i = 0; i < num_threads; ++i) {
+      m_threads.emplace_back([this] {
+        while (!m_done) {
+          auto task = m_queue.wait_and_pop();
+          if (task) { (*task)(); }
+        }
+      });
+    }
+  }
+  ~locked_queue_pool() {
+    m_done = true;
+    m_queue.wake_all(true);
+    for (auto& t : m_threads) { t.join(); }
+  }
+  size_t get_num_threads() const { return m_threads.size(); }
+  template <typename FunctionT>
+  std::future<typename std::result_of<FunctionT()>::type>
+  submit_job(FunctionT func) {
+    using return_type = typename std::result_of<FunctionT()>::type;
+    std::packaged_task<return_type()> task(std::move(func));
+    auto future = task.get_future();
+    m_queue.push(std::move(task));
+    return future;
+  }
+  using work_group = std::vector<std::future<bool>>;
+  template <typename FunctionT>
+  void submit_job_to_work_group(work_group& group, FunctionT func) {
+    group.emplace_back(submit_job(std::move(func)));
+  }
+  bool finish_work_group(work_group& group) {
+    for (auto& f : group) { f.get(); }
+    group.clear();
+    return true;
+  }
+private:
+  std::vector<std::thread> m_threads;
+  thread_safe_queue<type_erased_function> m_queue;
+  std::atomic<bool> m_done;
+};
+
+/** Throughput (tasks/s) of jobs submitted by the main thread. */
+template <typename PoolT>
+double external_throughput(PoolT& pool, long num_tasks) {
+  std::atomic<long> counter(0);
+  std::vector<std::future<bool>> futures;
+  futures.reserve(num_tasks);
+  const auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < num_tasks; ++i) {
+    futures.emplace_back(pool.submit_job([&counter] {
+      counter.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }));
+  }
+  for (auto& f : futures) { f.get(); }
+  const std::chrono::duration<double> elapsed
+    = std::chrono::steady_clock::now() - start;
+  return counter / elapsed.count();
+}
+
+/** Throughput (tasks/s) of work groups launched from a worker. */
+template <typename PoolT>
+double nested_throughput(PoolT& pool, long num_tasks) {
+  std::atomic<long> counter(0);
+  const long num_threads = pool.get_num_threads();
+  const long num_rounds = std::max(num_tasks / num_threads, 1L);
+  const auto start = std::chrono::steady_clock::now();
+  auto driver = pool.submit_job([&] {
+    typename PoolT::work_group group;
+    for (long r = 0; r < num_rounds; ++r) {
+      for (long t = 0; t < num_threads; ++t) {
+        pool.submit_job_to_work_group(group, [&counter] {
+          counter.fetch_add(1, std::memory_order_relaxed);
+          return true;
+        });
+      }
+      pool.finish_work_group(group);
+    }
+    return true;
+  });
+  driver.get();
+  const std::chrono::duration<double> elapsed
+    = std::chrono::steady_clock::now() - start;
+  return counter / elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const long num_tasks = (argc > 1 ? std::atol(argv[1]) : 200000);
+  const size_t max_threads = (argc > 2 ? std::atol(argv[2]) : 64);
+
+  std::cout << std::setw(8) << "threads"
+            << std::setw(18) << "external (old)"
+            << std::setw(18) << "external (new)"
+            << std::setw(18) << "nested (old)"
+            << std::setw(18) << "nested (new)"
+            << "   [tasks/s]" << std::endl;
+  for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    double old_external, old_nested, new_external, new_nested;
+    {
+      locked_queue_pool pool(num_threads);
+      old_external = external_throughput(pool, num_tasks);
+      // The nested workload needs a spare worker besides the driver,
+      // otherwise the old design deadlocks
+      old_nested = (num_threads > 1 ? nested_throughput(pool, num_tasks) : 0.0);
+    }
+    {
+      thread_pool pool;
+      pool.launch_threads(num_threads);
+      new_external = external_throughput(pool, num_tasks);
+      new_nested = nested_throughput(pool, num_tasks);
+    }
+    std::cout << std::setw(8) << num_threads
+              << std::scientific << std::setprecision(3)
+              << std::setw(18) << old_external
+              << std::setw(18) << new_external
+              << std::setw(18) << old_nested
+              << std::setw(18) << new_nested
+              << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}